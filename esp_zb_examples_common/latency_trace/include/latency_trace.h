@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee latency trace example
+ *
+ * Lightweight trace points along the user-visible paths of the device: a
+ * button edge until the Zigbee report is requested, or until a bound device
+ * acknowledged the command sent to it, and a ZCL attribute write until the LED
+ * has been refreshed. Every trace point appends a timestamp to a
+ * fixed-size ring and closes the latency paths it ends into log2 histograms.
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* set to 0 to compile every trace point out */
+#define LATENCY_TRACE_ENABLE            1
+
+/* number of raw events kept for latency_trace_dump(), must be a power of two */
+#define LATENCY_TRACE_RING_SIZE         64
+
+/* histogram bin i counts latencies below (LATENCY_TRACE_BIN0_US << i), the last bin counts the rest */
+#define LATENCY_TRACE_BINS              16
+#define LATENCY_TRACE_BIN0_US           128
+
+/* a path still open after this long is restarted by its next start point instead of being closed */
+#define LATENCY_TRACE_PATH_TIMEOUT_US   (5 * 1000 * 1000)
+
+typedef enum {
+    LATENCY_TRACE_BUTTON_EDGE,      /*!< switch_driver button interrupt, press edges only */
+    LATENCY_TRACE_DEBOUNCE_DONE,    /*!< switch_driver button settled */
+    LATENCY_TRACE_ATTR_SET,         /*!< Attribute set in the local attribute store */
+    LATENCY_TRACE_REPORT_REQUEST,   /*!< Report Attributes command handed to the stack */
+    LATENCY_TRACE_ATTR_CALLBACK,    /*!< Attribute write callback entered */
+    LATENCY_TRACE_LED_REFRESH,      /*!< led_strip_refresh() completed */
+    LATENCY_TRACE_COMMAND_REQUEST,  /*!< Command to the bound devices handed to the stack */
+    LATENCY_TRACE_COMMAND_ACK,      /*!< Command acknowledged by all the bound devices */
+    LATENCY_TRACE_POINT_COUNT,
+} latency_trace_point_t;
+
+typedef enum {
+    LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET,    /*!< LATENCY_TRACE_BUTTON_EDGE to LATENCY_TRACE_ATTR_SET */
+    LATENCY_TRACE_PATH_EDGE_TO_REPORT,      /*!< LATENCY_TRACE_BUTTON_EDGE to LATENCY_TRACE_REPORT_REQUEST */
+    LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE,    /*!< LATENCY_TRACE_BUTTON_EDGE to LATENCY_TRACE_DEBOUNCE_DONE */
+    LATENCY_TRACE_PATH_WRITE_TO_LED,        /*!< LATENCY_TRACE_ATTR_CALLBACK to LATENCY_TRACE_LED_REFRESH */
+    LATENCY_TRACE_PATH_EDGE_TO_COMMAND,     /*!< LATENCY_TRACE_BUTTON_EDGE to LATENCY_TRACE_COMMAND_REQUEST */
+    LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK, /*!< LATENCY_TRACE_BUTTON_EDGE to LATENCY_TRACE_COMMAND_ACK */
+    LATENCY_TRACE_PATH_COUNT,
+} latency_trace_path_t;
+
+typedef struct {
+    uint16_t bins[LATENCY_TRACE_BINS];  /*!< Saturating counts */
+    uint32_t count;                     /*!< Latencies recorded */
+    uint32_t max_us;                    /*!< Largest latency recorded */
+} latency_trace_histogram_t;
+
+/**
+ * @brief Measure the cost of a trace point, call once at start-up before any trace point
+ */
+void latency_trace_init(void);
+
+#if LATENCY_TRACE_ENABLE
+/**
+ * @brief Record a trace point, safe from any task and from interrupt handlers (IRAM)
+ *
+ * @param point  The trace point reached
+ */
+void latency_trace_point(latency_trace_point_t point);
+#else
+static inline void latency_trace_point(latency_trace_point_t point) {}
+#endif
+
+/**
+ * @brief Copy the histogram of one path
+ *
+ * @param path  The latency path
+ * @param out   Destination of the copy
+ */
+void latency_trace_get_histogram(latency_trace_path_t path, latency_trace_histogram_t *out);
+
+/**
+ * @brief Get the cost of one trace point measured by latency_trace_init(), in CPU cycles
+ */
+uint32_t latency_trace_overhead_cycles(void);
+
+/**
+ * @brief Get the number of latencies recorded on all paths, to know whether histograms changed
+ */
+uint32_t latency_trace_sample_count(void);
+
+/**
+ * @brief Log the raw events of the ring, oldest first, in the format read by tools/trace_dump.py
+ *
+ * @note Not reentrant, call it from one task only.
+ */
+void latency_trace_dump(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
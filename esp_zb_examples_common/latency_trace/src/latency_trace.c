@@ -0,0 +1,164 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee latency trace example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "latency_trace.h"
+
+/* number of trace points timed by latency_trace_init() */
+#define LATENCY_TRACE_CALIBRATION_POINTS    32
+
+_Static_assert((LATENCY_TRACE_RING_SIZE & (LATENCY_TRACE_RING_SIZE - 1)) == 0, "LATENCY_TRACE_RING_SIZE must be a power of two");
+
+typedef struct {
+    uint32_t time_us;   /* low 32 bits of esp_timer_get_time() */
+    uint8_t point;
+} latency_trace_event_t;
+
+typedef struct {
+    uint8_t start;
+    uint8_t end;
+} latency_trace_path_desc_t;
+
+static const char *TAG = "LATENCY_TRACE";
+
+static const char *const s_point_names[LATENCY_TRACE_POINT_COUNT] = {
+    [LATENCY_TRACE_BUTTON_EDGE] = "button_edge",
+    [LATENCY_TRACE_DEBOUNCE_DONE] = "debounce_done",
+    [LATENCY_TRACE_ATTR_SET] = "attr_set",
+    [LATENCY_TRACE_REPORT_REQUEST] = "report_request",
+    [LATENCY_TRACE_ATTR_CALLBACK] = "attr_callback",
+    [LATENCY_TRACE_LED_REFRESH] = "led_refresh",
+    [LATENCY_TRACE_COMMAND_REQUEST] = "command_request",
+    [LATENCY_TRACE_COMMAND_ACK] = "command_ack",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static latency_trace_event_t s_ring[LATENCY_TRACE_RING_SIZE];
+/* events ever written, the ring holds the last LATENCY_TRACE_RING_SIZE of them */
+static uint32_t s_ring_written;
+static latency_trace_histogram_t s_histograms[LATENCY_TRACE_PATH_COUNT];
+static uint32_t s_samples;
+static uint32_t s_overhead_cycles;
+
+#if LATENCY_TRACE_ENABLE
+/* read from interrupt handlers, keep it out of flash */
+static DRAM_ATTR const latency_trace_path_desc_t s_paths[LATENCY_TRACE_PATH_COUNT] = {
+    [LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET] = { LATENCY_TRACE_BUTTON_EDGE, LATENCY_TRACE_ATTR_SET },
+    [LATENCY_TRACE_PATH_EDGE_TO_REPORT] = { LATENCY_TRACE_BUTTON_EDGE, LATENCY_TRACE_REPORT_REQUEST },
+    [LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE] = { LATENCY_TRACE_BUTTON_EDGE, LATENCY_TRACE_DEBOUNCE_DONE },
+    [LATENCY_TRACE_PATH_WRITE_TO_LED] = { LATENCY_TRACE_ATTR_CALLBACK, LATENCY_TRACE_LED_REFRESH },
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND] = { LATENCY_TRACE_BUTTON_EDGE, LATENCY_TRACE_COMMAND_REQUEST },
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK] = { LATENCY_TRACE_BUTTON_EDGE, LATENCY_TRACE_COMMAND_ACK },
+};
+
+/* start time of every open path, 0 when closed */
+static int64_t s_open_us[LATENCY_TRACE_PATH_COUNT];
+
+static inline IRAM_ATTR void latency_trace_record(latency_trace_histogram_t *histogram, uint32_t latency_us)
+{
+    int bin = 0;
+    while (bin < LATENCY_TRACE_BINS - 1 && latency_us >= ((uint32_t)LATENCY_TRACE_BIN0_US << bin)) {
+        bin++;
+    }
+    if (histogram->bins[bin] < UINT16_MAX) {
+        histogram->bins[bin]++;
+    }
+    histogram->count++;
+    if (latency_us > histogram->max_us) {
+        histogram->max_us = latency_us;
+    }
+    s_samples++;
+}
+
+void IRAM_ATTR latency_trace_point(latency_trace_point_t point)
+{
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL_SAFE(&s_lock);
+    latency_trace_event_t *event = &s_ring[s_ring_written++ & (LATENCY_TRACE_RING_SIZE - 1)];
+    event->time_us = (uint32_t)now_us;
+    event->point = point;
+    for (int i = 0; i < LATENCY_TRACE_PATH_COUNT; i++) {
+        int64_t open_us = s_open_us[i];
+        bool abandoned = open_us && now_us - open_us > LATENCY_TRACE_PATH_TIMEOUT_US;
+        if (s_paths[i].end == point && open_us) {
+            if (!abandoned) {
+                latency_trace_record(&s_histograms[i], (uint32_t)(now_us - open_us));
+            }
+            s_open_us[i] = 0;
+        } else if (s_paths[i].start == point && (!open_us || abandoned)) {
+            /* the first edge of a burst opens the path, the ones it merges with do not restart it */
+            s_open_us[i] = now_us;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+#endif
+
+void latency_trace_init(void)
+{
+#if LATENCY_TRACE_ENABLE
+    /* LATENCY_TRACE_POINT_COUNT is not part of any path, so it only costs the ring write and the path scan */
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < LATENCY_TRACE_CALIBRATION_POINTS; i++) {
+        latency_trace_point(LATENCY_TRACE_POINT_COUNT);
+    }
+    s_overhead_cycles = (esp_cpu_get_cycle_count() - start) / LATENCY_TRACE_CALIBRATION_POINTS;
+
+    portENTER_CRITICAL(&s_lock);
+    s_ring_written = 0;
+    memset(s_ring, 0, sizeof(s_ring));
+    portEXIT_CRITICAL(&s_lock);
+#endif
+    ESP_LOGI(TAG, "Trace points %s, %" PRIu32 " cycles each", LATENCY_TRACE_ENABLE ? "enabled" : "disabled", s_overhead_cycles);
+}
+
+void latency_trace_get_histogram(latency_trace_path_t path, latency_trace_histogram_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_histograms[path];
+    portEXIT_CRITICAL(&s_lock);
+}
+
+uint32_t latency_trace_overhead_cycles(void)
+{
+    return s_overhead_cycles;
+}
+
+uint32_t latency_trace_sample_count(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t samples = s_samples;
+    portEXIT_CRITICAL(&s_lock);
+    return samples;
+}
+
+void latency_trace_dump(void)
+{
+    /* static to keep 512 bytes off the caller stack */
+    static latency_trace_event_t events[LATENCY_TRACE_RING_SIZE];
+    portENTER_CRITICAL(&s_lock);
+    uint32_t written = s_ring_written;
+    memcpy(events, s_ring, sizeof(events));
+    portEXIT_CRITICAL(&s_lock);
+
+    uint32_t first = written > LATENCY_TRACE_RING_SIZE ? written - LATENCY_TRACE_RING_SIZE : 0;
+    for (uint32_t seq = first; seq < written; seq++) {
+        const latency_trace_event_t *event = &events[seq & (LATENCY_TRACE_RING_SIZE - 1)];
+        ESP_LOGI(TAG, "event %" PRIu32 " %s %" PRIu32, seq, s_point_names[event->point], event->time_us);
+    }
+}
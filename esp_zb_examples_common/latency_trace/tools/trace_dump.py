@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+#
+# Turns latency trace output into per-path histograms on the host.
+#
+# From the raw events printed by latency_trace_dump() in a serial log:
+#
+#   idf.py monitor | tee monitor.log
+#   python3 tools/trace_dump.py monitor.log
+#
+# From a latency histogram attribute of the Diagnostics cluster, as the hex
+# dump of its octet string value (without the length byte):
+#
+#   python3 tools/trace_dump.py --attr 0300010000...
+
+import argparse
+import re
+import struct
+import sys
+
+# Keep in sync with include/latency_trace.h
+BINS = 16
+BIN0_US = 128
+PATH_TIMEOUT_US = 5 * 1000 * 1000
+PATHS = {
+    "edge_to_attr_set": ("button_edge", "attr_set"),
+    "edge_to_report": ("button_edge", "report_request"),
+    "edge_to_debounce": ("button_edge", "debounce_done"),
+    "write_to_led": ("attr_callback", "led_refresh"),
+    "edge_to_command": ("button_edge", "command_request"),
+    "edge_to_command_ack": ("button_edge", "command_ack"),
+}
+
+EVENT_RE = re.compile(r"LATENCY_TRACE: event (\d+) (\w+) (\d+)")
+
+
+def bin_of(latency_us):
+    bin = 0
+    while bin < BINS - 1 and latency_us >= BIN0_US << bin:
+        bin += 1
+    return bin
+
+
+def bin_label(bin):
+    if bin == BINS - 1:
+        return ">= %d us" % (BIN0_US << (bin - 1))
+    return "< %d us" % (BIN0_US << bin)
+
+
+def read_events(lines):
+    """Events in sequence order, duplicates from overlapping dumps removed"""
+    events = {}
+    for line in lines:
+        match = EVENT_RE.search(line)
+        if match:
+            events[int(match.group(1))] = (match.group(2), int(match.group(3)))
+    return [events[seq] for seq in sorted(events)]
+
+
+def histograms_from_events(events):
+    """Same path rules as latency_trace_point()"""
+    histograms = {path: [0] * BINS for path in PATHS}
+    open_us = {path: None for path in PATHS}
+    last_us = None
+    now_us = 0
+    for point, time_us in events:
+        # the device only logs the low 32 bits of the timestamp
+        now_us += (time_us - last_us) % (1 << 32) if last_us is not None else 0
+        last_us = time_us
+        for path, (start, end) in PATHS.items():
+            abandoned = open_us[path] is not None and now_us - open_us[path] > PATH_TIMEOUT_US
+            if point == end and open_us[path] is not None:
+                if not abandoned:
+                    histograms[path][bin_of(now_us - open_us[path])] += 1
+                open_us[path] = None
+            elif point == start and (open_us[path] is None or abandoned):
+                open_us[path] = now_us
+    return histograms
+
+
+def histogram_from_attr(hex_value):
+    """Octet string written by main/diagnostics.c: BINS little-endian uint16 counts, then the uint32 maximum"""
+    data = bytes.fromhex(hex_value)
+    bins = list(struct.unpack_from("<%dH" % BINS, data))
+    (max_us,) = struct.unpack_from("<I", data, BINS * 2)
+    return bins, max_us
+
+
+def print_histogram(name, bins, max_us=None):
+    count = sum(bins)
+    print("%s: %d samples%s" % (name, count, ", max %d us" % max_us if max_us is not None else ""))
+    for bin, n in enumerate(bins):
+        if n:
+            print("  %-12s %6d %s" % (bin_label(bin), n, "#" * max(1, 50 * n // count)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin, help="serial log, stdin by default")
+    parser.add_argument("--attr", help="hex value of a latency histogram attribute")
+    args = parser.parse_args()
+
+    if args.attr:
+        bins, max_us = histogram_from_attr(args.attr)
+        print_histogram("attribute", bins, max_us)
+        return
+    for path, bins in histograms_from_events(read_events(args.log)).items():
+        print_histogram(path, bins)
+
+
+if __name__ == "__main__":
+    main()
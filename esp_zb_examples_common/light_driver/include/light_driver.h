@@ -16,6 +16,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 
 #ifdef __cplusplus
@@ -29,7 +30,24 @@ extern "C" {
 /* LED strip configuration */
 #define CONFIG_EXAMPLE_STRIP_LED_GPIO   8
 #define CONFIG_EXAMPLE_STRIP_LED_NUMBER 1
+/* pixels showing the light, from the start of the strip, the others are free for light_driver_set_pixels() */
+#define LIGHT_DRIVER_LIGHT_PIXELS       1
 
+/* task sending the frames to the strip, so that rendering overlaps with the RMT transmission */
+#define LIGHT_DRIVER_TX_TASK_STACK_SIZE 3072
+#define LIGHT_DRIVER_TX_TASK_PRIORITY   4
+
+/* render loop frame period used by transitions, 50 frames per second */
+#define LIGHT_DRIVER_FRAME_PERIOD_US    20000
+
+/* release the LED strip (RMT channel) while the LED is dark, so that it does not prevent light sleep */
+#define LIGHT_DRIVER_AUTO_POWER_DOWN    1
+
+/* apply gamma correction (tools/gen_color_lut.py) on top of the linear RGB conversions */
+#define LIGHT_DRIVER_GAMMA_CORRECTION   0
+
+/* The float conversion macros below are kept as the reference of the integer colour engine
+   (src/color_engine.c) which the driver uses, the ESP32-C6 has no FPU. */
 
 /** Convert Hue,Saturation,V to RGB
  * RGB - [0..0xffff]
@@ -74,6 +92,14 @@ extern "C" {
   if(b>1){b=1;}                                             \
 }
 
+/** Complete state of the light, applied in one refresh by light_driver_set_state() */
+typedef struct {
+    bool power;         /*!< On/off */
+    uint8_t level;      /*!< Light level, 0..0xff */
+    uint16_t color_x;   /*!< Color x, 0..0xffff */
+    uint16_t color_y;   /*!< Color y, 0..0xffff */
+} light_driver_state_t;
+
 /**
 * @brief Set light power (on/off).
 *
@@ -120,6 +146,46 @@ void light_driver_set_color_xy(uint16_t color_current_x, uint16_t color_current_
 */
 void light_driver_set_color_hue_sat(uint8_t hue, uint8_t sat);
 
+/**
+* @brief Set power, level and color xy at once, with a single conversion and a single LED refresh
+*
+* @param  state  The light state to be set
+*/
+void light_driver_set_state(const light_driver_state_t *state);
+
+/**
+* @brief Fade from the current output to a new state
+*
+* The fade is rendered by a fixed-rate loop (LIGHT_DRIVER_FRAME_PERIOD_US) that only runs while a
+* fade is in progress and only refreshes the LED when the rendered pixel changes. Starting a new fade
+* interrupts the current one from wherever it is.
+*
+* @param  state          The light state to fade to
+* @param  transition_ms  Duration of the fade, 0 to apply the state right away
+*/
+void light_driver_fade_to_state(const light_driver_state_t *state, uint32_t transition_ms);
+
+/**
+* @brief Set pixels of the strip, e.g. a status bar after the light pixels
+*
+* The pixels are drawn in a back buffer and sent to the strip by the next light_driver_refresh(), or
+* by the next frame of a light fade. Pixels of the light are overwritten by the light.
+*
+* @param  first  Index of the first pixel on the strip
+* @param  count  Number of pixels, those beyond CONFIG_EXAMPLE_STRIP_LED_NUMBER are ignored
+* @param  red    The red color to be set
+* @param  green  The green color to be set
+* @param  blue   The blue color to be set
+*/
+void light_driver_set_pixels(uint16_t first, uint16_t count, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+* @brief Send the pixels drawn since the last refresh to the strip, does nothing if none changed
+*
+* Returns once the frame is handed to the transmit task, without waiting for the transmission.
+*/
+void light_driver_refresh(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "color_engine.h"
+#include "color_lut.h"
+
+#define COLOR_ENGINE_XY_MAX     UINT16_MAX
+#define COLOR_ENGINE_ONE        (1 << COLOR_LUT_XYZ_Q)
+
+/* One row of the XYZ to RGB matrix applied to X = x / y, Y = 1, Z = (1 - x - y) / y, clamped to 0..255 */
+static uint8_t color_engine_xy_channel(const int32_t row[3], int32_t x, int32_t y)
+{
+    /* every term is multiplied by y to stay in integers, |numerator| < 2^31 */
+    int32_t numerator = row[0] * x + row[1] * y + row[2] * (COLOR_ENGINE_XY_MAX - x - y);
+    int32_t channel = numerator / y;
+    if (channel <= 0) {
+        return 0;
+    }
+    if (channel >= COLOR_ENGINE_ONE) {
+        return UINT8_MAX;
+    }
+    return (uint8_t)((channel * UINT8_MAX) >> COLOR_LUT_XYZ_Q);
+}
+
+color_rgb_t color_engine_xy_to_rgb(uint16_t x, uint16_t y)
+{
+    int32_t y_safe = y ? y : 1;
+    return (color_rgb_t) {
+        .red = color_engine_xy_channel(COLOR_LUT_XYZ_TO_RGB[0], x, y_safe),
+        .green = color_engine_xy_channel(COLOR_LUT_XYZ_TO_RGB[1], x, y_safe),
+        .blue = color_engine_xy_channel(COLOR_LUT_XYZ_TO_RGB[2], x, y_safe),
+    };
+}
+
+color_rgb_t color_engine_hue_sat_to_rgb(uint8_t hue, uint8_t sat)
+{
+    const uint8_t *full = COLOR_LUT_HUE_TO_RGB[hue];
+    /* every channel moves linearly from white (sat = 0) to the full saturation colour */
+    return (color_rgb_t) {
+        .red = UINT8_MAX - (sat * (UINT8_MAX - full[0])) / UINT8_MAX,
+        .green = UINT8_MAX - (sat * (UINT8_MAX - full[1])) / UINT8_MAX,
+        .blue = UINT8_MAX - (sat * (UINT8_MAX - full[2])) / UINT8_MAX,
+    };
+}
+
+color_rgb_t color_engine_scale(color_rgb_t color, uint8_t level, bool gamma)
+{
+    color_rgb_t scaled = {
+        .red = (color.red * level) / UINT8_MAX,
+        .green = (color.green * level) / UINT8_MAX,
+        .blue = (color.blue * level) / UINT8_MAX,
+    };
+    if (gamma) {
+        scaled.red = COLOR_LUT_GAMMA[scaled.red];
+        scaled.green = COLOR_LUT_GAMMA[scaled.green];
+        scaled.blue = COLOR_LUT_GAMMA[scaled.blue];
+    }
+    return scaled;
+}
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * Integer colour conversions used by the light driver. The ESP32-C6 has no FPU,
+ * so everything here is done with table lookups and 32-bit fixed-point math.
+ * No ESP-IDF dependency: the file also builds on the host.
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+} color_rgb_t;
+
+/**
+ * @brief Convert ZCL CurrentX/CurrentY to linear RGB at full brightness
+ *
+ * Integer equivalent of the float conversion through XYZ_to_RGB (Y = 1).
+ *
+ * @param x  The color x, 0..0xffff
+ * @param y  The color y, 0..0xffff
+ */
+color_rgb_t color_engine_xy_to_rgb(uint16_t x, uint16_t y);
+
+/**
+ * @brief Convert hue/saturation to RGB at full value
+ *
+ * Integer equivalent of HSV_to_RGB(hue, sat, UINT8_MAX, ...).
+ *
+ * @param hue  The hue, 0..0xff
+ * @param sat  The saturation, 0..0xff
+ */
+color_rgb_t color_engine_hue_sat_to_rgb(uint8_t hue, uint8_t sat);
+
+/**
+ * @brief Scale a colour by a light level, optionally gamma corrected
+ *
+ * @param color  The colour at full brightness
+ * @param level  The light level, 0..0xff
+ * @param gamma  Apply the gamma table to the scaled channels
+ */
+color_rgb_t color_engine_scale(color_rgb_t color, uint8_t level, bool gamma);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
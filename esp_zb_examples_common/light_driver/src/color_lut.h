@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * Generated by tools/gen_color_lut.py, do not edit.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Fractional bits of COLOR_LUT_XYZ_TO_RGB */
+#define COLOR_LUT_XYZ_Q 12
+
+/* XYZ to linear RGB matrix, Q12 */
+static const int32_t COLOR_LUT_XYZ_TO_RGB[3][3] = {
+    {  13273,  -6296,  -2042 },
+    {  -3970,   7684,    170 },
+    {    228,   -836,   4331 }
+};
+
+/* Gamma 2.2 correction of an 8-bit channel */
+static const uint8_t COLOR_LUT_GAMMA[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+/* RGB of every 8-bit hue at full saturation and value */
+static const uint8_t COLOR_LUT_HUE_TO_RGB[256][3] = {
+    { 255,   0,   0 }, { 255,   6,   0 }, { 255,  12,   0 }, { 255,  18,   0 },
+    { 255,  24,   0 }, { 255,  30,   0 }, { 255,  36,   0 }, { 255,  42,   0 },
+    { 255,  48,   0 }, { 255,  54,   0 }, { 255,  60,   0 }, { 255,  66,   0 },
+    { 255,  72,   0 }, { 255,  78,   0 }, { 255,  84,   0 }, { 255,  91,   0 },
+    { 255,  97,   0 }, { 255, 103,   0 }, { 255, 109,   0 }, { 255, 115,   0 },
+    { 255, 121,   0 }, { 255, 127,   0 }, { 255, 133,   0 }, { 255, 139,   0 },
+    { 255, 145,   0 }, { 255, 151,   0 }, { 255, 157,   0 }, { 255, 163,   0 },
+    { 255, 170,   0 }, { 255, 176,   0 }, { 255, 182,   0 }, { 255, 188,   0 },
+    { 255, 194,   0 }, { 255, 200,   0 }, { 255, 206,   0 }, { 255, 212,   0 },
+    { 255, 218,   0 }, { 255, 224,   0 }, { 255, 230,   0 }, { 255, 236,   0 },
+    { 255, 242,   0 }, { 255, 248,   0 }, { 255, 255,   0 }, { 248, 255,   0 },
+    { 242, 255,   0 }, { 236, 255,   0 }, { 230, 255,   0 }, { 224, 255,   0 },
+    { 218, 255,   0 }, { 212, 255,   0 }, { 206, 255,   0 }, { 200, 255,   0 },
+    { 194, 255,   0 }, { 188, 255,   0 }, { 182, 255,   0 }, { 176, 255,   0 },
+    { 170, 255,   0 }, { 163, 255,   0 }, { 157, 255,   0 }, { 151, 255,   0 },
+    { 145, 255,   0 }, { 139, 255,   0 }, { 133, 255,   0 }, { 127, 255,   0 },
+    { 121, 255,   0 }, { 115, 255,   0 }, { 109, 255,   0 }, { 103, 255,   0 },
+    {  97, 255,   0 }, {  91, 255,   0 }, {  85, 255,   0 }, {  78, 255,   0 },
+    {  72, 255,   0 }, {  66, 255,   0 }, {  60, 255,   0 }, {  54, 255,   0 },
+    {  48, 255,   0 }, {  42, 255,   0 }, {  36, 255,   0 }, {  30, 255,   0 },
+    {  24, 255,   0 }, {  18, 255,   0 }, {  12, 255,   0 }, {   6, 255,   0 },
+    {   0, 255,   0 }, {   0, 255,   6 }, {   0, 255,  12 }, {   0, 255,  18 },
+    {   0, 255,  24 }, {   0, 255,  30 }, {   0, 255,  36 }, {   0, 255,  42 },
+    {   0, 255,  48 }, {   0, 255,  54 }, {   0, 255,  60 }, {   0, 255,  66 },
+    {   0, 255,  72 }, {   0, 255,  78 }, {   0, 255,  84 }, {   0, 255,  91 },
+    {   0, 255,  97 }, {   0, 255, 103 }, {   0, 255, 109 }, {   0, 255, 115 },
+    {   0, 255, 121 }, {   0, 255, 127 }, {   0, 255, 133 }, {   0, 255, 139 },
+    {   0, 255, 145 }, {   0, 255, 151 }, {   0, 255, 157 }, {   0, 255, 163 },
+    {   0, 255, 170 }, {   0, 255, 176 }, {   0, 255, 182 }, {   0, 255, 188 },
+    {   0, 255, 194 }, {   0, 255, 200 }, {   0, 255, 206 }, {   0, 255, 212 },
+    {   0, 255, 218 }, {   0, 255, 224 }, {   0, 255, 230 }, {   0, 255, 236 },
+    {   0, 255, 242 }, {   0, 255, 248 }, {   0, 255, 255 }, {   0, 248, 255 },
+    {   0, 242, 255 }, {   0, 236, 255 }, {   0, 230, 255 }, {   0, 224, 255 },
+    {   0, 218, 255 }, {   0, 212, 255 }, {   0, 206, 255 }, {   0, 200, 255 },
+    {   0, 194, 255 }, {   0, 188, 255 }, {   0, 182, 255 }, {   0, 176, 255 },
+    {   0, 170, 255 }, {   0, 163, 255 }, {   0, 157, 255 }, {   0, 151, 255 },
+    {   0, 145, 255 }, {   0, 139, 255 }, {   0, 133, 255 }, {   0, 127, 255 },
+    {   0, 121, 255 }, {   0, 115, 255 }, {   0, 109, 255 }, {   0, 103, 255 },
+    {   0,  97, 255 }, {   0,  91, 255 }, {   0,  85, 255 }, {   0,  78, 255 },
+    {   0,  72, 255 }, {   0,  66, 255 }, {   0,  60, 255 }, {   0,  54, 255 },
+    {   0,  48, 255 }, {   0,  42, 255 }, {   0,  36, 255 }, {   0,  30, 255 },
+    {   0,  24, 255 }, {   0,  18, 255 }, {   0,  12, 255 }, {   0,   6, 255 },
+    {   0,   0, 255 }, {   6,   0, 255 }, {  12,   0, 255 }, {  18,   0, 255 },
+    {  24,   0, 255 }, {  30,   0, 255 }, {  36,   0, 255 }, {  42,   0, 255 },
+    {  48,   0, 255 }, {  54,   0, 255 }, {  60,   0, 255 }, {  66,   0, 255 },
+    {  72,   0, 255 }, {  78,   0, 255 }, {  84,   0, 255 }, {  91,   0, 255 },
+    {  97,   0, 255 }, { 103,   0, 255 }, { 109,   0, 255 }, { 115,   0, 255 },
+    { 121,   0, 255 }, { 127,   0, 255 }, { 133,   0, 255 }, { 139,   0, 255 },
+    { 145,   0, 255 }, { 151,   0, 255 }, { 157,   0, 255 }, { 163,   0, 255 },
+    { 170,   0, 255 }, { 176,   0, 255 }, { 182,   0, 255 }, { 188,   0, 255 },
+    { 194,   0, 255 }, { 200,   0, 255 }, { 206,   0, 255 }, { 212,   0, 255 },
+    { 218,   0, 255 }, { 224,   0, 255 }, { 230,   0, 255 }, { 236,   0, 255 },
+    { 242,   0, 255 }, { 248,   0, 255 }, { 255,   0, 255 }, { 255,   0, 248 },
+    { 255,   0, 242 }, { 255,   0, 236 }, { 255,   0, 230 }, { 255,   0, 224 },
+    { 255,   0, 218 }, { 255,   0, 212 }, { 255,   0, 206 }, { 255,   0, 200 },
+    { 255,   0, 194 }, { 255,   0, 188 }, { 255,   0, 182 }, { 255,   0, 176 },
+    { 255,   0, 170 }, { 255,   0, 163 }, { 255,   0, 157 }, { 255,   0, 151 },
+    { 255,   0, 145 }, { 255,   0, 139 }, { 255,   0, 133 }, { 255,   0, 127 },
+    { 255,   0, 121 }, { 255,   0, 115 }, { 255,   0, 109 }, { 255,   0, 103 },
+    { 255,   0,  97 }, { 255,   0,  91 }, { 255,   0,  85 }, { 255,   0,  78 },
+    { 255,   0,  72 }, { 255,   0,  66 }, { 255,   0,  60 }, { 255,   0,  54 },
+    { 255,   0,  48 }, { 255,   0,  42 }, { 255,   0,  36 }, { 255,   0,  30 },
+    { 255,   0,  24 }, { 255,   0,  18 }, { 255,   0,  12 }, { 255,   0,   6 },
+    { 255,   0, 255 }, { 255,   0, 248 }, { 255,   0, 242 }, { 255,   0, 236 },
+};
@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <string.h>
+#include "framebuffer.h"
+
+static uint16_t framebuffer_region_count(const framebuffer_t *fb)
+{
+    return (fb->count + FRAMEBUFFER_REGION_PIXELS - 1) / FRAMEBUFFER_REGION_PIXELS;
+}
+
+static void framebuffer_mark_dirty(framebuffer_t *fb, uint16_t region)
+{
+    fb->dirty[region / 32] |= 1UL << (region % 32);
+}
+
+static void framebuffer_region_span(const framebuffer_t *fb, uint16_t region, uint16_t *first, uint16_t *count)
+{
+    *first = region * FRAMEBUFFER_REGION_PIXELS;
+    *count = fb->count - *first < FRAMEBUFFER_REGION_PIXELS ? fb->count - *first : FRAMEBUFFER_REGION_PIXELS;
+}
+
+void framebuffer_init(framebuffer_t *fb, uint8_t *pixels, uint32_t *dirty, uint16_t count)
+{
+    fb->pixels = pixels;
+    fb->dirty = dirty;
+    fb->count = count;
+    memset(pixels, 0, FRAMEBUFFER_BYTES(count));
+    framebuffer_mark_all_dirty(fb);
+}
+
+bool framebuffer_fill(framebuffer_t *fb, uint16_t first, uint16_t count, color_rgb_t color)
+{
+    bool changed = false;
+    for (uint32_t index = first; index < (uint32_t)first + count && index < fb->count; index++) {
+        uint8_t *pixel = &fb->pixels[FRAMEBUFFER_BYTES(index)];
+        if (pixel[0] != color.red || pixel[1] != color.green || pixel[2] != color.blue) {
+            pixel[0] = color.red;
+            pixel[1] = color.green;
+            pixel[2] = color.blue;
+            framebuffer_mark_dirty(fb, index / FRAMEBUFFER_REGION_PIXELS);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+color_rgb_t framebuffer_get(const framebuffer_t *fb, uint16_t index)
+{
+    const uint8_t *pixel = &fb->pixels[FRAMEBUFFER_BYTES(index)];
+    return (color_rgb_t) { .red = pixel[0], .green = pixel[1], .blue = pixel[2] };
+}
+
+bool framebuffer_is_dirty(const framebuffer_t *fb)
+{
+    for (uint16_t word = 0; word < FRAMEBUFFER_DIRTY_WORDS(fb->count); word++) {
+        if (fb->dirty[word]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool framebuffer_is_black(const framebuffer_t *fb)
+{
+    for (uint32_t i = 0; i < FRAMEBUFFER_BYTES((uint32_t)fb->count); i++) {
+        if (fb->pixels[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void framebuffer_mark_all_dirty(framebuffer_t *fb)
+{
+    memset(fb->dirty, 0, FRAMEBUFFER_DIRTY_WORDS(fb->count) * sizeof(uint32_t));
+    for (uint16_t region = 0; region < framebuffer_region_count(fb); region++) {
+        framebuffer_mark_dirty(fb, region);
+    }
+}
+
+uint16_t framebuffer_copy_dirty(framebuffer_t *dst, framebuffer_t *src)
+{
+    uint16_t copied = 0;
+    uint16_t first, count;
+    while (framebuffer_take_dirty(src, &first, &count)) {
+        memcpy(&dst->pixels[FRAMEBUFFER_BYTES(first)], &src->pixels[FRAMEBUFFER_BYTES(first)], FRAMEBUFFER_BYTES(count));
+        framebuffer_mark_dirty(dst, first / FRAMEBUFFER_REGION_PIXELS);
+        copied++;
+    }
+    return copied;
+}
+
+bool framebuffer_take_dirty(framebuffer_t *fb, uint16_t *first, uint16_t *count)
+{
+    for (uint16_t word = 0; word < FRAMEBUFFER_DIRTY_WORDS(fb->count); word++) {
+        if (fb->dirty[word]) {
+            uint16_t bit = __builtin_ctz(fb->dirty[word]);
+            fb->dirty[word] &= fb->dirty[word] - 1;
+            framebuffer_region_span(fb, word * 32 + bit, first, count);
+            return true;
+        }
+    }
+    return false;
+}
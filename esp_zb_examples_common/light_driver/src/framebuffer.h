@@ -0,0 +1,110 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * Packed RGB framebuffer of an LED strip with dirty tracking per region of
+ * FRAMEBUFFER_REGION_PIXELS pixels. Writes that do not change a pixel leave it
+ * clean, so a frame identical to the previous one costs no transmission, and
+ * only the dirty regions are copied from one buffer to the next.
+ * The storage is provided by the caller. No ESP-IDF dependency: the file also
+ * builds on the host.
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "color_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pixels per dirty bit */
+#define FRAMEBUFFER_REGION_PIXELS   8
+
+/* Storage of a framebuffer of count pixels */
+#define FRAMEBUFFER_BYTES(count)        ((count) * 3)
+#define FRAMEBUFFER_DIRTY_WORDS(count)  (((count) + FRAMEBUFFER_REGION_PIXELS * 32 - 1) / (FRAMEBUFFER_REGION_PIXELS * 32))
+
+typedef struct {
+    uint8_t *pixels;        /*!< RGB, 3 bytes per pixel */
+    uint32_t *dirty;        /*!< One bit per region */
+    uint16_t count;         /*!< Number of pixels */
+} framebuffer_t;
+
+/**
+ * @brief Initialize a framebuffer, black and entirely dirty
+ *
+ * @param fb      The framebuffer to initialize
+ * @param pixels  FRAMEBUFFER_BYTES(count) bytes
+ * @param dirty   FRAMEBUFFER_DIRTY_WORDS(count) words
+ * @param count   Number of pixels
+ */
+void framebuffer_init(framebuffer_t *fb, uint8_t *pixels, uint32_t *dirty, uint16_t count);
+
+/**
+ * @brief Set consecutive pixels to one colour, out of range pixels are ignored
+ *
+ * @param fb     The framebuffer
+ * @param first  Index of the first pixel
+ * @param count  Number of pixels
+ * @param color  The colour
+ * @return true if a pixel changed
+ */
+bool framebuffer_fill(framebuffer_t *fb, uint16_t first, uint16_t count, color_rgb_t color);
+
+/**
+ * @brief Get a pixel
+ *
+ * @param fb     The framebuffer
+ * @param index  Index of the pixel, in range
+ */
+color_rgb_t framebuffer_get(const framebuffer_t *fb, uint16_t index);
+
+/**
+ * @brief Check whether a region changed since it was last copied
+ */
+bool framebuffer_is_dirty(const framebuffer_t *fb);
+
+/**
+ * @brief Check whether all the pixels are off
+ */
+bool framebuffer_is_black(const framebuffer_t *fb);
+
+/**
+ * @brief Mark every region dirty, e.g. after the strip lost its content
+ */
+void framebuffer_mark_all_dirty(framebuffer_t *fb);
+
+/**
+ * @brief Copy the dirty regions of a framebuffer into another of the same size
+ *
+ * The regions become clean in src and dirty in dst.
+ *
+ * @param dst  The destination
+ * @param src  The source
+ * @return Number of regions copied
+ */
+uint16_t framebuffer_copy_dirty(framebuffer_t *dst, framebuffer_t *src);
+
+/**
+ * @brief Take the next dirty region and mark it clean
+ *
+ * @param fb      The framebuffer
+ * @param first   Set to the index of the first pixel of the region
+ * @param count   Set to the number of pixels of the region
+ * @return false once no region is dirty
+ */
+bool framebuffer_take_dirty(framebuffer_t *fb, uint16_t *first, uint16_t *count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -14,76 +14,276 @@
 
 
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "latency_trace.h"
 #include "led_strip.h"
 #include "light_driver.h"
+#include "color_engine.h"
+#include "framebuffer.h"
 
+/* created at init and for the first lit frame after a release, only used by the transmit task once it runs */
 static led_strip_handle_t s_led_strip;
-static uint8_t s_red = 255, s_green = 255, s_blue = 255, s_level = 255;
+/* serializes the render loop and direct updates, both draw into the back buffer */
+static SemaphoreHandle_t s_render_lock;
+static StaticSemaphore_t s_render_lock_buffer;
+static esp_timer_handle_t s_frame_timer;
+/* double buffer: frames are drawn in the back buffer, and their dirty regions copied to the front
+   buffer that the transmit task sends, which keeps the renderers off the RMT transmission */
+static uint8_t s_back_pixels[FRAMEBUFFER_BYTES(CONFIG_EXAMPLE_STRIP_LED_NUMBER)];
+static uint32_t s_back_dirty[FRAMEBUFFER_DIRTY_WORDS(CONFIG_EXAMPLE_STRIP_LED_NUMBER)];
+static framebuffer_t s_back;
+static uint8_t s_front_pixels[FRAMEBUFFER_BYTES(CONFIG_EXAMPLE_STRIP_LED_NUMBER)];
+static uint32_t s_front_dirty[FRAMEBUFFER_DIRTY_WORDS(CONFIG_EXAMPLE_STRIP_LED_NUMBER)];
+static framebuffer_t s_front;
+static SemaphoreHandle_t s_front_lock;
+static StaticSemaphore_t s_front_lock_buffer;
+/* no fade was running when the front buffer was last committed, the strip may be released if dark */
+static bool s_front_idle;
+static TaskHandle_t s_tx_task;
+static StackType_t s_tx_task_stack[LIGHT_DRIVER_TX_TASK_STACK_SIZE];
+static StaticTask_t s_tx_task_buffer;
+/* light colour in the back buffer */
+static color_rgb_t s_shown;
+static bool s_shown_valid;
+/* fade in progress, s_fade.to is also the target of instant updates */
+static struct {
+    color_rgb_t from;
+    color_rgb_t to;
+    int64_t start_us;
+    int64_t duration_us;
+    bool active;
+} s_fade;
+static color_rgb_t s_color = { .red = 255, .green = 255, .blue = 255 };
+static uint8_t s_level = 255;
+/* xy that s_color was converted from, if it was */
+static uint16_t s_color_x, s_color_y;
+static bool s_color_xy_valid;
+
+static void light_driver_strip_power_up(void)
+{
+    if (s_led_strip) {
+        return;
+    }
+    led_strip_config_t led_strip_conf = {
+        .max_leds = CONFIG_EXAMPLE_STRIP_LED_NUMBER,
+        .strip_gpio_num = CONFIG_EXAMPLE_STRIP_LED_GPIO,
+    };
+    led_strip_rmt_config_t rmt_conf = {
+        .resolution_hz = 10 * 1000 * 1000, // 10MHz
+    };
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&led_strip_conf, &rmt_conf, &s_led_strip));
+}
+
+/* An enabled RMT channel holds a power management lock, release it while the LED is dark */
+static void light_driver_strip_power_down(void)
+{
+    if (!s_led_strip) {
+        return;
+    }
+    ESP_ERROR_CHECK(led_strip_del(s_led_strip));
+    s_led_strip = NULL;
+}
+
+static uint8_t light_driver_lerp(uint8_t from, uint8_t to, int64_t elapsed_us, int64_t duration_us)
+{
+    return (uint8_t)(from + ((int32_t)to - from) * elapsed_us / duration_us);
+}
+
+static void light_driver_tx_task(void *arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(s_front_lock, portMAX_DELAY);
+        bool black = framebuffer_is_black(&s_front);
+        bool release = LIGHT_DRIVER_AUTO_POWER_DOWN && s_front_idle && black;
+        /* a released strip was left black, it only needs waking up for a lit frame */
+        bool send = framebuffer_is_dirty(&s_front) && (s_led_strip || !black);
+        if (send && !s_led_strip) {
+            light_driver_strip_power_up();
+            framebuffer_mark_all_dirty(&s_front);
+        }
+        uint16_t first, count;
+        while (framebuffer_take_dirty(&s_front, &first, &count)) {
+            for (uint16_t index = first; send && index < first + count; index++) {
+                color_rgb_t pixel = framebuffer_get(&s_front, index);
+                ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, index, pixel.red, pixel.green, pixel.blue));
+            }
+        }
+        xSemaphoreGive(s_front_lock);
+        /* the renderers can commit the next frame during the transmission, it is picked up by the next round */
+        if (send) {
+            ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+            latency_trace_point(LATENCY_TRACE_LED_REFRESH);
+        }
+        if (release) {
+            light_driver_strip_power_down();
+        }
+    }
+}
+
+/**
+ * @brief Hand the back buffer to the transmit task, must be called with s_render_lock held
+ *
+ * @param idle  No fade is running
+ */
+static void light_driver_commit(bool idle)
+{
+    /* unchanged frames cost nothing */
+    if (!framebuffer_is_dirty(&s_back) && idle == s_front_idle) {
+        return;
+    }
+    xSemaphoreTake(s_front_lock, portMAX_DELAY);
+    framebuffer_copy_dirty(&s_front, &s_back);
+    s_front_idle = idle;
+    xSemaphoreGive(s_front_lock);
+    xTaskNotifyGive(s_tx_task);
+}
+
+/**
+ * @brief Render one frame of the current fade, must be called with s_render_lock held
+ *
+ * @return true while the fade is still in progress
+ */
+static bool light_driver_render_frame(int64_t now_us)
+{
+    color_rgb_t frame = s_fade.to;
+    int64_t elapsed_us = now_us - s_fade.start_us;
+    if (s_fade.active && elapsed_us < s_fade.duration_us) {
+        frame.red = light_driver_lerp(s_fade.from.red, s_fade.to.red, elapsed_us, s_fade.duration_us);
+        frame.green = light_driver_lerp(s_fade.from.green, s_fade.to.green, elapsed_us, s_fade.duration_us);
+        frame.blue = light_driver_lerp(s_fade.from.blue, s_fade.to.blue, elapsed_us, s_fade.duration_us);
+    } else {
+        s_fade.active = false;
+    }
+    framebuffer_fill(&s_back, 0, LIGHT_DRIVER_LIGHT_PIXELS, frame);
+    s_shown = frame;
+    s_shown_valid = true;
+    light_driver_commit(!s_fade.active);
+    return s_fade.active;
+}
+
+static void light_driver_frame_cb(void *arg)
+{
+    xSemaphoreTake(s_render_lock, portMAX_DELAY);
+    if (!light_driver_render_frame(esp_timer_get_time())) {
+        esp_timer_stop(s_frame_timer);
+    }
+    xSemaphoreGive(s_render_lock);
+}
+
+static void light_driver_fade_pixel(color_rgb_t target, uint32_t transition_ms)
+{
+    int64_t now_us = esp_timer_get_time();
+    xSemaphoreTake(s_render_lock, portMAX_DELAY);
+    /* a new fade starts from whatever is on the LED, even in the middle of another fade */
+    s_fade.from = s_shown;
+    s_fade.to = target;
+    s_fade.start_us = now_us;
+    s_fade.duration_us = (int64_t)transition_ms * 1000;
+    s_fade.active = s_shown_valid && transition_ms > 0;
+    if (light_driver_render_frame(now_us)) {
+        if (!esp_timer_is_active(s_frame_timer)) {
+            ESP_ERROR_CHECK(esp_timer_start_periodic(s_frame_timer, LIGHT_DRIVER_FRAME_PERIOD_US));
+        }
+    } else if (esp_timer_is_active(s_frame_timer)) {
+        esp_timer_stop(s_frame_timer);
+    }
+    xSemaphoreGive(s_render_lock);
+}
+
+static void light_driver_show(color_rgb_t color, uint8_t level)
+{
+    light_driver_fade_pixel(color_engine_scale(color, level, LIGHT_DRIVER_GAMMA_CORRECTION), 0);
+}
 
 void light_driver_set_color_xy(uint16_t color_current_x, uint16_t color_current_y)
 {
-    float red_f = 0, green_f = 0, blue_f = 0, color_x, color_y;
-    color_x = (float)color_current_x / 65535;
-    color_y = (float)color_current_y / 65535;
-    /* assume color_Y is full light level value 1  (0-1.0) */
-    float color_X = color_x / color_y;
-    float color_Z = (1 - color_x - color_y) / color_y;
-    /* change from xy to linear RGB NOT sRGB */
-    XYZ_to_RGB(color_X, 1, color_Z, red_f, green_f, blue_f);
-    float ratio = (float)s_level / 255;
-    s_red = (uint8_t)(red_f * (float)255);
-    s_green = (uint8_t)(green_f * (float)255);
-    s_blue = (uint8_t)(blue_f * (float)255);
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    /* change from xy to linear RGB NOT sRGB, assuming color_Y is full light level */
+    s_color = color_engine_xy_to_rgb(color_current_x, color_current_y);
+    s_color_x = color_current_x;
+    s_color_y = color_current_y;
+    s_color_xy_valid = true;
+    light_driver_show(s_color, s_level);
 }
 
 void light_driver_set_color_hue_sat(uint8_t hue, uint8_t sat)
 {
-    float red_f, green_f, blue_f;
-    HSV_to_RGB(hue, sat, UINT8_MAX, red_f, green_f, blue_f);
-    float ratio = (float)s_level / 255;
-    s_red = (uint8_t)red_f;
-    s_green = (uint8_t)green_f;
-    s_blue = (uint8_t)blue_f;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    s_color = color_engine_hue_sat_to_rgb(hue, sat);
+    s_color_xy_valid = false;
+    light_driver_show(s_color, s_level);
 }
 
 void light_driver_set_color_RGB(uint8_t red, uint8_t green, uint8_t blue)
 {
-    float ratio = (float)s_level / 255;
-    s_red = red;
-    s_green = green;
-    s_blue = blue;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, red * ratio, green * ratio, blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    s_color = (color_rgb_t) { .red = red, .green = green, .blue = blue };
+    s_color_xy_valid = false;
+    light_driver_show(s_color, s_level);
 }
 
 void light_driver_set_power(bool power)
 {
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * power, s_green * power, s_blue * power));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    light_driver_show(s_color, power ? UINT8_MAX : 0);
 }
 
 void light_driver_set_level(uint8_t level)
 {
     s_level = level;
-    float ratio = (float)s_level / 255;
-    ESP_ERROR_CHECK(led_strip_set_pixel(s_led_strip, 0, s_red * ratio, s_green * ratio, s_blue * ratio));
-    ESP_ERROR_CHECK(led_strip_refresh(s_led_strip));
+    light_driver_show(s_color, s_level);
+}
+
+void light_driver_set_state(const light_driver_state_t *state)
+{
+    light_driver_fade_to_state(state, 0);
+}
+
+void light_driver_fade_to_state(const light_driver_state_t *state, uint32_t transition_ms)
+{
+    /* the xy conversion is the expensive part, skip it when only power or level changed */
+    if (!s_color_xy_valid || state->color_x != s_color_x || state->color_y != s_color_y) {
+        s_color = color_engine_xy_to_rgb(state->color_x, state->color_y);
+        s_color_x = state->color_x;
+        s_color_y = state->color_y;
+        s_color_xy_valid = true;
+    }
+    s_level = state->level;
+    light_driver_fade_pixel(color_engine_scale(s_color, state->power ? s_level : 0, LIGHT_DRIVER_GAMMA_CORRECTION), transition_ms);
+}
+
+void light_driver_set_pixels(uint16_t first, uint16_t count, uint8_t red, uint8_t green, uint8_t blue)
+{
+    xSemaphoreTake(s_render_lock, portMAX_DELAY);
+    framebuffer_fill(&s_back, first, count, (color_rgb_t) { .red = red, .green = green, .blue = blue });
+    xSemaphoreGive(s_render_lock);
+}
+
+void light_driver_refresh(void)
+{
+    xSemaphoreTake(s_render_lock, portMAX_DELAY);
+    light_driver_commit(!s_fade.active);
+    xSemaphoreGive(s_render_lock);
 }
 
 void light_driver_init(bool power)
 {
-    led_strip_config_t led_strip_conf = {
-        .max_leds = CONFIG_EXAMPLE_STRIP_LED_NUMBER,
-        .strip_gpio_num = CONFIG_EXAMPLE_STRIP_LED_GPIO,
-    };
-    led_strip_rmt_config_t rmt_conf = {
-        .resolution_hz = 10 * 1000 * 1000, // 10MHz
+    light_driver_strip_power_up();
+    framebuffer_init(&s_back, s_back_pixels, s_back_dirty, CONFIG_EXAMPLE_STRIP_LED_NUMBER);
+    framebuffer_init(&s_front, s_front_pixels, s_front_dirty, CONFIG_EXAMPLE_STRIP_LED_NUMBER);
+
+    /* static, nothing the driver keeps for its lifetime comes from the heap */
+    s_render_lock = xSemaphoreCreateMutexStatic(&s_render_lock_buffer);
+    s_front_lock = xSemaphoreCreateMutexStatic(&s_front_lock_buffer);
+    s_tx_task = xTaskCreateStatic(light_driver_tx_task, "light_tx", LIGHT_DRIVER_TX_TASK_STACK_SIZE, NULL,
+                                  LIGHT_DRIVER_TX_TASK_PRIORITY, s_tx_task_stack, &s_tx_task_buffer);
+    esp_timer_create_args_t frame_timer_args = {
+        .callback = light_driver_frame_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "light_frame",
+        .skip_unhandled_events = true,
     };
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&led_strip_conf, &rmt_conf, &s_led_strip));
+    ESP_ERROR_CHECK(esp_timer_create(&frame_timer_args, &s_frame_timer));
 
     light_driver_set_power(power);
 }
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+#
+# Generates src/color_lut.h, the lookup tables and fixed-point constants used by
+# the integer colour engine of the light driver. Run it again after changing
+# any of the parameters below:
+#
+#   python3 tools/gen_color_lut.py > src/color_lut.h
+
+GAMMA = 2.2
+XYZ_Q = 12
+
+# Same matrix as the XYZ_to_RGB macro in light_driver.h
+XYZ_TO_RGB = (
+    (3.240479, -1.537150, -0.498535),
+    (-0.969256, 1.875992, 0.041556),
+    (0.055648, -0.204043, 1.057311),
+)
+
+UINT8_MAX = 255
+
+
+def hue_to_rgb(hue):
+    """Full saturation, full value output of the HSV_to_RGB macro in light_driver.h"""
+    sector = UINT8_MAX // 6
+    i = hue // sector
+    f = hue % sector
+    v = UINT8_MAX
+    p = 0.0
+    q = v * (1.0 - f / sector)
+    t = v * (1.0 - (1 - f / sector))
+    return {
+        0: (v, t, p),
+        1: (q, v, p),
+        2: (p, v, t),
+        3: (p, q, v),
+        4: (t, p, v),
+    }.get(i, (v, p, q))
+
+
+def table(values, per_line):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append('    ' + ', '.join(values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    gamma = [f'{round(((i / UINT8_MAX) ** GAMMA) * UINT8_MAX):3d}' for i in range(UINT8_MAX + 1)]
+    hue = ['{ %3d, %3d, %3d }' % tuple(int(c) for c in hue_to_rgb(h)) for h in range(UINT8_MAX + 1)]
+    matrix = ',\n'.join('    { %s }' % ', '.join(f'{round(c * (1 << XYZ_Q)):6d}' for c in row) for row in XYZ_TO_RGB)
+
+    print(f'''/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee light driver example
+ *
+ * Generated by tools/gen_color_lut.py, do not edit.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Fractional bits of COLOR_LUT_XYZ_TO_RGB */
+#define COLOR_LUT_XYZ_Q {XYZ_Q}
+
+/* XYZ to linear RGB matrix, Q{XYZ_Q} */
+static const int32_t COLOR_LUT_XYZ_TO_RGB[3][3] = {{
+{matrix}
+}};
+
+/* Gamma {GAMMA} correction of an 8-bit channel */
+static const uint8_t COLOR_LUT_GAMMA[256] = {{
+{table(gamma, 16)}
+}};
+
+/* RGB of every 8-bit hue at full saturation and value */
+static const uint8_t COLOR_LUT_HUE_TO_RGB[256][3] = {{
+{table(hue, 4)}
+}};''')
+
+
+if __name__ == '__main__':
+    main()
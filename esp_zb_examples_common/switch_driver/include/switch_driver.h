@@ -15,6 +15,7 @@
 #pragma once
 
 #include "driver/gpio.h"
+#include "switch_gesture.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,20 +27,20 @@ extern "C" {
 /* config button level depends on the pull up/down setting
    push button level is on level = 1 when pull-down enable
    push button level is on level = 0 when pull-up enable
+   this is the level of the buttons that are not active_high, see switch_func_pair_t
 */
 #define GPIO_INPUT_LEVEL_ON     0
 
 #define ESP_INTR_FLAG_DEFAULT   0
 
-#define PAIR_SIZE(TYPE_STR_PAIR) (sizeof(TYPE_STR_PAIR) / sizeof(TYPE_STR_PAIR[0]))
+/* debounce: the pin is sampled every period until it reads the same level this many times in a row */
+#define SWITCH_DEBOUNCE_SAMPLE_PERIOD_US    5000
+#define SWITCH_DEBOUNCE_STABLE_SAMPLES      3
 
-typedef enum {
-    SWITCH_IDLE,
-    SWITCH_PRESS_ARMED,
-    SWITCH_PRESS_DETECTED,
-    SWITCH_PRESSED,
-    SWITCH_RELEASE_DETECTED,
-} switch_state_t;
+/* buttons handled by switch_driver_init(), their state is allocated statically */
+#define SWITCH_DRIVER_MAX_BUTTONS           4
+
+#define PAIR_SIZE(TYPE_STR_PAIR) (sizeof(TYPE_STR_PAIR) / sizeof(TYPE_STR_PAIR[0]))
 
 typedef enum {
     SWITCH_ON_CONTROL,
@@ -54,13 +55,26 @@ typedef enum {
 typedef struct {
     uint32_t pin;
     switch_func_t func;
+    bool active_high;                   /*!< Pressed reads 1 and the pin is pulled down, otherwise pressed reads GPIO_INPUT_LEVEL_ON and the pin is pulled up */
+    switch_gesture_config_t gestures;   /*!< Timings of the gestures, left zeroed only press, release and click are recognized */
 } switch_func_pair_t;
 
-typedef void (*esp_switch_callback_t)(switch_func_pair_t *param);
+/**
+ * @brief Called for every gesture recognized on a button
+ *
+ * @param param    The button
+ * @param gesture  The gesture, a button gets the gestures of one press in order: PRESS, LONG_PRESS,
+ *                 HOLD, RELEASE, then CLICK or DOUBLE_CLICK
+ */
+typedef void (*esp_switch_callback_t)(switch_func_pair_t *param, switch_gesture_t gesture);
 
 /**
  * @brief init function for switch and callback setup
  *
+ * @note All the buttons share a single one-shot esp_timer: it samples the buttons being debounced,
+ *       then waits for the next gesture timeout, and is stopped while every button is idle. The
+ *       callback is invoked from the esp_timer task, so it must stay short.
+ *
  * @param button_func_pair      pointer of the button pair.
  * @param button_num            number of button pair.
  * @param cb                    callback pointer.
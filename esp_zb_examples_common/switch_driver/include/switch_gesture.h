@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee switch driver example
+ *
+ * Gesture recognizer core used by the switch driver. It is fed the debounced
+ * presses and releases of one button and tells which gestures they make, and
+ * when it must be polled again for the gestures that fire on a timeout (long
+ * press, hold, single click waiting out a possible double click). Like the
+ * debounce core it never reads the clock itself, so it also builds on the host.
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* No poll needed */
+#define SWITCH_GESTURE_NO_DEADLINE  INT64_MAX
+
+typedef enum {
+    SWITCH_GESTURE_PRESS,           /*!< Button pressed */
+    SWITCH_GESTURE_RELEASE,         /*!< Button released */
+    SWITCH_GESTURE_CLICK,           /*!< Short press, once the double click window has passed if double clicks are recognized */
+    SWITCH_GESTURE_DOUBLE_CLICK,    /*!< Second short press within the double click window */
+    SWITCH_GESTURE_LONG_PRESS,      /*!< Held for the long press time, fired while still held */
+    SWITCH_GESTURE_HOLD,            /*!< Held for the hold time, to confirm a destructive action */
+    SWITCH_GESTURE_COUNT,
+} switch_gesture_t;
+
+/* Set of gestures, one bit per switch_gesture_t */
+#define SWITCH_GESTURE_BIT(gesture)  (1U << (gesture))
+
+/** Timings of the gestures of one button, 0 disables a gesture */
+typedef struct {
+    uint16_t double_click_ms;       /*!< Longest gap between the two presses of a double click */
+    uint16_t long_press_ms;         /*!< Press time of a long press */
+    uint16_t hold_ms;               /*!< Press time of a hold */
+} switch_gesture_config_t;
+
+/** Per-button recognizer state */
+typedef struct {
+    switch_gesture_config_t config;
+    bool pressed;
+    bool timed_out;                 /*!< The current press became a long press or a hold, it is not a click */
+    bool long_press_fired;
+    bool hold_fired;
+    uint8_t clicks;                 /*!< Short presses waiting for the double click window to pass */
+    int64_t press_us;               /*!< Time of the last press */
+    int64_t release_us;             /*!< Time of the last release */
+} switch_gesture_state_t;
+
+/**
+ * @brief Initialize a recognizer, button released
+ *
+ * @param state   The recognizer to initialize
+ * @param config  Timings of the gestures
+ */
+void switch_gesture_init(switch_gesture_state_t *state, const switch_gesture_config_t *config);
+
+/**
+ * @brief Feed a debounced press or release
+ *
+ * @param state    The recognizer
+ * @param pressed  New state of the button
+ * @param now_us   Time of the change
+ * @return The gestures recognized, as SWITCH_GESTURE_BIT()s
+ */
+uint32_t switch_gesture_input(switch_gesture_state_t *state, bool pressed, int64_t now_us);
+
+/**
+ * @brief Recognize the gestures that fire on a timeout
+ *
+ * @param state   The recognizer
+ * @param now_us  Current time
+ * @return The gestures recognized, as SWITCH_GESTURE_BIT()s
+ */
+uint32_t switch_gesture_poll(switch_gesture_state_t *state, int64_t now_us);
+
+/**
+ * @brief Time of the next switch_gesture_poll() that may recognize a gesture
+ *
+ * @param state  The recognizer
+ * @return The time, SWITCH_GESTURE_NO_DEADLINE if none
+ */
+int64_t switch_gesture_next_deadline(const switch_gesture_state_t *state);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee switch driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "switch_debounce.h"
+
+void switch_debounce_init(switch_debounce_t *db, bool pressed, uint8_t required_samples)
+{
+    db->pressed = pressed;
+    db->last_sample = pressed;
+    db->stable_samples = 0;
+    db->required_samples = required_samples ? required_samples : 1;
+    db->first_edge_us = -1;
+}
+
+void switch_debounce_edge(switch_debounce_t *db, int64_t now_us)
+{
+    if (db->first_edge_us < 0) {
+        db->first_edge_us = now_us;
+        db->stable_samples = 0;
+    }
+}
+
+switch_debounce_result_t switch_debounce_sample(switch_debounce_t *db, bool pressed)
+{
+    if (pressed == db->last_sample) {
+        if (db->stable_samples < UINT8_MAX) {
+            db->stable_samples++;
+        }
+    } else {
+        /* a bounce restarts the integration window */
+        db->last_sample = pressed;
+        db->stable_samples = 1;
+    }
+    if (db->stable_samples < db->required_samples) {
+        return SWITCH_DEBOUNCE_SAMPLE_AGAIN;
+    }
+
+    db->first_edge_us = -1;
+    if (pressed == db->pressed) {
+        return SWITCH_DEBOUNCE_SETTLED;
+    }
+    db->pressed = pressed;
+    return pressed ? SWITCH_DEBOUNCE_PRESSED : SWITCH_DEBOUNCE_RELEASED;
+}
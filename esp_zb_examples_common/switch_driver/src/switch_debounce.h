@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee switch driver example
+ *
+ * Integrator debounce core used by the switch driver. It holds no global state
+ * and never reads the clock itself: the caller feeds it samples and timestamps,
+ * which keeps it usable with a fake clock on the host.
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SWITCH_DEBOUNCE_SETTLED,        /*!< Input is stable and unchanged, re-arm the edge interrupt */
+    SWITCH_DEBOUNCE_SAMPLE_AGAIN,   /*!< Input still bouncing, sample again after one period */
+    SWITCH_DEBOUNCE_PRESSED,        /*!< Input settled in the pressed state */
+    SWITCH_DEBOUNCE_RELEASED,       /*!< Input settled in the released state */
+} switch_debounce_result_t;
+
+/** Per-pin debounce state */
+typedef struct {
+    bool pressed;               /*!< Debounced state */
+    bool last_sample;           /*!< Last raw sample */
+    uint8_t stable_samples;     /*!< Consecutive samples equal to last_sample */
+    uint8_t required_samples;   /*!< Consecutive equal samples needed to accept a new state */
+    int64_t first_edge_us;      /*!< Time of the edge that started the current debounce window, -1 when idle */
+} switch_debounce_t;
+
+/**
+ * @brief Initialize the debounce state of one pin
+ *
+ * @param db                The debounce state to initialize
+ * @param pressed           Current (assumed stable) level of the input
+ * @param required_samples  Consecutive equal samples needed to accept a new state
+ */
+void switch_debounce_init(switch_debounce_t *db, bool pressed, uint8_t required_samples);
+
+/**
+ * @brief Signal an edge on the input, the caller then schedules a sample one period later
+ *
+ * @param db      The debounce state
+ * @param now_us  Time of the edge
+ */
+void switch_debounce_edge(switch_debounce_t *db, int64_t now_us);
+
+/**
+ * @brief Feed one sample of the input
+ *
+ * @param db       The debounce state
+ * @param pressed  Raw level of the input, true when at the pressed level
+ * @return What the caller should do next, see switch_debounce_result_t
+ */
+switch_debounce_result_t switch_debounce_sample(switch_debounce_t *db, bool pressed);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
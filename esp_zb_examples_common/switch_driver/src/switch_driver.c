@@ -12,11 +12,14 @@
  * CONDITIONS OF ANY KIND, either express or implied.
  */
 
+#include <inttypes.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "freertos/queue.h"
+#include "latency_trace.h"
+#include "switch_debounce.h"
 #include "switch_driver.h"
+#include "switch_gesture.h"
 
 /**
  * @brief:
@@ -29,83 +32,154 @@
  * For other possible switch functions (on/off,level up/down,step up/down). User need to implement and create them by themselves
  */
 
-static QueueHandle_t gpio_evt_queue = NULL;
-/* button function pair, should be defined in switch example source file */
-static switch_func_pair_t *switch_func_pair;
+/* per-pin debounce and gesture context */
+typedef struct {
+    switch_func_pair_t *pair;
+    switch_debounce_t debounce;
+    switch_gesture_state_t gesture;
+    int64_t edge_us;            /* time of the last edge seen by the isr, -1 when consumed, guarded by switch_lock */
+} switch_pin_t;
+
+static switch_pin_t switch_pins[SWITCH_DRIVER_MAX_BUTTONS];
+static uint8_t switch_pin_count;
+/* one-shot timer shared by all the pins */
+static esp_timer_handle_t switch_timer;
+/* guards edge_us and switch_timer_sampling, between the isr and the timer callback */
+static portMUX_TYPE switch_lock = portMUX_INITIALIZER_UNLOCKED;
+/* the timer is armed for the debounce sample period rather than for a gesture timeout */
+static bool switch_timer_sampling;
 /* call back function pointer */
 static esp_switch_callback_t func_ptr;
-/* which button is pressed */
-static uint8_t switch_num;
 static const char *TAG = "ESP_ZB_SWITCH";
 
-static void switch_driver_gpios_intr_enabled(bool enabled);
-
 static void IRAM_ATTR gpio_isr_handler(void *arg)
 {
-    switch_driver_gpios_intr_enabled(false);
-    xQueueSendFromISR(gpio_evt_queue, (switch_func_pair_t *)arg, NULL);
+    switch_pin_t *pin = (switch_pin_t *)arg;
+    /* keep the pin quiet until the debounce timer has sampled it */
+    gpio_intr_disable(pin->pair->pin);
+    if (!pin->debounce.pressed) {
+        latency_trace_point(LATENCY_TRACE_BUTTON_EDGE);
+    }
+    portENTER_CRITICAL_ISR(&switch_lock);
+    pin->edge_us = esp_timer_get_time();
+    if (!switch_timer_sampling) {
+        /* the timer is idle or waiting for a gesture timeout, sample now and poll the gestures then */
+        switch_timer_sampling = true;
+        esp_timer_stop(switch_timer);
+        esp_timer_start_once(switch_timer, SWITCH_DEBOUNCE_SAMPLE_PERIOD_US);
+    }
+    portEXIT_CRITICAL_ISR(&switch_lock);
+}
+
+static bool switch_driver_pin_pressed(const switch_pin_t *pin)
+{
+    bool level_on = pin->pair->active_high ? 1 : GPIO_INPUT_LEVEL_ON;
+    return gpio_get_level(pin->pair->pin) == level_on;
 }
 
 /**
- * @brief Enable GPIO (switches refer to) isr
+ * @brief Arm the pin interrupt for the level opposite to the debounced state
+ *
+ * Level interrupts are used rather than edges because only a level can wake the chip from light
+ * sleep. Waiting for the opposite level gives one interrupt per press or release, and an edge that
+ * happened while the interrupt was disabled is still seen once it is enabled again.
  *
- * @param enabled      enable isr if true.
+ * @param pin      The pin to arm.
  */
-static void switch_driver_gpios_intr_enabled(bool enabled)
+static void switch_driver_arm(const switch_pin_t *pin)
 {
-    for (int i = 0; i < switch_num; ++i) {
-        if (enabled) {
-            gpio_intr_enable((switch_func_pair + i)->pin);
-        } else {
-            gpio_intr_disable((switch_func_pair + i)->pin);
+    bool level_on = pin->pair->active_high ? 1 : GPIO_INPUT_LEVEL_ON;
+    bool level = pin->debounce.pressed ? !level_on : level_on;
+    gpio_wakeup_enable(pin->pair->pin, level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    gpio_intr_enable(pin->pair->pin);
+}
+
+static void switch_driver_notify(switch_pin_t *pin, uint32_t gestures)
+{
+    for (switch_gesture_t gesture = 0; gestures; gesture++) {
+        if (gestures & SWITCH_GESTURE_BIT(gesture)) {
+            gestures &= ~SWITCH_GESTURE_BIT(gesture);
+            /* callback to button_handler */
+            (*func_ptr)(pin->pair, gesture);
         }
     }
 }
 
 /**
- * @brief Tasks for checking the button event and debounce the switch state
+ * @brief Sample a pin being debounced and feed the gesture recognizer
  *
- * @param arg      Unused value.
+ * @param pin      The pin to sample.
+ * @param now_us   Time of the sample.
+ * @return true if the pin must be sampled again
  */
-static void switch_driver_button_detected(void *arg)
+static bool switch_driver_sample_pin(switch_pin_t *pin, int64_t now_us)
 {
-    gpio_num_t io_num = GPIO_NUM_NC;
-    switch_func_pair_t button_func_pair;
-    static switch_state_t switch_state = SWITCH_IDLE;
-    bool evt_flag = false;
-
-    for (;;) {
-        /* check if there is any queue received, if yes read out the button_func_pair */
-        if (xQueueReceive(gpio_evt_queue, &button_func_pair, portMAX_DELAY)) {
-            io_num =  button_func_pair.pin;
-            switch_driver_gpios_intr_enabled(false);
-            evt_flag = true;
-        }
-        while (evt_flag) {
-            bool value = gpio_get_level(io_num);
-            switch (switch_state) {
-            case SWITCH_IDLE:
-                switch_state = (value == GPIO_INPUT_LEVEL_ON) ? SWITCH_PRESS_DETECTED : SWITCH_IDLE;
-                break;
-            case SWITCH_PRESS_DETECTED:
-                switch_state = (value == GPIO_INPUT_LEVEL_ON) ? SWITCH_PRESS_DETECTED : SWITCH_RELEASE_DETECTED;
-                break;
-            case SWITCH_RELEASE_DETECTED:
-                switch_state = SWITCH_IDLE;
-                /* callback to button_handler */
-                (*func_ptr)(&button_func_pair);
-                break;
-            default:
-                break;
-            }
-            if (switch_state == SWITCH_IDLE) {
-                switch_driver_gpios_intr_enabled(true);
-                evt_flag = false;
-                break;
-            }
-            vTaskDelay(10 / portTICK_PERIOD_MS);
-        }
+    portENTER_CRITICAL(&switch_lock);
+    int64_t edge_us = pin->edge_us;
+    pin->edge_us = -1;
+    portEXIT_CRITICAL(&switch_lock);
+    if (edge_us >= 0) {
+        switch_debounce_edge(&pin->debounce, edge_us);
+    }
+    int64_t first_edge_us = pin->debounce.first_edge_us;
+    if (first_edge_us < 0) {
+        return false;
+    }
+
+    switch (switch_debounce_sample(&pin->debounce, switch_driver_pin_pressed(pin))) {
+    case SWITCH_DEBOUNCE_SAMPLE_AGAIN:
+        return true;
+    case SWITCH_DEBOUNCE_PRESSED:
+    case SWITCH_DEBOUNCE_RELEASED:
+        latency_trace_point(LATENCY_TRACE_DEBOUNCE_DONE);
+        ESP_LOGD(TAG, "GPIO%" PRIu32 " %s, %" PRId64 " us after first edge", pin->pair->pin,
+                 pin->debounce.pressed ? "pressed" : "released", now_us - first_edge_us);
+        /* the timeouts that expired before the edge come first */
+        switch_driver_notify(pin, switch_gesture_poll(&pin->gesture, now_us));
+        switch_driver_notify(pin, switch_gesture_input(&pin->gesture, pin->debounce.pressed, now_us));
+        break;
+    default:
+        break;
+    }
+    switch_driver_arm(pin);
+    return false;
+}
+
+/**
+ * @brief Shared timer callback, samples the pins being debounced, polls the gesture timeouts, then
+ *        re-arms the timer for the next sample or the earliest timeout
+ *
+ * @param arg      Unused.
+ */
+static void switch_driver_timer_cb(void *arg)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool sampling = false;
+    int64_t deadline_us = SWITCH_GESTURE_NO_DEADLINE;
+
+    for (int i = 0; i < switch_pin_count; ++i) {
+        switch_pin_t *pin = switch_pins + i;
+        sampling |= switch_driver_sample_pin(pin, now_us);
+        switch_driver_notify(pin, switch_gesture_poll(&pin->gesture, now_us));
+        int64_t pin_deadline_us = switch_gesture_next_deadline(&pin->gesture);
+        deadline_us = pin_deadline_us < deadline_us ? pin_deadline_us : deadline_us;
+    }
+
+    portENTER_CRITICAL(&switch_lock);
+    /* an edge seen since its pin was sampled, the isr left the timer to us */
+    for (int i = 0; i < switch_pin_count && !sampling; ++i) {
+        sampling = switch_pins[i].edge_us >= 0;
     }
+    switch_timer_sampling = sampling;
+    /* the isr may have started it while the pins were sampled */
+    esp_timer_stop(switch_timer);
+    if (sampling) {
+        esp_timer_start_once(switch_timer, SWITCH_DEBOUNCE_SAMPLE_PERIOD_US);
+    } else if (deadline_us != SWITCH_GESTURE_NO_DEADLINE) {
+        int64_t delay_us = deadline_us - esp_timer_get_time();
+        esp_timer_start_once(switch_timer, delay_us > 0 ? delay_us : 0);
+    }
+    portEXIT_CRITICAL(&switch_lock);
 }
 
 /**
@@ -116,44 +190,58 @@ static void switch_driver_button_detected(void *arg)
  */
 static bool switch_driver_gpio_init(switch_func_pair_t *button_func_pair, uint8_t button_num)
 {
-    gpio_config_t io_conf = {};
-    switch_func_pair = button_func_pair;
-    switch_num = button_num;
-    uint64_t pin_bit_mask = 0;
-
-    /* set up button func pair pin mask */
-    for (int i = 0; i < button_num; ++i) {
-        pin_bit_mask |= (1ULL << (button_func_pair + i)->pin);
+    if (button_num > SWITCH_DRIVER_MAX_BUTTONS) {
+        ESP_LOGE(TAG, "%d switches, at most %d are supported", button_num, SWITCH_DRIVER_MAX_BUTTONS);
+        return false;
     }
-    /* interrupt of falling edge */
-    io_conf.intr_type = GPIO_INTR_LOW_LEVEL;
-    io_conf.pin_bit_mask = pin_bit_mask;
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pull_down_en = 0;
-    io_conf.pull_up_en = 1;
-    /* configure GPIO with the given settings */
-    gpio_config(&io_conf);
-    /* create a queue to handle gpio event from isr */
-    gpio_evt_queue = xQueueCreate(10, sizeof(switch_func_pair_t));
-    if ( gpio_evt_queue == 0) {
-        ESP_LOGE(TAG, "Queue was not created and must not be used");
+    switch_pin_count = button_num;
+
+    /* one one-shot timer for all the pins, nothing runs while the buttons are idle */
+    esp_timer_create_args_t timer_args = {
+        .callback = switch_driver_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "switch_driver",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&timer_args, &switch_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Switch timer was not created");
         return false;
     }
-    /* start gpio task */
-    xTaskCreate(switch_driver_button_detected, "button_detected", 4096, NULL, 10, NULL);
+
+    for (int i = 0; i < button_num; ++i) {
+        switch_pin_t *pin = switch_pins + i;
+        pin->pair = button_func_pair + i;
+        pin->edge_us = -1;
+        /* interrupts stay off until each pin is armed for its current level, see switch_driver_arm() */
+        gpio_config_t io_conf = {
+            .intr_type = GPIO_INTR_DISABLE,
+            .pin_bit_mask = 1ULL << pin->pair->pin,
+            .mode = GPIO_MODE_INPUT,
+            .pull_down_en = pin->pair->active_high,
+            .pull_up_en = !pin->pair->active_high,
+        };
+        /* configure GPIO with the given settings */
+        if (gpio_config(&io_conf) != ESP_OK) {
+            ESP_LOGE(TAG, "GPIO%" PRIu32 " was not configured", pin->pair->pin);
+            return false;
+        }
+        switch_debounce_init(&pin->debounce, switch_driver_pin_pressed(pin), SWITCH_DEBOUNCE_STABLE_SAMPLES);
+        switch_gesture_init(&pin->gesture, &pin->pair->gestures);
+    }
     /* install gpio isr service */
     gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
     for (int i = 0; i < button_num; ++i) {
-        gpio_isr_handler_add((button_func_pair + i)->pin, gpio_isr_handler, (void *) (button_func_pair + i));
+        gpio_isr_handler_add((button_func_pair + i)->pin, gpio_isr_handler, (void *)(switch_pins + i));
+        switch_driver_arm(switch_pins + i);
     }
     return true;
 }
 
 bool switch_driver_init(switch_func_pair_t *button_func_pair, uint8_t button_num, esp_switch_callback_t cb)
 {
+    func_ptr = cb;
     if (!switch_driver_gpio_init(button_func_pair, button_num)) {
         return false;
     }
-    func_ptr = cb;
     return true;
 }
@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Zigbee switch driver example
+ *
+ * This example code is in the Public Domain (or CC0 licensed, at your option.)
+ *
+ * Unless required by applicable law or agreed to in writing, this
+ * software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "switch_gesture.h"
+
+static int64_t switch_gesture_ms_to_us(uint16_t ms)
+{
+    return (int64_t)ms * 1000;
+}
+
+void switch_gesture_init(switch_gesture_state_t *state, const switch_gesture_config_t *config)
+{
+    *state = (switch_gesture_state_t) {
+        .config = *config,
+    };
+}
+
+uint32_t switch_gesture_input(switch_gesture_state_t *state, bool pressed, int64_t now_us)
+{
+    if (pressed == state->pressed) {
+        return 0;
+    }
+    uint32_t gestures = switch_gesture_poll(state, now_us);
+    state->pressed = pressed;
+    if (pressed) {
+        state->press_us = now_us;
+        state->timed_out = false;
+        state->long_press_fired = false;
+        state->hold_fired = false;
+        return gestures | SWITCH_GESTURE_BIT(SWITCH_GESTURE_PRESS);
+    }
+
+    state->release_us = now_us;
+    gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_RELEASE);
+    if (state->timed_out) {
+        state->clicks = 0;
+    } else if (!state->config.double_click_ms) {
+        gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_CLICK);
+    } else if (++state->clicks == 2) {
+        state->clicks = 0;
+        gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_DOUBLE_CLICK);
+    }
+    return gestures;
+}
+
+uint32_t switch_gesture_poll(switch_gesture_state_t *state, int64_t now_us)
+{
+    uint32_t gestures = 0;
+    if (state->pressed) {
+        int64_t held_us = now_us - state->press_us;
+        if (state->config.long_press_ms && !state->long_press_fired && held_us >= switch_gesture_ms_to_us(state->config.long_press_ms)) {
+            state->long_press_fired = true;
+            state->timed_out = true;
+            gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_LONG_PRESS);
+        }
+        if (state->config.hold_ms && !state->hold_fired && held_us >= switch_gesture_ms_to_us(state->config.hold_ms)) {
+            state->hold_fired = true;
+            state->timed_out = true;
+            gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_HOLD);
+        }
+    } else if (state->clicks && now_us - state->release_us >= switch_gesture_ms_to_us(state->config.double_click_ms)) {
+        state->clicks = 0;
+        gestures |= SWITCH_GESTURE_BIT(SWITCH_GESTURE_CLICK);
+    }
+    return gestures;
+}
+
+int64_t switch_gesture_next_deadline(const switch_gesture_state_t *state)
+{
+    int64_t deadline_us = SWITCH_GESTURE_NO_DEADLINE;
+    if (state->pressed) {
+        if (state->config.long_press_ms && !state->long_press_fired) {
+            deadline_us = state->press_us + switch_gesture_ms_to_us(state->config.long_press_ms);
+        }
+        if (state->config.hold_ms && !state->hold_fired) {
+            int64_t hold_us = state->press_us + switch_gesture_ms_to_us(state->config.hold_ms);
+            deadline_us = hold_us < deadline_us ? hold_us : deadline_us;
+        }
+    } else if (state->clicks) {
+        deadline_us = state->release_us + switch_gesture_ms_to_us(state->config.double_click_ms);
+    }
+    return deadline_us;
+}
@@ -28,6 +28,56 @@ extern "C" {
 /*! Maximum length of ModelIdentifier string field */
 #define ESP_ZB_ZCL_CLUSTER_ID_BASIC_MODEL_IDENTIFIER_MAX_LEN 32
 
+/*! Maximum length of a ZCL character string */
+#define ZCL_UTILITY_STRING_MAX_LEN 254
+
+/**
+ * @brief Define a length-prefixed ZCL character string from a literal, the length is computed at compile time
+ *
+ * @param name     Name of the constant to define
+ * @param literal  The string literal, without length prefix
+ */
+#define ZCL_UTILITY_STRING(name, literal)                                                           \
+    _Static_assert(sizeof(literal) - 1 <= ZCL_UTILITY_STRING_MAX_LEN, "ZCL string too long");    \
+    static const struct {                                                                           \
+        uint8_t len;                                                                                \
+        char data[sizeof(literal) - 1];                                                             \
+    } name = { sizeof(literal) - 1, literal }
+
+/** Adds a cluster to a cluster list, i.e. one of the esp_zb_cluster_list_add_*_cluster functions */
+typedef esp_err_t (*zcl_utility_cluster_add_t)(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+
+/** Adds a standard attribute to a cluster, i.e. one of the esp_zb_*_cluster_add_attr functions */
+typedef esp_err_t (*zcl_utility_attr_add_t)(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+
+/** Declarative description of one attribute */
+typedef struct zcl_utility_attr_desc_s {
+    uint16_t attr_id;
+    uint8_t attr_type;      /*!< Only used by clusters without add_attr (custom clusters) */
+    uint8_t attr_access;    /*!< Only used by clusters without add_attr (custom clusters) */
+    const void *value;      /*!< Initial value, ZCL strings must be length-prefixed (see ZCL_UTILITY_STRING) */
+} zcl_utility_attr_desc_t;
+
+/** Declarative description of one cluster */
+typedef struct zcl_utility_cluster_desc_s {
+    uint16_t cluster_id;
+    uint8_t role;                           /*!< ESP_ZB_ZCL_CLUSTER_SERVER_ROLE or ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE */
+    zcl_utility_cluster_add_t add_cluster;
+    zcl_utility_attr_add_t add_attr;        /*!< NULL for custom clusters and manufacturer attributes */
+    const zcl_utility_attr_desc_t *attrs;
+    uint8_t attr_count;
+} zcl_utility_cluster_desc_t;
+
+/** Declarative description of one endpoint */
+typedef struct zcl_utility_ep_desc_s {
+    esp_zb_endpoint_config_t config;
+    const zcl_utility_cluster_desc_t *clusters;
+    uint8_t cluster_count;
+} zcl_utility_ep_desc_t;
+
+/** Number of elements of a schema array */
+#define ZCL_UTILITY_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
 /** optional basic manufacturer information */
 typedef struct zcl_basic_manufacturer_info_s {
     char *manufacturer_name;
@@ -46,6 +96,19 @@ typedef struct zcl_basic_manufacturer_info_s {
  */
 esp_err_t esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_ep_list_t *ep_list, uint8_t endpoint_id, zcl_basic_manufacturer_info_t *info);
 
+/**
+ * @brief Instantiates the endpoints, clusters and attributes of a declarative device schema
+ *
+ * @param[in] eps The endpoint descriptions
+ * @param[in] ep_count Number of endpoint descriptions
+ * @param[out] ep_list Set to the created endpoint list, ready for esp_zb_device_register()
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NO_MEM: A list could not be allocated
+ *      - Error returned by the stack when an attribute or cluster is rejected
+ */
+esp_err_t esp_zcl_utility_build_ep_list(const zcl_utility_ep_desc_t *eps, uint8_t ep_count, esp_zb_ep_list_t **ep_list);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
\ No newline at end of file
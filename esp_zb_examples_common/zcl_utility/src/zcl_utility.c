@@ -35,3 +35,40 @@ esp_err_t esp_zcl_utility_add_ep_basic_manufacturer_info(esp_zb_ep_list_t *ep_li
     ESP_ERROR_CHECK(esp_zb_basic_cluster_add_attr(basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, info->model_identifier));
     return ret;
 }
+
+static esp_err_t zcl_utility_build_cluster(esp_zb_cluster_list_t *cluster_list, const zcl_utility_cluster_desc_t *cluster)
+{
+    esp_zb_attribute_list_t *attr_list = esp_zb_zcl_attr_list_create(cluster->cluster_id);
+    ESP_RETURN_ON_FALSE(attr_list, ESP_ERR_NO_MEM, TAG, "Failed to create cluster: 0x%x", cluster->cluster_id);
+    for (uint8_t i = 0; i < cluster->attr_count; i++) {
+        const zcl_utility_attr_desc_t *attr = cluster->attrs + i;
+        /* the stack copies the value, the schema itself stays in flash */
+        void *value = (void *)attr->value;
+        if (cluster->add_attr) {
+            ESP_RETURN_ON_ERROR(cluster->add_attr(attr_list, attr->attr_id, value), TAG, "Failed to add attribute 0x%x to cluster 0x%x",
+                                attr->attr_id, cluster->cluster_id);
+        } else {
+            ESP_RETURN_ON_ERROR(esp_zb_custom_cluster_add_custom_attr(attr_list, attr->attr_id, attr->attr_type, attr->attr_access, value),
+                                TAG, "Failed to add attribute 0x%x to custom cluster 0x%x", attr->attr_id, cluster->cluster_id);
+        }
+    }
+    ESP_RETURN_ON_ERROR(cluster->add_cluster(cluster_list, attr_list, cluster->role), TAG, "Failed to add cluster 0x%x", cluster->cluster_id);
+    return ESP_OK;
+}
+
+esp_err_t esp_zcl_utility_build_ep_list(const zcl_utility_ep_desc_t *eps, uint8_t ep_count, esp_zb_ep_list_t **ep_list)
+{
+    ESP_RETURN_ON_FALSE(eps && ep_list, ESP_ERR_INVALID_ARG, TAG, "Invalid schema");
+    *ep_list = esp_zb_ep_list_create();
+    ESP_RETURN_ON_FALSE(*ep_list, ESP_ERR_NO_MEM, TAG, "Failed to create endpoint list");
+    for (uint8_t i = 0; i < ep_count; i++) {
+        const zcl_utility_ep_desc_t *ep = eps + i;
+        esp_zb_cluster_list_t *cluster_list = esp_zb_zcl_cluster_list_create();
+        ESP_RETURN_ON_FALSE(cluster_list, ESP_ERR_NO_MEM, TAG, "Failed to create cluster list of endpoint: %d", ep->config.endpoint);
+        for (uint8_t j = 0; j < ep->cluster_count; j++) {
+            ESP_RETURN_ON_ERROR(zcl_utility_build_cluster(cluster_list, ep->clusters + j), TAG, "Failed to build endpoint: %d", ep->config.endpoint);
+        }
+        ESP_RETURN_ON_ERROR(esp_zb_ep_list_add_ep(*ep_list, cluster_list, ep->config), TAG, "Failed to add endpoint: %d", ep->config.endpoint);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "attr_registry.h"
+#include "esp_check.h"
+
+static const char *TAG = "ATTR_REGISTRY";
+
+_Static_assert((ATTR_REGISTRY_HASH_SIZE & (ATTR_REGISTRY_HASH_SIZE - 1)) == 0, "ATTR_REGISTRY_HASH_SIZE must be a power of two");
+
+static attr_registry_entry_t *s_buckets[ATTR_REGISTRY_HASH_SIZE];
+
+static uint32_t attr_registry_hash(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    uint32_t key = ((uint32_t)endpoint << 24) ^ ((uint32_t)cluster_id << 8) ^ attr_id ^ ((uint32_t)attr_id << 16);
+    /* Knuth multiplicative hash, the top bits are the best mixed */
+    return (key * 2654435761u) >> (32 - __builtin_ctz(ATTR_REGISTRY_HASH_SIZE));
+}
+
+static bool attr_registry_match(const attr_registry_entry_t *entry, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    return entry->endpoint == endpoint && entry->cluster_id == cluster_id && entry->attr_id == attr_id;
+}
+
+esp_err_t attr_registry_init(attr_registry_entry_t *entries, uint16_t count)
+{
+    ESP_RETURN_ON_FALSE(count * 2 <= ATTR_REGISTRY_HASH_SIZE, ESP_ERR_NO_MEM, TAG, "Too many attributes (%d)", count);
+    for (uint16_t i = 0; i < count; i++) {
+        attr_registry_entry_t *entry = entries + i;
+        entry->attr = esp_zb_zcl_get_attribute(entry->endpoint, entry->cluster_id, entry->cluster_role, entry->attr_id);
+        ESP_RETURN_ON_FALSE(entry->attr, ESP_ERR_NOT_FOUND, TAG, "Attribute not found: endpoint(%d), cluster(0x%x), attribute(0x%x)",
+                            entry->endpoint, entry->cluster_id, entry->attr_id);
+        uint32_t bucket = attr_registry_hash(entry->endpoint, entry->cluster_id, entry->attr_id);
+        while (s_buckets[bucket]) {
+            bucket = (bucket + 1) & (ATTR_REGISTRY_HASH_SIZE - 1);
+        }
+        s_buckets[bucket] = entry;
+    }
+    return ESP_OK;
+}
+
+attr_registry_entry_t *attr_registry_find(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    uint32_t bucket = attr_registry_hash(endpoint, cluster_id, attr_id);
+    /* the table is at most half full, so probing always ends on an empty bucket */
+    while (s_buckets[bucket]) {
+        if (attr_registry_match(s_buckets[bucket], endpoint, cluster_id, attr_id)) {
+            return s_buckets[bucket];
+        }
+        bucket = (bucket + 1) & (ATTR_REGISTRY_HASH_SIZE - 1);
+    }
+    return NULL;
+}
+
+esp_err_t attr_registry_dispatch(const esp_zb_zcl_set_attr_value_message_t *message)
+{
+    attr_registry_entry_t *entry = attr_registry_find(message->info.dst_endpoint, message->info.cluster, message->attribute.id);
+    if (!entry || !entry->on_write) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_RETURN_ON_FALSE(message->attribute.data.type == entry->attr_type && message->attribute.data.value, ESP_ERR_INVALID_ARG, TAG,
+                        "Unexpected data: cluster(0x%x), attribute(0x%x), type(0x%x)", message->info.cluster, message->attribute.id,
+                        message->attribute.data.type);
+    entry->on_write(message->attribute.data.value);
+    return ESP_OK;
+}
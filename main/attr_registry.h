@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Registry of the attributes owned by this firmware. The attribute pointers are
+ * resolved once after esp_zb_device_register() and indexed by
+ * (endpoint, cluster, attribute) in a small open-addressing hash table, which
+ * replaces per-event esp_zb_zcl_get_attribute() walks and the nested switch of
+ * the attribute write handler.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hash table size, power of two and at least twice the number of registered attributes */
+#define ATTR_REGISTRY_HASH_SIZE     64
+
+/**
+ * @brief Called when the stack reports a new value of a registered attribute
+ *
+ * @param value  The new value, already checked against the registered type
+ */
+typedef void (*attr_registry_write_cb_t)(const void *value);
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t attr_id;
+    uint8_t attr_type;                  /*!< Expected esp_zb_zcl_attr_type_t of written values */
+    attr_registry_write_cb_t on_write;  /*!< Write handler, NULL for attributes only written locally */
+    esp_zb_zcl_attr_t *attr;            /*!< Resolved by attr_registry_init() */
+} attr_registry_entry_t;
+
+/**
+ * @brief Resolve and index the attributes of a table
+ *
+ * @note Must be called from the Zigbee task after esp_zb_device_register().
+ *
+ * @param entries  The attribute table, must stay valid for the lifetime of the application
+ * @param count    Number of entries in the table
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NOT_FOUND: An attribute is not part of the registered endpoints
+ *      - ESP_ERR_NO_MEM: The table does not fit ATTR_REGISTRY_HASH_SIZE
+ */
+esp_err_t attr_registry_init(attr_registry_entry_t *entries, uint16_t count);
+
+/**
+ * @brief Find a registered attribute
+ *
+ * @return The registry entry, NULL if the attribute is not registered
+ */
+attr_registry_entry_t *attr_registry_find(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id);
+
+/**
+ * @brief Route an attribute write from the stack to the handler of the attribute
+ *
+ * @param message  The ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID message
+ * @return
+ *      - ESP_OK: The handler has been called
+ *      - ESP_ERR_NOT_FOUND: The attribute is not registered or has no write handler
+ *      - ESP_ERR_INVALID_ARG: The value has an unexpected type or is missing
+ */
+esp_err_t attr_registry_dispatch(const esp_zb_zcl_set_attr_value_message_t *message);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,150 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "attr_reporter.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "latency_trace.h"
+#include "report_frame.h"
+#include "zboss_api.h"
+
+static const char *TAG = "ATTR_REPORTER";
+
+static attr_reporter_t *s_reporters[ATTR_REPORTER_MAX];
+static uint8_t s_reporter_count;
+static bool s_flush_scheduled;
+static uint8_t s_frame[ATTR_REPORTER_FRAME_SIZE];
+
+static int64_t attr_reporter_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+/* Pick up intervals set by a Configure Reporting command from the coordinator, if any, and keep the stack from reporting the
+   attribute as well */
+static void attr_reporter_refresh_intervals(attr_reporter_t *reporter)
+{
+    esp_zb_zcl_attr_location_info_t location = {
+        .endpoint_id = reporter->endpoint,
+        .cluster_id = reporter->cluster_id,
+        .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+        .attr_id = reporter->attr_id,
+    };
+    esp_zb_zcl_reporting_info_t *info = esp_zb_zcl_find_reporting_info(location);
+    if (info) {
+        report_coalescer_set_intervals(&reporter->coalescer, info->u.send_info.min_interval, info->u.send_info.max_interval);
+        esp_zb_zcl_stop_attr_reporting(location);
+    }
+}
+
+static void attr_reporter_send(uint8_t endpoint, uint16_t cluster_id, const report_frame_t *frame)
+{
+    /* through the binding table, like the stack's own reports */
+    esp_zb_apsde_data_req_t req = {
+        .dst_addr_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+        .cluster_id = cluster_id,
+        .src_endpoint = endpoint,
+        .asdu_length = frame->length,
+        .asdu = frame->data,
+        .tx_options = ESP_ZB_APSDE_TX_OPT_ACK_TX,
+    };
+    esp_err_t err = esp_zb_aps_data_request(&req);
+    latency_trace_point(LATENCY_TRACE_REPORT_REQUEST);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to report endpoint(%d) cluster(0x%x): %s", endpoint, cluster_id, esp_err_to_name(err));
+    }
+}
+
+/* Send one frame with the due attributes of the cluster of first, those that do not fit stay due */
+static void attr_reporter_send_frame(attr_reporter_t *first)
+{
+    report_frame_t frame;
+    /* the sequence the stack numbers its own ZCL frames with, so that no two frames in flight share a TSN */
+    report_frame_init(&frame, s_frame, sizeof(s_frame), ZB_ZCL_GET_SEQ_NUM());
+    for (uint8_t i = first->index; i < s_reporter_count; i++) {
+        attr_reporter_t *reporter = s_reporters[i];
+        if (!reporter->due || reporter->endpoint != first->endpoint || reporter->cluster_id != first->cluster_id) {
+            continue;
+        }
+        esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(reporter->endpoint, reporter->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                           reporter->attr_id);
+        if (attr && report_frame_add(&frame, reporter->attr_id, attr->type, attr->data_p)) {
+            reporter->due = false;
+        } else if (reporter == first) {
+            ESP_LOGW(TAG, "Cannot report cluster(0x%x) attribute(0x%x)", reporter->cluster_id, reporter->attr_id);
+            reporter->due = false;
+            return;
+        }
+    }
+    attr_reporter_send(first->endpoint, first->cluster_id, &frame);
+}
+
+static void attr_reporter_flush_cb(uint8_t param)
+{
+    s_flush_scheduled = false;
+    for (uint8_t i = 0; i < s_reporter_count; i++) {
+        while (s_reporters[i]->due) {
+            attr_reporter_send_frame(s_reporters[i]);
+        }
+    }
+}
+
+static void attr_reporter_mark_due(attr_reporter_t *reporter)
+{
+    reporter->due = true;
+    if (!s_flush_scheduled) {
+        s_flush_scheduled = true;
+        esp_zb_scheduler_alarm((esp_zb_callback_t)attr_reporter_flush_cb, 0, ATTR_REPORTER_GATHER_MS);
+    }
+}
+
+static void attr_reporter_alarm_cb(uint8_t index);
+
+static void attr_reporter_schedule(attr_reporter_t *reporter, int64_t next_ms)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)attr_reporter_alarm_cb, reporter->index);
+    if (next_ms == REPORT_COALESCER_NO_DEADLINE) {
+        return;
+    }
+    int64_t delay_ms = next_ms - attr_reporter_now_ms();
+    esp_zb_scheduler_alarm((esp_zb_callback_t)attr_reporter_alarm_cb, reporter->index, delay_ms > 0 ? (uint32_t)delay_ms : 0);
+}
+
+static void attr_reporter_alarm_cb(uint8_t index)
+{
+    attr_reporter_t *reporter = s_reporters[index];
+    int64_t next_ms;
+    attr_reporter_refresh_intervals(reporter);
+    if (report_coalescer_poll(&reporter->coalescer, attr_reporter_now_ms(), &next_ms)) {
+        attr_reporter_mark_due(reporter);
+    }
+    attr_reporter_schedule(reporter, next_ms);
+}
+
+esp_err_t attr_reporter_register(attr_reporter_t *reporter, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                                 uint32_t window_ms, uint32_t reportable_change)
+{
+    ESP_RETURN_ON_FALSE(s_reporter_count < ATTR_REPORTER_MAX, ESP_ERR_NO_MEM, TAG, "Too many attribute reporters");
+    reporter->endpoint = endpoint;
+    reporter->cluster_id = cluster_id;
+    reporter->attr_id = attr_id;
+    reporter->index = s_reporter_count;
+    reporter->due = false;
+    report_coalescer_init(&reporter->coalescer, window_ms, reportable_change);
+    s_reporters[s_reporter_count++] = reporter;
+    return ESP_OK;
+}
+
+void attr_reporter_update(attr_reporter_t *reporter, int32_t value)
+{
+    attr_reporter_refresh_intervals(reporter);
+    attr_reporter_schedule(reporter, report_coalescer_update(&reporter->coalescer, value, attr_reporter_now_ms()));
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Coalesced attribute reporting driven by the Zigbee scheduler. Each reporter
+ * watches one server attribute and reports it only when its report_coalescer_t
+ * says so. The reports that fall due together, e.g. Occupancy and
+ * ThermostatRunningState, are sent as one Report Attributes frame per endpoint
+ * and cluster: the ZCL allows one cluster per frame.
+ *
+ * These attributes are reported here only. When the coordinator configures their
+ * reporting, the reporter takes its intervals over and stops the stack's own
+ * reporting of them, which would send every change a second time.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "report_coalescer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of attributes reported through attr_reporter */
+#define ATTR_REPORTER_MAX           8
+
+/* Reports falling due within this delay of the first one are sent together */
+#define ATTR_REPORTER_GATHER_MS     10
+/* Largest report frame, the APS payload that is sent without fragmentation on a secured network */
+#define ATTR_REPORTER_FRAME_SIZE    82
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t index;                  /*!< Slot in the reporter table, used as scheduler alarm parameter */
+    bool due;                       /*!< Waiting for the next frame of its cluster */
+    report_coalescer_t coalescer;
+} attr_reporter_t;
+
+/**
+ * @brief Register a reporter for a server attribute
+ *
+ * @param reporter           The reporter, must stay valid for the lifetime of the application
+ * @param endpoint           Endpoint of the attribute
+ * @param cluster_id         Cluster of the attribute
+ * @param attr_id            Attribute identifier
+ * @param window_ms          Changes within this window are merged into one report
+ * @param reportable_change  Smallest change worth a report
+ * @return
+ *      - ESP_OK: On success
+ *      - ESP_ERR_NO_MEM: ATTR_REPORTER_MAX reporters are already registered
+ */
+esp_err_t attr_reporter_register(attr_reporter_t *reporter, uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id,
+                                 uint32_t window_ms, uint32_t reportable_change);
+
+/**
+ * @brief Notify the reporter that the attribute value changed
+ *
+ * @note Must be called from the Zigbee task or with the Zigbee lock held, after the
+ *       attribute itself has been updated with esp_zb_zcl_set_attribute_val().
+ *
+ * @param reporter  The reporter of the attribute
+ * @param value     The new value of the attribute
+ */
+void attr_reporter_update(attr_reporter_t *reporter, int32_t value);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,114 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include "boot_stage.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "BOOT_STAGE";
+
+static const char *const s_phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_APP_MAIN] = "app_main",
+    [BOOT_PHASE_DRIVERS_READY] = "drivers",
+    [BOOT_PHASE_STACK_READY] = "stack",
+    [BOOT_PHASE_NETWORK_READY] = "network",
+    [BOOT_PHASE_FIRST_INPUT] = "first input",
+    [BOOT_PHASE_FIRST_RESPONSE] = "first response",
+};
+
+typedef struct {
+    esp_zb_callback_t cb;
+    uint8_t param;
+} boot_stage_action_t;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_phase_us[BOOT_PHASE_COUNT];
+static boot_stage_action_t s_queue[BOOT_STAGE_QUEUE_SIZE];
+static uint8_t s_queue_head;
+static uint8_t s_queue_count;
+static bool s_stack_ready;
+
+void boot_stage_mark(boot_phase_t phase)
+{
+    boot_stage_mark_at(phase, esp_timer_get_time());
+}
+
+void boot_stage_mark_at(boot_phase_t phase, int64_t time_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (s_phase_us[phase] == 0) {
+        s_phase_us[phase] = time_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+int64_t boot_stage_time_us(boot_phase_t phase)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t time_us = s_phase_us[phase];
+    portEXIT_CRITICAL(&s_lock);
+    return time_us;
+}
+
+void boot_stage_log(void)
+{
+    for (boot_phase_t phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        int64_t time_us = boot_stage_time_us(phase);
+        if (time_us) {
+            ESP_LOGI(TAG, "%s at %" PRId64 " us", s_phase_names[phase], time_us);
+        }
+    }
+}
+
+esp_err_t boot_stage_run(esp_zb_callback_t cb, uint8_t param)
+{
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&s_lock);
+    bool stack_ready = s_stack_ready;
+    if (!stack_ready) {
+        if (s_queue_count < BOOT_STAGE_QUEUE_SIZE) {
+            s_queue[(s_queue_head + s_queue_count++) % BOOT_STAGE_QUEUE_SIZE] = (boot_stage_action_t) { cb, param };
+        } else {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (stack_ready) {
+        esp_zb_lock_acquire(portMAX_DELAY);
+        cb(param);
+        esp_zb_lock_release();
+    }
+    return ret;
+}
+
+void boot_stage_stack_ready(void)
+{
+    /* the lock keeps the actions arriving during the replay behind the queued ones */
+    esp_zb_lock_acquire(portMAX_DELAY);
+    for (;;) {
+        boot_stage_action_t action;
+        portENTER_CRITICAL(&s_lock);
+        bool empty = s_queue_count == 0;
+        if (empty) {
+            s_stack_ready = true;
+        } else {
+            action = s_queue[s_queue_head];
+            s_queue_head = (s_queue_head + 1) % BOOT_STAGE_QUEUE_SIZE;
+            s_queue_count--;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (empty) {
+            break;
+        }
+        action.cb(action.param);
+    }
+    esp_zb_lock_release();
+    boot_stage_mark(BOOT_PHASE_STACK_READY);
+}
@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Staged boot: the drivers and the local controls start from app_main, before
+ * the Zigbee stack. Actions that need the stack (attribute store, scheduler,
+ * reports) are queued until the Zigbee task has started it, then replayed in
+ * order. The time each boot phase is first reached is recorded so that the
+ * time to the first button response can be measured.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Actions queued before the stack is up, further ones are dropped */
+#define BOOT_STAGE_QUEUE_SIZE   8
+
+typedef enum {
+    BOOT_PHASE_APP_MAIN,        /*!< app_main() entered */
+    BOOT_PHASE_DRIVERS_READY,   /*!< LED strip and buttons running */
+    BOOT_PHASE_STACK_READY,     /*!< Zigbee stack started, queued actions replayed */
+    BOOT_PHASE_NETWORK_READY,   /*!< Joined or rejoined the network */
+    BOOT_PHASE_FIRST_INPUT,     /*!< First button or switch edge */
+    BOOT_PHASE_FIRST_RESPONSE,  /*!< First input applied */
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+/**
+ * @brief Record that a phase is reached now, only the first time counts
+ *
+ * @param phase  The phase
+ */
+void boot_stage_mark(boot_phase_t phase);
+
+/**
+ * @brief Record that a phase was reached at a given time, only the first time counts
+ *
+ * @param phase    The phase
+ * @param time_us  esp_timer time at which it was reached
+ */
+void boot_stage_mark_at(boot_phase_t phase, int64_t time_us);
+
+/**
+ * @brief Get the time a phase was first reached
+ *
+ * @param phase  The phase
+ * @return esp_timer time in microseconds, 0 if not reached yet
+ */
+int64_t boot_stage_time_us(boot_phase_t phase);
+
+/**
+ * @brief Log the time of the phases reached so far
+ */
+void boot_stage_log(void);
+
+/**
+ * @brief Run an action in the Zigbee context
+ *
+ * Runs it right away with the Zigbee lock held once the stack is up, queues it until then.
+ *
+ * @note Must not be called from the Zigbee task.
+ *
+ * @param cb     The action
+ * @param param  Its parameter
+ * @return
+ *      - ESP_OK: The action has run or is queued
+ *      - ESP_ERR_NO_MEM: The queue is full, the action is dropped
+ */
+esp_err_t boot_stage_run(esp_zb_callback_t cb, uint8_t param);
+
+/**
+ * @brief Replay the queued actions and run the following ones directly, call from the Zigbee task once started
+ */
+void boot_stage_stack_ready(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "command_tracker.h"
+
+void command_tracker_init(command_tracker_t *tracker, uint32_t timeout_ms, uint8_t max_attempts)
+{
+    *tracker = (command_tracker_t) {
+        .timeout_ms = timeout_ms,
+        .max_attempts = max_attempts ? max_attempts : 1,
+        .deadline_ms = COMMAND_TRACKER_NO_DEADLINE,
+    };
+}
+
+void command_tracker_clear_targets(command_tracker_t *tracker)
+{
+    tracker->target_count = 0;
+}
+
+bool command_tracker_add_target(command_tracker_t *tracker, uint16_t short_addr, uint8_t endpoint)
+{
+    for (uint8_t i = 0; i < tracker->target_count; i++) {
+        if (tracker->targets[i].short_addr == short_addr && tracker->targets[i].endpoint == endpoint) {
+            return false;
+        }
+    }
+    if (tracker->target_count == COMMAND_TRACKER_MAX_TARGETS) {
+        return false;
+    }
+    /* a target added while a command is pending was not there to receive it */
+    tracker->targets[tracker->target_count++] = (command_tracker_target_t) {
+        .short_addr = short_addr,
+        .endpoint = endpoint,
+        .acked = !tracker->pending,
+    };
+    return true;
+}
+
+int64_t command_tracker_sent(command_tracker_t *tracker, uint8_t tsn, bool retry, int64_t now_ms)
+{
+    if (!retry || !tracker->pending) {
+        for (uint8_t i = 0; i < tracker->target_count; i++) {
+            tracker->targets[i].acked = false;
+        }
+        tracker->attempts = 0;
+        tracker->sent_ms = now_ms;
+    }
+    tracker->tsn = tsn;
+    tracker->attempts++;
+    /* with no target known there is no acknowledgement to wait for */
+    tracker->pending = tracker->target_count > 0;
+    tracker->deadline_ms = tracker->pending ? now_ms + tracker->timeout_ms : COMMAND_TRACKER_NO_DEADLINE;
+    return tracker->deadline_ms;
+}
+
+bool command_tracker_ack(command_tracker_t *tracker, uint8_t tsn, uint16_t short_addr, uint8_t endpoint)
+{
+    if (!tracker->pending || tsn != tracker->tsn) {
+        return false;
+    }
+    bool done = true;
+    for (uint8_t i = 0; i < tracker->target_count; i++) {
+        command_tracker_target_t *target = &tracker->targets[i];
+        if (target->short_addr == short_addr && target->endpoint == endpoint) {
+            target->acked = true;
+        }
+        done &= target->acked;
+    }
+    if (done) {
+        tracker->pending = false;
+        tracker->deadline_ms = COMMAND_TRACKER_NO_DEADLINE;
+    }
+    return done;
+}
+
+command_tracker_event_t command_tracker_poll(command_tracker_t *tracker, int64_t now_ms, int64_t *next_ms)
+{
+    if (!tracker->pending || now_ms < tracker->deadline_ms) {
+        *next_ms = tracker->deadline_ms;
+        return COMMAND_TRACKER_IDLE;
+    }
+    *next_ms = COMMAND_TRACKER_NO_DEADLINE;
+    if (tracker->attempts < tracker->max_attempts) {
+        /* the caller sends the next attempt and calls command_tracker_sent() again */
+        tracker->deadline_ms = COMMAND_TRACKER_NO_DEADLINE;
+        return COMMAND_TRACKER_RETRY;
+    }
+    tracker->pending = false;
+    tracker->deadline_ms = COMMAND_TRACKER_NO_DEADLINE;
+    return COMMAND_TRACKER_FAILED;
+}
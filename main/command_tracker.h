@@ -0,0 +1,113 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Acknowledgement tracking of a command sent through the binding table. The
+ * stack delivers it to every bound target, each of which answers with its own
+ * Default Response; the command is done once all the known targets have
+ * acknowledged it, and it is repeated after a timeout until the attempts run
+ * out. Only the latest command matters: a new one supersedes the pending one,
+ * so the commands must be idempotent (On and Off rather than Toggle).
+ *
+ * Time is always passed in by the caller (milliseconds, any monotonic origin)
+ * and the module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMAND_TRACKER_MAX_TARGETS     4
+
+/* No deadline pending */
+#define COMMAND_TRACKER_NO_DEADLINE     INT64_MAX
+
+typedef enum {
+    COMMAND_TRACKER_IDLE,       /*!< Nothing to do */
+    COMMAND_TRACKER_RETRY,      /*!< Some targets did not answer in time, send the command again */
+    COMMAND_TRACKER_FAILED,     /*!< Some targets did not answer any attempt, the command is dropped */
+} command_tracker_event_t;
+
+typedef struct {
+    uint16_t short_addr;
+    uint8_t endpoint;
+    bool acked;                 /*!< The pending command has been acknowledged by this target */
+} command_tracker_target_t;
+
+typedef struct {
+    uint32_t timeout_ms;        /*!< Wait for the acknowledgements of one attempt */
+    uint8_t max_attempts;       /*!< Attempts of a command, the first one included */
+    uint8_t target_count;
+    command_tracker_target_t targets[COMMAND_TRACKER_MAX_TARGETS];
+    bool pending;               /*!< A command awaits acknowledgements */
+    uint8_t tsn;                /*!< ZCL transaction sequence number of the last attempt */
+    uint8_t attempts;
+    int64_t sent_ms;            /*!< Time of the first attempt */
+    int64_t deadline_ms;        /*!< End of the current attempt */
+} command_tracker_t;
+
+/**
+ * @brief Initialize a tracker without targets
+ *
+ * @param tracker       The tracker to initialize
+ * @param timeout_ms    Wait for the acknowledgements of one attempt, in milliseconds
+ * @param max_attempts  Attempts of a command, the first one included
+ */
+void command_tracker_init(command_tracker_t *tracker, uint32_t timeout_ms, uint8_t max_attempts);
+
+/**
+ * @brief Forget the targets, e.g. before reading the binding table again
+ *
+ * @param tracker  The tracker
+ */
+void command_tracker_clear_targets(command_tracker_t *tracker);
+
+/**
+ * @brief Add a bound target whose acknowledgement is awaited
+ *
+ * @param tracker     The tracker
+ * @param short_addr  Network address of the target
+ * @param endpoint    Endpoint of the target
+ * @return false if the target is already known or COMMAND_TRACKER_MAX_TARGETS are
+ */
+bool command_tracker_add_target(command_tracker_t *tracker, uint16_t short_addr, uint8_t endpoint);
+
+/**
+ * @brief Record that a command, or an attempt of the pending one, has been sent
+ *
+ * @param tracker  The tracker
+ * @param tsn      ZCL transaction sequence number of the frame
+ * @param retry    false for a new command, which supersedes the pending one
+ * @param now_ms   Current time
+ * @return Next time command_tracker_poll() must be called, COMMAND_TRACKER_NO_DEADLINE if none
+ */
+int64_t command_tracker_sent(command_tracker_t *tracker, uint8_t tsn, bool retry, int64_t now_ms);
+
+/**
+ * @brief Record a Default Response
+ *
+ * @param tracker     The tracker
+ * @param tsn         ZCL transaction sequence number of the response
+ * @param short_addr  Network address of the sender
+ * @param endpoint    Endpoint of the sender
+ * @return true if it was the last acknowledgement awaited, the command is done
+ */
+bool command_tracker_ack(command_tracker_t *tracker, uint8_t tsn, uint16_t short_addr, uint8_t endpoint);
+
+/**
+ * @brief Check whether the current attempt timed out
+ *
+ * @param tracker  The tracker
+ * @param now_ms   Current time
+ * @param next_ms  Set to the next time this function must be called, COMMAND_TRACKER_NO_DEADLINE if none
+ * @return What the caller must do now
+ */
+command_tracker_event_t command_tracker_poll(command_tracker_t *tracker, int64_t now_ms, int64_t *next_ms);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include "commissioning.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "join_backoff.h"
+#include "nvs.h"
+
+static const char *TAG = "COMMISSIONING";
+
+static join_backoff_t s_backoff;
+static uint16_t s_pan_id;
+static int64_t s_start_us;
+
+static void commissioning_steering_cb(uint8_t param)
+{
+    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING) == ESP_OK, , TAG,
+                        "Failed to start network steering");
+}
+
+static void commissioning_attempt(join_backoff_attempt_t attempt)
+{
+    esp_zb_set_primary_network_channel_set(attempt.channel_mask);
+    if (attempt.channel_mask == 1UL << s_backoff.last_channel) {
+        ESP_LOGI(TAG, "Steering on channel %d (PAN ID 0x%04hx) in %" PRIu32 " ms", s_backoff.last_channel, s_pan_id, attempt.delay_ms);
+    } else {
+        ESP_LOGI(TAG, "Steering on all channels in %" PRIu32 " ms", attempt.delay_ms);
+    }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)commissioning_steering_cb, 0, attempt.delay_ms);
+}
+
+static void commissioning_save(uint8_t channel, uint16_t pan_id)
+{
+    if (channel == s_backoff.last_channel && pan_id == s_pan_id) {
+        return;
+    }
+    nvs_handle_t handle;
+    ESP_RETURN_ON_FALSE(nvs_open(COMMISSIONING_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK, , TAG, "Failed to open NVS namespace");
+    if (nvs_set_u8(handle, "channel", channel) != ESP_OK || nvs_set_u16(handle, "pan_id", pan_id) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save the network");
+    }
+    nvs_close(handle);
+}
+
+esp_err_t commissioning_init(uint32_t all_channels_mask)
+{
+    uint8_t channel = JOIN_BACKOFF_NO_CHANNEL;
+    nvs_handle_t handle;
+    if (nvs_open(COMMISSIONING_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        if (nvs_get_u8(handle, "channel", &channel) != ESP_OK || nvs_get_u16(handle, "pan_id", &s_pan_id) != ESP_OK) {
+            channel = JOIN_BACKOFF_NO_CHANNEL;
+        }
+        nvs_close(handle);
+    }
+    join_backoff_config_t config = {
+        .all_channels_mask = all_channels_mask,
+        .last_channel_tries = COMMISSIONING_LAST_CHANNEL_TRIES,
+        .first_delay_ms = COMMISSIONING_FIRST_DELAY_MS,
+        .max_delay_ms = COMMISSIONING_MAX_DELAY_MS,
+    };
+    join_backoff_init(&s_backoff, &config, channel);
+    return esp_zb_set_primary_network_channel_set(all_channels_mask);
+}
+
+void commissioning_start(void)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)commissioning_steering_cb, 0);
+    s_start_us = esp_timer_get_time();
+    commissioning_attempt(join_backoff_start(&s_backoff));
+}
+
+esp_err_t commissioning_erase(void)
+{
+    nvs_handle_t handle;
+    ESP_RETURN_ON_ERROR(nvs_open(COMMISSIONING_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+    esp_err_t err = nvs_erase_all(handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to erase the network");
+    s_pan_id = 0;
+    s_backoff.last_channel = JOIN_BACKOFF_NO_CHANNEL;
+    return ESP_OK;
+}
+
+void commissioning_steering_done(esp_err_t status)
+{
+    if (status != ESP_OK) {
+        commissioning_attempt(join_backoff_failed(&s_backoff, esp_random()));
+        return;
+    }
+    uint8_t channel = esp_zb_get_current_channel();
+    ESP_LOGI(TAG, "Joined in %" PRId64 " ms after %u attempts, %" PRIu32 " channel scans", (esp_timer_get_time() - s_start_us) / 1000,
+             s_backoff.attempts, s_backoff.channels_scanned);
+    commissioning_save(channel, esp_zb_get_pan_id());
+    s_pan_id = esp_zb_get_pan_id();
+    join_backoff_joined(&s_backoff, channel);
+}
@@ -0,0 +1,64 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Network steering with retries: the channel and PAN ID of the last network
+ * joined are kept in NVS, the steering tries that channel alone first and then
+ * falls back to scanning every channel with a jittered exponential backoff (see
+ * join_backoff.h).
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMISSIONING_NAMESPACE             "commissioning"
+
+/* Attempts on the last channel alone before scanning all the channels */
+#define COMMISSIONING_LAST_CHANNEL_TRIES    2
+/* Retry delays, the backoff doubles from the first delay up to the max delay */
+#define COMMISSIONING_FIRST_DELAY_MS        1000
+#define COMMISSIONING_MAX_DELAY_MS          (5 * 60 * 1000)
+
+/**
+ * @brief Read the last network joined, call once before esp_zb_start()
+ *
+ * @param all_channels_mask  Channels scanned once the last channel has failed
+ */
+esp_err_t commissioning_init(uint32_t all_channels_mask);
+
+/**
+ * @brief Start network steering, on the first start and whenever the network is lost
+ *
+ * An attempt already scheduled is replaced, the backoff starts over.
+ *
+ * @note Must be called from the Zigbee task.
+ */
+void commissioning_start(void);
+
+/**
+ * @brief Forget the last network joined, call on a factory reset before esp_zb_factory_reset()
+ *
+ * @return
+ *      - ESP_OK: On success
+ *      - Others: NVS errors
+ */
+esp_err_t commissioning_erase(void);
+
+/**
+ * @brief Handle the result of a network steering, on ESP_ZB_BDB_SIGNAL_STEERING
+ *
+ * Saves the network on success, schedules the next attempt on failure.
+ *
+ * @param status  Status of the steering signal
+ */
+void commissioning_steering_done(esp_err_t status);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
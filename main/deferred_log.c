@@ -0,0 +1,213 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "deferred_log.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "memory_report.h"
+
+_Static_assert((DEFERRED_LOG_RING_SIZE & (DEFERRED_LOG_RING_SIZE - 1)) == 0, "DEFERRED_LOG_RING_SIZE must be a power of two");
+
+static const char *TAG = "DEFERRED_LOG";
+
+typedef struct {
+    /* slot owner: equals the write position when free, the write position + 1 once the record is complete */
+    atomic_uint sequence;
+    uint8_t level;
+    uint8_t argc;
+    uint32_t timestamp_ms;
+    const char *tag;
+    const char *format;
+    uint32_t args[DEFERRED_LOG_ARGS_MAX];
+} deferred_log_record_t;
+
+/* Bounded multi-producer ring: producers reserve a slot with a compare-and-swap on the write position and
+   publish it through its sequence, the single consumer never writes the write position */
+static deferred_log_record_t s_ring[DEFERRED_LOG_RING_SIZE];
+static atomic_uint s_write_pos;
+static unsigned s_read_pos;
+static atomic_uint s_dropped;
+static TaskHandle_t s_task;
+static StackType_t s_task_stack[DEFERRED_LOG_TASK_STACK_SIZE];
+static StaticTask_t s_task_buffer;
+
+/* in IRAM like the interrupt handlers calling it, esp_timer_get_time() and the notification functions are too */
+void IRAM_ATTR deferred_log_write(esp_log_level_t level, const char *tag, const char *format, const uint32_t *args, uint32_t argc)
+{
+    unsigned pos = atomic_load_explicit(&s_write_pos, memory_order_relaxed);
+    deferred_log_record_t *record;
+    for (;;) {
+        record = &s_ring[pos & (DEFERRED_LOG_RING_SIZE - 1)];
+        int diff = (int)(atomic_load_explicit(&record->sequence, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&s_write_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* the consumer has not freed this slot yet, the ring is full */
+            atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&s_write_pos, memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    record->argc = argc < DEFERRED_LOG_ARGS_MAX ? argc : DEFERRED_LOG_ARGS_MAX;
+    record->timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    record->tag = tag;
+    record->format = format;
+    for (int i = 0; i < record->argc; i++) {
+        record->args[i] = args[i];
+    }
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+
+    if (s_task) {
+        if (xPortInIsrContext()) {
+            /* the printer has the lowest priority, no need to yield to it */
+            vTaskNotifyGiveFromISR(s_task, NULL);
+        } else {
+            xTaskNotifyGive(s_task);
+        }
+    }
+}
+
+static bool deferred_log_print_next(void)
+{
+    static const char level_letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    deferred_log_record_t *record = &s_ring[s_read_pos & (DEFERRED_LOG_RING_SIZE - 1)];
+    if (atomic_load_explicit(&record->sequence, memory_order_acquire) != s_read_pos + 1) {
+        return false;
+    }
+    /* unused arguments are passed too, printf ignores them */
+    esp_log_write(record->level, record->tag, "%c (%" PRIu32 ") %s: ", level_letters[record->level], record->timestamp_ms, record->tag);
+    esp_log_write(record->level, record->tag, record->format, record->args[0], record->args[1], record->args[2], record->args[3]);
+    esp_log_write(record->level, record->tag, "\n");
+    atomic_store_explicit(&record->sequence, s_read_pos + DEFERRED_LOG_RING_SIZE, memory_order_release);
+    s_read_pos++;
+    return true;
+}
+
+static void deferred_log_task(void *pvParameters)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (deferred_log_print_next()) {
+        }
+        uint32_t dropped = atomic_exchange_explicit(&s_dropped, 0, memory_order_relaxed);
+        if (dropped) {
+            ESP_LOGW(TAG, "Log ring overflowed, %" PRIu32 " records dropped", dropped);
+        }
+    }
+}
+
+esp_err_t deferred_log_init(void)
+{
+    for (unsigned i = 0; i < DEFERRED_LOG_RING_SIZE; i++) {
+        atomic_store_explicit(&s_ring[i].sequence, i, memory_order_relaxed);
+    }
+    s_task = xTaskCreateStatic(deferred_log_task, "deferred_log", DEFERRED_LOG_TASK_STACK_SIZE, NULL, DEFERRED_LOG_TASK_PRIORITY,
+                               s_task_stack, &s_task_buffer);
+    return memory_report_add_task(s_task, DEFERRED_LOG_TASK_STACK_SIZE);
+}
+
+#if DEFERRED_LOG_BENCHMARK
+#include "driver/gptimer.h"
+
+#define DEFERRED_LOG_BENCHMARK_CALLS        16
+#define DEFERRED_LOG_BENCHMARK_PERIOD_US    1000
+
+typedef struct {
+    uint32_t total;
+    uint32_t max;
+} deferred_log_cycles_t;
+
+static deferred_log_cycles_t s_isr_deferred;
+static deferred_log_cycles_t s_isr_early;
+static volatile int s_isr_calls;
+
+static void IRAM_ATTR deferred_log_cycles_add(deferred_log_cycles_t *cycles, uint32_t start)
+{
+    uint32_t elapsed = esp_cpu_get_cycle_count() - start;
+    cycles->total += elapsed;
+    cycles->max = elapsed > cycles->max ? elapsed : cycles->max;
+}
+
+/* Timer alarm, a real interrupt handler: what the GPIO handlers paid for ESP_EARLY_LOGI, against a deferred record */
+static bool IRAM_ATTR deferred_log_benchmark_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *user_ctx)
+{
+    int call = s_isr_calls;
+    if (call >= DEFERRED_LOG_BENCHMARK_CALLS) {
+        return false;
+    }
+    uint32_t start = esp_cpu_get_cycle_count();
+    DEFERRED_LOGI(TAG, "Benchmark ISR call %d, value 0x%x", call, 0x1234);
+    deferred_log_cycles_add(&s_isr_deferred, start);
+
+    start = esp_cpu_get_cycle_count();
+    ESP_EARLY_LOGI(TAG, "Benchmark ISR call %d, value 0x%x", call, 0x1234);
+    deferred_log_cycles_add(&s_isr_early, start);
+    s_isr_calls = call + 1;
+    return false;
+}
+
+static void deferred_log_benchmark_isr_run(void)
+{
+    gptimer_handle_t timer = NULL;
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = DEFERRED_LOG_BENCHMARK_PERIOD_US,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = deferred_log_benchmark_isr,
+    };
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_config, &timer));
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &callbacks, NULL));
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(timer, &alarm_config));
+    ESP_ERROR_CHECK(gptimer_enable(timer));
+    ESP_ERROR_CHECK(gptimer_start(timer));
+    while (s_isr_calls < DEFERRED_LOG_BENCHMARK_CALLS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    ESP_ERROR_CHECK(gptimer_stop(timer));
+    ESP_ERROR_CHECK(gptimer_disable(timer));
+    ESP_ERROR_CHECK(gptimer_del_timer(timer));
+}
+
+void deferred_log_benchmark(void)
+{
+    deferred_log_cycles_t deferred = { 0 }, direct = { 0 };
+    for (int i = 0; i < DEFERRED_LOG_BENCHMARK_CALLS; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        DEFERRED_LOGI(TAG, "Benchmark call %d, value 0x%x", i, 0x1234);
+        deferred_log_cycles_add(&deferred, start);
+
+        start = esp_cpu_get_cycle_count();
+        ESP_LOGI(TAG, "Benchmark call %d, value 0x%x", i, 0x1234);
+        deferred_log_cycles_add(&direct, start);
+    }
+    ESP_LOGI(TAG, "Deferred log: %" PRIu32 " cycles per call, %" PRIu32 " worst case", deferred.total / DEFERRED_LOG_BENCHMARK_CALLS, deferred.max);
+    ESP_LOGI(TAG, "ESP_LOGI: %" PRIu32 " cycles per call, %" PRIu32 " worst case", direct.total / DEFERRED_LOG_BENCHMARK_CALLS, direct.max);
+
+    deferred_log_benchmark_isr_run();
+    ESP_LOGI(TAG, "Deferred log in ISR: %" PRIu32 " cycles per call, %" PRIu32 " worst case", s_isr_deferred.total / DEFERRED_LOG_BENCHMARK_CALLS,
+             s_isr_deferred.max);
+    ESP_LOGI(TAG, "ESP_EARLY_LOGI in ISR: %" PRIu32 " cycles per call, %" PRIu32 " worst case", s_isr_early.total / DEFERRED_LOG_BENCHMARK_CALLS,
+             s_isr_early.max);
+}
+#endif
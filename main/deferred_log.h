@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Deferred logging for hot paths and interrupt handlers. A call only stores the
+ * format string pointer, the tag and up to DEFERRED_LOG_ARGS_MAX raw 32-bit
+ * arguments in a lock-free ring; the low-priority deferred_log task formats and
+ * prints them later through esp_log_write(), so the caller never pays for
+ * printf or the UART.
+ *
+ * Arguments must be 32-bit integers, or pointers to strings that are never
+ * freed (literals, esp_err_to_name()). Use ESP_LOGx for anything else.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of records waiting to be printed, must be a power of two */
+#define DEFERRED_LOG_RING_SIZE          64
+
+#define DEFERRED_LOG_ARGS_MAX           4
+
+#define DEFERRED_LOG_TASK_STACK_SIZE    3072
+#define DEFERRED_LOG_TASK_PRIORITY      1       /* only runs when nothing else has to */
+
+/* Compare deferred_log_write() with ESP_LOGI at start-up, from a task and from an interrupt handler, see deferred_log_benchmark() */
+#define DEFERRED_LOG_BENCHMARK          0
+
+/**
+ * @brief Initialize the ring and start the task printing it, call before the first DEFERRED_LOGx
+ */
+esp_err_t deferred_log_init(void);
+
+/**
+ * @brief Queue one record, safe from any task and from interrupt handlers
+ *
+ * Use the DEFERRED_LOGx macros rather than calling it directly.
+ *
+ * @param level   Log level
+ * @param tag     Log tag, must outlive the record
+ * @param format  printf format, must outlive the record
+ * @param args    Arguments, each stored as 32 bits
+ * @param argc    Number of arguments, at most DEFERRED_LOG_ARGS_MAX
+ */
+void deferred_log_write(esp_log_level_t level, const char *tag, const char *format, const uint32_t *args, uint32_t argc);
+
+#if DEFERRED_LOG_BENCHMARK
+/**
+ * @brief Log the per-call cycles, average and worst case, of deferred_log_write() against ESP_LOGI from the
+ *        calling task, and against ESP_EARLY_LOGI from a timer interrupt handler
+ */
+void deferred_log_benchmark(void);
+#endif
+
+#define DEFERRED_LOG_ARG(arg)               ((uint32_t)(uintptr_t)(arg))
+#define DEFERRED_LOG_ARGS_0()
+#define DEFERRED_LOG_ARGS_1(a)              DEFERRED_LOG_ARG(a)
+#define DEFERRED_LOG_ARGS_2(a, b)           DEFERRED_LOG_ARG(a), DEFERRED_LOG_ARG(b)
+#define DEFERRED_LOG_ARGS_3(a, b, c)        DEFERRED_LOG_ARG(a), DEFERRED_LOG_ARG(b), DEFERRED_LOG_ARG(c)
+#define DEFERRED_LOG_ARGS_4(a, b, c, d)     DEFERRED_LOG_ARG(a), DEFERRED_LOG_ARG(b), DEFERRED_LOG_ARG(c), DEFERRED_LOG_ARG(d)
+#define DEFERRED_LOG_NARGS_(_0, _1, _2, _3, _4, n, ...) n
+#define DEFERRED_LOG_NARGS(...)             DEFERRED_LOG_NARGS_(_0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define DEFERRED_LOG_CONCAT_(a, b)          a##b
+#define DEFERRED_LOG_CONCAT(a, b)           DEFERRED_LOG_CONCAT_(a, b)
+
+#define DEFERRED_LOG_LEVEL(level, tag, format, ...) do {                                                          \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                                                         \
+            /* never called, only there for the compiler to check the format against the arguments */            \
+            if (0) {                                                                                              \
+                esp_log_write(level, tag, format, ##__VA_ARGS__);                                                 \
+            }                                                                                                     \
+            const uint32_t _args[] = { 0, DEFERRED_LOG_CONCAT(DEFERRED_LOG_ARGS_, DEFERRED_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__) }; \
+            deferred_log_write(level, tag, format, _args + 1, DEFERRED_LOG_NARGS(__VA_ARGS__));                  \
+        }                                                                                                         \
+    } while (0)
+
+#define DEFERRED_LOGE(tag, format, ...) DEFERRED_LOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DEFERRED_LOGW(tag, format, ...) DEFERRED_LOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DEFERRED_LOGI(tag, format, ...) DEFERRED_LOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DEFERRED_LOGD(tag, format, ...) DEFERRED_LOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,239 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "device_schema.h"
+#include "diagnostics.h"
+#include "esp_zb_light.h"
+#include "ota_client.h"
+#include "ha/esp_zigbee_ha_standard.h"
+#include "temperature_filter.h"
+#include "temperature_sensor.h"
+#include "thermostat.h"
+#include "thermostat_control.h"
+
+ZCL_UTILITY_STRING(s_manufacturer_name, ESP_MANUFACTURER_NAME);
+ZCL_UTILITY_STRING(s_model_identifier, ESP_MODEL_IDENTIFIER);
+ZCL_UTILITY_STRING(s_binary_input_description, "Switch state");
+
+/* Values shared by several attributes */
+static const uint8_t s_zcl_version = ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE;
+static const uint8_t s_power_source = ESP_ZB_ZCL_BASIC_POWER_SOURCE_DEFAULT_VALUE;
+static const uint16_t s_identify_time = ESP_ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE;
+static const bool s_false = false;
+static const uint8_t s_zero_u8 = 0;
+static const uint16_t s_zero_u16 = 0;
+static const uint32_t s_zero_u32 = 0;
+
+static const zcl_utility_attr_desc_t s_basic_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_BASIC_ZCL_VERSION_ID, .value = &s_zcl_version },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID, .value = &s_power_source },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID, .value = &s_manufacturer_name },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, .value = &s_model_identifier },
+};
+
+static const zcl_utility_attr_desc_t s_identify_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_IDENTIFY_IDENTIFY_TIME_ID, .value = &s_identify_time },
+};
+
+/* Diagnostics: latency trace, published by diagnostics.c */
+static const diagnostics_histogram_attr_t s_empty_histogram = DIAGNOSTICS_HISTOGRAM_ATTR_EMPTY;
+
+#define DIAGNOSTICS_TRACE_OVERHEAD_ATTR \
+    { DIAGNOSTICS_ATTR_TRACE_OVERHEAD_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &s_zero_u16 }
+#define DIAGNOSTICS_MEMORY_ATTR(attr_id) \
+    { (attr_id), ESP_ZB_ZCL_ATTR_TYPE_U32, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &s_zero_u32 }
+#define DIAGNOSTICS_LATENCY_ATTR(path) \
+    { DIAGNOSTICS_ATTR_LATENCY_ID + (path), ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, &s_empty_histogram }
+
+/* Light */
+static const zcl_utility_attr_desc_t s_light_groups_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_GROUPS_NAME_SUPPORT_ID, .value = &s_zero_u8 },
+};
+
+static const zcl_utility_attr_desc_t s_light_scenes_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_SCENES_SCENE_COUNT_ID, .value = &s_zero_u8 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID, .value = &s_zero_u8 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID, .value = &s_zero_u16 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID, .value = &s_false },
+    { .attr_id = ESP_ZB_ZCL_ATTR_SCENES_NAME_SUPPORT_ID, .value = &s_zero_u8 },
+};
+
+static const zcl_utility_attr_desc_t s_light_on_off_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, .value = &(const bool){ ESP_ZB_ZCL_ON_OFF_ON_OFF_DEFAULT_VALUE } },
+};
+
+static const zcl_utility_attr_desc_t s_light_level_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, .value = &(const uint8_t){ ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, .value = &s_zero_u16 },
+};
+
+static const zcl_utility_attr_desc_t s_light_color_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, .value = &(const uint16_t){ ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, .value = &(const uint16_t){ ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, .value = &(const uint8_t){ 0x01 } },             /* CurrentX and CurrentY */
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_OPTIONS_ID, .value = &s_zero_u8 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_COLOR_MODE_ID, .value = &(const uint8_t){ 0x01 } },    /* CurrentX and CurrentY */
+    { .attr_id = ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID, .value = &(const uint16_t){ 0x0008 } },  /* XY attributes */
+};
+
+static const zcl_utility_attr_desc_t s_light_diagnostics_attrs[] = {
+    DIAGNOSTICS_TRACE_OVERHEAD_ATTR,
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_WRITE_TO_LED),
+    DIAGNOSTICS_MEMORY_ATTR(DIAGNOSTICS_ATTR_HEAP_FREE_MIN_ID),
+    DIAGNOSTICS_MEMORY_ATTR(DIAGNOSTICS_ATTR_HEAP_LARGEST_ID),
+    DIAGNOSTICS_MEMORY_ATTR(DIAGNOSTICS_ATTR_STACK_FREE_MIN_ID),
+};
+
+static const zcl_utility_cluster_desc_t s_light_clusters[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_basic_cluster, esp_zb_basic_cluster_add_attr,
+      s_basic_attrs, ZCL_UTILITY_COUNT(s_basic_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_identify_cluster, esp_zb_identify_cluster_add_attr,
+      s_identify_attrs, ZCL_UTILITY_COUNT(s_identify_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_GROUPS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_groups_cluster, esp_zb_groups_cluster_add_attr,
+      s_light_groups_attrs, ZCL_UTILITY_COUNT(s_light_groups_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_scenes_cluster, esp_zb_scenes_cluster_add_attr,
+      s_light_scenes_attrs, ZCL_UTILITY_COUNT(s_light_scenes_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_on_off_cluster, esp_zb_on_off_cluster_add_attr,
+      s_light_on_off_attrs, ZCL_UTILITY_COUNT(s_light_on_off_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_level_cluster, esp_zb_level_cluster_add_attr,
+      s_light_level_attrs, ZCL_UTILITY_COUNT(s_light_level_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_color_control_cluster, esp_zb_color_control_cluster_add_attr,
+      s_light_color_attrs, ZCL_UTILITY_COUNT(s_light_color_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_diagnostics_cluster, NULL,
+      s_light_diagnostics_attrs, ZCL_UTILITY_COUNT(s_light_diagnostics_attrs) },
+};
+
+/* Binary input */
+static const zcl_utility_attr_desc_t s_binary_input_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_BINARY_INPUT_OUT_OF_SERVICE_ID, .value = &(const bool){ ESP_ZB_ZCL_BINARY_INPUT_OUT_OF_SERVICE_DEFAULT_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BINARY_INPUT_STATUS_FLAGS_ID, .value = &(const uint8_t){ ESP_ZB_ZCL_BINARY_INPUT_STATUS_FLAG_DEFAULT_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BINARY_INPUT_DESCRIPTION_ID, .value = &s_binary_input_description },
+    { .attr_id = ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, .value = &s_false },
+};
+
+/* OTA client, the stack requests the image blocks and hands them to ota_client.c */
+static const esp_zb_zcl_ota_upgrade_client_variable_t s_ota_client_data = {
+    .timer_query = ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF,
+    .hw_version = OTA_CLIENT_HW_VERSION,
+    .max_data_size = OTA_CLIENT_BLOCK_SIZE,
+};
+
+static const zcl_utility_attr_desc_t s_binary_input_ota_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID, .value = &(const uint32_t){ OTA_CLIENT_FILE_VERSION } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID, .value = &(const uint16_t){ OTA_CLIENT_MANUFACTURER_CODE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID, .value = &(const uint16_t){ OTA_CLIENT_IMAGE_TYPE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, .value = &s_ota_client_data },
+};
+
+static const zcl_utility_attr_desc_t s_binary_input_diagnostics_attrs[] = {
+    DIAGNOSTICS_TRACE_OVERHEAD_ATTR,
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET),
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_EDGE_TO_REPORT),
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE),
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_EDGE_TO_COMMAND),
+    DIAGNOSTICS_LATENCY_ATTR(LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK),
+};
+
+static const zcl_utility_cluster_desc_t s_binary_input_clusters[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_basic_cluster, esp_zb_basic_cluster_add_attr,
+      s_basic_attrs, ZCL_UTILITY_COUNT(s_basic_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_identify_cluster, esp_zb_identify_cluster_add_attr,
+      s_identify_attrs, ZCL_UTILITY_COUNT(s_identify_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE, esp_zb_cluster_list_add_identify_cluster, esp_zb_identify_cluster_add_attr,
+      NULL, 0 },
+    { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_binary_input_cluster, esp_zb_binary_input_cluster_add_attr,
+      s_binary_input_attrs, ZCL_UTILITY_COUNT(s_binary_input_attrs) },
+    /* sends the heating output to the bound heaters, see heater_link.h */
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE, esp_zb_cluster_list_add_on_off_cluster, esp_zb_on_off_cluster_add_attr,
+      NULL, 0 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE, esp_zb_cluster_list_add_ota_cluster, esp_zb_ota_cluster_add_attr,
+      s_binary_input_ota_attrs, ZCL_UTILITY_COUNT(s_binary_input_ota_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_diagnostics_cluster, NULL,
+      s_binary_input_diagnostics_attrs, ZCL_UTILITY_COUNT(s_binary_input_diagnostics_attrs) },
+};
+
+/* Thermostat */
+static const zcl_utility_attr_desc_t s_thermostat_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, .value = &(const int16_t){ THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, .value = &s_zero_u8 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, .value = &s_zero_u8 },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, .value = &(const int16_t){ THERMOSTAT_COMFORT_SETPOINT } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, .value = &(const int16_t){ THERMOSTAT_ECO_SETPOINT } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_CONTROL_SEQUENCE_OF_OPERATION_ID,
+      .value = &(const uint8_t){ ESP_ZB_ZCL_THERMOSTAT_CONTROL_SEQ_OF_OPERATION_HEATING_ONLY } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, .value = &(const uint8_t){ ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, .value = &s_zero_u16 },
+};
+
+static const zcl_utility_cluster_desc_t s_thermostat_clusters[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_basic_cluster, esp_zb_basic_cluster_add_attr,
+      s_basic_attrs, ZCL_UTILITY_COUNT(s_basic_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_identify_cluster, esp_zb_identify_cluster_add_attr,
+      s_identify_attrs, ZCL_UTILITY_COUNT(s_identify_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_thermostat_cluster, esp_zb_thermostat_cluster_add_attr,
+      s_thermostat_attrs, ZCL_UTILITY_COUNT(s_thermostat_attrs) },
+};
+
+/* Temperature sensor */
+static const zcl_utility_attr_desc_t s_temperature_attrs[] = {
+    { .attr_id = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, .value = &(const int16_t){ TEMPERATURE_FILTER_UNKNOWN } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID, .value = &(const int16_t){ TEMPERATURE_SENSOR_MIN_VALUE } },
+    { .attr_id = ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID, .value = &(const int16_t){ TEMPERATURE_SENSOR_MAX_VALUE } },
+};
+
+static const zcl_utility_cluster_desc_t s_temperature_clusters[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_basic_cluster, esp_zb_basic_cluster_add_attr,
+      s_basic_attrs, ZCL_UTILITY_COUNT(s_basic_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_identify_cluster, esp_zb_identify_cluster_add_attr,
+      s_identify_attrs, ZCL_UTILITY_COUNT(s_identify_attrs) },
+    { ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, esp_zb_cluster_list_add_temperature_meas_cluster,
+      esp_zb_temperature_meas_cluster_add_attr, s_temperature_attrs, ZCL_UTILITY_COUNT(s_temperature_attrs) },
+};
+
+const zcl_utility_ep_desc_t device_schema[] = {
+    {
+        .config = {
+            .endpoint = BATHROOM_LIGHT_ENDPOINT,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID,
+            .app_device_version = 0,
+        },
+        .clusters = s_light_clusters,
+        .cluster_count = ZCL_UTILITY_COUNT(s_light_clusters),
+    },
+    {
+        .config = {
+            .endpoint = BATHROOM_BINARY_INPUT_ENDPOINT,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_CUSTOM_ATTR_DEVICE_ID,
+            .app_device_version = 0,
+        },
+        .clusters = s_binary_input_clusters,
+        .cluster_count = ZCL_UTILITY_COUNT(s_binary_input_clusters),
+    },
+    {
+        .config = {
+            .endpoint = BATHROOM_THERMOSTAT_ENDPOINT,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_THERMOSTAT_DEVICE_ID,
+            .app_device_version = 0,
+        },
+        .clusters = s_thermostat_clusters,
+        .cluster_count = ZCL_UTILITY_COUNT(s_thermostat_clusters),
+    },
+    {
+        .config = {
+            .endpoint = BATHROOM_TEMPERATURE_ENDPOINT,
+            .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
+            .app_device_id = ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,
+            .app_device_version = 0,
+        },
+        .clusters = s_temperature_clusters,
+        .cluster_count = ZCL_UTILITY_COUNT(s_temperature_clusters),
+    },
+};
+
+const uint8_t device_schema_ep_count = ZCL_UTILITY_COUNT(device_schema);
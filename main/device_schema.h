@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Declarative description of the endpoints, clusters and attributes of the
+ * device, instantiated by esp_zcl_utility_build_ep_list() in esp_zb_task.
+ */
+
+#pragma once
+
+#include "zcl_utility.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const zcl_utility_ep_desc_t device_schema[];
+extern const uint8_t device_schema_ep_count;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "diagnostics.h"
+#include "esp_log.h"
+#include "esp_zb_light.h"
+#include "memory_report.h"
+
+static const char *TAG = "DIAGNOSTICS";
+
+/* Endpoint carrying the histogram of every path, keep in sync with device_schema.c */
+static const uint8_t s_path_endpoints[LATENCY_TRACE_PATH_COUNT] = {
+    [LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET] = BATHROOM_BINARY_INPUT_ENDPOINT,
+    [LATENCY_TRACE_PATH_EDGE_TO_REPORT] = BATHROOM_BINARY_INPUT_ENDPOINT,
+    [LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE] = BATHROOM_BINARY_INPUT_ENDPOINT,
+    [LATENCY_TRACE_PATH_WRITE_TO_LED] = BATHROOM_LIGHT_ENDPOINT,
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND] = BATHROOM_BINARY_INPUT_ENDPOINT,
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK] = BATHROOM_BINARY_INPUT_ENDPOINT,
+};
+
+static uint32_t s_published_samples;
+static uint32_t s_published_heap_free_min = UINT32_MAX;
+
+static void diagnostics_set(uint8_t endpoint, uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_status_t status = esp_zb_zcl_set_attribute_val(endpoint, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                                              attr_id, value, false);
+    if (status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "Failed to set endpoint(%d) attribute(0x%x): status(%d)", endpoint, attr_id, status);
+    }
+}
+
+static void diagnostics_publish_path(latency_trace_path_t path)
+{
+    latency_trace_histogram_t histogram;
+    diagnostics_histogram_attr_t value = DIAGNOSTICS_HISTOGRAM_ATTR_EMPTY;
+    latency_trace_get_histogram(path, &histogram);
+    for (int i = 0; i < LATENCY_TRACE_BINS; i++) {
+        value.data[2 * i] = histogram.bins[i] & 0xFF;
+        value.data[2 * i + 1] = histogram.bins[i] >> 8;
+    }
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+        value.data[2 * LATENCY_TRACE_BINS + i] = (histogram.max_us >> (8 * i)) & 0xFF;
+    }
+    diagnostics_set(s_path_endpoints[path], DIAGNOSTICS_ATTR_LATENCY_ID + path, &value);
+}
+
+static void diagnostics_publish_memory(void)
+{
+    memory_report_t report;
+    memory_report_get(&report);
+    diagnostics_set(BATHROOM_LIGHT_ENDPOINT, DIAGNOSTICS_ATTR_HEAP_FREE_MIN_ID, &report.heap_free_min);
+    diagnostics_set(BATHROOM_LIGHT_ENDPOINT, DIAGNOSTICS_ATTR_HEAP_LARGEST_ID, &report.heap_largest_block);
+    diagnostics_set(BATHROOM_LIGHT_ENDPOINT, DIAGNOSTICS_ATTR_STACK_FREE_MIN_ID, &report.stack_free_min);
+    if (report.heap_free_min < s_published_heap_free_min) {
+        s_published_heap_free_min = report.heap_free_min;
+        memory_report_log();
+    }
+}
+
+static void diagnostics_publish_cb(uint8_t param)
+{
+    diagnostics_publish_memory();
+    uint32_t samples = latency_trace_sample_count();
+    if (samples != s_published_samples) {
+        s_published_samples = samples;
+        for (int path = 0; path < LATENCY_TRACE_PATH_COUNT; path++) {
+            diagnostics_publish_path(path);
+        }
+        if (DIAGNOSTICS_DUMP_TRACE) {
+            latency_trace_dump();
+        }
+    }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)diagnostics_publish_cb, 0, DIAGNOSTICS_PUBLISH_INTERVAL_MS);
+}
+
+void diagnostics_init(void)
+{
+    uint16_t overhead_cycles = latency_trace_overhead_cycles() > UINT16_MAX ? UINT16_MAX : latency_trace_overhead_cycles();
+    diagnostics_set(BATHROOM_LIGHT_ENDPOINT, DIAGNOSTICS_ATTR_TRACE_OVERHEAD_ID, &overhead_cycles);
+    diagnostics_set(BATHROOM_BINARY_INPUT_ENDPOINT, DIAGNOSTICS_ATTR_TRACE_OVERHEAD_ID, &overhead_cycles);
+    diagnostics_publish_memory();
+    esp_zb_scheduler_alarm((esp_zb_callback_t)diagnostics_publish_cb, 0, DIAGNOSTICS_PUBLISH_INTERVAL_MS);
+}
@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Publishes the latency trace histograms as manufacturer attributes of the
+ * Diagnostics cluster (0x0B05): the button paths on the binary input endpoint,
+ * the attribute write to LED path on the light endpoint. Each histogram is an
+ * octet string of LATENCY_TRACE_BINS little-endian uint16 counts followed by the
+ * uint32 largest latency in microseconds, tools/trace_dump.py --attr decodes it.
+ *
+ * The memory report is published alongside, on the light endpoint: the lowest
+ * free heap since boot, the largest free heap block and the smallest stack
+ * headroom of the tasks, and it is logged in full whenever the heap reaches a
+ * new low.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "latency_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* uint16, CPU cycles spent in one trace point */
+#define DIAGNOSTICS_ATTR_TRACE_OVERHEAD_ID  0xF000
+/* octet string, DIAGNOSTICS_ATTR_LATENCY_ID + latency_trace_path_t */
+#define DIAGNOSTICS_ATTR_LATENCY_ID         0xF001
+/* uint32 bytes, see memory_report_t */
+#define DIAGNOSTICS_ATTR_HEAP_FREE_MIN_ID   0xF010
+#define DIAGNOSTICS_ATTR_HEAP_LARGEST_ID    0xF011
+#define DIAGNOSTICS_ATTR_STACK_FREE_MIN_ID  0xF012
+
+/* period of the attribute refresh, the histograms are skipped when nothing was traced */
+#define DIAGNOSTICS_PUBLISH_INTERVAL_MS     60000
+
+/* also log the raw trace events at every refresh, for tools/trace_dump.py */
+#define DIAGNOSTICS_DUMP_TRACE              0
+
+/** ZCL octet string value of a latency histogram attribute */
+typedef struct {
+    uint8_t len;
+    uint8_t data[LATENCY_TRACE_BINS * sizeof(uint16_t) + sizeof(uint32_t)];
+} diagnostics_histogram_attr_t;
+
+/* Value of a histogram attribute before the first refresh */
+#define DIAGNOSTICS_HISTOGRAM_ATTR_EMPTY    { .len = sizeof(((diagnostics_histogram_attr_t *)0)->data) }
+
+/**
+ * @brief Publish the trace point overhead and start refreshing the histograms, call once the device is registered
+ */
+void diagnostics_init(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -1,23 +1,40 @@
 #include "esp_zb_light.h"
-#include "driver/gpio.h"
-#include "esp_bit_defs.h"
+#include "attr_registry.h"
+#include "attr_reporter.h"
+#include "boot_stage.h"
+#include "commissioning.h"
+#include "deferred_log.h"
+#include "device_schema.h"
+#include "diagnostics.h"
 #include "esp_check.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "esp_zigbee_attribute.h"
 #include "esp_zigbee_cluster.h"
 #include "esp_zigbee_endpoint.h"
 #include "esp_zigbee_type.h"
 #include "ha/esp_zigbee_ha_standard.h"
+#include "heater_link.h"
+#include "latency_trace.h"
+#include "light_scenes.h"
+#include "light_state.h"
+#include "memory_report.h"
+#include "power_save.h"
+#include "status_indicator.h"
 #include "nvs_flash.h"
+#include "ota_client.h"
 #include "freertos/task.h"
-#include "soc/gpio_num.h"
+#include "state_store.h"
 #include "switch_driver.h"
+#include "temperature_sensor.h"
+#include "thermostat.h"
 #include "zcl/esp_zigbee_zcl_basic.h"
 #include "zcl/esp_zigbee_zcl_binary_input.h"
 #include "zcl/esp_zigbee_zcl_command.h"
 #include "zcl/esp_zigbee_zcl_common.h"
 #include "zcl/esp_zigbee_zcl_on_off.h"
+#include "zboss_api.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -29,69 +46,157 @@
 static const char *TAG = "BATHROOM_THERMOSTAT_CONTROLLER";
 /********************* Define functions **************************/
 
-static void switch_isr_handler(void *data) {
-    esp_zb_zcl_attr_t *binary_input_present_value = esp_zb_zcl_get_attribute(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID);
-    bool binary_input_current_value = *(bool *)binary_input_present_value->data_p;
-    bool binary_input_new_value = !binary_input_current_value;
-    *((bool *)binary_input_present_value->data_p) = !binary_input_current_value;
-    esp_zb_lock_acquire(portMAX_DELAY);
-    ESP_ERROR_CHECK(esp_zb_zcl_set_attribute_val(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, binary_input_present_value->data_p, false));
-    esp_zb_lock_release();
-
-    esp_zb_zcl_report_attr_cmd_t cmd_req = {
-        .address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
-        .attributeID = ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID,
-        .clusterID = ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT,
-        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_CLI,
-        .zcl_basic_cmd.src_endpoint = BATHROOM_BINARY_INPUT_ENDPOINT, 
-    };
+/* Index of the attributes in s_attributes */
+typedef enum {
+    ATTR_LIGHT_ON_OFF,
+    ATTR_LIGHT_LEVEL,
+    ATTR_LIGHT_ON_OFF_TRANSITION,
+    ATTR_LIGHT_COLOR_X,
+    ATTR_LIGHT_COLOR_Y,
+    ATTR_PRESENT_VALUE,
+    ATTR_THERMOSTAT_COMFORT_SETPOINT,
+    ATTR_THERMOSTAT_ECO_SETPOINT,
+    ATTR_THERMOSTAT_SYSTEM_MODE,
+    ATTR_COUNT,
+} bathroom_attr_t;
+
+static void light_on_off_write(const void *value);
+static void light_level_write(const void *value);
+static void light_on_off_transition_write(const void *value);
+static void light_color_x_write(const void *value);
+static void light_color_y_write(const void *value);
+static void thermostat_setpoint_write(const void *value);
+static void thermostat_system_mode_write(const void *value);
+
+/* Attributes this firmware reads or reacts to, resolved once after the device is registered */
+static attr_registry_entry_t s_attributes[ATTR_COUNT] = {
+    [ATTR_LIGHT_ON_OFF] = { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, light_on_off_write },
+    [ATTR_LIGHT_LEVEL] = { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, light_level_write },
+    [ATTR_LIGHT_ON_OFF_TRANSITION] = { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_on_off_transition_write },
+    [ATTR_LIGHT_COLOR_X] = { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_x_write },
+    [ATTR_LIGHT_COLOR_Y] = { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_y_write },
+    [ATTR_PRESENT_VALUE] = { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, NULL },
+    [ATTR_THERMOSTAT_COMFORT_SETPOINT] = { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, thermostat_setpoint_write },
+    [ATTR_THERMOSTAT_ECO_SETPOINT] = { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, thermostat_setpoint_write },
+    [ATTR_THERMOSTAT_SYSTEM_MODE] = { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, thermostat_system_mode_write },
+};
+
+static attr_reporter_t s_present_value_reporter;
+
+#define ATTR_VALUE(index, type) (*(type *)s_attributes[index].attr->data_p)
+
+/* State the device starts from: the defaults of the device schema, or the saved state */
+static state_store_state_t s_boot_state = {
+    .light_power = LIGHT_DEFAULT_OFF,
+    .light_level = ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE,
+    .color_x = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE,
+    .color_y = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE,
+    .comfort_setpoint = THERMOSTAT_COMFORT_SETPOINT,
+    .eco_setpoint = THERMOSTAT_ECO_SETPOINT,
+    .system_mode = ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT,
+};
+static bool s_boot_state_restored;
+static StackType_t s_zb_task_stack[ESP_ZB_TASK_STACK_SIZE];
+static StaticTask_t s_zb_task_buffer;
 
-    esp_zb_lock_acquire(portMAX_DELAY);
-    ESP_ERROR_CHECK(esp_zb_zcl_report_attr_cmd_req(&cmd_req));
-    esp_zb_lock_release();
-    ESP_EARLY_LOGI(TAG, "Send binary input attribute report to %s", binary_input_new_value ? "true" : "false");
+static void switch_toggle_cb(uint8_t param)
+{
+    bool binary_input_new_value = !ATTR_VALUE(ATTR_PRESENT_VALUE, bool);
+    ESP_ERROR_CHECK(esp_zb_zcl_set_attribute_val(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, &binary_input_new_value, false));
+    latency_trace_point(LATENCY_TRACE_ATTR_SET);
+
+    /* the reporter merges quick toggles and only sends the final state */
+    attr_reporter_update(&s_present_value_reporter, binary_input_new_value);
+    status_indicator_update(binary_input_new_value);
+    thermostat_set_occupied(binary_input_new_value);
+    state_store_touch();
+    boot_stage_mark(BOOT_PHASE_FIRST_RESPONSE);
+    DEFERRED_LOGI(TAG, "Binary input present value set to %s", binary_input_new_value ? "true" : "false");
+}
+
+static void status_show_cb(uint8_t param)
+{
+    status_indicator_show(ATTR_VALUE(ATTR_PRESENT_VALUE, bool));
+    boot_stage_mark(BOOT_PHASE_FIRST_RESPONSE);
 }
 
-static void reset_isr_handler(void *data) {
-    ESP_EARLY_LOGI(TAG, "Factory reset...");
+static void factory_reset_cb(uint8_t param)
+{
+    ESP_LOGI(TAG, "Factory reset...");
+    if (commissioning_erase() != ESP_OK) {
+        ESP_LOGW(TAG, "The last network is still saved");
+    }
+    if (light_scenes_erase() != ESP_OK) {
+        ESP_LOGW(TAG, "The scenes are still saved");
+    }
     esp_zb_factory_reset();
 }
 
-static void switch_init(void) {
-    gpio_config_t switch_config = {
-        .intr_type = GPIO_INTR_POSEDGE,
-        .mode = GPIO_MODE_INPUT,
-        .pin_bit_mask = BIT(10),
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .pull_up_en = GPIO_PULLDOWN_DISABLE
-    };
-    ESP_ERROR_CHECK(gpio_config(&switch_config));
-
-    gpio_config_t reset_config = {
-        .intr_type = GPIO_INTR_POSEDGE,
-        .mode = GPIO_MODE_INPUT,
-        .pin_bit_mask = BIT(11),
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .pull_up_en = GPIO_PULLDOWN_DISABLE
-    };
-    ESP_ERROR_CHECK(gpio_config(&reset_config));
+static switch_func_pair_t s_buttons[] = {
+    { .pin = BATHROOM_SWITCH_GPIO, .func = SWITCH_ONOFF_TOGGLE_CONTROL, .active_high = true },
+    { .pin = BATHROOM_STATUS_GPIO, .func = SWITCH_COLOR_CONTROL },
+    { .pin = BATHROOM_RESET_GPIO, .func = SWITCH_OFF_CONTROL, .active_high = true, .gestures = { .hold_ms = BATHROOM_RESET_HOLD_MS } },
+};
 
-    ESP_ERROR_CHECK(gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT));
+/* What each button gesture does, run in the Zigbee context */
+typedef struct {
+    uint32_t pin;
+    switch_gesture_t gesture;
+    esp_zb_callback_t action;
+    const char *name;
+} button_action_t;
 
-    ESP_ERROR_CHECK(gpio_isr_handler_add(10, switch_isr_handler, NULL));
-    ESP_ERROR_CHECK(gpio_isr_handler_add(11, reset_isr_handler, NULL));
-}
+static const button_action_t s_button_actions[] = {
+    { BATHROOM_SWITCH_GPIO, SWITCH_GESTURE_PRESS, switch_toggle_cb, "Switch toggle" },
+    { BATHROOM_STATUS_GPIO, SWITCH_GESTURE_CLICK, status_show_cb, "Status indication" },
+    { BATHROOM_RESET_GPIO, SWITCH_GESTURE_HOLD, factory_reset_cb, "Factory reset" },
+};
 
-static esp_err_t deferred_driver_init(void)
+static void button_handler(switch_func_pair_t *button, switch_gesture_t gesture)
 {
-    light_driver_init(LIGHT_DEFAULT_OFF);
-    switch_init();
-    return ESP_OK;
+    /* called from the esp_timer task */
+    if (gesture == SWITCH_GESTURE_PRESS) {
+        boot_stage_mark(BOOT_PHASE_FIRST_INPUT);
+    }
+    for (size_t i = 0; i < PAIR_SIZE(s_button_actions); i++) {
+        const button_action_t *action = &s_button_actions[i];
+        if (action->pin != button->pin || action->gesture != gesture) {
+            continue;
+        }
+        /* queued until the Zigbee stack is up, applied right away after that */
+        if (boot_stage_run(action->action, 0) != ESP_OK) {
+            ESP_LOGW(TAG, "%s dropped, the Zigbee stack is not up yet", action->name);
+        }
+    }
 }
 
-static void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
+/* Runs from app_main, before the Zigbee stack: the LED and the buttons work even without a network */
+static esp_err_t driver_init(void)
 {
-    ESP_RETURN_ON_FALSE(esp_zb_bdb_start_top_level_commissioning(mode_mask) == ESP_OK, , TAG, "Failed to start Zigbee commissioning");
+    s_boot_state_restored = state_store_restore(&s_boot_state) == ESP_OK;
+    light_driver_state_t light_initial_state = {
+        .power = s_boot_state.light_power,
+        .level = s_boot_state.light_level,
+        .color_x = s_boot_state.color_x,
+        .color_y = s_boot_state.color_y,
+    };
+    light_driver_init(LIGHT_DEFAULT_OFF);
+    light_state_set_on_off_transition(s_boot_state.on_off_transition_ds);
+    light_state_init(&light_initial_state);
+    status_indicator_init();
+    if (temperature_sensor_init(thermostat_set_local_temperature) != ESP_OK) {
+        ESP_LOGW(TAG, "Temperature sensor unavailable, the heating stays off");
+    }
+    return switch_driver_init(s_buttons, PAIR_SIZE(s_buttons), button_handler) ? ESP_OK : ESP_FAIL;
 }
 
 void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
@@ -107,19 +212,29 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     case ESP_ZB_BDB_SIGNAL_DEVICE_FIRST_START:
     case ESP_ZB_BDB_SIGNAL_DEVICE_REBOOT:
         if (err_status == ESP_OK) {
-            ESP_LOGI(TAG, "Deferred driver initialization %s", deferred_driver_init() ? "failed" : "successful");
             ESP_LOGI(TAG, "Device started up in %s factory-reset mode", esp_zb_bdb_is_factory_new() ? "" : "non");
             if (esp_zb_bdb_is_factory_new()) {
                 ESP_LOGI(TAG, "Start network steering");
-                esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_STEERING);
+                commissioning_start();
             } else {
                 ESP_LOGI(TAG, "Device rebooted");
+                boot_stage_mark(BOOT_PHASE_NETWORK_READY);
+                boot_stage_log();
+                memory_report_log();
+                ota_client_network_ready();
+                heater_link_network_ready();
             }
         } else {
-            /* commissioning failed */
+            /* on a reboot this was the rejoin of the saved network, steer with the backoff from its channel */
             ESP_LOGW(TAG, "Failed to initialize Zigbee stack (status: %s)", esp_err_to_name(err_status));
+            commissioning_start();
         }
         break;
+    case ESP_ZB_COMMON_SIGNAL_CAN_SLEEP:
+#ifdef CONFIG_PM_ENABLE
+        esp_zb_sleep_now();
+#endif
+        break;
     case ESP_ZB_BDB_SIGNAL_STEERING:
         if (err_status == ESP_OK) {
             esp_zb_ieee_addr_t extended_pan_id;
@@ -128,10 +243,15 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
                      extended_pan_id[7], extended_pan_id[6], extended_pan_id[5], extended_pan_id[4],
                      extended_pan_id[3], extended_pan_id[2], extended_pan_id[1], extended_pan_id[0],
                      esp_zb_get_pan_id(), esp_zb_get_current_channel(), esp_zb_get_short_address());
+            boot_stage_mark(BOOT_PHASE_NETWORK_READY);
+            boot_stage_log();
+            memory_report_log();
+            ota_client_network_ready();
+            heater_link_network_ready();
         } else {
             ESP_LOGI(TAG, "Network steering was not successful (status: %s)", esp_err_to_name(err_status));
-            esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb, ESP_ZB_BDB_MODE_NETWORK_STEERING, 1000);
         }
+        commissioning_steering_done(err_status);
         break;
     default:
         ESP_LOGI(TAG, "ZDO signal: %s (0x%x), status: %s", esp_zb_zdo_signal_to_string(sig_type), sig_type,
@@ -140,61 +260,113 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
     }
 }
 
+static void light_on_off_write(const void *value)
+{
+    bool light_state = *(const bool *)value;
+    DEFERRED_LOGI(TAG, "Light sets to %s", light_state ? "On" : "Off");
+    light_state_stage_power(light_state);
+    light_scenes_invalidate();
+    state_store_touch();
+}
+
+static void light_level_write(const void *value)
+{
+    uint8_t light_level = *(const uint8_t *)value;
+    DEFERRED_LOGI(TAG, "Light level changes to %d", light_level);
+    light_state_stage_level(light_level);
+    light_scenes_invalidate();
+    state_store_touch();
+}
+
+static void light_on_off_transition_write(const void *value)
+{
+    uint16_t light_transition = *(const uint16_t *)value;
+    DEFERRED_LOGI(TAG, "Light on/off transition changes to %d ds", light_transition);
+    light_state_set_on_off_transition(light_transition);
+    state_store_touch();
+}
+
+static void light_color_x_write(const void *value)
+{
+    uint16_t light_color_x = *(const uint16_t *)value;
+    DEFERRED_LOGI(TAG, "Light color x changes to 0x%x", light_color_x);
+    light_state_stage_color_x(light_color_x);
+    light_scenes_invalidate();
+    state_store_touch();
+}
+
+static void light_color_y_write(const void *value)
+{
+    uint16_t light_color_y = *(const uint16_t *)value;
+    DEFERRED_LOGI(TAG, "Light color y changes to 0x%x", light_color_y);
+    light_state_stage_color_y(light_color_y);
+    light_scenes_invalidate();
+    state_store_touch();
+}
+
+static void thermostat_setpoint_write(const void *value)
+{
+    DEFERRED_LOGI(TAG, "Thermostat setpoint changes to %d", *(const int16_t *)value);
+    thermostat_refresh();
+    state_store_touch();
+}
+
+static void thermostat_system_mode_write(const void *value)
+{
+    DEFERRED_LOGI(TAG, "Thermostat system mode changes to %d", *(const uint8_t *)value);
+    thermostat_refresh();
+    state_store_touch();
+}
+
+static void state_set_attribute(bathroom_attr_t index, void *value)
+{
+    const attr_registry_entry_t *entry = &s_attributes[index];
+    esp_zb_zcl_set_attribute_val(entry->endpoint, entry->cluster_id, entry->cluster_role, entry->attr_id, value, false);
+}
+
+/* Put the saved state, already shown by the drivers, into the attribute store before the stack starts */
+static void state_restore(void)
+{
+    if (!s_boot_state_restored) {
+        return;
+    }
+    bool light_power = s_boot_state.light_power;
+    bool present_value = s_boot_state.present_value;
+    state_set_attribute(ATTR_LIGHT_ON_OFF, &light_power);
+    state_set_attribute(ATTR_LIGHT_LEVEL, &s_boot_state.light_level);
+    state_set_attribute(ATTR_LIGHT_ON_OFF_TRANSITION, &s_boot_state.on_off_transition_ds);
+    state_set_attribute(ATTR_LIGHT_COLOR_X, &s_boot_state.color_x);
+    state_set_attribute(ATTR_LIGHT_COLOR_Y, &s_boot_state.color_y);
+    state_set_attribute(ATTR_PRESENT_VALUE, &present_value);
+    state_set_attribute(ATTR_THERMOSTAT_COMFORT_SETPOINT, &s_boot_state.comfort_setpoint);
+    state_set_attribute(ATTR_THERMOSTAT_ECO_SETPOINT, &s_boot_state.eco_setpoint);
+    state_set_attribute(ATTR_THERMOSTAT_SYSTEM_MODE, &s_boot_state.system_mode);
+}
+
+static void state_snapshot(state_store_state_t *state)
+{
+    state->light_power = ATTR_VALUE(ATTR_LIGHT_ON_OFF, bool);
+    state->light_level = ATTR_VALUE(ATTR_LIGHT_LEVEL, uint8_t);
+    state->color_x = ATTR_VALUE(ATTR_LIGHT_COLOR_X, uint16_t);
+    state->color_y = ATTR_VALUE(ATTR_LIGHT_COLOR_Y, uint16_t);
+    state->on_off_transition_ds = ATTR_VALUE(ATTR_LIGHT_ON_OFF_TRANSITION, uint16_t);
+    state->present_value = ATTR_VALUE(ATTR_PRESENT_VALUE, bool);
+    state->comfort_setpoint = ATTR_VALUE(ATTR_THERMOSTAT_COMFORT_SETPOINT, int16_t);
+    state->eco_setpoint = ATTR_VALUE(ATTR_THERMOSTAT_ECO_SETPOINT, int16_t);
+    state->system_mode = ATTR_VALUE(ATTR_THERMOSTAT_SYSTEM_MODE, uint8_t);
+}
+
 static esp_err_t zb_attribute_handler(const esp_zb_zcl_set_attr_value_message_t *message)
 {
     esp_err_t ret = ESP_OK;
-    bool light_state = 0;
-    uint8_t light_level = 0;
-    uint16_t light_color_x = 0;
-    uint16_t light_color_y = 0;
+    latency_trace_point(LATENCY_TRACE_ATTR_CALLBACK);
     ESP_RETURN_ON_FALSE(message, ESP_FAIL, TAG, "Empty message");
     ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "Received message: error status(%d)",
                         message->info.status);
-    ESP_LOGI(TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)", message->info.dst_endpoint, message->info.cluster,
-             message->attribute.id, message->attribute.data.size);
-    if (message->info.dst_endpoint == BATHROOM_LIGHT_ENDPOINT) {
-        switch (message->info.cluster) {
-        case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
-            if (message->attribute.id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL) {
-                light_state = message->attribute.data.value ? *(bool *)message->attribute.data.value : light_state;
-                ESP_LOGI(TAG, "Light sets to %s", light_state ? "On" : "Off");
-                light_driver_set_power(light_state);
-            } else {
-                ESP_LOGW(TAG, "On/Off cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
-            }
-            break;
-        case ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL:
-            if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16) {
-                light_color_x = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : light_color_x;
-                light_color_y = *(uint16_t *)esp_zb_zcl_get_attribute(message->info.dst_endpoint, message->info.cluster,
-                                                                      ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID)
-                                     ->data_p;
-                ESP_LOGI(TAG, "Light color x changes to 0x%x", light_color_x);
-            } else if (message->attribute.id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID &&
-                       message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U16) {
-                light_color_y = message->attribute.data.value ? *(uint16_t *)message->attribute.data.value : light_color_y;
-                light_color_x = *(uint16_t *)esp_zb_zcl_get_attribute(message->info.dst_endpoint, message->info.cluster,
-                                                                      ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID)
-                                     ->data_p;
-                ESP_LOGI(TAG, "Light color y changes to 0x%x", light_color_y);
-            } else {
-                ESP_LOGW(TAG, "Color control cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
-            }
-            // For some reason, x and y are inverted either in HA or here, but doing so gives better results.
-            light_driver_set_color_xy(light_color_y, light_color_x);
-            break;
-        case ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL:
-            if (message->attribute.id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID && message->attribute.data.type == ESP_ZB_ZCL_ATTR_TYPE_U8) {
-                light_level = message->attribute.data.value ? *(uint8_t *)message->attribute.data.value : light_level;
-                light_driver_set_level((uint8_t)light_level);
-                ESP_LOGI(TAG, "Light level changes to %d", light_level);
-            } else {
-                ESP_LOGW(TAG, "Level Control cluster data: attribute(0x%x), type(0x%x)", message->attribute.id, message->attribute.data.type);
-            }
-            break;
-        default:
-            ESP_LOGI(TAG, "Message data: cluster(0x%x), attribute(0x%x)  ", message->info.cluster, message->attribute.id);
-        }
+    DEFERRED_LOGI(TAG, "Received message: endpoint(%d), cluster(0x%x), attribute(0x%x), data size(%d)", message->info.dst_endpoint, message->info.cluster,
+                  message->attribute.id, message->attribute.data.size);
+    if (attr_registry_dispatch(message) == ESP_ERR_NOT_FOUND) {
+        DEFERRED_LOGI(TAG, "Message data: cluster(0x%x), attribute(0x%x)", message->info.cluster, message->attribute.id);
     }
     return ret;
 }
@@ -206,6 +378,18 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     case ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID:
         ret = zb_attribute_handler((esp_zb_zcl_set_attr_value_message_t *)message);
         break;
+    case ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID:
+        ret = ota_client_handle((esp_zb_zcl_ota_upgrade_value_message_t *)message);
+        break;
+    case ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID:
+        ret = light_scenes_store((esp_zb_zcl_store_scene_message_t *)message);
+        break;
+    case ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID:
+        ret = light_scenes_recall((esp_zb_zcl_recall_scene_message_t *)message);
+        break;
+    case ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID:
+        ret = heater_link_handle_default_response((esp_zb_zcl_cmd_default_resp_message_t *)message);
+        break;
     default:
         ESP_LOGW(TAG, "Receive Zigbee action(0x%x) callback", callback_id);
         break;
@@ -213,70 +397,61 @@ static esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id,
     return ret;
 }
 
+/* Sees the ZCL commands before the stack, which still handles them all */
+static bool zb_raw_command_handler(uint8_t bufid)
+{
+    zb_zcl_parsed_hdr_t *cmd_info = ZB_BUF_GET_PARAM(bufid, zb_zcl_parsed_hdr_t);
+    if (!cmd_info->is_common_command && cmd_info->cmd_direction == ZB_ZCL_FRAME_DIRECTION_TO_SRV &&
+        ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).dst_endpoint == BATHROOM_LIGHT_ENDPOINT) {
+        light_scenes_command(cmd_info->cluster_id, cmd_info->cmd_id, zb_buf_begin(bufid), zb_buf_len(bufid));
+    }
+    return false;
+}
+
 static void esp_zb_task(void *pvParameters)
 {
+    /* the last task to start, the report is complete from here */
+    ESP_ERROR_CHECK(memory_report_add_task(xTaskGetCurrentTaskHandle(), ESP_ZB_TASK_STACK_SIZE));
     /* initialize Zigbee stack */
     esp_zb_cfg_t zb_nwk_cfg = ESP_ZB_ZED_CONFIG();
+#ifdef CONFIG_PM_ENABLE
+    /* sleepy end device: the radio is off between polls and the stack tells us when it can sleep */
+    esp_zb_sleep_enable(true);
+#endif
     esp_zb_init(&zb_nwk_cfg);
+#ifdef CONFIG_PM_ENABLE
+    esp_zb_sleep_set_threshold(POWER_SAVE_ZB_SLEEP_THRESHOLD_MS);
+    esp_zb_set_rx_on_when_idle(false);
+#endif
 
-    esp_zb_ep_list_t *ep_list = esp_zb_ep_list_create();
-
-    // Light
-    esp_zb_color_dimmable_light_cfg_t light_cfg = ESP_ZB_DEFAULT_COLOR_DIMMABLE_LIGHT_CONFIG();
-    esp_zb_cluster_list_t *light_cluster_list = esp_zb_color_dimmable_light_clusters_create(&light_cfg);
-    esp_zb_endpoint_config_t light_ep_config = {
-        .endpoint = BATHROOM_LIGHT_ENDPOINT,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .app_device_id = ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID,
-        .app_device_version = 0,
-    };
-    esp_zb_ep_list_add_ep(ep_list, light_cluster_list, light_ep_config);
-    zcl_basic_manufacturer_info_t light_info = {
-        .manufacturer_name = ESP_MANUFACTURER_NAME,
-        .model_identifier = ESP_MODEL_IDENTIFIER,
-    };
-    esp_zcl_utility_add_ep_basic_manufacturer_info(ep_list, BATHROOM_LIGHT_ENDPOINT, &light_info);
-
-    // Binary input
-    esp_zb_binary_input_cluster_cfg_t binary_input_cfg = {
-        .out_of_service = ESP_ZB_ZCL_BINARY_INPUT_OUT_OF_SERVICE_DEFAULT_VALUE,
-        .status_flags = ESP_ZB_ZCL_BINARY_INPUT_STATUS_FLAG_DEFAULT_VALUE
-    };
-    esp_zb_basic_cluster_cfg_t binary_input_basic_cfg = {
-        .power_source = ESP_ZB_ZCL_BASIC_POWER_SOURCE_DEFAULT_VALUE,
-        .zcl_version = ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE,
-    };
-    esp_zb_identify_cluster_cfg_t binary_input_identify_cfg = {
-        .identify_time = ESP_ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE
-    };
-    esp_zb_cluster_list_t *binary_input_cluster_list = esp_zb_zcl_cluster_list_create();
-    esp_zb_attribute_list_t *binary_input_basic_cluster = esp_zb_basic_cluster_create(&binary_input_basic_cfg);
-    esp_zb_basic_cluster_add_attr(binary_input_basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID, ESP_MANUFACTURER_NAME);
-    esp_zb_basic_cluster_add_attr(binary_input_basic_cluster, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, ESP_MODEL_IDENTIFIER);
-    esp_zb_cluster_list_add_basic_cluster(binary_input_cluster_list, binary_input_basic_cluster, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
-    esp_zb_cluster_list_add_identify_cluster(binary_input_cluster_list, esp_zb_identify_cluster_create(&binary_input_identify_cfg), ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
-    esp_zb_cluster_list_add_identify_cluster(binary_input_cluster_list, esp_zb_zcl_attr_list_create(ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY), ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
-    esp_zb_attribute_list_t *binary_input_attr_list = esp_zb_binary_input_cluster_create(&binary_input_cfg);
-    esp_zb_binary_input_cluster_add_attr(binary_input_attr_list, ESP_ZB_ZCL_ATTR_BINARY_INPUT_DESCRIPTION_ID, "\x0C""Switch state");
-    esp_zb_binary_input_cluster_add_attr(binary_input_attr_list, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, &(bool *){ false });
-    esp_zb_cluster_list_add_binary_input_cluster(binary_input_cluster_list, binary_input_attr_list, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE);
-
-    esp_zb_endpoint_config_t binary_input_endpoint_config = {
-        .endpoint = BATHROOM_BINARY_INPUT_ENDPOINT,
-        .app_profile_id = ESP_ZB_AF_HA_PROFILE_ID,
-        .app_device_id = ESP_ZB_HA_CUSTOM_ATTR_DEVICE_ID,
-        .app_device_version = 0,
-    };
-    esp_zb_ep_list_add_ep(ep_list, binary_input_cluster_list, binary_input_endpoint_config);
+    size_t free_heap = esp_get_free_heap_size();
+    esp_zb_ep_list_t *ep_list = NULL;
+    ESP_ERROR_CHECK(esp_zcl_utility_build_ep_list(device_schema, device_schema_ep_count, &ep_list));
+    ESP_LOGI(TAG, "Device schema built with %d bytes of heap", (int)(free_heap - esp_get_free_heap_size()));
 
     if (esp_zb_device_register(ep_list) != ESP_OK) {
         ESP_LOGW(TAG,  "Can't register bathroom device");
     }
+    ESP_ERROR_CHECK(attr_registry_init(s_attributes, PAIR_SIZE(s_attributes)));
+    state_restore();
+    state_store_init(state_snapshot);
+    if (light_scenes_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Saved scenes unavailable");
+    }
+    ESP_ERROR_CHECK(attr_reporter_register(&s_present_value_reporter, BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT,
+                                           ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, BINARY_INPUT_REPORT_WINDOW_MS, 1));
+    heater_link_init();
+    ESP_ERROR_CHECK(thermostat_init(ATTR_VALUE(ATTR_PRESENT_VALUE, bool)));
+    ESP_ERROR_CHECK(temperature_sensor_register());
+    diagnostics_init();
 
     esp_zb_core_action_handler_register(zb_action_handler);
+    esp_zb_raw_command_handler_register(zb_raw_command_handler);
 
-    esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
+    ESP_ERROR_CHECK(commissioning_init(ESP_ZB_PRIMARY_CHANNEL_MASK));
     ESP_ERROR_CHECK(esp_zb_start(false));
+    /* the scheduler and the attribute store are usable from here, whether the network is up or not */
+    boot_stage_stack_ready();
     esp_zb_stack_main_loop();
 }
 
@@ -286,7 +461,20 @@ void app_main(void)
         .radio_config = ESP_ZB_DEFAULT_RADIO_CONFIG(),
         .host_config = ESP_ZB_DEFAULT_HOST_CONFIG(),
     };
+    boot_stage_mark(BOOT_PHASE_APP_MAIN);
+    ESP_ERROR_CHECK(deferred_log_init());
+#if DEFERRED_LOG_BENCHMARK
+    deferred_log_benchmark();
+#endif
+    latency_trace_init();
     ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(power_save_init());
+    ESP_ERROR_CHECK(driver_init());
+    ESP_ERROR_CHECK(ota_client_init());
+    boot_stage_mark(BOOT_PHASE_DRIVERS_READY);
     ESP_ERROR_CHECK(esp_zb_platform_config(&config));
-    xTaskCreate(esp_zb_task, "Zigbee_main", 4096, NULL, 5, NULL);
+    ESP_ERROR_CHECK(memory_report_add_task(xTaskGetHandle("light_tx"), LIGHT_DRIVER_TX_TASK_STACK_SIZE));
+    /* runs the button and LED frame timers */
+    ESP_ERROR_CHECK(memory_report_add_task(xTaskGetHandle("esp_timer"), CONFIG_ESP_TIMER_TASK_STACK_SIZE));
+    xTaskCreateStatic(esp_zb_task, "Zigbee_main", ESP_ZB_TASK_STACK_SIZE, NULL, ESP_ZB_TASK_PRIORITY, s_zb_task_stack, &s_zb_task_buffer);
 }
@@ -18,16 +18,33 @@
 #include "zcl_utility.h"
 
 /* Zigbee configuration */
+#define ESP_ZB_TASK_STACK_SIZE          4096    /* check it against the high-water mark logged by memory_report */
+#define ESP_ZB_TASK_PRIORITY            5
 #define INSTALLCODE_POLICY_ENABLE       false    /* enable the install code policy for security */
 #define ED_AGING_TIMEOUT                ESP_ZB_ED_AGING_TIMEOUT_64MIN
+#ifdef CONFIG_PM_ENABLE
+#define ED_KEEP_ALIVE                   30000   /* 30 seconds, the radio stays off between keep-alives on battery */
+#else
 #define ED_KEEP_ALIVE                   3000    /* 3000 millisecond */
+#endif
 #define BATHROOM_LIGHT_ENDPOINT         10
 #define BATHROOM_BINARY_INPUT_ENDPOINT  1
+#define BATHROOM_THERMOSTAT_ENDPOINT    2
+#define BATHROOM_TEMPERATURE_ENDPOINT   3
 #define ESP_ZB_PRIMARY_CHANNEL_MASK     ESP_ZB_TRANSCEIVER_ALL_CHANNELS_MASK  /* Zigbee primary channel mask use in the example */
 
-/* Basic manufacturer information */
-#define ESP_MANUFACTURER_NAME "\x09""ESPRESSIF"      /* Customized manufacturer name */
-#define ESP_MODEL_IDENTIFIER "\x24""ESP32-C6 Bathroom 0.0.11" /* Customized model identifier */
+/* Buttons */
+#define BATHROOM_SWITCH_GPIO            10      /* toggles the Binary Input PresentValue */
+#define BATHROOM_RESET_GPIO             11      /* Zigbee factory reset, once held long enough */
+#define BATHROOM_STATUS_GPIO            GPIO_INPUT_IO_TOGGLE_SWITCH  /* BOOT button, shows Eco/Comfort on the LED */
+#define BATHROOM_RESET_HOLD_MS          5000
+
+/* Reporting */
+#define BINARY_INPUT_REPORT_WINDOW_MS   300     /* toggles within this window are sent as a single report */
+
+/* Basic manufacturer information, the ZCL length prefix is added by ZCL_UTILITY_STRING */
+#define ESP_MANUFACTURER_NAME "ESPRESSIF"                   /* Customized manufacturer name */
+#define ESP_MODEL_IDENTIFIER "ESP32-C6 Bathroom 0.0.11"     /* Customized model identifier */
 
 #define ESP_ZB_ZED_CONFIG()                                         \
     {                                                               \
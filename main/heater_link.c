@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include "command_tracker.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zb_light.h"
+#include "heater_link.h"
+#include "latency_trace.h"
+
+static const char *TAG = "HEATER_LINK";
+
+static command_tracker_t s_tracker;
+static bool s_heating;
+/* on a network, the commands can be sent */
+static bool s_ready;
+static bool s_refreshing;
+
+static int64_t heater_link_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void heater_link_alarm_cb(uint8_t param);
+
+static void heater_link_schedule(int64_t next_ms)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)heater_link_alarm_cb, 0);
+    if (next_ms == COMMAND_TRACKER_NO_DEADLINE) {
+        return;
+    }
+    int64_t delay_ms = next_ms - heater_link_now_ms();
+    esp_zb_scheduler_alarm((esp_zb_callback_t)heater_link_alarm_cb, 0, delay_ms > 0 ? (uint32_t)delay_ms : 0);
+}
+
+static void heater_link_send(bool retry)
+{
+    /* On and Off rather than Toggle: repeating a command cannot flip the heater back */
+    esp_zb_zcl_on_off_cmd_t cmd_req = {
+        .zcl_basic_cmd.src_endpoint = BATHROOM_BINARY_INPUT_ENDPOINT,
+        .address_mode = ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+        .on_off_cmd_id = s_heating ? ESP_ZB_ZCL_CMD_ON_OFF_ON_ID : ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID,
+    };
+    uint8_t tsn = esp_zb_zcl_on_off_cmd_req(&cmd_req);
+    latency_trace_point(LATENCY_TRACE_COMMAND_REQUEST);
+    heater_link_schedule(command_tracker_sent(&s_tracker, tsn, retry, heater_link_now_ms()));
+}
+
+static void heater_link_refresh_bindings(void);
+
+static void heater_link_alarm_cb(uint8_t param)
+{
+    int64_t next_ms;
+    switch (command_tracker_poll(&s_tracker, heater_link_now_ms(), &next_ms)) {
+    case COMMAND_TRACKER_RETRY:
+        DEFERRED_LOGW(TAG, "Heater %s not acknowledged, attempt %d", s_heating ? "on" : "off", s_tracker.attempts + 1);
+        heater_link_send(true);
+        return;
+    case COMMAND_TRACKER_FAILED:
+        DEFERRED_LOGW(TAG, "Heater %s not acknowledged after %d attempts", s_heating ? "on" : "off", s_tracker.attempts);
+        /* a target may have left or got a new network address */
+        heater_link_refresh_bindings();
+        break;
+    case COMMAND_TRACKER_IDLE:
+        break;
+    }
+    heater_link_schedule(next_ms);
+}
+
+static void heater_link_request_bindings(uint8_t start_index);
+
+static void heater_link_binding_cb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx)
+{
+    if (table_info->status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "Failed to read the binding table: status(0x%x)", table_info->status);
+        s_refreshing = false;
+        return;
+    }
+    if (table_info->index == 0) {
+        command_tracker_clear_targets(&s_tracker);
+    }
+    for (const esp_zb_zdo_binding_table_record_t *record = table_info->record; record; record = record->next) {
+        /* group bindings are delivered too, but a multicast is never acknowledged */
+        if (record->src_endp != BATHROOM_BINARY_INPUT_ENDPOINT || record->cluster_id != ESP_ZB_ZCL_CLUSTER_ID_ON_OFF ||
+            record->dst_addr_mode != ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED) {
+            continue;
+        }
+        uint16_t short_addr = esp_zb_address_short_by_ieee((uint8_t *)record->dst_address.addr_long);
+        if (!command_tracker_add_target(&s_tracker, short_addr, record->dst_endp)) {
+            ESP_LOGW(TAG, "Heater 0x%04hx endpoint(%d) not tracked", short_addr, record->dst_endp);
+        }
+    }
+    uint8_t next_index = table_info->index + table_info->count;
+    if (table_info->count > 0 && next_index < table_info->total) {
+        heater_link_request_bindings(next_index);
+        return;
+    }
+    s_refreshing = false;
+    ESP_LOGI(TAG, "%d heater(s) bound", s_tracker.target_count);
+}
+
+static void heater_link_request_bindings(uint8_t start_index)
+{
+    esp_zb_zdo_mgmt_bind_param_t req = {
+        .start_index = start_index,
+        .dst_addr = esp_zb_get_short_address(),
+    };
+    esp_zb_zdo_binding_table_req(&req, heater_link_binding_cb, NULL);
+}
+
+static void heater_link_refresh_bindings(void)
+{
+    if (!s_refreshing) {
+        s_refreshing = true;
+        heater_link_request_bindings(0);
+    }
+}
+
+static void heater_link_refresh_cb(uint8_t param)
+{
+    heater_link_refresh_bindings();
+    esp_zb_scheduler_alarm((esp_zb_callback_t)heater_link_refresh_cb, 0, HEATER_LINK_BINDING_REFRESH_MS);
+}
+
+void heater_link_init(void)
+{
+    command_tracker_init(&s_tracker, HEATER_LINK_ACK_TIMEOUT_MS, HEATER_LINK_MAX_ATTEMPTS);
+}
+
+void heater_link_set(bool heating)
+{
+    s_heating = heating;
+    if (s_ready) {
+        heater_link_send(false);
+    }
+}
+
+void heater_link_network_ready(void)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)heater_link_refresh_cb, 0);
+    heater_link_refresh_cb(0);
+    /* the heaters may have missed changes while the device was away; until the table
+     * has been read the command is not tracked, the next one will be */
+    s_ready = true;
+    heater_link_send(false);
+}
+
+esp_err_t heater_link_handle_default_response(const esp_zb_zcl_cmd_default_resp_message_t *message)
+{
+    if (message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_ON_OFF || message->info.dst_endpoint != BATHROOM_BINARY_INPUT_ENDPOINT) {
+        return ESP_OK;
+    }
+    uint16_t short_addr = message->info.src_address.u.short_addr;
+    if (message->status_code != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        /* answered all the same, repeating the command would not help */
+        DEFERRED_LOGW(TAG, "Heater 0x%04hx refused the command: status(0x%x)", short_addr, message->status_code);
+    }
+    if (command_tracker_ack(&s_tracker, message->info.header.tsn, short_addr, message->info.src_endpoint)) {
+        latency_trace_point(LATENCY_TRACE_COMMAND_ACK);
+        heater_link_schedule(COMMAND_TRACKER_NO_DEADLINE);
+        DEFERRED_LOGI(TAG, "Heater %s acknowledged in %" PRIu32 " ms", s_heating ? "on" : "off",
+                      (uint32_t)(heater_link_now_ms() - s_tracker.sent_ms));
+    }
+    return ESP_OK;
+}
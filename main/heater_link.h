@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Direct control of the heater: the On/Off client of the binary input endpoint
+ * sends the heating output of the thermostat as On and Off commands to the
+ * devices bound to it, e.g. a smart plug, so the heater follows the button and
+ * the temperature without a round trip through the coordinator and keeps
+ * working when the home automation server is down. The bindings are made from
+ * the coordinator like any other (source endpoint BATHROOM_BINARY_INPUT_ENDPOINT,
+ * cluster On/Off) and read back from the local binding table, which gives the
+ * targets whose Default Response is awaited; unanswered commands are repeated.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Wait for the Default Responses of one attempt, a sleepy end device only gets them at its next poll */
+#define HEATER_LINK_ACK_TIMEOUT_MS          3000
+#define HEATER_LINK_MAX_ATTEMPTS            3
+/* The coordinator may add or remove bindings at any time, read the table again this often */
+#define HEATER_LINK_BINDING_REFRESH_MS      (10 * 60 * 1000)
+
+/**
+ * @brief Initialize the link, call before the thermostat starts
+ */
+void heater_link_init(void);
+
+/**
+ * @brief Set the state the bound heaters must be in, sent right away once the device is on a network
+ *
+ * @param heating  true to switch them on
+ */
+void heater_link_set(bool heating);
+
+/**
+ * @brief Read the binding table and send the current state, call once the device has joined the network
+ */
+void heater_link_network_ready(void);
+
+/**
+ * @brief Handle a Default Response, i.e. ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID
+ *
+ * @param message  The Default Response, those to other clusters or endpoints are ignored
+ * @return ESP_OK
+ */
+esp_err_t heater_link_handle_default_response(const esp_zb_zcl_cmd_default_resp_message_t *message);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "join_backoff.h"
+
+static uint32_t join_backoff_popcount(uint32_t mask)
+{
+    uint32_t count = 0;
+    for (; mask; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+static join_backoff_attempt_t join_backoff_attempt(join_backoff_t *jb, uint32_t delay_ms)
+{
+    uint32_t channel_mask = jb->config.all_channels_mask;
+    if (jb->last_channel != JOIN_BACKOFF_NO_CHANNEL && jb->attempts < jb->config.last_channel_tries &&
+        (channel_mask & (1UL << jb->last_channel))) {
+        channel_mask = 1UL << jb->last_channel;
+    }
+    jb->attempts++;
+    jb->channels_scanned += join_backoff_popcount(channel_mask);
+    return (join_backoff_attempt_t) {
+        .channel_mask = channel_mask,
+        .delay_ms = delay_ms,
+    };
+}
+
+/* Exponential backoff with equal jitter: half the delay is fixed, the other half is random */
+static uint32_t join_backoff_delay_ms(const join_backoff_t *jb, uint32_t random)
+{
+    uint32_t delay_ms = jb->config.first_delay_ms;
+    for (uint16_t failure = 1; failure < jb->failures && delay_ms < jb->config.max_delay_ms; failure++) {
+        delay_ms *= 2;
+    }
+    if (delay_ms > jb->config.max_delay_ms) {
+        delay_ms = jb->config.max_delay_ms;
+    }
+    return delay_ms - delay_ms / 2 + random % (delay_ms / 2 + 1);
+}
+
+void join_backoff_init(join_backoff_t *jb, const join_backoff_config_t *config, uint8_t last_channel)
+{
+    *jb = (join_backoff_t) {
+        .config = *config,
+        .last_channel = last_channel,
+    };
+}
+
+join_backoff_attempt_t join_backoff_start(join_backoff_t *jb)
+{
+    jb->failures = 0;
+    jb->attempts = 0;
+    jb->channels_scanned = 0;
+    return join_backoff_attempt(jb, 0);
+}
+
+join_backoff_attempt_t join_backoff_failed(join_backoff_t *jb, uint32_t random)
+{
+    jb->failures++;
+    return join_backoff_attempt(jb, join_backoff_delay_ms(jb, random));
+}
+
+void join_backoff_joined(join_backoff_t *jb, uint8_t channel)
+{
+    jb->last_channel = channel;
+    jb->failures = 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Core of the network steering retry strategy. The channel of the last network
+ * joined is tried alone first, which after a coordinator restart finds the
+ * network again with a single-channel scan. After that every attempt scans all
+ * the channels, with an exponential backoff capped at a maximum delay and
+ * jittered so that devices that lost the network together do not scan in step.
+ *
+ * The random numbers are passed in by the caller and the module has no
+ * ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* No network joined yet */
+#define JOIN_BACKOFF_NO_CHANNEL     0
+
+typedef struct {
+    uint32_t all_channels_mask;     /*!< Channels scanned once the last channel has failed */
+    uint8_t last_channel_tries;     /*!< Attempts on the last channel alone before scanning all the channels */
+    uint32_t first_delay_ms;        /*!< Delay before the first retry */
+    uint32_t max_delay_ms;          /*!< The backoff stops growing there */
+} join_backoff_config_t;
+
+typedef struct {
+    join_backoff_config_t config;
+    uint8_t last_channel;           /*!< Channel of the last network joined, JOIN_BACKOFF_NO_CHANNEL if none */
+    uint16_t failures;              /*!< Failed attempts since the last join */
+    uint16_t attempts;              /*!< Attempts since the last join, including the one in progress */
+    uint32_t channels_scanned;      /*!< Channels scanned since the last join, one per channel of each attempt */
+} join_backoff_t;
+
+typedef struct {
+    uint32_t channel_mask;          /*!< Channels to scan */
+    uint32_t delay_ms;              /*!< Wait before starting the attempt */
+} join_backoff_attempt_t;
+
+/**
+ * @brief Initialize the strategy
+ *
+ * @param jb            The strategy to initialize
+ * @param config        Timings and channels
+ * @param last_channel  Channel of the last network joined, JOIN_BACKOFF_NO_CHANNEL if none
+ */
+void join_backoff_init(join_backoff_t *jb, const join_backoff_config_t *config, uint8_t last_channel);
+
+/**
+ * @brief Get the first attempt of a join, started without delay
+ *
+ * @param jb  The strategy
+ * @return The attempt to make
+ */
+join_backoff_attempt_t join_backoff_start(join_backoff_t *jb);
+
+/**
+ * @brief Get the next attempt after a failed one
+ *
+ * @param jb      The strategy
+ * @param random  A random number, used for the jitter
+ * @return The attempt to make
+ */
+join_backoff_attempt_t join_backoff_failed(join_backoff_t *jb, uint32_t random);
+
+/**
+ * @brief Record a successful join, the next join starts from this channel
+ *
+ * @param jb       The strategy
+ * @param channel  Channel of the network joined
+ */
+void join_backoff_joined(join_backoff_t *jb, uint8_t channel);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,202 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "deferred_log.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_zb_light.h"
+#include "light_scenes.h"
+#include "light_state.h"
+#include "nvs.h"
+#include "scene_table.h"
+#include "state_journal.h"
+#include "state_store.h"
+
+static const char *TAG = "LIGHT_SCENES";
+
+#define LIGHT_SCENES_KEY    "table"
+
+typedef struct {
+    state_journal_header_t header;
+    scene_table_t table;
+} light_scenes_record_t;
+
+/* Clusters of the extension field sets of every scene */
+static const uint16_t s_scene_clusters[] = {
+    SCENE_TABLE_ON_OFF_CLUSTER_ID,
+    SCENE_TABLE_LEVEL_CLUSTER_ID,
+    SCENE_TABLE_COLOR_CLUSTER_ID,
+};
+
+static nvs_handle_t s_nvs;
+static scene_table_t s_table;
+/* only numbers and checks the saved records, the table is saved as soon as a scene is stored */
+static state_journal_t s_journal;
+static bool s_scene_valid;
+
+static scene_table_state_t light_scenes_current_state(void)
+{
+    const light_driver_state_t *light = light_state_get();
+    return (scene_table_state_t) {
+        .power = light->power,
+        .level = light->level,
+        .color_x = light->color_x,
+        .color_y = light->color_y,
+    };
+}
+
+static void light_scenes_set_attr(uint16_t cluster_id, uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_set_attribute_val(BATHROOM_LIGHT_ENDPOINT, cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id, value, false);
+}
+
+static void light_scenes_set_current(uint16_t group_id, uint8_t scene_id)
+{
+    s_scene_valid = true;
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID, &group_id);
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID, &scene_id);
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID, &s_scene_valid);
+}
+
+/* The stack keeps its own copy, it answers View Scene and Get Scene Membership from it */
+static esp_err_t light_scenes_register(const scene_table_entry_t *entry)
+{
+    uint8_t values[PAIR_SIZE(s_scene_clusters)][SCENE_TABLE_FIELD_SET_MAX_LENGTH];
+    esp_zb_zcl_scenes_extension_field_t fields[PAIR_SIZE(s_scene_clusters)];
+    for (size_t i = 0; i < PAIR_SIZE(s_scene_clusters); i++) {
+        fields[i] = (esp_zb_zcl_scenes_extension_field_t) {
+            .cluster_id = s_scene_clusters[i],
+            .length = scene_table_encode_field_set(&entry->state, s_scene_clusters[i], values[i]),
+            .extension_field_attribute_value_list = values[i],
+            .next = i + 1 < PAIR_SIZE(s_scene_clusters) ? &fields[i + 1] : NULL,
+        };
+    }
+    return esp_zb_zcl_scenes_table_store(BATHROOM_LIGHT_ENDPOINT, entry->group_id, entry->scene_id, 0, fields);
+}
+
+static esp_err_t light_scenes_save(void)
+{
+    light_scenes_record_t record = { .table = s_table };
+    state_journal_encode(&s_journal, &record.header, &record.table, sizeof(record.table));
+    ESP_RETURN_ON_ERROR(nvs_set_blob(s_nvs, LIGHT_SCENES_KEY, &record, sizeof(record)), TAG, "Failed to write the scenes");
+    return nvs_commit(s_nvs);
+}
+
+esp_err_t light_scenes_init(void)
+{
+    scene_table_init(&s_table);
+    state_journal_init(&s_journal, 0, 0, 0);
+    ESP_RETURN_ON_ERROR(nvs_open(LIGHT_SCENES_NAMESPACE, NVS_READWRITE, &s_nvs), TAG, "Failed to open NVS namespace");
+
+    light_scenes_record_t record;
+    size_t length = sizeof(record);
+    esp_err_t err = nvs_get_blob(s_nvs, LIGHT_SCENES_KEY, &record, &length);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to read the scenes");
+    if (length != sizeof(record) || !state_journal_check(&record.header, &record.table, sizeof(record.table))) {
+        ESP_LOGW(TAG, "Saved scenes are not valid, dropped");
+        return ESP_OK;
+    }
+    s_table = record.table;
+    state_journal_init(&s_journal, 0, 0, record.header.sequence);
+    for (int i = 0; i < SCENE_TABLE_MAX_SCENES; i++) {
+        const scene_table_entry_t *entry = &s_table.entries[i];
+        if (entry->used && light_scenes_register(entry) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to restore scene %d of group 0x%x", entry->scene_id, entry->group_id);
+        }
+    }
+    ESP_LOGI(TAG, "%d scene(s) restored", scene_table_count(&s_table));
+    return ESP_OK;
+}
+
+esp_err_t light_scenes_erase(void)
+{
+    nvs_handle_t handle;
+    ESP_RETURN_ON_ERROR(nvs_open(LIGHT_SCENES_NAMESPACE, NVS_READWRITE, &handle), TAG, "Failed to open NVS namespace");
+    esp_err_t err = nvs_erase_all(handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to erase the scenes");
+    scene_table_init(&s_table);
+    return ESP_OK;
+}
+
+void light_scenes_command(uint16_t cluster_id, uint8_t command_id, const uint8_t *payload, size_t length)
+{
+    uint8_t removed = scene_table_apply_command(&s_table, cluster_id, command_id, payload, length);
+    if (removed == 0) {
+        return;
+    }
+    if (light_scenes_save() != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save the scenes left");
+    }
+    DEFERRED_LOGI(TAG, "%d scene(s) removed, %d left", removed, scene_table_count(&s_table));
+}
+
+esp_err_t light_scenes_store(const esp_zb_zcl_store_scene_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "Received message: error status(%d)",
+                        message->info.status);
+    /* include writes still waiting for the settle window */
+    light_state_commit();
+    scene_table_state_t state = light_scenes_current_state();
+    const scene_table_entry_t *entry = scene_table_store(&s_table, message->group_id, message->scene_id, &state);
+    ESP_RETURN_ON_FALSE(entry, ESP_ERR_NO_MEM, TAG, "No room for scene %d of group 0x%x", message->scene_id, message->group_id);
+    ESP_RETURN_ON_ERROR(light_scenes_register(entry), TAG, "Failed to hand scene %d to the stack", message->scene_id);
+    ESP_RETURN_ON_ERROR(light_scenes_save(), TAG, "Failed to save scene %d", message->scene_id);
+    light_scenes_set_current(message->group_id, message->scene_id);
+    DEFERRED_LOGI(TAG, "Scene %d of group 0x%x stored", message->scene_id, message->group_id);
+    return ESP_OK;
+}
+
+esp_err_t light_scenes_recall(const esp_zb_zcl_recall_scene_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "Received message: error status(%d)",
+                        message->info.status);
+    /* the field sets of the stack also cover scenes added with Add Scene, the table only those stored here */
+    scene_table_state_t state = light_scenes_current_state();
+    if (message->field_set) {
+        for (const esp_zb_zcl_scenes_extension_field_t *field = message->field_set; field; field = field->next) {
+            scene_table_decode_field_set(&state, field->cluster_id, field->extension_field_attribute_value_list, field->length);
+        }
+    } else {
+        const scene_table_entry_t *entry = scene_table_find(&s_table, message->group_id, message->scene_id);
+        ESP_RETURN_ON_FALSE(entry, ESP_ERR_NOT_FOUND, TAG, "Unknown scene %d of group 0x%x", message->scene_id, message->group_id);
+        state = entry->state;
+    }
+
+    bool power = state.power;
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, &power);
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &state.level);
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, &state.color_x);
+    light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, &state.color_y);
+
+    /* TransitionTime of the command in tenths of a second, 0xFFFF asks for the one of the scene, which is not kept */
+    uint32_t transition_ms = message->transition_time == 0xFFFF ? 0 : (uint32_t)message->transition_time * 100;
+    light_driver_state_t light = {
+        .power = power,
+        .level = state.level,
+        .color_x = state.color_x,
+        .color_y = state.color_y,
+    };
+    light_state_apply(&light, transition_ms);
+    state_store_touch();
+    light_scenes_set_current(message->group_id, message->scene_id);
+    DEFERRED_LOGI(TAG, "Scene %d of group 0x%x recalled", message->scene_id, message->group_id);
+    return ESP_OK;
+}
+
+void light_scenes_invalidate(void)
+{
+    if (s_scene_valid) {
+        s_scene_valid = false;
+        light_scenes_set_attr(ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID, &s_scene_valid);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Scenes (0x0005) of the light endpoint, with the Groups (0x0004) server for
+ * group-addressed recalls. A Store Scene command saves the current on/off,
+ * level and xy colour into scene_table, which is kept in the nvs partition and
+ * handed back to the stack at boot. The commands that remove scenes from the
+ * stack (Remove Scene, Remove All Scenes, Remove Group, Remove All Groups) are
+ * mirrored in the saved table, so a removed scene does not come back at boot.
+ * A Recall Scene command sets the whole state in the attribute store and
+ * commits it to the LED at once, so one frame does what an On/Off, a Level and
+ * a Color Control command did with a refresh each.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_SCENES_NAMESPACE      "scenes"
+
+/**
+ * @brief Restore the saved scenes into the stack, call once the device is registered
+ *
+ * @return
+ *      - ESP_OK: On success, also when nothing has been saved yet
+ *      - Others: NVS errors
+ */
+esp_err_t light_scenes_init(void);
+
+/**
+ * @brief Forget the saved scenes, call on a factory reset before esp_zb_factory_reset()
+ *
+ * @return
+ *      - ESP_OK: On success
+ *      - Others: NVS errors
+ */
+esp_err_t light_scenes_erase(void);
+
+/**
+ * @brief Mirror a Scenes or Groups command of the light endpoint that removes scenes, before the stack handles it
+ *
+ * Other commands are ignored. The saved table is written again if it changed.
+ *
+ * @param cluster_id  Cluster of the command
+ * @param command_id  Command identifier, client to server
+ * @param payload     Command payload, after the ZCL header
+ * @param length      Length of @p payload
+ */
+void light_scenes_command(uint16_t cluster_id, uint8_t command_id, const uint8_t *payload, size_t length);
+
+/**
+ * @brief Handle a Store Scene command, i.e. ESP_ZB_CORE_SCENES_STORE_SCENE_CB_ID
+ *
+ * @param message  The Store Scene message
+ * @return
+ *      - ESP_OK: The scene has been stored
+ *      - ESP_ERR_NO_MEM: The scene table is full
+ *      - Others: NVS errors
+ */
+esp_err_t light_scenes_store(const esp_zb_zcl_store_scene_message_t *message);
+
+/**
+ * @brief Handle a Recall Scene command, i.e. ESP_ZB_CORE_SCENES_RECALL_SCENE_CB_ID
+ *
+ * @param message  The Recall Scene message
+ * @return
+ *      - ESP_OK: The scene is shown
+ *      - ESP_ERR_NOT_FOUND: Unknown scene
+ */
+esp_err_t light_scenes_recall(const esp_zb_zcl_recall_scene_message_t *message);
+
+/**
+ * @brief Note that the light no longer shows the last scene, call when an attribute of the light is written
+ */
+void light_scenes_invalidate(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
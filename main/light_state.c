@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "deferred_log.h"
+#include "esp_zigbee_core.h"
+#include "light_state.h"
+
+static const char *TAG = "LIGHT_STATE";
+
+static light_driver_state_t s_staged;
+static light_driver_state_t s_committed;
+static bool s_commit_scheduled;
+static uint32_t s_on_off_transition_ms;
+static bool s_overridden;
+
+static bool light_state_equal(const light_driver_state_t *a, const light_driver_state_t *b)
+{
+    return a->power == b->power && a->level == b->level && a->color_x == b->color_x && a->color_y == b->color_y;
+}
+
+static void light_state_show(const light_driver_state_t *state, uint32_t transition_ms)
+{
+    // For some reason, x and y are inverted either in HA or here, but doing so gives better results.
+    light_driver_state_t shown = *state;
+    shown.color_x = state->color_y;
+    shown.color_y = state->color_x;
+    light_driver_fade_to_state(&shown, transition_ms);
+}
+
+static void light_state_commit_cb(uint8_t param)
+{
+    s_commit_scheduled = false;
+    light_state_commit();
+}
+
+static void light_state_schedule_commit(void)
+{
+    if (!s_commit_scheduled) {
+        s_commit_scheduled = true;
+        esp_zb_scheduler_alarm((esp_zb_callback_t)light_state_commit_cb, 0, LIGHT_STATE_SETTLE_MS);
+    }
+}
+
+void light_state_init(const light_driver_state_t *initial)
+{
+    s_staged = *initial;
+    s_committed = *initial;
+    light_state_show(&s_committed, 0);
+}
+
+void light_state_set_on_off_transition(uint16_t transition_ds)
+{
+    s_on_off_transition_ms = (uint32_t)transition_ds * 100;
+}
+
+void light_state_stage_power(bool power)
+{
+    s_staged.power = power;
+    light_state_schedule_commit();
+}
+
+void light_state_stage_level(uint8_t level)
+{
+    s_staged.level = level;
+    light_state_schedule_commit();
+}
+
+void light_state_stage_color_x(uint16_t color_x)
+{
+    s_staged.color_x = color_x;
+    light_state_schedule_commit();
+}
+
+void light_state_stage_color_y(uint16_t color_y)
+{
+    s_staged.color_y = color_y;
+    light_state_schedule_commit();
+}
+
+static void light_state_commit_with(uint32_t transition_ms)
+{
+    if (s_commit_scheduled) {
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)light_state_commit_cb, 0);
+        s_commit_scheduled = false;
+    }
+    if (light_state_equal(&s_staged, &s_committed)) {
+        return;
+    }
+    s_committed = s_staged;
+    DEFERRED_LOGI(TAG, "Light %s, level %d, color x 0x%x y 0x%x", s_committed.power ? "on" : "off", s_committed.level,
+                  s_committed.color_x, s_committed.color_y);
+    if (!s_overridden) {
+        light_state_show(&s_committed, transition_ms);
+    }
+}
+
+void light_state_apply(const light_driver_state_t *state, uint32_t transition_ms)
+{
+    s_staged = *state;
+    light_state_commit_with(transition_ms);
+}
+
+void light_state_commit(void)
+{
+    light_state_commit_with(s_staged.power != s_committed.power ? s_on_off_transition_ms : LIGHT_STATE_STEP_FADE_MS);
+}
+
+void light_state_override(const light_driver_state_t *state, uint32_t transition_ms)
+{
+    s_overridden = true;
+    light_driver_fade_to_state(state, transition_ms);
+}
+
+void light_state_release(uint32_t transition_ms)
+{
+    if (s_overridden) {
+        s_overridden = false;
+        light_state_show(&s_committed, transition_ms);
+    }
+}
+
+const light_driver_state_t *light_state_get(void)
+{
+    return &s_committed;
+}
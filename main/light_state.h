@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Light state aggregator. On/Off, Level Control and Color Control attribute
+ * writes are staged here and committed to the LED in one frame once the
+ * settle window has elapsed, so a colour change (CurrentX then CurrentY)
+ * costs one conversion and one refresh and never shows an intermediate colour.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "light_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Delay between the first staged change and the LED commit */
+#define LIGHT_STATE_SETTLE_MS       10
+
+/* Fade applied to level and colour changes. The stack already turns the TransitionTime of
+   Level/Color Control commands into a series of attribute updates, this smooths between them. */
+#define LIGHT_STATE_STEP_FADE_MS    100
+
+/**
+ * @brief Initialize the aggregator and show the initial state
+ *
+ * @param initial  The state currently held by the attribute store
+ */
+void light_state_init(const light_driver_state_t *initial);
+
+/**
+ * @brief Stage the On/Off attribute
+ *
+ * @param power  The new on/off value
+ */
+void light_state_stage_power(bool power);
+
+/**
+ * @brief Stage the CurrentLevel attribute
+ *
+ * @param level  The new level
+ */
+void light_state_stage_level(uint8_t level);
+
+/**
+ * @brief Stage the CurrentX attribute
+ *
+ * @param color_x  The new color x
+ */
+void light_state_stage_color_x(uint16_t color_x);
+
+/**
+ * @brief Stage the CurrentY attribute
+ *
+ * @param color_y  The new color y
+ */
+void light_state_stage_color_y(uint16_t color_y);
+
+/**
+ * @brief Set the fade used when the light is switched on or off
+ *
+ * @param transition_ds  The Level Control OnOffTransitionTime attribute, in tenths of a second
+ */
+void light_state_set_on_off_transition(uint16_t transition_ds);
+
+/**
+ * @brief Stage a whole state and commit it right away, e.g. a recalled scene
+ *
+ * @param state          The new on/off, level and colour
+ * @param transition_ms  Fade to @p state
+ */
+void light_state_apply(const light_driver_state_t *state, uint32_t transition_ms);
+
+/**
+ * @brief Commit staged changes right away instead of waiting for the settle window
+ */
+void light_state_commit(void);
+
+/**
+ * @brief Take the LED over, e.g. for a status indication
+ *
+ * Attribute changes keep being committed while the LED is overridden, they are shown once it is
+ * released. The state is given to the light driver as is, it is not an attribute state.
+ *
+ * @param state          The state to show
+ * @param transition_ms  Fade to @p state
+ */
+void light_state_override(const light_driver_state_t *state, uint32_t transition_ms);
+
+/**
+ * @brief Give the LED back to the committed state
+ *
+ * @param transition_ms  Fade to the committed state
+ */
+void light_state_release(uint32_t transition_ms);
+
+/**
+ * @brief Get the state last committed to the LED
+ */
+const light_driver_state_t *light_state_get(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "memory_report.h"
+
+static const char *TAG = "MEMORY_REPORT";
+
+typedef struct {
+    TaskHandle_t task;
+    uint32_t stack_size;
+} memory_report_entry_t;
+
+/* only written while the tasks start, before the Zigbee task first reads them */
+static memory_report_entry_t s_tasks[MEMORY_REPORT_MAX_TASKS];
+static uint8_t s_task_count;
+
+esp_err_t memory_report_add_task(TaskHandle_t task, uint32_t stack_size)
+{
+    ESP_RETURN_ON_FALSE(task, ESP_ERR_INVALID_ARG, TAG, "Task not created");
+    ESP_RETURN_ON_FALSE(s_task_count < MEMORY_REPORT_MAX_TASKS, ESP_ERR_NO_MEM, TAG, "Too many tasks");
+    s_tasks[s_task_count++] = (memory_report_entry_t) {
+        .task = task,
+        .stack_size = stack_size,
+    };
+    return ESP_OK;
+}
+
+void memory_report_get(memory_report_t *report)
+{
+    report->heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    report->heap_free_min = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    report->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    report->stack_free_min = UINT32_MAX;
+    report->task_count = s_task_count;
+    for (uint8_t i = 0; i < s_task_count; i++) {
+        /* the stack depth unit of ESP-IDF FreeRTOS is the byte */
+        memory_report_task_t *task = &report->tasks[i];
+        task->name = pcTaskGetName(s_tasks[i].task);
+        task->stack_size = s_tasks[i].stack_size;
+        task->stack_free_min = uxTaskGetStackHighWaterMark(s_tasks[i].task);
+        if (task->stack_free_min < report->stack_free_min) {
+            report->stack_free_min = task->stack_free_min;
+        }
+    }
+}
+
+void memory_report_log(void)
+{
+    memory_report_t report;
+    memory_report_get(&report);
+    ESP_LOGI(TAG, "Heap %" PRIu32 " bytes free, %" PRIu32 " at the lowest, largest block %" PRIu32 " bytes", report.heap_free, report.heap_free_min,
+             report.heap_largest_block);
+    for (uint8_t i = 0; i < report.task_count; i++) {
+        const memory_report_task_t *task = &report.tasks[i];
+        ESP_LOGI(TAG, "Task %s: %" PRIu32 " of %" PRIu32 " stack bytes used at the most", task->name, task->stack_size - task->stack_free_min,
+                 task->stack_size);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Runtime view of the memory budget: the stack high-water mark of every task
+ * of the application, and the state of the default heap (free bytes, lowest
+ * free bytes since boot, largest free block). Tasks and their synchronization
+ * objects are allocated statically, so after boot the heap is left to the
+ * Zigbee stack and the drivers; a largest free block shrinking while the free
+ * bytes stay put is the sign of fragmentation.
+ *
+ * The static part of the budget is reported at build time by idf.py size and
+ * idf.py size-components, see the README.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tasks that can be added to the report */
+#define MEMORY_REPORT_MAX_TASKS     8
+
+typedef struct {
+    const char *name;
+    uint32_t stack_size;            /*!< Bytes */
+    uint32_t stack_free_min;        /*!< Bytes never used since the task started */
+} memory_report_task_t;
+
+typedef struct {
+    uint32_t heap_free;             /*!< Free bytes of the default heap */
+    uint32_t heap_free_min;         /*!< Lowest heap_free since boot */
+    uint32_t heap_largest_block;    /*!< Largest block the default heap can allocate */
+    uint32_t stack_free_min;        /*!< Lowest stack_free_min of the tasks */
+    uint8_t task_count;
+    memory_report_task_t tasks[MEMORY_REPORT_MAX_TASKS];
+} memory_report_t;
+
+/**
+ * @brief Add a task to the report, call at start-up, before the Zigbee task reads the report
+ *
+ * @param task        The task, NULL if it could not be created
+ * @param stack_size  Its stack size in bytes
+ * @return
+ *      - ESP_OK: The task is reported
+ *      - ESP_ERR_INVALID_ARG: The task was not created
+ *      - ESP_ERR_NO_MEM: MEMORY_REPORT_MAX_TASKS are already reported
+ */
+esp_err_t memory_report_add_task(TaskHandle_t task, uint32_t stack_size);
+
+/**
+ * @brief Read the stack high-water marks and the heap state, safe from any task
+ *
+ * @param report  Filled with the current state
+ */
+void memory_report_get(memory_report_t *report);
+
+/**
+ * @brief Log the current state, one line for the heap and one per task
+ */
+void memory_report_log(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,393 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "esp_app_format.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/sha256.h"
+#include "memory_report.h"
+#include "ota_client.h"
+#include "ota_image.h"
+
+static const char *TAG = "OTA_CLIENT";
+
+#define OTA_CLIENT_DIGEST_SIZE  32
+
+typedef enum {
+    OTA_CLIENT_JOB_BEGIN,       /*!< Open the update partition for an image of length bytes */
+    OTA_CLIENT_JOB_WRITE,       /*!< Write length bytes of a buffer, then free it */
+    OTA_CLIENT_JOB_END,         /*!< Check and close the image, then signal s_done */
+    OTA_CLIENT_JOB_ABORT,       /*!< Drop the image */
+} ota_client_job_type_t;
+
+typedef struct {
+    ota_client_job_type_t type;
+    uint8_t buffer;
+    uint32_t length;
+} ota_client_job_t;
+
+/* Zigbee task side */
+static bool s_active;
+static ota_image_t s_image;
+static uint8_t s_fill;              /* buffer being filled */
+static uint32_t s_fill_length;
+static bool s_holding;              /* the Zigbee task owns s_fill */
+static uint32_t s_received;
+static uint8_t s_progress;          /* last progress logged, in tenths */
+static int64_t s_start_us;
+static bool s_pending_verify;
+
+/* shared, the queue and the semaphores order the accesses */
+static uint8_t s_buffers[OTA_CLIENT_BUFFER_COUNT][OTA_CLIENT_BUFFER_SIZE];
+static QueueHandle_t s_jobs;
+static StaticQueue_t s_jobs_buffer;
+static uint8_t s_jobs_storage[OTA_CLIENT_BUFFER_COUNT + 2][sizeof(ota_client_job_t)];
+static SemaphoreHandle_t s_free;    /* counts the buffers the Zigbee task may fill */
+static StaticSemaphore_t s_free_buffer;
+static SemaphoreHandle_t s_done;    /* given by the writer when an image is closed */
+static StaticSemaphore_t s_done_buffer;
+static StackType_t s_writer_stack[OTA_CLIENT_WRITER_STACK_SIZE];
+static StaticTask_t s_writer_buffer;
+
+/* writer task side, s_result is read by the Zigbee task once s_done is given */
+static const esp_partition_t *s_partition;
+static esp_ota_handle_t s_handle;
+static esp_err_t s_result;
+static bool s_open;                 /* an image is being written */
+static uint32_t s_image_length;
+static uint32_t s_written;
+static bool s_hash_appended;
+static mbedtls_sha256_context s_sha;
+static uint8_t s_appended_digest[OTA_CLIENT_DIGEST_SIZE];
+
+static void ota_client_writer_begin(uint32_t length)
+{
+    s_image_length = length;
+    s_written = 0;
+    s_hash_appended = false;
+    s_partition = esp_ota_get_next_update_partition(NULL);
+    if (!s_partition) {
+        s_result = ESP_ERR_NOT_FOUND;
+        ESP_LOGE(TAG, "No OTA partition to write to");
+        return;
+    }
+    /* erase sector by sector while writing, rather than the whole partition up front */
+    s_result = esp_ota_begin(s_partition, OTA_WITH_SEQUENTIAL_WRITES, &s_handle);
+    if (s_result != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to begin the OTA in %s: %s", s_partition->label, esp_err_to_name(s_result));
+        return;
+    }
+    mbedtls_sha256_init(&s_sha);
+    mbedtls_sha256_starts(&s_sha, 0);
+    s_open = true;
+}
+
+static void ota_client_writer_close(void)
+{
+    mbedtls_sha256_free(&s_sha);
+    s_open = false;
+}
+
+static void ota_client_writer_write(const uint8_t *data, uint32_t length)
+{
+    if (!s_open || s_result != ESP_OK) {
+        return;
+    }
+    if (s_written == 0 && length >= sizeof(esp_image_header_t)) {
+        s_hash_appended = ((const esp_image_header_t *)data)->hash_appended;
+    }
+    /* everything but the appended SHA-256 is hashed, the digest itself is kept aside */
+    uint32_t hashed_length = s_image_length - OTA_CLIENT_DIGEST_SIZE;
+    if (s_hash_appended) {
+        uint32_t hashed = s_written < hashed_length ? hashed_length - s_written : 0;
+        hashed = hashed < length ? hashed : length;
+        mbedtls_sha256_update(&s_sha, data, hashed);
+        for (uint32_t i = hashed; i < length; i++) {
+            s_appended_digest[s_written + i - hashed_length] = data[i];
+        }
+    }
+    s_result = esp_ota_write(s_handle, data, length);
+    s_written += length;
+    if (s_result != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write at offset %" PRIu32 ": %s", s_written - length, esp_err_to_name(s_result));
+    }
+}
+
+static void ota_client_writer_end(void)
+{
+    if (!s_open) {
+        return;
+    }
+    uint8_t digest[OTA_CLIENT_DIGEST_SIZE];
+    mbedtls_sha256_finish(&s_sha, digest);
+    ota_client_writer_close();
+    if (s_result == ESP_OK && s_written != s_image_length) {
+        ESP_LOGE(TAG, "Image incomplete, %" PRIu32 " of %" PRIu32 " bytes", s_written, s_image_length);
+        s_result = ESP_ERR_INVALID_SIZE;
+    }
+    if (s_result == ESP_OK && s_hash_appended && memcmp(digest, s_appended_digest, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Image SHA-256 mismatch");
+        s_result = ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (s_result != ESP_OK) {
+        esp_ota_abort(s_handle);
+        return;
+    }
+    /* validates the image once more from flash, including its signature when secure boot is enabled */
+    s_result = esp_ota_end(s_handle);
+    if (s_result != ESP_OK) {
+        ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(s_result));
+    }
+}
+
+static void ota_client_writer_task(void *pvParameters)
+{
+    ota_client_job_t job;
+    for (;;) {
+        xQueueReceive(s_jobs, &job, portMAX_DELAY);
+        switch (job.type) {
+        case OTA_CLIENT_JOB_BEGIN:
+            ota_client_writer_begin(job.length);
+            break;
+        case OTA_CLIENT_JOB_WRITE:
+            ota_client_writer_write(s_buffers[job.buffer], job.length);
+            xSemaphoreGive(s_free);
+            break;
+        case OTA_CLIENT_JOB_END:
+            ota_client_writer_end();
+            xSemaphoreGive(s_done);
+            break;
+        case OTA_CLIENT_JOB_ABORT:
+            if (s_open) {
+                ota_client_writer_close();
+                esp_ota_abort(s_handle);
+            }
+            break;
+        }
+    }
+}
+
+static void ota_client_send(ota_client_job_type_t type, uint8_t buffer, uint32_t length)
+{
+    ota_client_job_t job = {
+        .type = type,
+        .buffer = buffer,
+        .length = length,
+    };
+    /* the queue holds a job per buffer plus the begin and end ones, it never fills up */
+    xQueueSend(s_jobs, &job, portMAX_DELAY);
+}
+
+/* Hand the buffer being filled to the writer, then wait for the other one to be free */
+static esp_err_t ota_client_flush(void)
+{
+    if (s_fill_length == 0) {
+        return ESP_OK;
+    }
+    ota_client_send(OTA_CLIENT_JOB_WRITE, s_fill, s_fill_length);
+    s_holding = false;
+    /* the writer handles the buffers in order, the next one to be freed is the next one to fill */
+    s_fill = (s_fill + 1) % OTA_CLIENT_BUFFER_COUNT;
+    s_fill_length = 0;
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(s_free, pdMS_TO_TICKS(OTA_CLIENT_WRITE_TIMEOUT_MS)) == pdTRUE, ESP_ERR_TIMEOUT, TAG,
+                        "Flash writes too slow");
+    s_holding = true;
+    return ESP_OK;
+}
+
+/* Give back the buffer being filled */
+static void ota_client_release(void)
+{
+    if (s_holding) {
+        s_holding = false;
+        xSemaphoreGive(s_free);
+    }
+}
+
+static void ota_client_stop(void)
+{
+    if (!s_active) {
+        return;
+    }
+    s_active = false;
+    ota_client_send(OTA_CLIENT_JOB_ABORT, 0, 0);
+    ota_client_release();
+}
+
+static esp_err_t ota_client_start(uint32_t file_size, uint32_t file_version)
+{
+    ota_client_stop();
+    ESP_LOGI(TAG, "Download of file version 0x%08" PRIx32 " started, %" PRIu32 " bytes", file_version, file_size);
+    /* the stack consumes the OTA header, the parser is given the whole file size and accounts for it */
+    ota_image_init(&s_image, file_size);
+    s_fill = 0;
+    s_fill_length = 0;
+    s_received = 0;
+    s_progress = 0;
+    s_start_us = esp_timer_get_time();
+    /* wait for the writer to be done with a previous image, then keep the first buffer */
+    for (int i = 0; i < OTA_CLIENT_BUFFER_COUNT; i++) {
+        if (xSemaphoreTake(s_free, pdMS_TO_TICKS(OTA_CLIENT_WRITE_TIMEOUT_MS)) != pdTRUE) {
+            while (i--) {
+                xSemaphoreGive(s_free);
+            }
+            ESP_LOGE(TAG, "Previous image still being written");
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    for (int i = 1; i < OTA_CLIENT_BUFFER_COUNT; i++) {
+        xSemaphoreGive(s_free);
+    }
+    s_holding = true;
+    s_active = true;
+    return ESP_OK;
+}
+
+static esp_err_t ota_client_copy(const uint8_t *data, size_t length)
+{
+    while (length) {
+        if (s_fill_length == OTA_CLIENT_BUFFER_SIZE) {
+            ESP_RETURN_ON_ERROR(ota_client_flush(), TAG, "Failed to flush a buffer");
+        }
+        size_t take = OTA_CLIENT_BUFFER_SIZE - s_fill_length;
+        take = take < length ? take : length;
+        memcpy(s_buffers[s_fill] + s_fill_length, data, take);
+        s_fill_length += take;
+        data += take;
+        length -= take;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_client_receive(const uint8_t *data, size_t length)
+{
+    ESP_RETURN_ON_FALSE(s_active, ESP_ERR_INVALID_STATE, TAG, "Block received outside of a download");
+    s_received += length;
+    while (length) {
+        size_t consumed;
+        const uint8_t *image_data;
+        size_t image_length;
+        bool image_started = s_image.image_length != 0;
+        ota_image_status_t status = ota_image_parse(&s_image, data, length, &consumed, &image_data, &image_length);
+        ESP_RETURN_ON_FALSE(status == OTA_IMAGE_OK, ESP_ERR_INVALID_RESPONSE, TAG, "Invalid OTA file (%d)", status);
+        if (!image_started && s_image.image_length) {
+            ESP_RETURN_ON_FALSE(s_image.image_length > OTA_CLIENT_DIGEST_SIZE, ESP_ERR_INVALID_SIZE, TAG, "Upgrade image too short");
+            ota_client_send(OTA_CLIENT_JOB_BEGIN, 0, s_image.image_length);
+        }
+        if (image_length) {
+            ESP_RETURN_ON_ERROR(ota_client_copy(image_data, image_length), TAG, "Failed to buffer the image");
+        }
+        data += consumed;
+        length -= consumed;
+    }
+
+    uint8_t progress = (uint64_t)s_received * 10 / (s_received + s_image.file_remaining - OTA_IMAGE_FILE_HEADER_MIN_SIZE);
+    if (progress != s_progress) {
+        s_progress = progress;
+        ESP_LOGI(TAG, "Downloaded %" PRIu32 " bytes, %u%%", s_received, progress * 10);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ota_client_check(void)
+{
+    ESP_RETURN_ON_FALSE(s_active, ESP_ERR_INVALID_STATE, TAG, "No download to check");
+    ESP_RETURN_ON_FALSE(ota_image_complete(&s_image), ESP_ERR_INVALID_SIZE, TAG, "Upgrade image incomplete");
+    ESP_RETURN_ON_ERROR(ota_client_flush(), TAG, "Failed to flush the last buffer");
+    ota_client_send(OTA_CLIENT_JOB_END, 0, 0);
+    s_active = false;
+    ota_client_release();
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(s_done, pdMS_TO_TICKS(OTA_CLIENT_WRITE_TIMEOUT_MS)) == pdTRUE, ESP_ERR_TIMEOUT, TAG,
+                        "Image check timed out");
+    ESP_RETURN_ON_ERROR(s_result, TAG, "Image check failed");
+    int64_t elapsed_ms = (esp_timer_get_time() - s_start_us) / 1000;
+    ESP_LOGI(TAG, "Image of %" PRIu32 " bytes checked, downloaded in %" PRId64 " ms (%" PRId64 " bytes/s)", s_image.image_length,
+             elapsed_ms, elapsed_ms ? s_received * INT64_C(1000) / elapsed_ms : 0);
+    return ESP_OK;
+}
+
+static esp_err_t ota_client_finish(void)
+{
+    ESP_RETURN_ON_ERROR(esp_ota_set_boot_partition(s_partition), TAG, "Failed to select %s", s_partition->label);
+    ESP_LOGI(TAG, "Restarting into %s", s_partition->label);
+    esp_restart();
+    return ESP_OK;
+}
+
+esp_err_t ota_client_init(void)
+{
+    s_jobs = xQueueCreateStatic(OTA_CLIENT_BUFFER_COUNT + 2, sizeof(ota_client_job_t), &s_jobs_storage[0][0], &s_jobs_buffer);
+    s_free = xSemaphoreCreateCountingStatic(OTA_CLIENT_BUFFER_COUNT, OTA_CLIENT_BUFFER_COUNT, &s_free_buffer);
+    s_done = xSemaphoreCreateBinaryStatic(&s_done_buffer);
+    TaskHandle_t writer = xTaskCreateStatic(ota_client_writer_task, "ota_writer", OTA_CLIENT_WRITER_STACK_SIZE, NULL,
+                                            OTA_CLIENT_WRITER_PRIORITY, s_writer_stack, &s_writer_buffer);
+    ESP_RETURN_ON_ERROR(memory_report_add_task(writer, OTA_CLIENT_WRITER_STACK_SIZE), TAG, "Failed to report the writer task");
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    s_pending_verify = esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY;
+    ESP_LOGI(TAG, "Running %s, file version 0x%08x%s", running->label, OTA_CLIENT_FILE_VERSION,
+             s_pending_verify ? ", confirmed once the network is joined" : "");
+    return ESP_OK;
+}
+
+esp_err_t ota_client_handle(const esp_zb_zcl_ota_upgrade_value_message_t *message)
+{
+    ESP_RETURN_ON_FALSE(message->info.status == ESP_ZB_ZCL_STATUS_SUCCESS, ESP_ERR_INVALID_ARG, TAG, "OTA upgrade error status(%d)",
+                        message->info.status);
+    esp_err_t ret = ESP_OK;
+    switch (message->upgrade_status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        ret = ota_client_start(message->ota_header.image_size, message->ota_header.file_version);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        ret = ota_client_receive(message->payload, message->payload_size);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        ESP_LOGI(TAG, "Applying the upgrade");
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        ret = ota_client_check();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+        ret = ota_client_finish();
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+        ESP_LOGW(TAG, "Download aborted by the server");
+        ota_client_stop();
+        break;
+    default:
+        ESP_LOGI(TAG, "OTA upgrade status(%d)", message->upgrade_status);
+        break;
+    }
+    if (ret != ESP_OK) {
+        ota_client_stop();
+    }
+    return ret;
+}
+
+void ota_client_network_ready(void)
+{
+    if (!s_pending_verify) {
+        return;
+    }
+    s_pending_verify = false;
+    esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to confirm the new image: %s", esp_err_to_name(err));
+        return;
+    }
+    ESP_LOGI(TAG, "New image confirmed, rollback cancelled");
+}
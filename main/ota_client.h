@@ -0,0 +1,72 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Firmware update over Zigbee: OTA Upgrade cluster (0x0019) client on the
+ * binary input endpoint. The stack queries the OTA server and requests the
+ * image blocks; this module streams them to the ota_0 / ota_1 partition that
+ * is not running.
+ *
+ * The Zigbee task only copies each block into one of two sector-sized buffers,
+ * and a writer task erases and writes the full ones to flash, so the next
+ * blocks are requested while a sector is being written. The writer hashes the
+ * image on the fly and checks the SHA-256 appended to it by the build once the
+ * last block is in, before esp_ota_end() validates the partition.
+ *
+ * A new image boots in the pending verify state: it is confirmed once it has
+ * joined the network, and the bootloader rolls back to the previous one if the
+ * device resets before that.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Identify this firmware to the OTA server, bump the file version with every release */
+#define OTA_CLIENT_MANUFACTURER_CODE    0x131B
+#define OTA_CLIENT_IMAGE_TYPE           0x1011
+#define OTA_CLIENT_FILE_VERSION         0x0000000B
+#define OTA_CLIENT_HW_VERSION           1
+
+/* Largest image block requested, the server may send smaller ones */
+#define OTA_CLIENT_BLOCK_SIZE           223
+
+/* Blocks are gathered into buffers of one flash sector, one is written while the other fills */
+#define OTA_CLIENT_BUFFER_SIZE          4096
+#define OTA_CLIENT_BUFFER_COUNT         2
+/* Longest wait of the Zigbee task for a free buffer, or for the final check */
+#define OTA_CLIENT_WRITE_TIMEOUT_MS     5000
+
+#define OTA_CLIENT_WRITER_STACK_SIZE    3072
+#define OTA_CLIENT_WRITER_PRIORITY      3       /* below Zigbee_main, the flash writes wait for the stack */
+
+/**
+ * @brief Start the writer task and check whether the running image awaits confirmation, call from app_main
+ */
+esp_err_t ota_client_init(void);
+
+/**
+ * @brief Handle an OTA upgrade callback, i.e. ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID
+ *
+ * @note Must be called from the Zigbee task.
+ *
+ * @param message  The OTA upgrade message
+ * @return ESP_OK to go on with the upgrade, an error aborts it
+ */
+esp_err_t ota_client_handle(const esp_zb_zcl_ota_upgrade_value_message_t *message);
+
+/**
+ * @brief Confirm a new image once it has joined the network, which cancels the rollback
+ */
+void ota_client_network_ready(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "ota_image.h"
+
+void ota_image_init(ota_image_t *image, uint32_t file_size)
+{
+    *image = (ota_image_t) {
+        .file_remaining = file_size,
+    };
+}
+
+static ota_image_status_t ota_image_start_element(ota_image_t *image)
+{
+    const uint8_t *header = image->header;
+    image->tag = header[0] | header[1] << 8;
+    image->element_remaining = header[2] | header[3] << 8 | header[4] << 16 | (uint32_t)header[5] << 24;
+    image->header_length = 0;
+    /* the parsed bytes never reach into the header's worth of the file size, see ota_image_parse() */
+    if (image->element_remaining > image->file_remaining - OTA_IMAGE_FILE_HEADER_MIN_SIZE) {
+        return OTA_IMAGE_TOO_LONG;
+    }
+    if (image->tag == OTA_IMAGE_TAG_UPGRADE_IMAGE) {
+        if (image->image_length) {
+            return OTA_IMAGE_DUPLICATE;
+        }
+        image->image_length = image->element_remaining;
+    }
+    return OTA_IMAGE_OK;
+}
+
+ota_image_status_t ota_image_parse(ota_image_t *image, const uint8_t *data, size_t length, size_t *consumed,
+                                   const uint8_t **element_data, size_t *element_length)
+{
+    *element_data = NULL;
+    *element_length = 0;
+    if (length + OTA_IMAGE_FILE_HEADER_MIN_SIZE > image->file_remaining) {
+        return OTA_IMAGE_TOO_LONG;
+    }
+
+    size_t used = 0;
+    /* a sub-element header may be split across blocks */
+    while (image->element_remaining == 0 && used < length) {
+        image->header[image->header_length++] = data[used++];
+        image->file_remaining--;
+        if (image->header_length == OTA_IMAGE_ELEMENT_HEADER_SIZE) {
+            ota_image_status_t status = ota_image_start_element(image);
+            if (status != OTA_IMAGE_OK) {
+                *consumed = used;
+                return status;
+            }
+        }
+    }
+
+    size_t take = length - used < image->element_remaining ? length - used : image->element_remaining;
+    if (take && image->tag == OTA_IMAGE_TAG_UPGRADE_IMAGE) {
+        *element_data = data + used;
+        *element_length = take;
+        image->image_received += take;
+    }
+    image->element_remaining -= take;
+    image->file_remaining -= take;
+    *consumed = used + take;
+    return OTA_IMAGE_OK;
+}
+
+bool ota_image_complete(const ota_image_t *image)
+{
+    /* what is left of the file size is the header the stack consumed */
+    return image->file_remaining >= OTA_IMAGE_FILE_HEADER_MIN_SIZE && image->file_remaining <= OTA_IMAGE_FILE_HEADER_MAX_SIZE &&
+           image->header_length == 0 && image->element_remaining == 0 && image->image_length &&
+           image->image_received == image->image_length;
+}
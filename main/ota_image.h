@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Core of the OTA client: a streaming parser of the Zigbee OTA file body. After
+ * the OTA header, which the Zigbee stack consumes, the file is a sequence of
+ * sub-elements, each a 2-byte tag and a 4-byte length (little endian) followed
+ * by the data. The parser is fed the image blocks as they arrive, in any size,
+ * and hands back the data of the upgrade image sub-element (tag 0x0000), the
+ * firmware to write to flash; the other sub-elements are skipped.
+ *
+ * The stack gives the size of the whole file (ImageSize of the Query Next Image
+ * response) but not the length of the header it consumed, which depends on its
+ * optional fields. The body is complete once all but a header's worth of the
+ * file has been parsed, ending on a sub-element boundary.
+ *
+ * The module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_IMAGE_TAG_UPGRADE_IMAGE     0x0000
+#define OTA_IMAGE_ELEMENT_HEADER_SIZE   6
+/* OTA header without optional fields, and with the security credential version, the upgrade file
+   destination and the hardware versions */
+#define OTA_IMAGE_FILE_HEADER_MIN_SIZE  56
+#define OTA_IMAGE_FILE_HEADER_MAX_SIZE  (OTA_IMAGE_FILE_HEADER_MIN_SIZE + 1 + 8 + 4)
+
+typedef enum {
+    OTA_IMAGE_OK,           /*!< Block consumed */
+    OTA_IMAGE_TOO_LONG,     /*!< A sub-element runs past the end of the file */
+    OTA_IMAGE_DUPLICATE,    /*!< A second upgrade image sub-element */
+} ota_image_status_t;
+
+typedef struct {
+    uint32_t file_remaining;        /*!< Bytes of the file not parsed yet, the OTA header included */
+    uint8_t header[OTA_IMAGE_ELEMENT_HEADER_SIZE];
+    uint8_t header_length;          /*!< Bytes of the current sub-element header received */
+    uint16_t tag;                   /*!< Tag of the current sub-element */
+    uint32_t element_remaining;     /*!< Data bytes of the current sub-element not parsed yet */
+    uint32_t image_length;          /*!< Length of the upgrade image, 0 until its header is parsed */
+    uint32_t image_received;        /*!< Upgrade image bytes handed back */
+} ota_image_t;
+
+/**
+ * @brief Start parsing a file body
+ *
+ * @param image      The parser
+ * @param file_size  Size of the whole file, OTA header included, i.e. the ImageSize given by the server
+ */
+void ota_image_init(ota_image_t *image, uint32_t file_size);
+
+/**
+ * @brief Parse the next bytes of the file body, up to the end of the current sub-element
+ *
+ * Call in a loop until the whole block has been consumed.
+ *
+ * @param image          The parser
+ * @param data           Next bytes of the file
+ * @param length         Their number
+ * @param consumed       Set to the number of bytes parsed
+ * @param element_data   Set to the upgrade image bytes among them, NULL if none
+ * @param element_length Set to the number of upgrade image bytes
+ * @return OTA_IMAGE_OK, or the error that makes the file invalid
+ */
+ota_image_status_t ota_image_parse(ota_image_t *image, const uint8_t *data, size_t length, size_t *consumed,
+                                   const uint8_t **element_data, size_t *element_length);
+
+/**
+ * @brief Check that a whole file body was parsed and held an upgrade image
+ *
+ * @param image  The parser
+ * @return true if the upgrade image is complete and only the OTA header is left of the file size
+ */
+bool ota_image_complete(const ota_image_t *image);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
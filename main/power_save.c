@@ -0,0 +1,29 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "power_save.h"
+#include "esp_check.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+
+static const char *TAG = "POWER_SAVE";
+
+esp_err_t power_save_init(void)
+{
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(esp_pm_configure(&pm_config), TAG, "Failed to configure power management");
+    ESP_RETURN_ON_ERROR(esp_sleep_enable_gpio_wakeup(), TAG, "Failed to enable GPIO wake-up");
+    ESP_LOGI(TAG, "Automatic light sleep %s", pm_config.light_sleep_enable ? "enabled" : "disabled");
+#endif
+    return ESP_OK;
+}
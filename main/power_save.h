@@ -0,0 +1,29 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Low-power mode for battery-powered deployment: automatic light sleep with
+ * tickless idle, Zigbee sleepy end device, and GPIO wake-up for the buttons.
+ * Everything is a no-op when CONFIG_PM_ENABLE is not set.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Minimum idle time the Zigbee stack must foresee before it allows light sleep */
+#define POWER_SAVE_ZB_SLEEP_THRESHOLD_MS    20
+
+/**
+ * @brief Configure dynamic frequency scaling and automatic light sleep, call before starting Zigbee
+ */
+esp_err_t power_save_init(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "report_coalescer.h"
+
+static bool report_coalescer_periodic(const report_coalescer_t *rc)
+{
+    return rc->max_interval_s != REPORT_COALESCER_MAX_INTERVAL_NONE && rc->max_interval_s != REPORT_COALESCER_MAX_INTERVAL_DISABLED;
+}
+
+static int64_t report_coalescer_due_ms(const report_coalescer_t *rc)
+{
+    int64_t due_ms = rc->first_change_ms + rc->window_ms;
+    if (rc->has_reported) {
+        int64_t min_due_ms = rc->last_report_ms + (int64_t)rc->min_interval_s * 1000;
+        due_ms = min_due_ms > due_ms ? min_due_ms : due_ms;
+    }
+    return due_ms;
+}
+
+static int64_t report_coalescer_next_ms(const report_coalescer_t *rc)
+{
+    if (rc->pending) {
+        return report_coalescer_due_ms(rc);
+    }
+    if (rc->has_reported && report_coalescer_periodic(rc)) {
+        return rc->last_report_ms + (int64_t)rc->max_interval_s * 1000;
+    }
+    return REPORT_COALESCER_NO_DEADLINE;
+}
+
+void report_coalescer_init(report_coalescer_t *rc, uint32_t window_ms, uint32_t reportable_change)
+{
+    *rc = (report_coalescer_t) {
+        .window_ms = window_ms,
+        .max_interval_s = REPORT_COALESCER_MAX_INTERVAL_NONE,
+        .reportable_change = reportable_change ? reportable_change : 1,
+    };
+}
+
+void report_coalescer_set_intervals(report_coalescer_t *rc, uint16_t min_interval_s, uint16_t max_interval_s)
+{
+    rc->min_interval_s = min_interval_s;
+    rc->max_interval_s = max_interval_s;
+}
+
+int64_t report_coalescer_update(report_coalescer_t *rc, int32_t value, int64_t now_ms)
+{
+    rc->current_value = value;
+    int64_t change = (int64_t)value - rc->reported_value;
+    bool reportable = !rc->has_reported || (change < 0 ? -change : change) >= rc->reportable_change;
+    if (reportable && !rc->pending) {
+        rc->first_change_ms = now_ms;
+    }
+    /* a value going back to the reported one cancels the pending report */
+    rc->pending = reportable;
+    return report_coalescer_next_ms(rc);
+}
+
+bool report_coalescer_poll(report_coalescer_t *rc, int64_t now_ms, int64_t *next_ms)
+{
+    bool report = false;
+    if (rc->pending) {
+        report = now_ms >= report_coalescer_due_ms(rc);
+    } else if (rc->has_reported && report_coalescer_periodic(rc)) {
+        report = now_ms >= rc->last_report_ms + (int64_t)rc->max_interval_s * 1000;
+    }
+    if (report) {
+        rc->reported_value = rc->current_value;
+        rc->has_reported = true;
+        rc->pending = false;
+        rc->last_report_ms = now_ms;
+    }
+    *next_ms = report_coalescer_next_ms(rc);
+    return report;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Timing core of attribute reporting. It merges changes of one attribute within
+ * a short window, honours the ZCL configure-reporting min/max intervals and
+ * reportable change, and tells the caller when a report frame is due.
+ *
+ * Time is always passed in by the caller (milliseconds, any monotonic origin)
+ * and the module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ZCL max interval values that disable periodic reports */
+#define REPORT_COALESCER_MAX_INTERVAL_NONE      0x0000
+#define REPORT_COALESCER_MAX_INTERVAL_DISABLED  0xFFFF
+
+/* No deadline pending */
+#define REPORT_COALESCER_NO_DEADLINE            INT64_MAX
+
+typedef struct {
+    uint32_t window_ms;         /*!< Changes within this window after the first one are merged */
+    uint16_t min_interval_s;    /*!< ZCL minimum reporting interval */
+    uint16_t max_interval_s;    /*!< ZCL maximum reporting interval, 0 or 0xFFFF disables periodic reports */
+    uint32_t reportable_change; /*!< Smallest change from the reported value that triggers a report */
+    int32_t current_value;      /*!< Latest known value */
+    int32_t reported_value;     /*!< Value carried by the last report */
+    bool has_reported;          /*!< A report has been emitted at least once */
+    bool pending;               /*!< current_value differs enough from reported_value to be reported */
+    int64_t first_change_ms;    /*!< Time of the first change merged into the pending report */
+    int64_t last_report_ms;     /*!< Time of the last report */
+} report_coalescer_t;
+
+/**
+ * @brief Initialize a coalescer
+ *
+ * @param rc                 The coalescer to initialize
+ * @param window_ms          Merge window, in milliseconds
+ * @param reportable_change  Smallest change worth a report (1 for booleans and enums)
+ */
+void report_coalescer_init(report_coalescer_t *rc, uint32_t window_ms, uint32_t reportable_change);
+
+/**
+ * @brief Apply ZCL reporting intervals, e.g. received in a Configure Reporting command
+ *
+ * @param rc              The coalescer
+ * @param min_interval_s  Minimum reporting interval, in seconds
+ * @param max_interval_s  Maximum reporting interval, in seconds
+ */
+void report_coalescer_set_intervals(report_coalescer_t *rc, uint16_t min_interval_s, uint16_t max_interval_s);
+
+/**
+ * @brief Record a new value of the attribute
+ *
+ * @param rc      The coalescer
+ * @param value   The new value
+ * @param now_ms  Current time
+ * @return Next time report_coalescer_poll() must be called, REPORT_COALESCER_NO_DEADLINE if none
+ */
+int64_t report_coalescer_update(report_coalescer_t *rc, int32_t value, int64_t now_ms);
+
+/**
+ * @brief Check whether a report is due
+ *
+ * @param rc       The coalescer
+ * @param now_ms   Current time
+ * @param next_ms  Set to the next time this function must be called, REPORT_COALESCER_NO_DEADLINE if none
+ * @return true if a report of the current value must be sent now
+ */
+bool report_coalescer_poll(report_coalescer_t *rc, int64_t now_ms, int64_t *next_ms);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
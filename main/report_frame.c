@@ -0,0 +1,69 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <string.h>
+#include "report_frame.h"
+
+/* Frame control: profile-wide, server to client, Default Response disabled */
+#define REPORT_FRAME_CONTROL            0x18
+#define REPORT_FRAME_CMD_REPORT_ATTRS   0x0A
+
+void report_frame_init(report_frame_t *frame, uint8_t *data, size_t capacity, uint8_t tsn)
+{
+    *frame = (report_frame_t) {
+        .data = data,
+        .capacity = capacity,
+        .length = REPORT_FRAME_HEADER_SIZE,
+    };
+    data[0] = REPORT_FRAME_CONTROL;
+    data[1] = tsn;
+    data[2] = REPORT_FRAME_CMD_REPORT_ATTRS;
+}
+
+size_t report_frame_value_size(uint8_t type, const void *value)
+{
+    switch (type) {
+    case 0x08:  /* data8 */
+    case 0x10:  /* bool */
+    case 0x18:  /* bitmap8 */
+    case 0x20:  /* uint8 */
+    case 0x28:  /* int8 */
+    case 0x30:  /* enum8 */
+        return 1;
+    case 0x09:  /* data16 */
+    case 0x19:  /* bitmap16 */
+    case 0x21:  /* uint16 */
+    case 0x29:  /* int16 */
+    case 0x31:  /* enum16 */
+        return 2;
+    case 0x0B:  /* data32 */
+    case 0x1B:  /* bitmap32 */
+    case 0x23:  /* uint32 */
+    case 0x2B:  /* int32 */
+        return 4;
+    case 0x41:  /* octet string */
+    case 0x42:  /* character string */
+        return 1 + ((const uint8_t *)value)[0];
+    default:
+        return 0;
+    }
+}
+
+bool report_frame_add(report_frame_t *frame, uint16_t attr_id, uint8_t type, const void *value)
+{
+    size_t size = report_frame_value_size(type, value);
+    if (size == 0 || frame->length + REPORT_FRAME_RECORD_HEADER_SIZE + size > frame->capacity) {
+        return false;
+    }
+    uint8_t *record = &frame->data[frame->length];
+    record[0] = attr_id & 0xFF;
+    record[1] = attr_id >> 8;
+    record[2] = type;
+    memcpy(&record[REPORT_FRAME_RECORD_HEADER_SIZE], value, size);
+    frame->length += REPORT_FRAME_RECORD_HEADER_SIZE + size;
+    frame->records++;
+    return true;
+}
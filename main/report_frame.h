@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Builder of ZCL Report Attributes frames (command 0x0A) carrying several
+ * attribute records of one cluster. A record is only added if the whole frame
+ * still fits in the buffer, which the caller sizes to the APS payload that is
+ * sent without fragmentation.
+ *
+ * The module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ZCL header of a server to client profile-wide command with the Default Response disabled */
+#define REPORT_FRAME_HEADER_SIZE        3
+/* Attribute identifier and data type of a record */
+#define REPORT_FRAME_RECORD_HEADER_SIZE 3
+
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t length;
+    uint8_t records;
+} report_frame_t;
+
+/**
+ * @brief Start a frame
+ *
+ * @param frame     The frame
+ * @param data      Buffer of the frame, at least REPORT_FRAME_HEADER_SIZE bytes
+ * @param capacity  Size of @p data, the largest frame to build
+ * @param tsn       ZCL transaction sequence number
+ */
+void report_frame_init(report_frame_t *frame, uint8_t *data, size_t capacity, uint8_t tsn);
+
+/**
+ * @brief Get the size of an attribute value in a frame
+ *
+ * @param type   ZCL data type
+ * @param value  The value, only read for strings whose size is in their first byte
+ * @return Size in bytes, 0 for types not supported
+ */
+size_t report_frame_value_size(uint8_t type, const void *value);
+
+/**
+ * @brief Append an attribute record
+ *
+ * @param frame    The frame
+ * @param attr_id  Attribute identifier
+ * @param type     ZCL data type
+ * @param value    The value, in ZCL (little-endian) layout
+ * @return false if the record does not fit or its type is not supported, the frame is unchanged
+ */
+bool report_frame_add(report_frame_t *frame, uint16_t attr_id, uint8_t type, const void *value);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,156 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <string.h>
+#include "scene_table.h"
+
+void scene_table_init(scene_table_t *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+static scene_table_entry_t *scene_table_lookup(scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    for (int i = 0; i < SCENE_TABLE_MAX_SCENES; i++) {
+        scene_table_entry_t *entry = &table->entries[i];
+        if (entry->used && entry->group_id == group_id && entry->scene_id == scene_id) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+const scene_table_entry_t *scene_table_find(const scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    return scene_table_lookup((scene_table_t *)table, group_id, scene_id);
+}
+
+const scene_table_entry_t *scene_table_store(scene_table_t *table, uint16_t group_id, uint8_t scene_id,
+                                             const scene_table_state_t *state)
+{
+    scene_table_entry_t *entry = scene_table_lookup(table, group_id, scene_id);
+    for (int i = 0; !entry && i < SCENE_TABLE_MAX_SCENES; i++) {
+        if (!table->entries[i].used) {
+            entry = &table->entries[i];
+        }
+    }
+    if (!entry) {
+        return NULL;
+    }
+    *entry = (scene_table_entry_t) {
+        .group_id = group_id,
+        .scene_id = scene_id,
+        .used = 1,
+        .state = *state,
+    };
+    return entry;
+}
+
+bool scene_table_remove(scene_table_t *table, uint16_t group_id, uint8_t scene_id)
+{
+    scene_table_entry_t *entry = scene_table_lookup(table, group_id, scene_id);
+    if (entry) {
+        entry->used = 0;
+    }
+    return entry != NULL;
+}
+
+/* Remove the scenes of a group, or of every group but 0 if all_groups */
+static uint8_t scene_table_remove_group(scene_table_t *table, uint16_t group_id, bool all_groups)
+{
+    uint8_t removed = 0;
+    for (int i = 0; i < SCENE_TABLE_MAX_SCENES; i++) {
+        scene_table_entry_t *entry = &table->entries[i];
+        if (entry->used && (all_groups ? entry->group_id != 0 : entry->group_id == group_id)) {
+            entry->used = 0;
+            removed++;
+        }
+    }
+    return removed;
+}
+
+uint8_t scene_table_apply_command(scene_table_t *table, uint16_t cluster_id, uint8_t command_id, const uint8_t *payload,
+                                  size_t length)
+{
+    uint16_t group_id = length >= 2 ? payload[0] | (payload[1] << 8) : 0;
+    if (cluster_id == SCENE_TABLE_SCENES_CLUSTER_ID) {
+        switch (command_id) {
+        case SCENE_TABLE_CMD_REMOVE_SCENE:
+            return length >= 3 && scene_table_remove(table, group_id, payload[2]) ? 1 : 0;
+        case SCENE_TABLE_CMD_REMOVE_ALL_SCENES:
+            return length >= 2 ? scene_table_remove_group(table, group_id, false) : 0;
+        default:
+            return 0;
+        }
+    }
+    if (cluster_id == SCENE_TABLE_GROUPS_CLUSTER_ID) {
+        switch (command_id) {
+        case SCENE_TABLE_CMD_REMOVE_GROUP:
+            /* 0 is not a group, the scenes without a group stay */
+            return length >= 2 && group_id != 0 ? scene_table_remove_group(table, group_id, false) : 0;
+        case SCENE_TABLE_CMD_REMOVE_ALL_GROUPS:
+            return scene_table_remove_group(table, 0, true);
+        default:
+            return 0;
+        }
+    }
+    return 0;
+}
+
+uint8_t scene_table_count(const scene_table_t *table)
+{
+    uint8_t count = 0;
+    for (int i = 0; i < SCENE_TABLE_MAX_SCENES; i++) {
+        count += table->entries[i].used ? 1 : 0;
+    }
+    return count;
+}
+
+size_t scene_table_encode_field_set(const scene_table_state_t *state, uint16_t cluster_id, uint8_t *data)
+{
+    switch (cluster_id) {
+    case SCENE_TABLE_ON_OFF_CLUSTER_ID:
+        data[0] = state->power ? 1 : 0;
+        return 1;
+    case SCENE_TABLE_LEVEL_CLUSTER_ID:
+        data[0] = state->level;
+        return 1;
+    case SCENE_TABLE_COLOR_CLUSTER_ID:
+        data[0] = state->color_x & 0xFF;
+        data[1] = state->color_x >> 8;
+        data[2] = state->color_y & 0xFF;
+        data[3] = state->color_y >> 8;
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void scene_table_decode_field_set(scene_table_state_t *state, uint16_t cluster_id, const uint8_t *data, size_t length)
+{
+    switch (cluster_id) {
+    case SCENE_TABLE_ON_OFF_CLUSTER_ID:
+        if (length >= 1) {
+            state->power = data[0] ? 1 : 0;
+        }
+        break;
+    case SCENE_TABLE_LEVEL_CLUSTER_ID:
+        if (length >= 1) {
+            state->level = data[0];
+        }
+        break;
+    case SCENE_TABLE_COLOR_CLUSTER_ID:
+        if (length >= 2) {
+            state->color_x = data[0] | (data[1] << 8);
+        }
+        if (length >= 4) {
+            state->color_y = data[2] | (data[3] << 8);
+        }
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Scene table of the light endpoint: each scene, identified by its group and
+ * scene identifiers, holds the whole light state (on/off, level and xy colour).
+ * The table has a fixed size and layout so that it is saved as one record, and
+ * it converts a scene from and to the extension field sets of the Scenes
+ * cluster (0x0005). The Scenes and Groups (0x0004) commands that remove scenes
+ * from the table of the stack are applied to it as well, so that it never
+ * holds a scene the stack has dropped.
+ *
+ * The module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCENE_TABLE_MAX_SCENES          8
+
+/* Extension field sets of a scene, the attributes are stored in this order as the ZCL requires */
+#define SCENE_TABLE_ON_OFF_CLUSTER_ID   0x0006  /*!< OnOff, bool */
+#define SCENE_TABLE_LEVEL_CLUSTER_ID    0x0008  /*!< CurrentLevel, uint8 */
+#define SCENE_TABLE_COLOR_CLUSTER_ID    0x0300  /*!< CurrentX then CurrentY, uint16 little-endian */
+#define SCENE_TABLE_FIELD_SET_MAX_LENGTH 4
+
+/* Client to server commands that remove scenes, with their payload */
+#define SCENE_TABLE_GROUPS_CLUSTER_ID       0x0004
+#define SCENE_TABLE_SCENES_CLUSTER_ID       0x0005
+#define SCENE_TABLE_CMD_REMOVE_SCENE        0x02    /*!< Scenes, group ID and scene ID */
+#define SCENE_TABLE_CMD_REMOVE_ALL_SCENES   0x03    /*!< Scenes, group ID */
+#define SCENE_TABLE_CMD_REMOVE_GROUP        0x03    /*!< Groups, group ID */
+#define SCENE_TABLE_CMD_REMOVE_ALL_GROUPS   0x04    /*!< Groups, no payload, the scenes of group 0 stay */
+
+/** Light state of a scene, keep fixed-size fields so that the record layout is stable */
+typedef struct {
+    uint8_t power;
+    uint8_t level;
+    uint16_t color_x;
+    uint16_t color_y;
+} scene_table_state_t;
+
+typedef struct {
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint8_t used;
+    scene_table_state_t state;
+} scene_table_entry_t;
+
+typedef struct {
+    scene_table_entry_t entries[SCENE_TABLE_MAX_SCENES];
+} scene_table_t;
+
+/**
+ * @brief Empty the table
+ *
+ * @param table  The table
+ */
+void scene_table_init(scene_table_t *table);
+
+/**
+ * @brief Look a scene up
+ *
+ * @param table     The table
+ * @param group_id  Group of the scene, 0 for none
+ * @param scene_id  Scene identifier
+ * @return The scene, NULL if it is not in the table
+ */
+const scene_table_entry_t *scene_table_find(const scene_table_t *table, uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Add a scene, or overwrite it if it exists
+ *
+ * @param table     The table
+ * @param group_id  Group of the scene, 0 for none
+ * @param scene_id  Scene identifier
+ * @param state     Light state of the scene
+ * @return The stored scene, NULL if the table is full
+ */
+const scene_table_entry_t *scene_table_store(scene_table_t *table, uint16_t group_id, uint8_t scene_id,
+                                             const scene_table_state_t *state);
+
+/**
+ * @brief Remove a scene
+ *
+ * @param table     The table
+ * @param group_id  Group of the scene, 0 for none
+ * @param scene_id  Scene identifier
+ * @return true if the scene was in the table
+ */
+bool scene_table_remove(scene_table_t *table, uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Apply a Scenes or Groups command that removes scenes, the stack answers it
+ *
+ * Other commands, and commands too short for their payload, leave the table unchanged.
+ *
+ * @param table       The table
+ * @param cluster_id  SCENE_TABLE_SCENES_CLUSTER_ID or SCENE_TABLE_GROUPS_CLUSTER_ID
+ * @param command_id  Command identifier, client to server
+ * @param payload     Command payload, after the ZCL header
+ * @param length      Length of @p payload
+ * @return Number of scenes removed
+ */
+uint8_t scene_table_apply_command(scene_table_t *table, uint16_t cluster_id, uint8_t command_id, const uint8_t *payload,
+                                  size_t length);
+
+/**
+ * @brief Get the number of scenes in the table
+ *
+ * @param table  The table
+ */
+uint8_t scene_table_count(const scene_table_t *table);
+
+/**
+ * @brief Write the extension field set of one cluster
+ *
+ * @param state       Light state of the scene
+ * @param cluster_id  SCENE_TABLE_ON_OFF_CLUSTER_ID, SCENE_TABLE_LEVEL_CLUSTER_ID or SCENE_TABLE_COLOR_CLUSTER_ID
+ * @param data        Destination, at least SCENE_TABLE_FIELD_SET_MAX_LENGTH bytes
+ * @return Length written, 0 for another cluster
+ */
+size_t scene_table_encode_field_set(const scene_table_state_t *state, uint16_t cluster_id, uint8_t *data);
+
+/**
+ * @brief Apply the extension field set of one cluster to a light state
+ *
+ * Attributes missing from a short field set and other clusters leave the state unchanged, as the ZCL requires.
+ *
+ * @param state       Light state to update
+ * @param cluster_id  Cluster of the field set
+ * @param data        Attribute values
+ * @param length      Length of @p data
+ */
+void scene_table_decode_field_set(scene_table_state_t *state, uint16_t cluster_id, const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
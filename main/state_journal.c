@@ -0,0 +1,84 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "state_journal.h"
+
+/* Bitwise CRC-32 (IEEE 802.3, reflected), records are a few bytes long and written rarely */
+static uint32_t state_journal_crc32(uint32_t crc, const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+    crc = ~crc;
+    while (length--) {
+        crc ^= *bytes++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t state_journal_record_crc(const state_journal_header_t *header, const void *payload, uint16_t length)
+{
+    uint32_t crc = state_journal_crc32(0, header, offsetof(state_journal_header_t, crc));
+    return state_journal_crc32(crc, payload, length);
+}
+
+static int64_t state_journal_due_ms(const state_journal_t *journal)
+{
+    int64_t quiet_ms = journal->last_change_ms + journal->debounce_ms;
+    int64_t latest_ms = journal->first_change_ms + journal->max_delay_ms;
+    return quiet_ms < latest_ms ? quiet_ms : latest_ms;
+}
+
+void state_journal_init(state_journal_t *journal, uint32_t debounce_ms, uint32_t max_delay_ms, uint32_t sequence)
+{
+    *journal = (state_journal_t) {
+        .debounce_ms = debounce_ms,
+        .max_delay_ms = max_delay_ms > debounce_ms ? max_delay_ms : debounce_ms,
+        .sequence = sequence,
+    };
+}
+
+int64_t state_journal_touch(state_journal_t *journal, int64_t now_ms)
+{
+    if (!journal->dirty) {
+        journal->dirty = true;
+        journal->first_change_ms = now_ms;
+    }
+    journal->last_change_ms = now_ms;
+    return state_journal_due_ms(journal);
+}
+
+bool state_journal_poll(state_journal_t *journal, int64_t now_ms, int64_t *next_ms)
+{
+    *next_ms = STATE_JOURNAL_NO_DEADLINE;
+    if (!journal->dirty) {
+        return false;
+    }
+    int64_t due_ms = state_journal_due_ms(journal);
+    if (now_ms < due_ms) {
+        *next_ms = due_ms;
+        return false;
+    }
+    journal->dirty = false;
+    return true;
+}
+
+void state_journal_encode(state_journal_t *journal, state_journal_header_t *header, const void *payload, uint16_t length)
+{
+    *header = (state_journal_header_t) {
+        .format = STATE_JOURNAL_FORMAT,
+        .length = length,
+        .sequence = ++journal->sequence,
+    };
+    header->crc = state_journal_record_crc(header, payload, length);
+}
+
+bool state_journal_check(const state_journal_header_t *header, const void *payload, uint16_t length)
+{
+    return header->format == STATE_JOURNAL_FORMAT && header->length == length &&
+           header->crc == state_journal_record_crc(header, payload, length);
+}
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Core of the persistent state journal: decides when a changed state is worth
+ * a flash write, and frames each saved state into a self-checking record
+ * (format, length, sequence number, CRC-32) so that a torn or stale record is
+ * never restored.
+ *
+ * Changes are coalesced: a record is due once the state has been quiet for the
+ * debounce time, or at the latest max delay after the first unsaved change, so
+ * a colour fade or a burst of button presses costs one write.
+ *
+ * Time is always passed in by the caller (milliseconds, any monotonic origin)
+ * and the module has no ESP-IDF dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Identifies the record layout, change it when the header changes */
+#define STATE_JOURNAL_FORMAT        0x5331
+
+/* No record due */
+#define STATE_JOURNAL_NO_DEADLINE   INT64_MAX
+
+typedef struct {
+    uint16_t format;        /*!< STATE_JOURNAL_FORMAT */
+    uint16_t length;        /*!< Payload length, a payload of another length is not restored */
+    uint32_t sequence;      /*!< Incremented by every record */
+    uint32_t crc;           /*!< CRC-32 of the header up to here and of the payload */
+} state_journal_header_t;
+
+typedef struct {
+    uint32_t debounce_ms;   /*!< Quiet time after a change before it is written */
+    uint32_t max_delay_ms;  /*!< Longest time a change may stay unwritten */
+    uint32_t sequence;      /*!< Sequence of the last record */
+    bool dirty;             /*!< Changes are waiting to be written */
+    int64_t first_change_ms;
+    int64_t last_change_ms;
+} state_journal_t;
+
+/**
+ * @brief Initialize a journal
+ *
+ * @param journal       The journal to initialize
+ * @param debounce_ms   Quiet time after a change before it is written
+ * @param max_delay_ms  Longest time a change may stay unwritten
+ * @param sequence      Sequence of the record restored at boot, 0 if none
+ */
+void state_journal_init(state_journal_t *journal, uint32_t debounce_ms, uint32_t max_delay_ms, uint32_t sequence);
+
+/**
+ * @brief Note that the state changed
+ *
+ * @param journal  The journal
+ * @param now_ms   Current time
+ * @return Time at which the record is due
+ */
+int64_t state_journal_touch(state_journal_t *journal, int64_t now_ms);
+
+/**
+ * @brief Check whether a record is due
+ *
+ * @param journal  The journal
+ * @param now_ms   Current time
+ * @param next_ms  Set to the time of the next check, STATE_JOURNAL_NO_DEADLINE if none
+ * @return true if the state must be written now, the journal is then clean
+ */
+bool state_journal_poll(state_journal_t *journal, int64_t now_ms, int64_t *next_ms);
+
+/**
+ * @brief Frame a payload into a record with the next sequence number
+ *
+ * @param journal  The journal
+ * @param header   Header to fill, written along with the payload
+ * @param payload  The state to save
+ * @param length   Payload length
+ */
+void state_journal_encode(state_journal_t *journal, state_journal_header_t *header, const void *payload, uint16_t length);
+
+/**
+ * @brief Check a record read back from flash
+ *
+ * @param header   The header read back
+ * @param payload  The payload read back
+ * @param length   Expected payload length
+ * @return true if the record is complete, of the current format and of the expected length
+ */
+bool state_journal_check(const state_journal_header_t *header, const void *payload, uint16_t length);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
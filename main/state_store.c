@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "nvs.h"
+#include "state_journal.h"
+#include "state_store.h"
+
+static const char *TAG = "STATE_STORE";
+
+typedef struct {
+    state_journal_header_t header;
+    state_store_state_t state;
+} state_store_record_t;
+
+static nvs_handle_t s_nvs;
+static state_journal_t s_journal;
+static state_store_snapshot_cb_t s_snapshot;
+/* state of the last record, written or restored */
+static state_store_state_t s_saved;
+static uint8_t s_next_slot;
+
+static int64_t state_store_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void state_store_slot_key(uint8_t slot, char key[NVS_KEY_NAME_MAX_SIZE])
+{
+    snprintf(key, NVS_KEY_NAME_MAX_SIZE, "record%u", slot);
+}
+
+static void state_store_flush_cb(uint8_t param);
+
+static void state_store_schedule(int64_t next_ms)
+{
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)state_store_flush_cb, 0);
+    if (next_ms == STATE_JOURNAL_NO_DEADLINE) {
+        return;
+    }
+    int64_t delay_ms = next_ms - state_store_now_ms();
+    esp_zb_scheduler_alarm((esp_zb_callback_t)state_store_flush_cb, 0, delay_ms > 0 ? (uint32_t)delay_ms : 0);
+}
+
+static esp_err_t state_store_write(const state_store_state_t *state)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    state_store_record_t record = { .state = *state };
+    state_journal_encode(&s_journal, &record.header, &record.state, sizeof(record.state));
+    state_store_slot_key(s_next_slot, key);
+    ESP_RETURN_ON_ERROR(nvs_set_blob(s_nvs, key, &record, sizeof(record)), TAG, "Failed to write %s", key);
+    ESP_RETURN_ON_ERROR(nvs_commit(s_nvs), TAG, "Failed to commit %s", key);
+    s_next_slot = (s_next_slot + 1) % STATE_STORE_SLOTS;
+    return ESP_OK;
+}
+
+static void state_store_flush_cb(uint8_t param)
+{
+    int64_t next_ms;
+    if (state_journal_poll(&s_journal, state_store_now_ms(), &next_ms)) {
+        state_store_state_t state;
+        memset(&state, 0, sizeof(state));
+        s_snapshot(&state);
+        /* changes that cancel each other out, e.g. an even number of toggles, cost nothing */
+        if (memcmp(&state, &s_saved, sizeof(state)) != 0) {
+            if (state_store_write(&state) == ESP_OK) {
+                s_saved = state;
+                ESP_LOGI(TAG, "State saved, record %" PRIu32, s_journal.sequence);
+            } else {
+                /* keep the change pending, it is written again after the debounce time */
+                next_ms = state_journal_touch(&s_journal, state_store_now_ms());
+            }
+        }
+    }
+    state_store_schedule(next_ms);
+}
+
+esp_err_t state_store_restore(state_store_state_t *state)
+{
+    int64_t start_us = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(nvs_open(STATE_STORE_NAMESPACE, NVS_READWRITE, &s_nvs), TAG, "Failed to open NVS namespace");
+
+    uint32_t sequence = 0;
+    bool found = false;
+    for (uint8_t slot = 0; slot < STATE_STORE_SLOTS; slot++) {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        state_store_record_t record;
+        size_t length = sizeof(record);
+        state_store_slot_key(slot, key);
+        if (nvs_get_blob(s_nvs, key, &record, &length) != ESP_OK || length != sizeof(record) ||
+            !state_journal_check(&record.header, &record.state, sizeof(record.state))) {
+            continue;
+        }
+        /* sequence numbers wrap, compare them by difference */
+        if (!found || (int32_t)(record.header.sequence - sequence) > 0) {
+            found = true;
+            sequence = record.header.sequence;
+            s_saved = record.state;
+            s_next_slot = (slot + 1) % STATE_STORE_SLOTS;
+        }
+    }
+    state_journal_init(&s_journal, STATE_STORE_DEBOUNCE_MS, STATE_STORE_MAX_DELAY_MS, sequence);
+    if (!found) {
+        ESP_LOGI(TAG, "No saved state");
+        return ESP_ERR_NOT_FOUND;
+    }
+    *state = s_saved;
+    ESP_LOGI(TAG, "State restored from record %" PRIu32 " in %" PRId64 " us", sequence, esp_timer_get_time() - start_us);
+    return ESP_OK;
+}
+
+void state_store_init(state_store_snapshot_cb_t snapshot)
+{
+    s_snapshot = snapshot;
+}
+
+void state_store_touch(void)
+{
+    if (s_snapshot) {
+        state_store_schedule(state_journal_touch(&s_journal, state_store_now_ms()));
+    }
+}
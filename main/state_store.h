@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Persists the application state (light, Binary Input PresentValue and thermostat settings) in the
+ * nvs partition so that it survives power cycles. Changes are coalesced by
+ * state_journal and written to alternating NVS slots, each record carrying a
+ * sequence number and a CRC; the restore picks the newest valid one. NVS is
+ * itself an append-only log whose pages are compacted when they fill up, so a
+ * save never rewrites the previous record in place.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATE_STORE_NAMESPACE       "state"
+#define STATE_STORE_SLOTS           2
+
+/* A change is saved once the state has been quiet this long, or at the latest after the max delay */
+#define STATE_STORE_DEBOUNCE_MS     2000
+#define STATE_STORE_MAX_DELAY_MS    30000
+
+/** The persisted state, keep fixed-size fields so that the record layout is stable */
+typedef struct {
+    uint8_t light_power;
+    uint8_t light_level;
+    uint16_t color_x;
+    uint16_t color_y;
+    uint16_t on_off_transition_ds;
+    uint8_t present_value;
+    int16_t comfort_setpoint;
+    int16_t eco_setpoint;
+    uint8_t system_mode;
+} state_store_state_t;
+
+/**
+ * @brief Read the current state from the attribute store, called when a save is due
+ *
+ * @param state  The state to fill, zeroed beforehand
+ */
+typedef void (*state_store_snapshot_cb_t)(state_store_state_t *state);
+
+/**
+ * @brief Read the newest valid record, call once at boot before state_store_init()
+ *
+ * @param state  Filled with the restored state
+ * @return
+ *      - ESP_OK: The state has been restored
+ *      - ESP_ERR_NOT_FOUND: Nothing valid has been saved yet
+ *      - Others: NVS errors
+ */
+esp_err_t state_store_restore(state_store_state_t *state);
+
+/**
+ * @brief Start saving changes
+ *
+ * @param snapshot  Reads the state to save
+ */
+void state_store_init(state_store_snapshot_cb_t snapshot);
+
+/**
+ * @brief Note that the state changed, the save is scheduled according to the debounce
+ *
+ * @note Must be called from the Zigbee task or with the Zigbee lock held.
+ */
+void state_store_touch(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
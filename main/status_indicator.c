@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "light_state.h"
+#include "status_indicator.h"
+#include "timer_wheel.h"
+
+static const char *TAG = "STATUS_INDICATOR";
+
+typedef enum {
+    STATUS_INDICATOR_IDLE,
+    STATUS_INDICATOR_ON,
+    STATUS_INDICATOR_FADING,
+} status_indicator_phase_t;
+
+static timer_wheel_t s_wheel;
+static timer_wheel_entry_t s_led_on;
+static timer_wheel_entry_t s_fade_out;
+static timer_wheel_entry_t s_done;
+/* deadline the scheduler alarm is armed for */
+static int64_t s_alarm_ms = TIMER_WHEEL_NO_DEADLINE;
+static status_indicator_phase_t s_phase;
+static bool s_comfort;
+static int64_t s_on_since_ms;
+static status_indicator_stats_t s_stats;
+
+static int64_t status_indicator_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void status_indicator_alarm_cb(uint8_t param);
+
+/* The wheel has a single backing timer, armed for its earliest deadline */
+static void status_indicator_arm(void)
+{
+    int64_t next_ms = timer_wheel_next_deadline(&s_wheel);
+    if (next_ms == s_alarm_ms) {
+        return;
+    }
+    if (s_alarm_ms != TIMER_WHEEL_NO_DEADLINE) {
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)status_indicator_alarm_cb, 0);
+    }
+    s_alarm_ms = next_ms;
+    if (next_ms != TIMER_WHEEL_NO_DEADLINE) {
+        int64_t delay_ms = next_ms - status_indicator_now_ms();
+        esp_zb_scheduler_alarm((esp_zb_callback_t)status_indicator_alarm_cb, 0, delay_ms > 0 ? (uint32_t)delay_ms : 0);
+    }
+}
+
+static void status_indicator_alarm_cb(uint8_t param)
+{
+    s_alarm_ms = TIMER_WHEEL_NO_DEADLINE;
+    timer_wheel_advance(&s_wheel, status_indicator_now_ms());
+    status_indicator_arm();
+}
+
+static void status_indicator_light(void)
+{
+    light_driver_state_t state = {
+        .power = true,
+        .level = STATUS_INDICATOR_LEVEL,
+        .color_x = s_comfort ? STATUS_INDICATOR_COMFORT_X : STATUS_INDICATOR_ECO_X,
+        .color_y = s_comfort ? STATUS_INDICATOR_COMFORT_Y : STATUS_INDICATOR_ECO_Y,
+    };
+    light_state_override(&state, 0);
+}
+
+static void status_indicator_led_on_cb(void *arg, int64_t now_ms)
+{
+    if (s_phase == STATUS_INDICATOR_IDLE) {
+        s_on_since_ms = now_ms;
+    }
+    s_phase = STATUS_INDICATOR_ON;
+    status_indicator_light();
+    timer_wheel_cancel(&s_wheel, &s_done);
+    timer_wheel_schedule(&s_wheel, &s_fade_out, now_ms + STATUS_INDICATOR_ON_MS);
+}
+
+static void status_indicator_fade_out_cb(void *arg, int64_t now_ms)
+{
+    s_phase = STATUS_INDICATOR_FADING;
+    /* back to the light endpoint state, the light driver releases the LED strip if that is dark */
+    light_state_release(STATUS_INDICATOR_FADE_MS);
+    timer_wheel_schedule(&s_wheel, &s_done, now_ms + STATUS_INDICATOR_FADE_MS);
+}
+
+static void status_indicator_done_cb(void *arg, int64_t now_ms)
+{
+    s_phase = STATUS_INDICATOR_IDLE;
+    s_stats.count++;
+    s_stats.last_on_ms = (uint32_t)(now_ms - s_on_since_ms);
+    s_stats.total_on_ms += s_stats.last_on_ms;
+    ESP_LOGI(TAG, "Indication done, LED on for %" PRIu32 " ms (%" PRIu32 " indications, %" PRIu64 " ms in total)", s_stats.last_on_ms,
+             s_stats.count, s_stats.total_on_ms);
+}
+
+void status_indicator_init(void)
+{
+    timer_wheel_init(&s_wheel, STATUS_INDICATOR_TICK_MS);
+    timer_wheel_entry_init(&s_led_on, status_indicator_led_on_cb, NULL);
+    timer_wheel_entry_init(&s_fade_out, status_indicator_fade_out_cb, NULL);
+    timer_wheel_entry_init(&s_done, status_indicator_done_cb, NULL);
+}
+
+void status_indicator_show(bool comfort)
+{
+    DEFERRED_LOGI(TAG, "Show %s mode", comfort ? "Comfort" : "Eco");
+    s_comfort = comfort;
+    timer_wheel_schedule(&s_wheel, &s_led_on, status_indicator_now_ms());
+    status_indicator_arm();
+}
+
+void status_indicator_update(bool comfort)
+{
+    if (s_phase == STATUS_INDICATOR_ON && comfort != s_comfort) {
+        s_comfort = comfort;
+        status_indicator_light();
+    }
+}
+
+const status_indicator_stats_t *status_indicator_get_stats(void)
+{
+    return &s_stats;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Thermostat mode indication on the RGB LED: green for Eco, red for Comfort,
+ * shown for STATUS_INDICATOR_ON_MS then faded out, after which the LED goes back
+ * to the light endpoint state (and the LED strip is released when that is off).
+ * The three steps are entries of one timer wheel backed by a single Zigbee
+ * scheduler alarm, nothing runs between them.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* How long the mode stays shown, then how long it takes to fade out */
+#define STATUS_INDICATOR_ON_MS          10000
+#define STATUS_INDICATOR_FADE_MS        1000
+
+/* Brightness of the indication, a status LED does not need full power */
+#define STATUS_INDICATOR_LEVEL          128
+
+/* Resolution of the timer wheel */
+#define STATUS_INDICATOR_TICK_MS        10
+
+/* Indication colours, as CIE xy (sRGB primaries) */
+#define STATUS_INDICATOR_ECO_X          0x4CCD  /* 0.30 */
+#define STATUS_INDICATOR_ECO_Y          0x999A  /* 0.60 */
+#define STATUS_INDICATOR_COMFORT_X      0xA3D7  /* 0.64 */
+#define STATUS_INDICATOR_COMFORT_Y      0x547B  /* 0.33 */
+
+/** LED on-time accounting, an indication counts from LED-on to the end of its fade */
+typedef struct {
+    uint32_t count;             /*!< Indications completed */
+    uint32_t last_on_ms;        /*!< On-time of the last indication */
+    uint64_t total_on_ms;       /*!< On-time of all indications */
+} status_indicator_stats_t;
+
+/**
+ * @brief Initialize the indicator, the LED is not touched until the first indication
+ */
+void status_indicator_init(void);
+
+/**
+ * @brief Show the thermostat mode, restarts the on-time if an indication is already running
+ *
+ * @param comfort  true for Comfort (red), false for Eco (green)
+ */
+void status_indicator_show(bool comfort);
+
+/**
+ * @brief Update the colour of a running indication, no-op when the LED is not indicating
+ *
+ * @param comfort  true for Comfort (red), false for Eco (green)
+ */
+void status_indicator_update(bool comfort);
+
+/**
+ * @brief Get the LED on-time accounting
+ */
+const status_indicator_stats_t *status_indicator_get_stats(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
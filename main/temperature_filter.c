@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "temperature_filter.h"
+
+int16_t temperature_filter_ntc(const temperature_filter_ntc_point_t *table, size_t count, int32_t millivolts)
+{
+    for (size_t i = 1; i < count; i++) {
+        const temperature_filter_ntc_point_t *hot = &table[i];
+        const temperature_filter_ntc_point_t *cold = &table[i - 1];
+        if (millivolts <= cold->millivolts && millivolts >= hot->millivolts) {
+            return cold->temperature + (int32_t)(hot->temperature - cold->temperature) * (cold->millivolts - millivolts) /
+                                       (cold->millivolts - hot->millivolts);
+        }
+    }
+    return TEMPERATURE_FILTER_UNKNOWN;
+}
+
+void temperature_filter_init(temperature_filter_t *filter, uint8_t shift)
+{
+    *filter = (temperature_filter_t) {
+        .shift = shift,
+    };
+}
+
+static int16_t temperature_filter_median(const temperature_filter_t *filter)
+{
+    int16_t sorted[TEMPERATURE_FILTER_MEDIAN_SIZE];
+    for (uint8_t i = 0; i < filter->count; i++) {
+        int16_t value = filter->window[i];
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return sorted[filter->count / 2];
+}
+
+int16_t temperature_filter_push(temperature_filter_t *filter, int16_t temperature)
+{
+    if (temperature == TEMPERATURE_FILTER_UNKNOWN) {
+        temperature_filter_init(filter, filter->shift);
+        return TEMPERATURE_FILTER_UNKNOWN;
+    }
+    filter->window[filter->next] = temperature;
+    filter->next = (filter->next + 1) % TEMPERATURE_FILTER_MEDIAN_SIZE;
+    if (filter->count < TEMPERATURE_FILTER_MEDIAN_SIZE) {
+        filter->count++;
+    }
+
+    int32_t median = (int32_t)temperature_filter_median(filter) * (1 << TEMPERATURE_FILTER_FRACTION_BITS);
+    if (!filter->primed) {
+        filter->primed = true;
+        filter->state = median;
+    } else {
+        filter->state += (median - filter->state) / (1 << filter->shift);
+    }
+    /* round to nearest, the state may be negative */
+    int32_t half = 1 << (TEMPERATURE_FILTER_FRACTION_BITS - 1);
+    return (filter->state + (filter->state >= 0 ? half : -half)) / (1 << TEMPERATURE_FILTER_FRACTION_BITS);
+}
@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Signal chain of the temperature sensor, in integer arithmetic since the
+ * ESP32-C6 has no FPU: conversion of the NTC divider voltage to a temperature
+ * by interpolation in a calibration table, then a median filter that removes
+ * single outliers (e.g. a conversion disturbed by the radio) followed by a
+ * first-order IIR low-pass filter.
+ *
+ * Temperatures are in ZCL units (0.01 °C) and the module has no ESP-IDF
+ * dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Samples the median is taken over */
+#define TEMPERATURE_FILTER_MEDIAN_SIZE      5
+/* Fractional bits of the IIR filter state */
+#define TEMPERATURE_FILTER_FRACTION_BITS    8
+
+/* ZCL value of an unknown temperature */
+#define TEMPERATURE_FILTER_UNKNOWN          INT16_MIN
+
+/** One point of an NTC calibration table */
+typedef struct {
+    int32_t millivolts;     /*!< Divider output */
+    int16_t temperature;    /*!< In 0.01 °C */
+} temperature_filter_ntc_point_t;
+
+typedef struct {
+    int16_t window[TEMPERATURE_FILTER_MEDIAN_SIZE];
+    uint8_t count;          /*!< Samples in the window, up to TEMPERATURE_FILTER_MEDIAN_SIZE */
+    uint8_t next;           /*!< Slot of the next sample */
+    uint8_t shift;          /*!< The IIR filter moves 1 / 2^shift of the way to each new median */
+    bool primed;            /*!< The IIR filter state holds a value */
+    int32_t state;          /*!< IIR filter state, with TEMPERATURE_FILTER_FRACTION_BITS fractional bits */
+} temperature_filter_t;
+
+/**
+ * @brief Convert a divider voltage to a temperature
+ *
+ * @param table       Calibration table, sorted by decreasing voltage (increasing temperature)
+ * @param count       Number of points of the table
+ * @param millivolts  Measured voltage
+ * @return The temperature, TEMPERATURE_FILTER_UNKNOWN outside of the table (open or shorted sensor)
+ */
+int16_t temperature_filter_ntc(const temperature_filter_ntc_point_t *table, size_t count, int32_t millivolts);
+
+/**
+ * @brief Initialize a filter, empty
+ *
+ * @param filter  The filter to initialize
+ * @param shift   IIR smoothing, the time constant is about 2^shift samples
+ */
+void temperature_filter_init(temperature_filter_t *filter, uint8_t shift);
+
+/**
+ * @brief Filter a new sample
+ *
+ * @param filter       The filter
+ * @param temperature  The sample, TEMPERATURE_FILTER_UNKNOWN empties the filter
+ * @return The filtered temperature, TEMPERATURE_FILTER_UNKNOWN if the sample is unknown
+ */
+int16_t temperature_filter_push(temperature_filter_t *filter, int16_t temperature);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
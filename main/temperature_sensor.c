@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "attr_reporter.h"
+#include "boot_stage.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_zb_light.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "memory_report.h"
+#include "temperature_filter.h"
+#include "temperature_sensor.h"
+
+static const char *TAG = "TEMPERATURE_SENSOR";
+
+#define TEMPERATURE_SENSOR_FRAME_SIZE   (TEMPERATURE_SENSOR_OVERSAMPLING * SOC_ADC_DIGI_RESULT_BYTES)
+
+/* NTC 10 kOhm B3950 with a 10 kOhm pull-up to 3.3 V, every 5 °C */
+static const temperature_filter_ntc_point_t s_ntc_table[] = {
+    { 2816, -1000 }, { 2689, -500 }, { 2543, 0 }, { 2381, 500 }, { 2206, 1000 },
+    { 2023, 1500 }, { 1836, 2000 }, { 1650, 2500 }, { 1470, 3000 }, { 1301, 3500 },
+    { 1143, 4000 }, { 1000, 4500 }, { 871, 5000 }, { 757, 5500 }, { 657, 6000 },
+};
+
+static adc_continuous_handle_t s_adc;
+static adc_cali_handle_t s_cali;
+static temperature_filter_t s_filter;
+static temperature_sensor_cb_t s_on_measure;
+static attr_reporter_t s_reporter;
+static StackType_t s_task_stack[TEMPERATURE_SENSOR_TASK_STACK_SIZE];
+static StaticTask_t s_task_buffer;
+/* latest filtered temperature, handed from the sensor task to the Zigbee context */
+static volatile int16_t s_temperature = TEMPERATURE_FILTER_UNKNOWN;
+
+static void temperature_sensor_publish_cb(uint8_t param)
+{
+    int16_t temperature = s_temperature;
+    esp_zb_zcl_set_attribute_val(BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, &temperature, false);
+    attr_reporter_update(&s_reporter, temperature);
+    if (s_on_measure) {
+        s_on_measure(temperature);
+    }
+}
+
+/* One burst of conversions, averaged, in millivolts */
+static esp_err_t temperature_sensor_sample(int *millivolts)
+{
+    uint8_t frame[TEMPERATURE_SENSOR_FRAME_SIZE];
+    uint32_t length = 0;
+    ESP_RETURN_ON_ERROR(adc_continuous_flush_pool(s_adc), TAG, "Failed to flush the ADC pool");
+    ESP_RETURN_ON_ERROR(adc_continuous_start(s_adc), TAG, "Failed to start the ADC");
+    esp_err_t ret = adc_continuous_read(s_adc, frame, sizeof(frame), &length, 100);
+    adc_continuous_stop(s_adc);
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to read the ADC");
+
+    uint32_t sum = 0;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *data = (const adc_digi_output_data_t *)&frame[i];
+        if (data->type2.channel == TEMPERATURE_SENSOR_ADC_CHANNEL) {
+            sum += data->type2.data;
+            count++;
+        }
+    }
+    ESP_RETURN_ON_FALSE(count, ESP_ERR_INVALID_RESPONSE, TAG, "No conversion of the sensor channel");
+    return adc_cali_raw_to_voltage(s_cali, (sum + count / 2) / count, millivolts);
+}
+
+static void temperature_sensor_task(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        int millivolts;
+        int16_t temperature = TEMPERATURE_FILTER_UNKNOWN;
+        if (temperature_sensor_sample(&millivolts) == ESP_OK) {
+            temperature = temperature_filter_ntc(s_ntc_table, sizeof(s_ntc_table) / sizeof(s_ntc_table[0]), millivolts);
+        }
+        temperature = temperature_filter_push(&s_filter, temperature);
+        if (temperature != s_temperature) {
+            s_temperature = temperature;
+            if (boot_stage_run(temperature_sensor_publish_cb, 0) != ESP_OK) {
+                ESP_LOGW(TAG, "Temperature dropped, the Zigbee stack is not up yet");
+            }
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TEMPERATURE_SENSOR_PERIOD_MS));
+    }
+}
+
+esp_err_t temperature_sensor_init(temperature_sensor_cb_t on_measure)
+{
+    s_on_measure = on_measure;
+    temperature_filter_init(&s_filter, TEMPERATURE_SENSOR_FILTER_SHIFT);
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = TEMPERATURE_SENSOR_FRAME_SIZE,
+        .conv_frame_size = TEMPERATURE_SENSOR_FRAME_SIZE,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&handle_config, &s_adc), TAG, "Failed to create the ADC handle");
+    adc_digi_pattern_config_t pattern = {
+        .atten = TEMPERATURE_SENSOR_ADC_ATTEN,
+        .channel = TEMPERATURE_SENSOR_ADC_CHANNEL,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t config = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = TEMPERATURE_SENSOR_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_config(s_adc, &config), TAG, "Failed to configure the ADC");
+
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .chan = TEMPERATURE_SENSOR_ADC_CHANNEL,
+        .atten = TEMPERATURE_SENSOR_ADC_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ESP_RETURN_ON_ERROR(adc_cali_create_scheme_curve_fitting(&cali_config, &s_cali), TAG, "Failed to create the ADC calibration");
+
+    TaskHandle_t task = xTaskCreateStatic(temperature_sensor_task, "temperature", TEMPERATURE_SENSOR_TASK_STACK_SIZE, NULL,
+                                          TEMPERATURE_SENSOR_TASK_PRIORITY, s_task_stack, &s_task_buffer);
+    return memory_report_add_task(task, TEMPERATURE_SENSOR_TASK_STACK_SIZE);
+}
+
+esp_err_t temperature_sensor_register(void)
+{
+    ESP_RETURN_ON_ERROR(attr_reporter_register(&s_reporter, BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+                                               ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, 0, TEMPERATURE_SENSOR_REPORT_DELTA),
+                        TAG, "Failed to register the temperature reporter");
+    /* defaults until the coordinator configures the reporting */
+    report_coalescer_set_intervals(&s_reporter.coalescer, TEMPERATURE_SENSOR_REPORT_MIN_S, TEMPERATURE_SENSOR_REPORT_MAX_S);
+    return ESP_OK;
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * NTC temperature sensor on an ADC pin, published as the MeasuredValue of the
+ * Temperature Measurement cluster (0x0402) of the temperature endpoint.
+ *
+ * Every period the ADC runs in continuous (DMA) mode for a single frame, whose
+ * conversions are averaged (oversampling), then stopped so that the chip can
+ * sleep in between. The averaged voltage goes through temperature_filter and
+ * the result is reported only when it moved by the report delta, or when the
+ * max interval has elapsed.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* NTC 10 kOhm B3950 to ground, 10 kOhm to 3.3 V, divider on GPIO2 */
+#define TEMPERATURE_SENSOR_ADC_CHANNEL      ADC_CHANNEL_2
+#define TEMPERATURE_SENSOR_ADC_ATTEN        ADC_ATTEN_DB_12
+
+/* Sampling: one burst of conversions per period, averaged */
+#define TEMPERATURE_SENSOR_PERIOD_MS        5000
+#define TEMPERATURE_SENSOR_SAMPLE_FREQ_HZ   20000
+#define TEMPERATURE_SENSOR_OVERSAMPLING     64
+/* IIR smoothing, the time constant is about 2^shift periods */
+#define TEMPERATURE_SENSOR_FILTER_SHIFT     2
+
+/* Reporting: changes smaller than the delta (0.01 °C) are not sent before the max interval */
+#define TEMPERATURE_SENSOR_REPORT_DELTA     20
+#define TEMPERATURE_SENSOR_REPORT_MIN_S     10
+#define TEMPERATURE_SENSOR_REPORT_MAX_S     600
+
+#define TEMPERATURE_SENSOR_TASK_STACK_SIZE  3072
+#define TEMPERATURE_SENSOR_TASK_PRIORITY    2
+
+/* Range of the calibration table, in 0.01 °C */
+#define TEMPERATURE_SENSOR_MIN_VALUE        -1000
+#define TEMPERATURE_SENSOR_MAX_VALUE        6000
+
+/**
+ * @brief Called in the Zigbee context with every new filtered temperature
+ *
+ * @param temperature  In 0.01 °C, TEMPERATURE_FILTER_UNKNOWN if the sensor is open or shorted
+ */
+typedef void (*temperature_sensor_cb_t)(int16_t temperature);
+
+/**
+ * @brief Set up the ADC and start sampling, the measurements are published once the Zigbee stack is up
+ *
+ * @param on_measure  Called with every new temperature, may be NULL
+ */
+esp_err_t temperature_sensor_init(temperature_sensor_cb_t on_measure);
+
+/**
+ * @brief Register the MeasuredValue reporter, call from the Zigbee task once the device is registered
+ */
+esp_err_t temperature_sensor_register(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <inttypes.h>
+#include "attr_reporter.h"
+#include "deferred_log.h"
+#include "esp_check.h"
+#include "esp_zb_light.h"
+#include "heater_link.h"
+#include "thermostat.h"
+#include "thermostat_control.h"
+
+static const char *TAG = "THERMOSTAT";
+
+static thermostat_control_t s_control;
+static attr_reporter_t s_temperature_reporter;
+static attr_reporter_t s_occupancy_reporter;
+static attr_reporter_t s_running_state_reporter;
+
+static void *thermostat_attr_value(uint16_t attr_id)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT,
+                                                       ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id);
+    return attr->data_p;
+}
+
+static void thermostat_set_attr(uint16_t attr_id, void *value)
+{
+    esp_zb_zcl_set_attribute_val(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 attr_id, value, false);
+}
+
+static void thermostat_run(void)
+{
+    bool occupied = *(uint8_t *)thermostat_attr_value(ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID) & 0x01;
+    int16_t setpoint = *(int16_t *)thermostat_attr_value(occupied ? ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID
+                                                                  : ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID);
+    int16_t temperature = *(int16_t *)thermostat_attr_value(ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID);
+    bool enabled = *(uint8_t *)thermostat_attr_value(ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID) != ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF;
+
+    if (!thermostat_control_update(&s_control, temperature, setpoint, enabled)) {
+        return;
+    }
+    uint16_t running_state = s_control.heating ? 0x0001 : 0x0000;   /* Heat State On */
+    uint8_t heating_demand = s_control.heating ? 100 : 0;
+    thermostat_set_attr(ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, &running_state);
+    thermostat_set_attr(ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, &heating_demand);
+    attr_reporter_update(&s_running_state_reporter, running_state);
+    /* the bound heaters follow without waiting for the coordinator */
+    heater_link_set(s_control.heating);
+    DEFERRED_LOGI(TAG, "Heating %s at %d (setpoint %d, %" PRIu32 " cycles)", s_control.heating ? "on" : "off", temperature, setpoint,
+                  s_control.cycles);
+}
+
+esp_err_t thermostat_init(bool occupied)
+{
+    thermostat_control_init(&s_control, THERMOSTAT_HYSTERESIS);
+    ESP_RETURN_ON_ERROR(attr_reporter_register(&s_temperature_reporter, BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT,
+                                               ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, THERMOSTAT_REPORT_WINDOW_MS,
+                                               THERMOSTAT_TEMPERATURE_REPORTABLE_CHANGE), TAG, "Failed to register the temperature reporter");
+    ESP_RETURN_ON_ERROR(attr_reporter_register(&s_occupancy_reporter, BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT,
+                                               ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, THERMOSTAT_REPORT_WINDOW_MS, 1),
+                        TAG, "Failed to register the occupancy reporter");
+    ESP_RETURN_ON_ERROR(attr_reporter_register(&s_running_state_reporter, BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT,
+                                               ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, THERMOSTAT_REPORT_WINDOW_MS, 1),
+                        TAG, "Failed to register the running state reporter");
+    uint8_t occupancy = occupied ? 0x01 : 0x00;
+    thermostat_set_attr(ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, &occupancy);
+    thermostat_run();
+    return ESP_OK;
+}
+
+void thermostat_set_occupied(bool occupied)
+{
+    uint8_t occupancy = occupied ? 0x01 : 0x00;
+    thermostat_set_attr(ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, &occupancy);
+    attr_reporter_update(&s_occupancy_reporter, occupancy);
+    thermostat_run();
+}
+
+void thermostat_set_local_temperature(int16_t temperature)
+{
+    thermostat_set_attr(ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, &temperature);
+    attr_reporter_update(&s_temperature_reporter, temperature);
+    thermostat_run();
+}
+
+void thermostat_refresh(void)
+{
+    thermostat_run();
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Thermostat cluster (0x0201) of the thermostat endpoint, driven on the device.
+ * Comfort is the occupied mode and Eco the unoccupied one, each with its own
+ * heating setpoint; the button switches between them without a round trip to
+ * the coordinator. thermostat_control runs the hysteresis loop and its output
+ * is published as ThermostatRunningState and PIHeatingDemand (0 or 100 %),
+ * reported upstream along with LocalTemperature and Occupancy, and sent to the
+ * bound heaters by heater_link.
+ *
+ * All functions must be called from the Zigbee task or with the Zigbee lock held.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default setpoints, in 0.01 °C */
+#define THERMOSTAT_COMFORT_SETPOINT         2200
+#define THERMOSTAT_ECO_SETPOINT             1800
+/* Width of the control band around the setpoint, in 0.01 °C */
+#define THERMOSTAT_HYSTERESIS               50
+
+/* Reporting: changes within the window are merged, temperature changes below the reportable change are not sent */
+#define THERMOSTAT_REPORT_WINDOW_MS         1000
+#define THERMOSTAT_TEMPERATURE_REPORTABLE_CHANGE    10
+
+/**
+ * @brief Start the control loop, call once the device is registered and its state restored
+ *
+ * @param occupied  Initial mode, true for Comfort
+ */
+esp_err_t thermostat_init(bool occupied);
+
+/**
+ * @brief Switch between Comfort (occupied) and Eco (unoccupied)
+ *
+ * @param occupied  true for Comfort
+ */
+void thermostat_set_occupied(bool occupied);
+
+/**
+ * @brief Feed a new temperature measurement to the control loop
+ *
+ * @param temperature  In 0.01 °C, THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN if the sensor failed
+ */
+void thermostat_set_local_temperature(int16_t temperature);
+
+/**
+ * @brief Run the control loop again after a setpoint or the system mode was written
+ */
+void thermostat_refresh(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,34 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include "thermostat_control.h"
+
+void thermostat_control_init(thermostat_control_t *tc, int16_t hysteresis)
+{
+    *tc = (thermostat_control_t) {
+        .hysteresis = hysteresis,
+    };
+}
+
+bool thermostat_control_update(thermostat_control_t *tc, int16_t temperature, int16_t setpoint, bool enabled)
+{
+    bool heating = tc->heating;
+    if (!enabled || temperature == THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN) {
+        heating = false;
+    } else if (heating && (int32_t)temperature >= (int32_t)setpoint + tc->hysteresis / 2) {
+        heating = false;
+    } else if (!heating && (int32_t)temperature <= (int32_t)setpoint - tc->hysteresis / 2) {
+        heating = true;
+    }
+    if (heating == tc->heating) {
+        return false;
+    }
+    tc->heating = heating;
+    if (heating) {
+        tc->cycles++;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Core of the heating control loop: an on/off controller with hysteresis
+ * around the setpoint of the current mode. Heating starts once the temperature
+ * falls half the hysteresis below the setpoint and stops once it rises half
+ * the hysteresis above it, so the heater does not chatter around the setpoint.
+ *
+ * Temperatures are in ZCL units (0.01 °C) and the module has no ESP-IDF
+ * dependency, so it can run on the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ZCL value of an unknown temperature, the heating is stopped */
+#define THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN  INT16_MIN
+
+typedef struct {
+    int16_t hysteresis;         /*!< Width of the band around the setpoint, in 0.01 °C */
+    bool heating;               /*!< Current output */
+    uint32_t cycles;            /*!< Number of times the heating started */
+} thermostat_control_t;
+
+/**
+ * @brief Initialize a control loop, heating off
+ *
+ * @param tc          The control loop to initialize
+ * @param hysteresis  Width of the band around the setpoint, in 0.01 °C
+ */
+void thermostat_control_init(thermostat_control_t *tc, int16_t hysteresis);
+
+/**
+ * @brief Run the loop on a new temperature or setpoint
+ *
+ * @param tc           The control loop
+ * @param temperature  Measured temperature, THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN if unknown
+ * @param setpoint     Setpoint of the current mode
+ * @param enabled      false when the system mode is off, the heating is then stopped
+ * @return true if the output changed
+ */
+bool thermostat_control_update(thermostat_control_t *tc, int16_t temperature, int16_t setpoint, bool enabled);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ */
+
+#include <stddef.h>
+#include "timer_wheel.h"
+
+static timer_wheel_entry_t **timer_wheel_slot(timer_wheel_t *wheel, int64_t tick)
+{
+    return &wheel->slots[(uint64_t)tick & (TIMER_WHEEL_SLOTS - 1)];
+}
+
+static int64_t timer_wheel_next_tick(const timer_wheel_t *wheel)
+{
+    int64_t next_tick = TIMER_WHEEL_NO_DEADLINE;
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        for (const timer_wheel_entry_t *entry = wheel->slots[i]; entry; entry = entry->next) {
+            if (entry->deadline_tick < next_tick) {
+                next_tick = entry->deadline_tick;
+            }
+        }
+    }
+    return next_tick;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t tick_ms)
+{
+    *wheel = (timer_wheel_t) {
+        .tick_ms = tick_ms ? tick_ms : 1,
+    };
+}
+
+void timer_wheel_entry_init(timer_wheel_entry_t *entry, timer_wheel_cb_t cb, void *arg)
+{
+    *entry = (timer_wheel_entry_t) {
+        .cb = cb,
+        .arg = arg,
+    };
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_wheel_entry_t *entry, int64_t deadline_ms)
+{
+    timer_wheel_cancel(wheel, entry);
+    /* round up so that an entry never expires before its deadline */
+    entry->deadline_tick = (deadline_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    timer_wheel_entry_t **slot = timer_wheel_slot(wheel, entry->deadline_tick);
+    entry->next = *slot;
+    *slot = entry;
+    entry->scheduled = true;
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_entry_t *entry)
+{
+    if (!entry->scheduled) {
+        return;
+    }
+    for (timer_wheel_entry_t **link = timer_wheel_slot(wheel, entry->deadline_tick); *link; link = &(*link)->next) {
+        if (*link == entry) {
+            *link = entry->next;
+            break;
+        }
+    }
+    entry->next = NULL;
+    entry->scheduled = false;
+}
+
+unsigned timer_wheel_advance(timer_wheel_t *wheel, int64_t now_ms)
+{
+    int64_t now_tick = now_ms / wheel->tick_ms;
+    unsigned expired = 0;
+    int64_t tick;
+    /* one entry at a time: callbacks may schedule or cancel other entries */
+    while ((tick = timer_wheel_next_tick(wheel)) <= now_tick) {
+        timer_wheel_entry_t **link = timer_wheel_slot(wheel, tick);
+        while ((*link)->deadline_tick != tick) {
+            link = &(*link)->next;
+        }
+        timer_wheel_entry_t *entry = *link;
+        *link = entry->next;
+        entry->next = NULL;
+        entry->scheduled = false;
+        entry->cb(entry->arg, now_ms);
+        expired++;
+    }
+    return expired;
+}
+
+int64_t timer_wheel_next_deadline(const timer_wheel_t *wheel)
+{
+    int64_t next_tick = timer_wheel_next_tick(wheel);
+    return next_tick == TIMER_WHEEL_NO_DEADLINE ? TIMER_WHEEL_NO_DEADLINE : next_tick * wheel->tick_ms;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bathroom thermostat controller
+ *
+ * Hashed timer wheel. Any number of deadlines share a single hardware or stack
+ * timer: the owner arms that timer for timer_wheel_next_deadline() and calls
+ * timer_wheel_advance() when it fires. Entries are intrusive, so scheduling never
+ * allocates, and nothing runs between deadlines.
+ *
+ * Time is always passed in by the caller (milliseconds, any monotonic origin)
+ * and the module has no ESP-IDF dependency, so it can run on the host.
+ * The wheel is not thread safe, all calls must come from the same context.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of slots of the wheel, must be a power of two */
+#define TIMER_WHEEL_SLOTS           16
+
+/* No entry scheduled */
+#define TIMER_WHEEL_NO_DEADLINE     INT64_MAX
+
+_Static_assert((TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1)) == 0, "TIMER_WHEEL_SLOTS must be a power of two");
+
+typedef struct timer_wheel_entry timer_wheel_entry_t;
+
+/**
+ * @brief Expiry callback, the entry is already unscheduled and may be scheduled again from here
+ *
+ * @param arg     The argument given to timer_wheel_entry_init()
+ * @param now_ms  The time passed to timer_wheel_advance()
+ */
+typedef void (*timer_wheel_cb_t)(void *arg, int64_t now_ms);
+
+struct timer_wheel_entry {
+    timer_wheel_entry_t *next;  /*!< Next entry of the same slot */
+    int64_t deadline_tick;      /*!< Expiry, in ticks */
+    timer_wheel_cb_t cb;        /*!< Called on expiry */
+    void *arg;                  /*!< Argument of cb */
+    bool scheduled;             /*!< The entry is linked in a slot */
+};
+
+typedef struct {
+    timer_wheel_entry_t *slots[TIMER_WHEEL_SLOTS];
+    uint32_t tick_ms;           /*!< Resolution, deadlines are rounded up to a tick */
+} timer_wheel_t;
+
+/**
+ * @brief Initialize an empty wheel
+ *
+ * @param wheel    The wheel to initialize
+ * @param tick_ms  Resolution of the wheel, in milliseconds
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t tick_ms);
+
+/**
+ * @brief Initialize an entry, once before its first use
+ *
+ * @param entry  The entry to initialize
+ * @param cb     Called when the entry expires
+ * @param arg    Argument of cb
+ */
+void timer_wheel_entry_init(timer_wheel_entry_t *entry, timer_wheel_cb_t cb, void *arg);
+
+/**
+ * @brief Schedule an entry, or move it if it is already scheduled
+ *
+ * A deadline in the past expires on the next timer_wheel_advance().
+ *
+ * @param wheel        The wheel
+ * @param entry        The entry to schedule
+ * @param deadline_ms  Expiry time
+ */
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_wheel_entry_t *entry, int64_t deadline_ms);
+
+/**
+ * @brief Unschedule an entry, no-op if it is not scheduled
+ *
+ * @param wheel  The wheel
+ * @param entry  The entry to unschedule
+ */
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_entry_t *entry);
+
+/**
+ * @brief Run the callbacks of every entry due at @p now_ms, in deadline order
+ *
+ * @param wheel   The wheel
+ * @param now_ms  Current time
+ * @return Number of callbacks run
+ */
+unsigned timer_wheel_advance(timer_wheel_t *wheel, int64_t now_ms);
+
+/**
+ * @brief Get the earliest deadline, to arm the backing timer
+ *
+ * @param wheel  The wheel
+ * @return Time at which timer_wheel_advance() must be called next, TIMER_WHEEL_NO_DEADLINE if none
+ */
+int64_t timer_wheel_next_deadline(const timer_wheel_t *wheel);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
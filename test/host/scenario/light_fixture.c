@@ -0,0 +1,509 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Scenario fixture of the light endpoint and the buttons: the real switch
+ * driver, light driver, light_state, light_scenes, attr_registry,
+ * attr_reporter and boot_stage, wired as esp_zb_light.c wires them, on the
+ * simulated stack.
+ *
+ * Commands, on top of those of the runner:
+ *
+ *     stack_ready                          the Zigbee stack is up, queued button actions run
+ *     write <attr> <value>                 attribute written by the network, see s_attrs for the names
+ *     reporting <attr> <min s> <max s>     Configure Reporting from the network
+ *     store <group> <scene>                Store Scene from the network
+ *     recall <group> <scene> <transition ds>
+ *                                          Recall Scene from the network
+ *     reset                                forget the frames, stack reports, LED refreshes and gestures counted so far
+ *     expect attr <attr> <value>
+ *     expect led <red> <green> <blue>      colour of the first pixel as last sent
+ *     expect refreshes <count>             LED frames sent since the last reset
+ *     expect strip <created> <deleted>     LED strip devices created and deleted since boot
+ *     expect frames <count>                APS frames sent since the last reset
+ *     expect stack_reports <count>         reports sent by the stack's own reporting since the last reset
+ *     expect frame <index> <endpoint> <cluster> <attr>=<value>...
+ *                                          Report Attributes frame and its records, in order
+ *     expect gesture <pin> <gesture> <count>
+ *                                          gestures since the last reset, e.g. "expect gesture 10 press 1"
+ *     expect latency <path> <count> <max time>
+ *                                          latency path since boot, e.g. "expect latency edge_to_report 1 400ms"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "attr_registry.h"
+#include "attr_reporter.h"
+#include "boot_stage.h"
+#include "esp_zb_light.h"
+#include "latency_trace.h"
+#include "light_scenes.h"
+#include "light_state.h"
+#include "scenario.h"
+#include "sim.h"
+
+/* time from reset to app_main, the latency paths take 0 for closed */
+#define LIGHT_FIXTURE_BOOT_US   100000
+
+typedef struct {
+    const char *name;
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+    uint32_t initial;
+} light_fixture_attr_t;
+
+typedef enum {
+    ATTR_ON_OFF,
+    ATTR_LEVEL,
+    ATTR_ON_OFF_TRANSITION,
+    ATTR_COLOR_X,
+    ATTR_COLOR_Y,
+    ATTR_PRESENT_VALUE,
+    ATTR_SCENE,
+    ATTR_GROUP,
+    ATTR_SCENE_VALID,
+    ATTR_COUNT,
+} light_fixture_attr_index_t;
+
+/* the attribute store of the simulated stack */
+static const light_fixture_attr_t s_attrs[ATTR_COUNT] = {
+    [ATTR_ON_OFF] = { "on_off", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0 },
+    [ATTR_LEVEL] = { "level", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE },
+    [ATTR_ON_OFF_TRANSITION] = { "transition", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, 0 },
+    [ATTR_COLOR_X] = { "color_x", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE },
+    [ATTR_COLOR_Y] = { "color_y", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE },
+    [ATTR_PRESENT_VALUE] = { "present_value", BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0 },
+    [ATTR_SCENE] = { "scene", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U8, 0 },
+    [ATTR_GROUP] = { "group", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, 0 },
+    [ATTR_SCENE_VALID] = { "scene_valid", BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0 },
+};
+
+static const char *const s_gesture_names[SWITCH_GESTURE_COUNT] = {
+    [SWITCH_GESTURE_PRESS] = "press",
+    [SWITCH_GESTURE_RELEASE] = "release",
+    [SWITCH_GESTURE_CLICK] = "click",
+    [SWITCH_GESTURE_DOUBLE_CLICK] = "double_click",
+    [SWITCH_GESTURE_LONG_PRESS] = "long_press",
+    [SWITCH_GESTURE_HOLD] = "hold",
+};
+
+static const char *const s_path_names[LATENCY_TRACE_PATH_COUNT] = {
+    [LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET] = "edge_to_attr_set",
+    [LATENCY_TRACE_PATH_EDGE_TO_REPORT] = "edge_to_report",
+    [LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE] = "edge_to_debounce",
+    [LATENCY_TRACE_PATH_WRITE_TO_LED] = "write_to_led",
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND] = "edge_to_command",
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK] = "edge_to_command_ack",
+};
+
+
+static switch_func_pair_t s_buttons[] = {
+    { .pin = BATHROOM_SWITCH_GPIO, .func = SWITCH_ONOFF_TOGGLE_CONTROL, .active_high = true },
+    { .pin = BATHROOM_STATUS_GPIO, .func = SWITCH_COLOR_CONTROL },
+    { .pin = BATHROOM_RESET_GPIO, .func = SWITCH_OFF_CONTROL, .active_high = true, .gestures = { .hold_ms = BATHROOM_RESET_HOLD_MS } },
+};
+
+static attr_reporter_t s_present_value_reporter;
+static uint32_t s_gestures[PAIR_SIZE(s_buttons)][SWITCH_GESTURE_COUNT];
+static uint32_t s_refreshes_base;
+static uint32_t s_stack_reports_base;
+
+static const light_fixture_attr_t *light_fixture_attr(const char *name, char *error)
+{
+    for (size_t i = 0; i < PAIR_SIZE(s_attrs); i++) {
+        if (strcmp(s_attrs[i].name, name) == 0) {
+            return &s_attrs[i];
+        }
+    }
+    snprintf(error, SCENARIO_ERROR_SIZE, "unknown attribute \"%s\"", name);
+    return NULL;
+}
+
+static uint32_t light_fixture_attr_value(const light_fixture_attr_t *desc)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(desc->endpoint, desc->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, desc->attr_id);
+    uint32_t value = 0;
+    memcpy(&value, attr->data_p, sim_zb_attr_size(desc->type));
+    return value;
+}
+
+/* Handlers of the network writes, as in esp_zb_light.c */
+static void light_on_off_write(const void *value)
+{
+    light_state_stage_power(*(const bool *)value);
+    light_scenes_invalidate();
+}
+
+static void light_level_write(const void *value)
+{
+    light_state_stage_level(*(const uint8_t *)value);
+    light_scenes_invalidate();
+}
+
+static void light_on_off_transition_write(const void *value)
+{
+    light_state_set_on_off_transition(*(const uint16_t *)value);
+}
+
+static void light_color_x_write(const void *value)
+{
+    light_state_stage_color_x(*(const uint16_t *)value);
+    light_scenes_invalidate();
+}
+
+static void light_color_y_write(const void *value)
+{
+    light_state_stage_color_y(*(const uint16_t *)value);
+    light_scenes_invalidate();
+}
+
+static attr_registry_entry_t s_registry[] = {
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_BOOL, light_on_off_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U8, light_level_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_on_off_transition_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_x_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_y_write },
+};
+
+static void switch_toggle_cb(uint8_t param)
+{
+    const light_fixture_attr_t *desc = &s_attrs[ATTR_PRESENT_VALUE];
+    bool value = !light_fixture_attr_value(desc);
+    esp_zb_zcl_set_attribute_val(desc->endpoint, desc->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, desc->attr_id, &value, false);
+    latency_trace_point(LATENCY_TRACE_ATTR_SET);
+    attr_reporter_update(&s_present_value_reporter, value);
+}
+
+static void button_handler(switch_func_pair_t *button, switch_gesture_t gesture)
+{
+    s_gestures[button - s_buttons][gesture]++;
+    if (button->pin == BATHROOM_SWITCH_GPIO && gesture == SWITCH_GESTURE_PRESS) {
+        boot_stage_run(switch_toggle_cb, 0);
+    }
+}
+
+static void light_fixture_setup(void)
+{
+    sim_advance(LIGHT_FIXTURE_BOOT_US);
+    latency_trace_init();
+    for (size_t i = 0; i < PAIR_SIZE(s_attrs); i++) {
+        ESP_ERROR_CHECK(sim_zb_attr_add(s_attrs[i].endpoint, s_attrs[i].cluster_id, s_attrs[i].attr_id, s_attrs[i].type,
+                                        &s_attrs[i].initial));
+    }
+    light_driver_state_t initial = {
+        .power = LIGHT_DEFAULT_OFF,
+        .level = ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE,
+        .color_x = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE,
+        .color_y = ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE,
+    };
+    light_driver_init(LIGHT_DEFAULT_OFF);
+    light_state_init(&initial);
+    ESP_ERROR_CHECK(light_scenes_init());
+    if (!switch_driver_init(s_buttons, PAIR_SIZE(s_buttons), button_handler)) {
+        abort();
+    }
+    ESP_ERROR_CHECK(attr_registry_init(s_registry, PAIR_SIZE(s_registry)));
+    ESP_ERROR_CHECK(attr_reporter_register(&s_present_value_reporter, BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT,
+                                           ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, BINARY_INPUT_REPORT_WINDOW_MS, 1));
+}
+
+static bool light_fixture_stack_ready(int argc, char **argv, char *error)
+{
+    boot_stage_stack_ready();
+    return true;
+}
+
+/* What the stack does on a Write Attributes command: update the store, then call the action handler */
+static bool light_fixture_write(int argc, char **argv, char *error)
+{
+    const light_fixture_attr_t *desc = light_fixture_attr(argv[0], error);
+    long value;
+    if (!desc) {
+        return false;
+    }
+    if (!scenario_parse_int(argv[1], &value)) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "bad value \"%s\"", argv[1]);
+        return false;
+    }
+    uint32_t data = (uint32_t)value;
+    esp_zb_zcl_set_attribute_val(desc->endpoint, desc->cluster_id, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, desc->attr_id, &data, false);
+    esp_zb_zcl_set_attr_value_message_t message = {
+        .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = desc->endpoint, .cluster = desc->cluster_id },
+        .attribute = { .id = desc->attr_id, .data = { .type = desc->type, .size = sim_zb_attr_size(desc->type), .value = &data } },
+    };
+    latency_trace_point(LATENCY_TRACE_ATTR_CALLBACK);
+    esp_err_t err = attr_registry_dispatch(&message);
+    if (err != ESP_OK) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "write of %s rejected: %s", desc->name, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+static bool light_fixture_reporting(int argc, char **argv, char *error)
+{
+    const light_fixture_attr_t *desc = light_fixture_attr(argv[0], error);
+    long min_interval, max_interval;
+    if (!desc) {
+        return false;
+    }
+    if (!scenario_parse_int(argv[1], &min_interval) || !scenario_parse_int(argv[2], &max_interval)) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "bad interval");
+        return false;
+    }
+    ESP_ERROR_CHECK(sim_zb_reporting_set(desc->endpoint, desc->cluster_id, desc->attr_id, min_interval, max_interval));
+    return true;
+}
+
+static bool light_fixture_parse_scene(char **argv, esp_zb_device_cb_common_info_t *info, uint16_t *group_id, uint8_t *scene_id,
+                                      char *error)
+{
+    long group, scene;
+    if (!scenario_parse_int(argv[0], &group) || !scenario_parse_int(argv[1], &scene)) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "bad scene");
+        return false;
+    }
+    *info = (esp_zb_device_cb_common_info_t) { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = BATHROOM_LIGHT_ENDPOINT };
+    *group_id = group;
+    *scene_id = scene;
+    return true;
+}
+
+static bool light_fixture_store(int argc, char **argv, char *error)
+{
+    esp_zb_zcl_store_scene_message_t message;
+    if (!light_fixture_parse_scene(argv, &message.info, &message.group_id, &message.scene_id, error)) {
+        return false;
+    }
+    esp_err_t err = light_scenes_store(&message);
+    if (err != ESP_OK) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "store rejected: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+/* What the stack does on a Recall Scene command of a scene stored here: call the action handler, without the field sets */
+static bool light_fixture_recall(int argc, char **argv, char *error)
+{
+    esp_zb_zcl_recall_scene_message_t message = { 0 };
+    long transition;
+    if (!light_fixture_parse_scene(argv, &message.info, &message.group_id, &message.scene_id, error)) {
+        return false;
+    }
+    if (!scenario_parse_int(argv[2], &transition)) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "bad transition time");
+        return false;
+    }
+    message.transition_time = transition;
+    latency_trace_point(LATENCY_TRACE_ATTR_CALLBACK);
+    esp_err_t err = light_scenes_recall(&message);
+    if (err != ESP_OK) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "recall rejected: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+static bool light_fixture_reset(int argc, char **argv, char *error)
+{
+    sim_zb_frames_clear();
+    s_refreshes_base = sim_led_strip_get()->refreshes;
+    s_stack_reports_base = sim_zb_stack_report_count();
+    memset(s_gestures, 0, sizeof(s_gestures));
+    return true;
+}
+
+static bool light_fixture_expect_count(const char *what, long expected, long actual, char *error)
+{
+    if (expected != actual) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "expected %ld %s, got %ld", expected, what, actual);
+        return false;
+    }
+    return true;
+}
+
+static bool light_fixture_expect_attr(int argc, char **argv, char *error)
+{
+    const light_fixture_attr_t *desc = light_fixture_attr(argv[0], error);
+    long expected;
+    if (!desc || !scenario_parse_int(argv[1], &expected)) {
+        return false;
+    }
+    return light_fixture_expect_count(desc->name, expected, light_fixture_attr_value(desc), error);
+}
+
+static bool light_fixture_expect_led(int argc, char **argv, char *error)
+{
+    const uint8_t *pixel = sim_led_strip_get()->pixels[0];
+    long expected[3];
+    for (int i = 0; i < 3; i++) {
+        if (!scenario_parse_int(argv[i], &expected[i])) {
+            return false;
+        }
+    }
+    if (pixel[0] != expected[0] || pixel[1] != expected[1] || pixel[2] != expected[2]) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "expected LED %ld %ld %ld, got %d %d %d", expected[0], expected[1], expected[2], pixel[0],
+                 pixel[1], pixel[2]);
+        return false;
+    }
+    return true;
+}
+
+static bool light_fixture_expect_refreshes(int argc, char **argv, char *error)
+{
+    long expected;
+    return scenario_parse_int(argv[0], &expected) &&
+           light_fixture_expect_count("LED refreshes", expected, sim_led_strip_get()->refreshes - s_refreshes_base, error);
+}
+
+static bool light_fixture_expect_strip(int argc, char **argv, char *error)
+{
+    long created, deleted;
+    return scenario_parse_int(argv[0], &created) && scenario_parse_int(argv[1], &deleted) &&
+           light_fixture_expect_count("strips created", created, sim_led_strip_get()->created, error) &&
+           light_fixture_expect_count("strips deleted", deleted, sim_led_strip_get()->deleted, error);
+}
+
+static bool light_fixture_expect_frames(int argc, char **argv, char *error)
+{
+    long expected;
+    return scenario_parse_int(argv[0], &expected) && light_fixture_expect_count("frames", expected, sim_zb_frame_count(), error);
+}
+
+static bool light_fixture_expect_stack_reports(int argc, char **argv, char *error)
+{
+    long expected;
+    return scenario_parse_int(argv[0], &expected) &&
+           light_fixture_expect_count("stack reports", expected, sim_zb_stack_report_count() - s_stack_reports_base, error);
+}
+
+/* Check a Report Attributes frame record by record, each written <attr>=<value> */
+static bool light_fixture_expect_frame(int argc, char **argv, char *error)
+{
+    long index, endpoint, cluster_id;
+    if (!scenario_parse_int(argv[0], &index) || !scenario_parse_int(argv[1], &endpoint) || !scenario_parse_int(argv[2], &cluster_id)) {
+        return false;
+    }
+    const sim_zb_frame_t *frame = sim_zb_frame(index);
+    if (!frame) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "no frame %ld, %zu sent", index, sim_zb_frame_count());
+        return false;
+    }
+    if (frame->src_endpoint != endpoint || frame->cluster_id != cluster_id || frame->length < 3 || frame->asdu[2] != 0x0A) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "frame %ld is command 0x%02x of endpoint %d cluster 0x%04x", index,
+                 frame->length >= 3 ? frame->asdu[2] : 0, frame->src_endpoint, frame->cluster_id);
+        return false;
+    }
+    uint32_t offset = 3;
+    for (int i = 3; i < argc; i++) {
+        char record[32];
+        snprintf(record, sizeof(record), "%s", argv[i]);
+        char *value_text = strchr(record, '=');
+        long attr_id, expected;
+        if (!value_text || (*value_text++ = '\0', !scenario_parse_int(record, &attr_id)) || !scenario_parse_int(value_text, &expected)) {
+            snprintf(error, SCENARIO_ERROR_SIZE, "bad record \"%s\", expected <attr>=<value>", argv[i]);
+            return false;
+        }
+        size_t size = offset + 3 <= frame->length ? sim_zb_attr_size(frame->asdu[offset + 2]) : 0;
+        if (size == 0 || offset + 3 + size > frame->length) {
+            snprintf(error, SCENARIO_ERROR_SIZE, "frame %ld has no record %d", index, i - 3);
+            return false;
+        }
+        uint32_t actual = 0;
+        memcpy(&actual, &frame->asdu[offset + 3], size);
+        uint16_t actual_id = frame->asdu[offset] | frame->asdu[offset + 1] << 8;
+        if (actual_id != attr_id || actual != (uint32_t)expected) {
+            snprintf(error, SCENARIO_ERROR_SIZE, "frame %ld record %d is 0x%04x=%u, expected %s", index, i - 3, actual_id, actual, argv[i]);
+            return false;
+        }
+        offset += 3 + size;
+    }
+    return light_fixture_expect_count("bytes in the frame", offset, frame->length, error);
+}
+
+static bool light_fixture_expect_gesture(int argc, char **argv, char *error)
+{
+    long pin, expected;
+    if (!scenario_parse_int(argv[0], &pin) || !scenario_parse_int(argv[2], &expected)) {
+        return false;
+    }
+    for (size_t button = 0; button < PAIR_SIZE(s_buttons); button++) {
+        for (int gesture = 0; s_buttons[button].pin == pin && gesture < SWITCH_GESTURE_COUNT; gesture++) {
+            if (strcmp(s_gesture_names[gesture], argv[1]) == 0) {
+                return light_fixture_expect_count(argv[1], expected, s_gestures[button][gesture], error);
+            }
+        }
+    }
+    snprintf(error, SCENARIO_ERROR_SIZE, "no button on pin %ld or unknown gesture \"%s\"", pin, argv[1]);
+    return false;
+}
+
+static bool light_fixture_expect_latency(int argc, char **argv, char *error)
+{
+    long count;
+    int64_t max_us;
+    if (!scenario_parse_int(argv[1], &count) || !scenario_parse_time(argv[2], &max_us)) {
+        return false;
+    }
+    for (int path = 0; path < LATENCY_TRACE_PATH_COUNT; path++) {
+        if (strcmp(s_path_names[path], argv[0]) != 0) {
+            continue;
+        }
+        latency_trace_histogram_t histogram;
+        latency_trace_get_histogram(path, &histogram);
+        if (!light_fixture_expect_count("latencies", count, histogram.count, error)) {
+            return false;
+        }
+        if (histogram.max_us > max_us) {
+            snprintf(error, SCENARIO_ERROR_SIZE, "%s took up to %u us, more than %s", argv[0], histogram.max_us, argv[2]);
+            return false;
+        }
+        return true;
+    }
+    snprintf(error, SCENARIO_ERROR_SIZE, "unknown latency path \"%s\"", argv[0]);
+    return false;
+}
+
+static const scenario_command_t s_commands[] = {
+    { "stack_ready", 0, light_fixture_stack_ready, "" },
+    { "write", 2, light_fixture_write, "<attr> <value>" },
+    { "reporting", 3, light_fixture_reporting, "<attr> <min s> <max s>" },
+    { "store", 2, light_fixture_store, "<group> <scene>" },
+    { "recall", 3, light_fixture_recall, "<group> <scene> <transition ds>" },
+    { "reset", 0, light_fixture_reset, "" },
+    { "expect attr", 2, light_fixture_expect_attr, "<attr> <value>" },
+    { "expect led", 3, light_fixture_expect_led, "<red> <green> <blue>" },
+    { "expect refreshes", 1, light_fixture_expect_refreshes, "<count>" },
+    { "expect strip", 2, light_fixture_expect_strip, "<created> <deleted>" },
+    { "expect frames", 1, light_fixture_expect_frames, "<count>" },
+    { "expect stack_reports", 1, light_fixture_expect_stack_reports, "<count>" },
+    { "expect frame", 3, light_fixture_expect_frame, "<index> <endpoint> <cluster> <attr>=<value>..." },
+    { "expect gesture", 3, light_fixture_expect_gesture, "<pin> <gesture> <count>" },
+    { "expect latency", 3, light_fixture_expect_latency, "<path> <count> <max time>" },
+};
+
+int main(int argc, char **argv)
+{
+    scenario_fixture_t fixture = {
+        .commands = s_commands,
+        .command_count = PAIR_SIZE(s_commands),
+        .setup = light_fixture_setup,
+    };
+    return scenario_main(argc, argv, &fixture);
+}
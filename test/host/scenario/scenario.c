@@ -0,0 +1,233 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Runner of scenario scripts against the host simulation
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "scenario.h"
+#include "sim.h"
+
+#define SCENARIO_MAX_LINES      1024
+#define SCENARIO_LINE_SIZE      256
+#define SCENARIO_MAX_DEPTH      8
+
+typedef struct {
+    int number;
+    int argc;
+    char *argv[SCENARIO_MAX_ARGS];
+    char text[SCENARIO_LINE_SIZE];
+} scenario_line_t;
+
+typedef struct {
+    scenario_line_t lines[SCENARIO_MAX_LINES];
+    int count;
+    const char *path;
+    const scenario_fixture_t *fixture;
+    uint64_t commands_run;
+} scenario_t;
+
+bool scenario_parse_int(const char *text, long *value)
+{
+    char *end;
+    errno = 0;
+    *value = strtol(text, &end, 0);
+    return errno == 0 && end != text && *end == '\0';
+}
+
+bool scenario_parse_time(const char *text, int64_t *time_us)
+{
+    char *end;
+    errno = 0;
+    long long value = strtoll(text, &end, 10);
+    if (errno != 0 || end == text || value < 0) {
+        return false;
+    }
+    if (strcmp(end, "us") == 0) {
+        *time_us = value;
+    } else if (strcmp(end, "ms") == 0) {
+        *time_us = value * 1000;
+    } else if (strcmp(end, "s") == 0) {
+        *time_us = value * 1000000;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool scenario_load(scenario_t *scenario, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    char text[SCENARIO_LINE_SIZE];
+    for (int number = 1; fgets(text, sizeof(text), file); number++) {
+        char *comment = strchr(text, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (scenario->count == SCENARIO_MAX_LINES) {
+            fprintf(stderr, "%s:%d: more than %d lines\n", path, number, SCENARIO_MAX_LINES);
+            fclose(file);
+            return false;
+        }
+        scenario_line_t *line = &scenario->lines[scenario->count];
+        memcpy(line->text, text, sizeof(text));
+        line->number = number;
+        line->argc = 0;
+        for (char *token = strtok(line->text, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+            if (line->argc == SCENARIO_MAX_ARGS) {
+                fprintf(stderr, "%s:%d: more than %d words\n", path, number, SCENARIO_MAX_ARGS);
+                fclose(file);
+                return false;
+            }
+            line->argv[line->argc++] = token;
+        }
+        if (line->argc) {
+            scenario->count++;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+/* Index of the "end" closing the "repeat" at index, -1 if there is none */
+static int scenario_block_end(const scenario_t *scenario, int index)
+{
+    int depth = 0;
+    for (int i = index; i < scenario->count; i++) {
+        const char *name = scenario->lines[i].argv[0];
+        if (strcmp(name, "repeat") == 0) {
+            depth++;
+        } else if (strcmp(name, "end") == 0 && --depth == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool scenario_builtin(int argc, char **argv, char *error, bool *handled)
+{
+    *handled = true;
+    long pin, level, edges;
+    int64_t time_us;
+    if (strcmp(argv[0], "wait") == 0 && argc == 2 && scenario_parse_time(argv[1], &time_us)) {
+        sim_advance(time_us);
+    } else if (strcmp(argv[0], "gpio") == 0 && argc == 3 && scenario_parse_int(argv[1], &pin) && scenario_parse_int(argv[2], &level)) {
+        sim_gpio_set(pin, level);
+        sim_run_tasks();
+    } else if (strcmp(argv[0], "bounce") == 0 && argc == 5 && scenario_parse_int(argv[1], &pin) &&
+               scenario_parse_int(argv[2], &level) && scenario_parse_int(argv[3], &edges) && scenario_parse_time(argv[4], &time_us)) {
+        /* an odd number of edges from the opposite level ends on the requested one */
+        for (long edge = 0; edge < edges; edge++) {
+            sim_gpio_set(pin, (edges - edge) % 2 ? level : !level);
+            sim_run_tasks();
+            sim_advance(time_us);
+        }
+    } else if (strcmp(argv[0], "wait") == 0 || strcmp(argv[0], "gpio") == 0 || strcmp(argv[0], "bounce") == 0) {
+        snprintf(error, SCENARIO_ERROR_SIZE, "usage: wait <time> | gpio <pin> <level> | bounce <pin> <level> <edges> <time>");
+        return false;
+    } else {
+        *handled = false;
+    }
+    return true;
+}
+
+static bool scenario_command(scenario_t *scenario, const scenario_line_t *line, char *error)
+{
+    bool handled;
+    bool ok = scenario_builtin(line->argc, (char **)line->argv, error, &handled);
+    if (handled) {
+        return ok;
+    }
+    /* "expect <what>" is one command name */
+    int skip = strcmp(line->argv[0], "expect") == 0 && line->argc > 1 ? 2 : 1;
+    char name[64];
+    snprintf(name, sizeof(name), skip == 2 ? "%s %s" : "%s", line->argv[0], line->argv[1]);
+    for (size_t i = 0; i < scenario->fixture->command_count; i++) {
+        const scenario_command_t *command = &scenario->fixture->commands[i];
+        if (strcmp(command->name, name) != 0) {
+            continue;
+        }
+        if (line->argc - skip < command->min_args) {
+            snprintf(error, SCENARIO_ERROR_SIZE, "usage: %s %s", command->name, command->usage);
+            return false;
+        }
+        ok = command->run(line->argc - skip, (char **)line->argv + skip, error);
+        sim_run_tasks();
+        return ok;
+    }
+    snprintf(error, SCENARIO_ERROR_SIZE, "unknown command \"%s\"", name);
+    return false;
+}
+
+static bool scenario_run_lines(scenario_t *scenario, int first, int end)
+{
+    for (int i = first; i < end; i++) {
+        const scenario_line_t *line = &scenario->lines[i];
+        char error[SCENARIO_ERROR_SIZE] = "";
+        if (strcmp(line->argv[0], "repeat") == 0) {
+            long count;
+            int block_end = scenario_block_end(scenario, i);
+            if (line->argc != 2 || !scenario_parse_int(line->argv[1], &count) || block_end < 0) {
+                fprintf(stderr, "%s:%d: usage: repeat <count> ... end\n", scenario->path, line->number);
+                return false;
+            }
+            for (long round = 0; round < count; round++) {
+                if (!scenario_run_lines(scenario, i + 1, block_end)) {
+                    fprintf(stderr, "%s:%d: in round %ld of %ld\n", scenario->path, line->number, round + 1, count);
+                    return false;
+                }
+            }
+            i = block_end;
+            continue;
+        }
+        if (strcmp(line->argv[0], "end") == 0) {
+            fprintf(stderr, "%s:%d: end without repeat\n", scenario->path, line->number);
+            return false;
+        }
+        scenario->commands_run++;
+        if (!scenario_command(scenario, line, error)) {
+            fprintf(stderr, "%s:%d: %s\n", scenario->path, line->number, error);
+            return false;
+        }
+    }
+    return true;
+}
+
+int scenario_run(const char *path, const scenario_fixture_t *fixture)
+{
+    static scenario_t scenario;
+    memset(&scenario, 0, sizeof(scenario));
+    scenario.path = path;
+    scenario.fixture = fixture;
+    if (!scenario_load(&scenario, path)) {
+        return 1;
+    }
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fixture->setup();
+    sim_run_tasks();
+    bool ok = scenario_run_lines(&scenario, 0, scenario.count);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double wall_s = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s: %s, %" PRIu64 " commands, %" PRIu64 " events, %.3f s simulated in %.3f s\n", path, ok ? "passed" : "FAILED",
+           scenario.commands_run, sim_event_count(), sim_now_us() / 1e6, wall_s);
+    return ok ? 0 : 1;
+}
+
+int scenario_main(int argc, char **argv, const scenario_fixture_t *fixture)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <script.scn>\n", argv[0]);
+        return 2;
+    }
+    return scenario_run(argv[1], fixture);
+}
@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Runner of scenario scripts against the host simulation.
+ *
+ * A script has one command per line, '#' starts a comment. The runner knows the
+ * commands that only drive the simulation:
+ *
+ *     wait <time>                          move the clock, e.g. "wait 20ms", "wait 1s", "wait 300us"
+ *     gpio <pin> <level>                   set the level read on a pin
+ *     bounce <pin> <level> <edges> <time>  toggle a pin every <time>, <edges> times, ending on <level>
+ *     repeat <count> ... end               run the enclosed lines <count> times, blocks nest
+ *
+ * The fixture linked with the runner adds its own commands, the expectations
+ * among them written "expect <what> ...". The first command that fails stops the
+ * script with its line.
+ *
+ * The firmware modules keep their state in statics, so a process runs a single
+ * script, from a fresh boot of the fixture.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCENARIO_MAX_ARGS       12
+#define SCENARIO_ERROR_SIZE     160
+
+/**
+ * @brief Run a command of the fixture
+ *
+ * @param argc   Number of arguments, the command name excluded
+ * @param argv   The arguments
+ * @param error  Where to explain a failure, SCENARIO_ERROR_SIZE bytes
+ * @return false if the command failed or its expectation is not met
+ */
+typedef bool (*scenario_command_run_t)(int argc, char **argv, char *error);
+
+typedef struct {
+    const char *name;               /*!< e.g. "write" or "expect led" */
+    int min_args;
+    scenario_command_run_t run;
+    const char *usage;
+} scenario_command_t;
+
+/** The fixture: its commands and how to bring it up before a script */
+typedef struct {
+    const scenario_command_t *commands;
+    size_t command_count;
+    void (*setup)(void);
+} scenario_fixture_t;
+
+/**
+ * @brief Parse a time, a number followed by "us", "ms" or "s", into microseconds
+ */
+bool scenario_parse_time(const char *text, int64_t *time_us);
+
+/**
+ * @brief Parse an integer, decimal or 0x-prefixed hexadecimal
+ */
+bool scenario_parse_int(const char *text, long *value);
+
+/**
+ * @brief Run one script against a fixture
+ *
+ * @param path     The script
+ * @param fixture  The fixture, set up once before the script
+ * @return 0 if every command succeeded
+ */
+int scenario_run(const char *path, const scenario_fixture_t *fixture);
+
+/**
+ * @brief Entry point of a scenario executable: runs the script given on the command line
+ */
+int scenario_main(int argc, char **argv, const scenario_fixture_t *fixture);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the ESP-IDF placement attributes, everything is in RAM
+ */
+
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,10 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for esp_bit_defs
+ */
+
+#pragma once
+
+#define BIT(nr)     (1UL << (nr))
+#define BIT64(nr)   (1ULL << (nr))
@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for esp_system: a restart is only counted, see sim_ota()
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_restart(void);
+
+#ifdef __cplusplus
+}
+#endif
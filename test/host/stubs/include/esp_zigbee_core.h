@@ -0,0 +1,468 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the part of esp-zigbee-lib used by the light and switch
+ * paths, the scenes, the commissioning and the heater link: the scheduler, the
+ * attribute store, the reporting information, the scene table, the APS data
+ * request, the On/Off command, the binding table and the endpoint, cluster and
+ * attribute lists the device is built from. The names and layouts follow esp-zigbee-lib 1.6 for the
+ * fields the application reads, the rest is left out.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ZB_AF_HA_PROFILE_ID                         0x0104
+#define ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID                0x0100
+#define ESP_ZB_HA_THERMOSTAT_DEVICE_ID                  0x0301
+#define ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID          0x0302
+#define ESP_ZB_HA_CUSTOM_ATTR_DEVICE_ID                 0xFFF0
+#define ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC       0xFFFF
+
+#define ESP_ZB_ZCL_CLUSTER_ID_BASIC                     0x0000
+#define ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY                  0x0003
+#define ESP_ZB_ZCL_CLUSTER_ID_GROUPS                    0x0004
+#define ESP_ZB_ZCL_CLUSTER_ID_SCENES                    0x0005
+#define ESP_ZB_ZCL_CLUSTER_ID_ON_OFF                    0x0006
+#define ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL             0x0008
+#define ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT              0x000F
+#define ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE               0x0019
+#define ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT                0x0201
+#define ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL             0x0300
+#define ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT          0x0402
+#define ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS               0x0B05
+
+#define ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY                0x01
+
+#define ESP_ZB_ZCL_ATTR_BASIC_ZCL_VERSION_ID                    0x0000
+#define ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID              0x0004
+#define ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID               0x0005
+#define ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID                   0x0007
+#define ESP_ZB_ZCL_ATTR_IDENTIFY_IDENTIFY_TIME_ID               0x0000
+#define ESP_ZB_ZCL_ATTR_GROUPS_NAME_SUPPORT_ID                  0x0000
+#define ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID                        0x0000
+#define ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID          0x0000
+#define ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID 0x0010
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID              0x0003
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID              0x0004
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID             0x0008
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_OPTIONS_ID                0x000F
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_COLOR_MODE_ID    0x4001
+#define ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID     0x400A
+#define ESP_ZB_ZCL_ATTR_BINARY_INPUT_DESCRIPTION_ID             0x001C
+#define ESP_ZB_ZCL_ATTR_BINARY_INPUT_OUT_OF_SERVICE_ID          0x0051
+#define ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID           0x0055
+#define ESP_ZB_ZCL_ATTR_BINARY_INPUT_STATUS_FLAGS_ID            0x006F
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID             0x0002
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID              0x0007
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID               0x0008
+#define ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID              0xFFF3
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID         0x0000
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID                 0x0002
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID         0x0008
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID 0x0012
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID 0x0014
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_CONTROL_SEQUENCE_OF_OPERATION_ID 0x001B
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID               0x001C
+#define ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID  0x0029
+#define ESP_ZB_ZCL_ATTR_SCENES_SCENE_COUNT_ID                   0x0000
+#define ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID                 0x0001
+#define ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID                 0x0002
+#define ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID                   0x0003
+#define ESP_ZB_ZCL_ATTR_SCENES_NAME_SUPPORT_ID                  0x0004
+#define ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID               0x0000
+#define ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID           0x0001
+#define ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID           0x0002
+
+#define ESP_ZB_ZCL_BASIC_ZCL_VERSION_DEFAULT_VALUE              0x08
+#define ESP_ZB_ZCL_BASIC_POWER_SOURCE_DEFAULT_VALUE             0x00
+#define ESP_ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE         0x0000
+#define ESP_ZB_ZCL_ON_OFF_ON_OFF_DEFAULT_VALUE                  false
+#define ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE    0xFF
+#define ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_X_DEF_VALUE            0x616B
+#define ESP_ZB_ZCL_COLOR_CONTROL_CURRENT_Y_DEF_VALUE            0x607D
+#define ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF                   0x00
+#define ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT                  0x04
+#define ESP_ZB_ZCL_THERMOSTAT_CONTROL_SEQ_OF_OPERATION_HEATING_ONLY 0x02
+#define ESP_ZB_ZCL_BINARY_INPUT_OUT_OF_SERVICE_DEFAULT_VALUE    false
+#define ESP_ZB_ZCL_BINARY_INPUT_STATUS_FLAG_DEFAULT_VALUE       0x00
+#define ESP_ZB_ZCL_OTA_UPGRADE_QUERY_TIMER_COUNT_DEF            (24 * 60)
+
+typedef enum {
+    ESP_ZB_ZCL_CLUSTER_SERVER_ROLE = 0x01,
+    ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE = 0x02,
+} esp_zb_zcl_cluster_role_t;
+
+typedef enum {
+    ESP_ZB_ZCL_ATTR_TYPE_NULL = 0x00,
+    ESP_ZB_ZCL_ATTR_TYPE_8BIT = 0x08,
+    ESP_ZB_ZCL_ATTR_TYPE_16BIT = 0x09,
+    ESP_ZB_ZCL_ATTR_TYPE_32BIT = 0x0B,
+    ESP_ZB_ZCL_ATTR_TYPE_BOOL = 0x10,
+    ESP_ZB_ZCL_ATTR_TYPE_8BITMAP = 0x18,
+    ESP_ZB_ZCL_ATTR_TYPE_16BITMAP = 0x19,
+    ESP_ZB_ZCL_ATTR_TYPE_32BITMAP = 0x1B,
+    ESP_ZB_ZCL_ATTR_TYPE_U8 = 0x20,
+    ESP_ZB_ZCL_ATTR_TYPE_U16 = 0x21,
+    ESP_ZB_ZCL_ATTR_TYPE_U32 = 0x23,
+    ESP_ZB_ZCL_ATTR_TYPE_S8 = 0x28,
+    ESP_ZB_ZCL_ATTR_TYPE_S16 = 0x29,
+    ESP_ZB_ZCL_ATTR_TYPE_S32 = 0x2B,
+    ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM = 0x30,
+    ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM = 0x31,
+    ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING = 0x41,
+    ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING = 0x42,
+} esp_zb_zcl_attr_type_t;
+
+typedef enum {
+    ESP_ZB_ZCL_STATUS_SUCCESS = 0x00,
+    ESP_ZB_ZCL_STATUS_FAIL = 0x01,
+    ESP_ZB_ZCL_STATUS_INVALID_VALUE = 0x87,
+} esp_zb_zcl_status_t;
+
+typedef enum {
+    ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT = 0x00,
+    ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT = 0x01,
+    ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT = 0x02,
+    ESP_ZB_APS_ADDR_MODE_64_ENDP_PRESENT = 0x03,
+} esp_zb_aps_address_mode_t;
+
+typedef enum {
+    ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID = 0x00,
+    ESP_ZB_ZCL_CMD_ON_OFF_ON_ID = 0x01,
+} esp_zb_zcl_on_off_cmd_id_t;
+
+typedef enum {
+    ESP_ZB_ZDP_STATUS_SUCCESS = 0x00,
+    ESP_ZB_ZDP_STATUS_NOT_SUPPORTED = 0x84,
+} esp_zb_zdp_status_t;
+
+typedef enum {
+    ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP = 0x01,
+    ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED = 0x03,
+} esp_zb_zdo_bind_dst_addr_mode_t;
+
+typedef uint8_t esp_zb_ieee_addr_t[8];
+
+typedef union {
+    uint16_t addr_short;
+    esp_zb_ieee_addr_t addr_long;
+} esp_zb_addr_u;
+
+#define ESP_ZB_APSDE_TX_OPT_SECURITY_ENABLED    0x01
+#define ESP_ZB_APSDE_TX_OPT_ACK_TX              0x04
+
+typedef enum {
+    ESP_ZB_CORE_SET_ATTR_VALUE_CB_ID = 0x0000,
+    ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID = 0x0004,
+    ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID = 0x1005,
+} esp_zb_core_action_callback_id_t;
+
+typedef esp_err_t (*esp_zb_core_action_callback_t)(esp_zb_core_action_callback_id_t callback_id, const void *message);
+
+typedef enum {
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START = 0x0000,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY = 0x0001,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE = 0x0002,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH = 0x0003,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ABORT = 0x0004,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK = 0x0005,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_OK = 0x0006,
+    ESP_ZB_ZCL_OTA_UPGRADE_STATUS_ERROR = 0x0007,
+} esp_zb_zcl_ota_upgrade_status_t;
+
+typedef void (*esp_zb_callback_t)(uint8_t param);
+
+typedef struct esp_zb_endpoint_config_s {
+    uint8_t endpoint;
+    uint16_t app_profile_id;
+    uint16_t app_device_id;
+    uint32_t app_device_version;
+} esp_zb_endpoint_config_t;
+
+typedef struct esp_zb_zcl_attr_s {
+    uint16_t id;
+    uint8_t type;
+    uint8_t access;
+    uint16_t manuf_code;
+    void *data_p;
+} esp_zb_zcl_attr_t;
+
+/* The lists the device is described with, each one headed by an empty node as in the stack */
+typedef struct esp_zb_attribute_list_s {
+    esp_zb_zcl_attr_t attribute;
+    uint16_t cluster_id;
+    struct esp_zb_attribute_list_s *next;
+} esp_zb_attribute_list_t;
+
+typedef struct esp_zb_zcl_cluster_s {
+    uint16_t cluster_id;
+    uint16_t attr_count;
+    esp_zb_attribute_list_t *attr_list;
+    uint8_t role_mask;
+    uint16_t manuf_code;
+} esp_zb_zcl_cluster_t;
+
+typedef struct esp_zb_cluster_list_s {
+    esp_zb_zcl_cluster_t cluster;
+    struct esp_zb_cluster_list_s *next;
+} esp_zb_cluster_list_t;
+
+typedef struct esp_zb_ep_list_s {
+    esp_zb_endpoint_config_t config;
+    esp_zb_cluster_list_t *cluster_list;
+    struct esp_zb_ep_list_s *next;
+} esp_zb_ep_list_t;
+
+typedef struct esp_zb_zcl_ota_upgrade_client_variable_s {
+    uint16_t timer_query;
+    uint16_t hw_version;
+    uint8_t max_data_size;
+} esp_zb_zcl_ota_upgrade_client_variable_t;
+
+typedef struct esp_zb_zcl_attr_location_info_s {
+    uint8_t endpoint_id;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t manuf_code;
+    uint16_t attr_id;
+} esp_zb_zcl_attr_location_info_t;
+
+typedef struct esp_zb_zcl_reporting_info_s {
+    uint8_t direction;
+    uint8_t ep;
+    uint16_t cluster_id;
+    uint8_t cluster_role;
+    uint16_t attr_id;
+    union {
+        struct {
+            uint16_t min_interval;
+            uint16_t max_interval;
+        } send_info;
+    } u;
+    uint16_t manuf_code;
+} esp_zb_zcl_reporting_info_t;
+
+typedef struct esp_zb_apsde_data_req_s {
+    union {
+        uint16_t addr_short;
+        uint8_t addr_long[8];
+    } dst_addr;
+    uint8_t dst_endpoint;
+    uint16_t profile_id;
+    uint16_t cluster_id;
+    uint8_t src_endpoint;
+    uint32_t asdu_length;
+    uint8_t *asdu;
+    uint8_t tx_options;
+    uint8_t radius;
+    esp_zb_aps_address_mode_t dst_addr_mode;
+} esp_zb_apsde_data_req_t;
+
+typedef struct esp_zb_device_cb_common_info_s {
+    esp_zb_zcl_status_t status;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+} esp_zb_device_cb_common_info_t;
+
+typedef struct esp_zb_zcl_attribute_data_s {
+    esp_zb_zcl_attr_type_t type;
+    uint16_t size;
+    void *value;
+} esp_zb_zcl_attribute_data_t;
+
+typedef struct esp_zb_zcl_attribute_s {
+    uint16_t id;
+    esp_zb_zcl_attribute_data_t data;
+} esp_zb_zcl_attribute_t;
+
+typedef struct esp_zb_zcl_set_attr_value_message_s {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_attribute_t attribute;
+} esp_zb_zcl_set_attr_value_message_t;
+
+typedef struct esp_zb_zcl_frame_header_s {
+    uint8_t fc;
+    uint16_t manuf_code;
+    uint8_t tsn;
+    int8_t rssi;
+} esp_zb_zcl_frame_header_t;
+
+typedef struct esp_zb_zcl_addr_s {
+    uint8_t addr_type;
+    union {
+        uint16_t short_addr;
+        uint8_t ieee_addr[8];
+    } u;
+} esp_zb_zcl_addr_t;
+
+typedef struct esp_zb_zcl_cmd_info_s {
+    esp_zb_zcl_status_t status;
+    esp_zb_zcl_frame_header_t header;
+    esp_zb_zcl_addr_t src_address;
+    uint16_t dst_address;
+    uint8_t src_endpoint;
+    uint8_t dst_endpoint;
+    uint16_t cluster;
+    uint16_t profile;
+} esp_zb_zcl_cmd_info_t;
+
+typedef struct esp_zb_zcl_cmd_default_resp_message_s {
+    esp_zb_zcl_cmd_info_t info;
+    uint8_t resp_to_cmd;
+    esp_zb_zcl_status_t status_code;
+} esp_zb_zcl_cmd_default_resp_message_t;
+
+typedef enum {
+    ESP_ZB_BDB_MODE_INITIALIZATION = 0,
+    ESP_ZB_BDB_MODE_NETWORK_STEERING = 2,
+} esp_zb_bdb_commissioning_mode_mask_t;
+
+typedef struct esp_zb_zcl_scenes_extension_field_s {
+    uint16_t cluster_id;
+    uint8_t length;
+    uint8_t *extension_field_attribute_value_list;
+    struct esp_zb_zcl_scenes_extension_field_s *next;
+} esp_zb_zcl_scenes_extension_field_t;
+
+typedef struct esp_zb_zcl_ota_upgrade_file_header_s {
+    uint16_t manufacturer_code;
+    uint16_t image_type;
+    uint32_t file_version;
+    uint32_t image_size;        /*!< Size of the whole file, OTA header included */
+} esp_zb_zcl_ota_upgrade_file_header_t;
+
+typedef struct esp_zb_zcl_ota_upgrade_value_message_s {
+    esp_zb_device_cb_common_info_t info;
+    esp_zb_zcl_ota_upgrade_status_t upgrade_status;
+    esp_zb_zcl_ota_upgrade_file_header_t ota_header;
+    uint16_t payload_size;
+    uint8_t *payload;
+} esp_zb_zcl_ota_upgrade_value_message_t;
+
+typedef struct esp_zb_zcl_store_scene_message_s {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+} esp_zb_zcl_store_scene_message_t;
+
+typedef struct esp_zb_zcl_recall_scene_message_s {
+    esp_zb_device_cb_common_info_t info;
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint16_t transition_time;
+    esp_zb_zcl_scenes_extension_field_t *field_set;
+} esp_zb_zcl_recall_scene_message_t;
+
+typedef struct esp_zb_zcl_basic_cmd_s {
+    esp_zb_addr_u dst_addr_u;
+    uint8_t dst_endpoint;
+    uint8_t src_endpoint;
+} esp_zb_zcl_basic_cmd_t;
+
+typedef struct esp_zb_zcl_on_off_cmd_s {
+    esp_zb_zcl_basic_cmd_t zcl_basic_cmd;
+    esp_zb_aps_address_mode_t address_mode;
+    uint8_t on_off_cmd_id;
+} esp_zb_zcl_on_off_cmd_t;
+
+typedef struct esp_zb_zdo_binding_table_record_s {
+    esp_zb_ieee_addr_t src_address;
+    uint8_t src_endp;
+    uint16_t cluster_id;
+    uint8_t dst_addr_mode;
+    esp_zb_addr_u dst_address;
+    uint8_t dst_endp;
+    struct esp_zb_zdo_binding_table_record_s *next;
+} esp_zb_zdo_binding_table_record_t;
+
+typedef struct esp_zb_zdo_binding_table_info_s {
+    uint8_t status;
+    uint8_t index;
+    uint8_t total;
+    uint8_t count;
+    esp_zb_zdo_binding_table_record_t *record;
+} esp_zb_zdo_binding_table_info_t;
+
+typedef void (*esp_zb_zdo_binding_table_callback_t)(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx);
+
+typedef struct esp_zb_zdo_mgmt_bind_param_s {
+    uint8_t start_index;
+    uint16_t dst_addr;
+} esp_zb_zdo_mgmt_bind_param_t;
+
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb);
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time);
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param);
+bool esp_zb_lock_acquire(uint32_t block_ticks);
+void esp_zb_lock_release(void);
+
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id);
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id,
+                                                 void *value_p, bool check);
+esp_zb_zcl_reporting_info_t *esp_zb_zcl_find_reporting_info(esp_zb_zcl_attr_location_info_t attr_info);
+esp_err_t esp_zb_zcl_stop_attr_reporting(esp_zb_zcl_attr_location_info_t attr_info);
+esp_err_t esp_zb_aps_data_request(esp_zb_apsde_data_req_t *req);
+
+esp_err_t esp_zb_zcl_scenes_table_store(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, uint16_t transition_time,
+                                        esp_zb_zcl_scenes_extension_field_t *field);
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask);
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask);
+uint8_t esp_zb_get_current_channel(void);
+uint16_t esp_zb_get_pan_id(void);
+uint16_t esp_zb_get_short_address(void);
+uint16_t esp_zb_address_short_by_ieee(esp_zb_ieee_addr_t address);
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void);
+esp_zb_cluster_list_t *esp_zb_zcl_cluster_list_create(void);
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id);
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config);
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id);
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id, uint8_t role_mask);
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access,
+                                                void *value_p);
+
+esp_err_t esp_zb_basic_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_identify_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_groups_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_scenes_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_on_off_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_level_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_color_control_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_binary_input_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_ota_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_thermostat_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+esp_err_t esp_zb_temperature_meas_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p);
+
+esp_err_t esp_zb_cluster_list_add_basic_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_identify_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_groups_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_scenes_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_on_off_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_level_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_color_control_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                        uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_binary_input_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                       uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_ota_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_thermostat_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                     uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_temperature_meas_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                           uint8_t role_mask);
+esp_err_t esp_zb_cluster_list_add_diagnostics_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                                      uint8_t role_mask);
+
+uint8_t esp_zb_zcl_on_off_cmd_req(esp_zb_zcl_on_off_cmd_t *cmd_req);
+void esp_zb_zdo_binding_table_req(esp_zb_zdo_mgmt_bind_param_t *cmd_req, esp_zb_zdo_binding_table_callback_t user_cb, void *user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the FreeRTOS queues. A task waits for an item until one is
+ * sent; the simulation lets the tasks run when it sends to a full queue.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_queue *QueueHandle_t;
+
+typedef struct {
+    int unused;
+} StaticQueue_t;
+
+#define errQUEUE_FULL   ((BaseType_t)0)
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *queue_buffer);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
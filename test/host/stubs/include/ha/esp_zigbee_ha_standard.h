@@ -0,0 +1,9 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the Home Automation definitions, they are all in esp_zigbee_core.h
+ */
+
+#pragma once
+
+#include "esp_zigbee_core.h"
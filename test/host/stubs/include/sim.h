@@ -0,0 +1,377 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Control of the host simulation behind the stand-ins: the clock, the tasks,
+ * the GPIO levels, the LED strip, NVS, the OTA partitions and the Zigbee stack.
+ *
+ * Time only moves in sim_advance(), which fires the due esp_timer callbacks and
+ * Zigbee scheduler alarms in deadline order and lets the tasks they wake run
+ * until they wait again. Everything is deterministic, a run does not depend on
+ * the speed of the host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_ota_ops.h"
+#include "esp_zigbee_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_LED_STRIP_MAX_LEDS      16
+#define SIM_LED_STRIP_MAX_FRAMES    256
+#define SIM_ZB_MAX_ATTRS            32
+#define SIM_ZB_MAX_FRAMES           64
+#define SIM_ZB_FRAME_SIZE           128
+#define SIM_NVS_MAX_VALUE_SIZE      256
+#define SIM_ZB_MAX_SCENES           16
+#define SIM_ZB_SCENE_DATA_SIZE      16
+
+/* Flash timings of the OTA partitions, typical values of the SPI NOR flash of the modules */
+#define SIM_OTA_SECTOR_SIZE         4096
+#define SIM_OTA_PAGE_SIZE           256
+#define SIM_OTA_SECTOR_ERASE_US     45000
+#define SIM_OTA_PAGE_PROGRAM_US     700
+
+/* Air time of the OTA exchanges: 250 kbit/s, the MAC, NWK and APS headers with security and the MAC
+   acknowledgement of each frame, longer ZCL payloads are sent in APS fragments; the server answers a
+   request after SIM_ZB_OTA_SERVER_US */
+#define SIM_ZB_BYTE_US              32
+#define SIM_ZB_FRAME_OVERHEAD       50
+#define SIM_ZB_FRAME_PAYLOAD        82
+#define SIM_ZB_FRAME_ACK_US         1000
+#define SIM_ZB_OTA_SERVER_US        20000
+
+/* Other devices on the network: each hop of a frame through the mesh waits for the CSMA-CA backoff of
+   the MAC, then takes its air time and acknowledgement; a device answers a command after SIM_ZB_DEVICE_US */
+#define SIM_ZB_MAX_DEVICES          4
+#define SIM_ZB_MAX_BINDINGS         8
+#define SIM_ZB_MAX_COMMANDS         8
+#define SIM_ZB_CSMA_US              2500
+#define SIM_ZB_DEVICE_US            2000
+
+/**
+ * @brief Get the simulated time
+ */
+int64_t sim_now_us(void);
+
+/**
+ * @brief Move the clock forward, firing the timers and alarms that fall due on the way
+ *
+ * @param delay_us  Time to move by
+ */
+void sim_advance(int64_t delay_us);
+
+/**
+ * @brief Let the tasks that are ready run until they all wait, done by sim_advance() after each event
+ */
+void sim_run_tasks(void);
+
+/**
+ * @brief Get the number of timer callbacks and alarms fired so far
+ */
+uint64_t sim_event_count(void);
+
+/**
+ * @brief Also write the ESP_LOGx output to a file, in the format of the serial monitor, whatever SIM_LOG says
+ *
+ * @param file  Destination, NULL to stop
+ */
+void sim_log_to(FILE *file);
+
+/**
+ * @brief Set the level read on a pin, its interrupt handler runs at once if it is armed for that level
+ *
+ * @param pin    The pin
+ * @param level  0 or 1
+ */
+void sim_gpio_set(gpio_num_t pin, int level);
+
+/** LED strip as last sent */
+typedef struct {
+    uint8_t pixels[SIM_LED_STRIP_MAX_LEDS][3];
+    uint32_t refreshes;     /*!< Frames sent */
+    uint32_t created;       /*!< Calls to led_strip_new_rmt_device() */
+    uint32_t deleted;       /*!< Calls to led_strip_del() */
+} sim_led_strip_t;
+
+/** Frame sent to the LED strip */
+typedef struct {
+    int64_t time_us;
+    uint8_t pixels[SIM_LED_STRIP_MAX_LEDS][3];
+} sim_led_strip_frame_t;
+
+/**
+ * @brief Get the LED strip
+ */
+const sim_led_strip_t *sim_led_strip_get(void);
+
+/**
+ * @brief Get the number of frames sent to the LED strip since the last sim_led_strip_frames_clear()
+ */
+size_t sim_led_strip_frame_count(void);
+
+/**
+ * @brief Get a frame sent to the LED strip, the first SIM_LED_STRIP_MAX_FRAMES frames are kept
+ */
+const sim_led_strip_frame_t *sim_led_strip_frame(size_t index);
+
+/**
+ * @brief Forget the frames sent to the LED strip so far
+ */
+void sim_led_strip_frames_clear(void);
+
+/**
+ * @brief Make the next calls that set an NVS value fail
+ *
+ * @param count  Number of calls to fail
+ * @param err    Error they return, e.g. ESP_ERR_NVS_NOT_ENOUGH_SPACE
+ */
+void sim_nvs_fail_writes(uint32_t count, esp_err_t err);
+
+/**
+ * @brief Make the next NVS commits fail
+ *
+ * @param count  Number of calls to fail
+ * @param err    Error they return
+ */
+void sim_nvs_fail_commits(uint32_t count, esp_err_t err);
+
+/**
+ * @brief Get the number of NVS values written so far
+ */
+uint32_t sim_nvs_write_count(void);
+
+/**
+ * @brief Get the number of flash pages erased by NVS so far, to make room for new values
+ */
+uint32_t sim_nvs_erase_count(void);
+
+/**
+ * @brief Get the number of erases of the most erased NVS page
+ */
+uint32_t sim_nvs_page_erase_max(void);
+
+/**
+ * @brief Get the number of entries in an NVS namespace
+ */
+size_t sim_nvs_entry_count(const char *namespace_name);
+
+/**
+ * @brief Add an attribute to the attribute store
+ *
+ * @param endpoint    Endpoint of the attribute
+ * @param cluster_id  Cluster of the attribute, server role
+ * @param attr_id     Attribute identifier
+ * @param type        ZCL data type, a fixed-size one
+ * @param value       Initial value
+ */
+esp_err_t sim_zb_attr_add(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, uint8_t type, const void *value);
+
+/**
+ * @brief Get the size of a value of a fixed-size ZCL data type, 0 for other types
+ */
+size_t sim_zb_attr_size(uint8_t type);
+
+/**
+ * @brief Configure the reporting of an attribute, as a Configure Reporting command would
+ */
+esp_err_t sim_zb_reporting_set(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, uint16_t min_interval, uint16_t max_interval);
+
+/**
+ * @brief Get the number of reports sent so far by the stack's own reporting
+ *
+ * The stack reports an attribute set while its reporting is configured, unless
+ * esp_zb_zcl_stop_attr_reporting() is called before the stack gets to run.
+ */
+uint32_t sim_zb_stack_report_count(void);
+
+/** APS frame sent by the application */
+typedef struct {
+    int64_t time_us;
+    uint8_t src_endpoint;
+    uint16_t cluster_id;
+    uint8_t dst_addr_mode;
+    uint32_t length;
+    uint8_t asdu[SIM_ZB_FRAME_SIZE];
+} sim_zb_frame_t;
+
+/**
+ * @brief Get the number of APS frames sent since the last sim_zb_frames_clear()
+ */
+size_t sim_zb_frame_count(void);
+
+/**
+ * @brief Get an APS frame, the first SIM_ZB_MAX_FRAMES frames are kept
+ */
+const sim_zb_frame_t *sim_zb_frame(size_t index);
+
+/**
+ * @brief Forget the APS frames sent so far
+ */
+void sim_zb_frames_clear(void);
+
+/** Scene in the scene table of the stack */
+typedef struct {
+    uint8_t endpoint;
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint8_t data_length;    /*!< Extension field sets as sent in a View Scene response */
+    uint8_t data[SIM_ZB_SCENE_DATA_SIZE];
+} sim_zb_scene_t;
+
+/**
+ * @brief Get the number of scenes in the scene table of the stack
+ */
+size_t sim_zb_scene_count(void);
+
+/**
+ * @brief Look a scene up in the scene table of the stack, NULL if it is not there
+ */
+const sim_zb_scene_t *sim_zb_scene_find(uint8_t endpoint, uint16_t group_id, uint8_t scene_id);
+
+/**
+ * @brief Empty the scene table of the stack, as a reboot does unless the application restores it
+ */
+void sim_zb_scenes_clear(void);
+
+/** Network commissioning as seen by the stack */
+typedef struct {
+    uint32_t channel_mask;      /*!< Primary channel set */
+    uint32_t steerings;         /*!< Network steerings started */
+    int64_t last_steering_us;   /*!< Time of the last one */
+    uint8_t channel;            /*!< Channel of the network joined */
+    uint16_t pan_id;            /*!< PAN ID of the network joined */
+    uint16_t short_addr;        /*!< Network address of the device */
+    uint8_t coordinator_hops;   /*!< Hops from the device to the coordinator */
+} sim_zb_network_t;
+
+/** Other device on the network, an On/Off server such as the smart plug of a heater */
+typedef struct {
+    uint16_t short_addr;
+    uint8_t ieee_addr[8];
+    uint8_t endpoint;
+    uint8_t hops;               /*!< Hops from this device */
+    uint8_t coordinator_hops;   /*!< Hops from the coordinator */
+    uint32_t lose;              /*!< Number of the next commands to it lost on the way */
+    bool on;
+    int64_t changed_us;         /*!< Time its On/Off state last changed */
+    uint32_t commands;          /*!< On/Off commands received */
+} sim_zb_device_t;
+
+/**
+ * @brief Add a device to the network, one hop from this device and from the coordinator, off
+ *
+ * @param short_addr  Its network address
+ * @param ieee_addr   Its IEEE address
+ * @param endpoint    Endpoint of its On/Off server
+ * @return The device, the test may change its hops and make it lose commands; NULL if there are too many
+ */
+sim_zb_device_t *sim_zb_device_add(uint16_t short_addr, const uint8_t ieee_addr[8], uint8_t endpoint);
+
+/**
+ * @brief Add an entry to the binding table of this device, as a Bind Request from the coordinator would
+ *
+ * On/Off commands sent through the binding table go to the devices bound to their source endpoint and
+ * cluster, each answers with a Default Response to the action handler, ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID.
+ *
+ * @param src_endpoint  Local endpoint
+ * @param cluster_id    Cluster, client role
+ * @param device        Device bound, its On/Off endpoint
+ */
+esp_err_t sim_zb_bind(uint8_t src_endpoint, uint16_t cluster_id, const sim_zb_device_t *device);
+
+/**
+ * @brief Have the coordinator act on a report, as a home automation server does: the report reaches the
+ *        coordinator, the server decides after automation_us, then the coordinator sends On or Off to the device
+ *
+ * @param report         The report sent by this device
+ * @param device         Device the automation switches
+ * @param on             State the automation sets
+ * @param automation_us  Time from the report at the coordinator to the command leaving it
+ */
+void sim_zb_coordinator_on_off(const sim_zb_frame_t *report, sim_zb_device_t *device, bool on, int64_t automation_us);
+
+typedef struct {
+    uint16_t block_size;        /*!< Largest block sent */
+    uint32_t blocks;            /*!< Image Block Responses sent */
+    int64_t start_us;
+    int64_t check_us;           /*!< Time the client was asked to check the image */
+    esp_err_t result;           /*!< Error returned by the client, ESP_OK once the upgrade finished */
+    bool done;
+} sim_zb_ota_t;
+
+/**
+ * @brief Serve an OTA file to the client, as the stack does once the server answered Query Next Image
+ *
+ * The action handler is called with ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID messages: START with the OTA
+ * header, then RECEIVE with the file after the header, one block per request and response exchange,
+ * then APPLY, CHECK and FINISH. An error returned by the client ends the download.
+ *
+ * @param file        The whole OTA file, it must stay valid until the download is done
+ * @param size        Its size
+ * @param block_size  Largest block, the Maximum Data Size of the Image Block Request
+ */
+void sim_zb_ota_serve(const uint8_t *file, uint32_t size, uint16_t block_size);
+
+/**
+ * @brief Get the progress of the download served
+ */
+const sim_zb_ota_t *sim_zb_ota(void);
+
+/**
+ * @brief Get the network commissioning, the test sets the network joined before the steering signal
+ */
+sim_zb_network_t *sim_zb_network(void);
+
+typedef struct {
+    uint32_t allocations;       /*!< Blocks allocated for the endpoint, cluster and attribute lists */
+    uint32_t bytes;             /*!< Bytes in them, list nodes and attribute values */
+    uint32_t live;              /*!< Blocks not freed yet */
+} sim_zb_list_heap_t;
+
+/**
+ * @brief Get the heap taken by the endpoint, cluster and attribute lists
+ *
+ * The lists are allocated as the stack does: one block per list node and one per attribute value.
+ */
+const sim_zb_list_heap_t *sim_zb_list_heap(void);
+
+/**
+ * @brief Free an endpoint list and everything in it, esp_zb_device_register() keeps it for good
+ */
+void sim_zb_ep_list_free(esp_zb_ep_list_t *ep_list);
+
+typedef struct {
+    uint32_t writes;                /*!< esp_ota_write() calls of the current image */
+    uint32_t written;               /*!< Bytes written to the update partition */
+    uint32_t sectors_erased;
+    int64_t flash_busy_us;          /*!< Time the flash spent erasing and programming */
+    int64_t flash_done_us;          /*!< Time the last write is done, the writes queue up behind each other */
+    int64_t lag_max_us;             /*!< Longest time from a write issued to the flash done with it */
+    bool ended;                     /*!< esp_ota_end() accepted the image */
+    const esp_partition_t *boot;    /*!< Partition booted after a restart */
+    esp_ota_img_states_t running_state;
+    uint32_t restarts;              /*!< Calls to esp_restart() */
+} sim_ota_t;
+
+/**
+ * @brief Get the OTA partitions, the test may set the state of the running image
+ */
+sim_ota_t *sim_ota(void);
+
+/**
+ * @brief Get the content of the update partition
+ */
+const uint8_t *sim_ota_partition_data(void);
+
+#ifdef __cplusplus
+}
+#endif
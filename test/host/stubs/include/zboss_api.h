@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the parts of the ZBOSS API used next to the esp-zigbee-lib one
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t zb_zcl_get_next_seq_number(void);
+
+#define ZB_ZCL_GET_SEQ_NUM() zb_zcl_get_next_seq_number()
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,206 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for esp_timer, the Zigbee scheduler alarms and the CPU cycle
+ * counter, all driven by the simulated clock, and for esp_random
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_cpu.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_zigbee_core.h"
+#include "sim.h"
+
+#define SIM_TIMER_MAX   16
+#define SIM_ALARM_MAX   64
+
+struct sim_timer {
+    esp_timer_create_args_t args;
+    int64_t deadline_us;
+    int64_t period_us;
+    uint64_t order;     /* timers and alarms due at the same time fire in the order they were set */
+    bool active;
+};
+
+typedef struct {
+    esp_zb_callback_t cb;
+    uint8_t param;
+    int64_t deadline_us;
+    uint64_t order;
+    bool active;
+} sim_alarm_t;
+
+static int64_t s_now_us;
+static uint64_t s_order;
+static uint64_t s_events;
+static struct sim_timer s_timers[SIM_TIMER_MAX];
+static uint8_t s_timer_count;
+static sim_alarm_t s_alarms[SIM_ALARM_MAX];
+
+int64_t sim_now_us(void)
+{
+    return s_now_us;
+}
+
+uint64_t sim_event_count(void)
+{
+    return s_events;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)(s_now_us * SIM_CPU_MHZ);
+}
+
+uint32_t esp_random(void)
+{
+    /* xorshift32, seeded with a constant */
+    static uint32_t state = 0x2545F491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (s_timer_count == SIM_TIMER_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct sim_timer *timer = &s_timers[s_timer_count++];
+    timer->args = *create_args;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t sim_timer_start(esp_timer_handle_t timer, uint64_t delay_us, int64_t period_us)
+{
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = s_now_us + (int64_t)delay_us;
+    timer->period_us = period_us;
+    timer->order = s_order++;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return sim_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return sim_timer_start(timer, period, (int64_t)period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    timer->active = false;
+    timer->args.callback = NULL;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
+
+void esp_zb_scheduler_alarm(esp_zb_callback_t cb, uint8_t param, uint32_t time)
+{
+    for (int i = 0; i < SIM_ALARM_MAX; i++) {
+        sim_alarm_t *alarm = &s_alarms[i];
+        if (!alarm->active) {
+            *alarm = (sim_alarm_t) {
+                .cb = cb,
+                .param = param,
+                .deadline_us = s_now_us + (int64_t)time * 1000,
+                .order = s_order++,
+                .active = true,
+            };
+            return;
+        }
+    }
+    fprintf(stderr, "sim: more than %d scheduler alarms\n", SIM_ALARM_MAX);
+    abort();
+}
+
+void esp_zb_scheduler_alarm_cancel(esp_zb_callback_t cb, uint8_t param)
+{
+    for (int i = 0; i < SIM_ALARM_MAX; i++) {
+        if (s_alarms[i].active && s_alarms[i].cb == cb && s_alarms[i].param == param) {
+            s_alarms[i].active = false;
+        }
+    }
+}
+
+/* Fire the earliest timer or alarm due by end_us, false if there is none */
+static bool sim_fire_next(int64_t end_us)
+{
+    struct sim_timer *timer = NULL;
+    sim_alarm_t *alarm = NULL;
+    int64_t deadline_us = end_us;
+    uint64_t order = UINT64_MAX;
+    for (int i = 0; i < s_timer_count; i++) {
+        struct sim_timer *t = &s_timers[i];
+        if (t->active && (t->deadline_us < deadline_us || (t->deadline_us == deadline_us && t->order < order))) {
+            timer = t;
+            deadline_us = t->deadline_us;
+            order = t->order;
+        }
+    }
+    for (int i = 0; i < SIM_ALARM_MAX; i++) {
+        sim_alarm_t *a = &s_alarms[i];
+        if (a->active && (a->deadline_us < deadline_us || (a->deadline_us == deadline_us && a->order < order))) {
+            timer = NULL;
+            alarm = a;
+            deadline_us = a->deadline_us;
+            order = a->order;
+        }
+    }
+    if (!timer && !alarm) {
+        return false;
+    }
+    s_now_us = deadline_us;
+    s_events++;
+    if (timer) {
+        if (timer->period_us) {
+            timer->deadline_us += timer->period_us;
+            timer->order = s_order++;
+        } else {
+            timer->active = false;
+        }
+        timer->args.callback(timer->args.arg);
+    } else {
+        alarm->active = false;
+        alarm->cb(alarm->param);
+    }
+    sim_run_tasks();
+    return true;
+}
+
+void sim_advance(int64_t delay_us)
+{
+    int64_t end_us = s_now_us + delay_us;
+    sim_run_tasks();
+    while (sim_fire_next(end_us)) {
+    }
+    s_now_us = end_us;
+}
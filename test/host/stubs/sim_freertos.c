@@ -0,0 +1,379 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the FreeRTOS tasks, notifications, mutexes, semaphores and
+ * queues.
+ *
+ * Every task is a thread, but the hand is passed explicitly so that a single
+ * context runs at a time: the simulation, i.e. the timer callbacks, alarms and
+ * scenario steps, or one task. A task keeps the hand until it waits for a
+ * notification or a queue item that is not there yet. This is what a
+ * single-core FreeRTOS does with the tasks of this firmware, which only ever
+ * block on notifications and queues.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sim.h"
+
+#define SIM_TASK_MAX    8
+#define SIM_SEMAPHORE_MAX   16
+#define SIM_QUEUE_MAX       4
+
+struct sim_task {
+    pthread_t thread;
+    TaskFunction_t code;
+    void *parameters;
+    const char *name;
+    uint32_t stack_depth;
+    uint32_t notification;
+    bool pending;       /* a notification arrived since the last wait */
+    bool waiting;
+};
+
+struct sim_semaphore {
+    bool mutex;
+    TaskHandle_t owner;     /* mutex holder */
+    UBaseType_t count;      /* 0 while a mutex is taken */
+    UBaseType_t max_count;
+};
+
+struct sim_queue {
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    struct sim_task *receiver;  /* task waiting for an item */
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static struct sim_task s_tasks[SIM_TASK_MAX];
+static uint8_t s_task_count;
+/* context holding the hand, NULL for the simulation */
+static struct sim_task *s_running;
+static struct sim_semaphore s_semaphores[SIM_SEMAPHORE_MAX];
+static uint8_t s_semaphore_count;
+static struct sim_queue s_queues[SIM_QUEUE_MAX];
+static uint8_t s_queue_count;
+
+/* Give the hand to another context and wait until it comes back, called with s_lock held */
+static void sim_switch_to(struct sim_task *next, struct sim_task *self)
+{
+    s_running = next;
+    pthread_cond_broadcast(&s_cond);
+    while (s_running != self) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+}
+
+static void *sim_task_thread(void *arg)
+{
+    struct sim_task *task = arg;
+    pthread_mutex_lock(&s_lock);
+    while (s_running != task) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+    task->code(task->parameters);
+    fprintf(stderr, "sim: task %s returned\n", task->name);
+    abort();
+}
+
+void sim_run_tasks(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_running) {
+        /* called from a task, it keeps the hand until it waits */
+        pthread_mutex_unlock(&s_lock);
+        return;
+    }
+    for (bool ran = true; ran;) {
+        ran = false;
+        for (uint8_t i = 0; i < s_task_count; i++) {
+            struct sim_task *task = &s_tasks[i];
+            if (!task->waiting || task->pending) {
+                sim_switch_to(task, NULL);
+                ran = true;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *parameters,
+                               UBaseType_t priority, StackType_t *stack_buffer, StaticTask_t *task_buffer)
+{
+    if (s_task_count == SIM_TASK_MAX) {
+        return NULL;
+    }
+    struct sim_task *task = &s_tasks[s_task_count];
+    *task = (struct sim_task) {
+        .code = task_code,
+        .parameters = parameters,
+        .name = name,
+        .stack_depth = stack_depth,
+    };
+    if (pthread_create(&task->thread, NULL, sim_task_thread, task) != 0) {
+        return NULL;
+    }
+    pthread_detach(task->thread);
+    s_task_count++;
+    return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *created_task)
+{
+    TaskHandle_t task = xTaskCreateStatic(task_code, name, stack_depth, parameters, priority, NULL, NULL);
+    if (created_task) {
+        *created_task = task;
+    }
+    return task ? pdPASS : pdFAIL;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_running;
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+    for (uint8_t i = 0; i < s_task_count; i++) {
+        if (strcmp(s_tasks[i].name, name) == 0) {
+            return &s_tasks[i];
+        }
+    }
+    return NULL;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    /* the host stack is not the target one, report it untouched */
+    return task ? task->stack_depth : 0;
+}
+
+/* Wait until a notification is pending, called by the running task with s_lock held */
+static bool sim_task_wait(struct sim_task *self, TickType_t ticks_to_wait)
+{
+    if (!self) {
+        fprintf(stderr, "sim: the simulation context cannot wait for a notification\n");
+        abort();
+    }
+    if (!self->pending && ticks_to_wait != portMAX_DELAY) {
+        /* the clock does not move while a task runs, a timed wait can only time out */
+        return false;
+    }
+    while (!self->pending) {
+        self->waiting = true;
+        sim_switch_to(NULL, self);
+    }
+    self->waiting = false;
+    return true;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&s_lock);
+    struct sim_task *self = s_running;
+    uint32_t count = 0;
+    if (sim_task_wait(self, ticks_to_wait)) {
+        count = self->notification;
+        self->notification = clear_count_on_exit ? 0 : count - 1;
+        self->pending = self->notification != 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return count;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *notification_value,
+                           TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&s_lock);
+    struct sim_task *self = s_running;
+    if (!self->pending) {
+        self->notification &= ~bits_to_clear_on_entry;
+    }
+    bool notified = sim_task_wait(self, ticks_to_wait);
+    if (notification_value) {
+        *notification_value = self->notification;
+    }
+    if (notified) {
+        self->notification &= ~bits_to_clear_on_exit;
+        self->pending = false;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return notified ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    pthread_mutex_lock(&s_lock);
+    switch (action) {
+    case eSetBits:
+        task->notification |= value;
+        break;
+    case eIncrement:
+        task->notification++;
+        break;
+    case eSetValueWithOverwrite:
+    case eSetValueWithoutOverwrite:
+        task->notification = value;
+        break;
+    default:
+        break;
+    }
+    task->pending = true;
+    pthread_mutex_unlock(&s_lock);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    xTaskNotifyFromISR(task, 0, eIncrement, higher_priority_task_woken);
+}
+
+static SemaphoreHandle_t sim_semaphore_create(bool mutex, UBaseType_t max_count, UBaseType_t initial_count)
+{
+    if (s_semaphore_count == SIM_SEMAPHORE_MAX) {
+        return NULL;
+    }
+    struct sim_semaphore *semaphore = &s_semaphores[s_semaphore_count++];
+    *semaphore = (struct sim_semaphore) {
+        .mutex = mutex,
+        .count = initial_count,
+        .max_count = max_count,
+    };
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *mutex_buffer)
+{
+    return sim_semaphore_create(true, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateMutexStatic(NULL);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max_count, UBaseType_t initial_count, StaticSemaphore_t *semaphore_buffer)
+{
+    return sim_semaphore_create(false, max_count, initial_count);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *semaphore_buffer)
+{
+    return sim_semaphore_create(false, 1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+    if (semaphore->count == 0 && !semaphore->mutex && !s_running) {
+        /* the simulation waits: the tasks run, they may give it */
+        sim_run_tasks();
+    }
+    if (semaphore->count == 0) {
+        if (ticks_to_wait == portMAX_DELAY) {
+            /* the owner has given the hand away while holding it, nothing could ever give it back */
+            if (semaphore->mutex) {
+                fprintf(stderr, "sim: mutex already taken by %s\n", semaphore->owner ? semaphore->owner->name : "the simulation");
+            } else {
+                fprintf(stderr, "sim: semaphore never given\n");
+            }
+            abort();
+        }
+        return pdFALSE;
+    }
+    semaphore->count--;
+    semaphore->owner = s_running;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count == semaphore->max_count) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *queue_buffer)
+{
+    if (s_queue_count == SIM_QUEUE_MAX) {
+        return NULL;
+    }
+    struct sim_queue *queue = &s_queues[s_queue_count++];
+    *queue = (struct sim_queue) {
+        .storage = storage,
+        .length = length,
+        .item_size = item_size,
+    };
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    if (queue->count == queue->length && !s_running) {
+        sim_run_tasks();
+    }
+    pthread_mutex_lock(&s_lock);
+    bool sent = queue->count < queue->length;
+    if (sent) {
+        memcpy(&queue->storage[(queue->head + queue->count) % queue->length * queue->item_size], item, queue->item_size);
+        queue->count++;
+        if (queue->receiver) {
+            /* runnable again, it takes the item once it has the hand */
+            queue->receiver->waiting = false;
+            queue->receiver = NULL;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return sent ? pdPASS : errQUEUE_FULL;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    pthread_mutex_lock(&s_lock);
+    struct sim_task *self = s_running;
+    if (queue->count == 0 && ticks_to_wait == portMAX_DELAY) {
+        if (!self) {
+            fprintf(stderr, "sim: the simulation context cannot wait for a queue item\n");
+            abort();
+        }
+        while (queue->count == 0) {
+            queue->receiver = self;
+            self->waiting = true;
+            sim_switch_to(NULL, self);
+        }
+    }
+    bool received = queue->count > 0;
+    if (received) {
+        memcpy(item, &queue->storage[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return received ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the GPIO driver
+ */
+
+#include "driver/gpio.h"
+#include "sim.h"
+
+typedef struct {
+    int level;
+    gpio_int_type_t intr_type;
+    bool intr_enabled;
+    gpio_isr_t isr_handler;
+    void *isr_arg;
+} sim_gpio_t;
+
+static sim_gpio_t s_pins[SIM_GPIO_COUNT];
+
+static bool sim_gpio_valid(gpio_num_t pin)
+{
+    return pin >= 0 && pin < SIM_GPIO_COUNT;
+}
+
+/* Run the handler of a level interrupt that is armed and asserted, it disables it or it would fire again */
+static void sim_gpio_check(gpio_num_t pin)
+{
+    sim_gpio_t *gpio = &s_pins[pin];
+    bool asserted = (gpio->intr_type == GPIO_INTR_HIGH_LEVEL && gpio->level) ||
+                    (gpio->intr_type == GPIO_INTR_LOW_LEVEL && !gpio->level);
+    if (gpio->intr_enabled && gpio->isr_handler && asserted) {
+        gpio->isr_handler(gpio->isr_arg);
+    }
+}
+
+void sim_gpio_set(gpio_num_t pin, int level)
+{
+    if (sim_gpio_valid(pin)) {
+        s_pins[pin].level = level ? 1 : 0;
+        sim_gpio_check(pin);
+    }
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    for (int pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+        if (config->pin_bit_mask & BIT64(pin)) {
+            s_pins[pin].intr_type = config->intr_type;
+            s_pins[pin].intr_enabled = config->intr_type != GPIO_INTR_DISABLE;
+            /* an open button reads its pull */
+            s_pins[pin].level = config->pull_up_en ? 1 : 0;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    if (!sim_gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_type = intr_type;
+    sim_gpio_check(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    if (!sim_gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_enabled = true;
+    sim_gpio_check(gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    if (!sim_gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_enabled = false;
+    return ESP_OK;
+}
+
+/* The level wake-up of a pin also sets the type of its interrupt, as on the chip */
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    if (!sim_gpio_valid(gpio_num) || (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].intr_type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num)
+{
+    return sim_gpio_valid(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return sim_gpio_valid(gpio_num) ? s_pins[gpio_num].level : 0;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!sim_gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (!sim_gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio_num].isr_handler = isr_handler;
+    s_pins[gpio_num].isr_arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the led_strip component, keeping the frames sent
+ */
+
+#include <string.h>
+#include "led_strip.h"
+#include "sim.h"
+
+struct sim_led_strip {
+    uint32_t max_leds;
+    uint8_t pixels[SIM_LED_STRIP_MAX_LEDS][3];
+};
+
+static struct sim_led_strip s_device;
+static bool s_device_used;
+static sim_led_strip_t s_strip;
+static sim_led_strip_frame_t s_frames[SIM_LED_STRIP_MAX_FRAMES];
+static size_t s_frame_count;
+
+const sim_led_strip_t *sim_led_strip_get(void)
+{
+    return &s_strip;
+}
+
+size_t sim_led_strip_frame_count(void)
+{
+    return s_frame_count;
+}
+
+const sim_led_strip_frame_t *sim_led_strip_frame(size_t index)
+{
+    return index < s_frame_count && index < SIM_LED_STRIP_MAX_FRAMES ? &s_frames[index] : NULL;
+}
+
+void sim_led_strip_frames_clear(void)
+{
+    s_frame_count = 0;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *ret_strip)
+{
+    /* the chip has one RMT channel for it */
+    if (s_device_used || led_config->max_leds > SIM_LED_STRIP_MAX_LEDS) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(&s_device, 0, sizeof(s_device));
+    s_device.max_leds = led_config->max_leds;
+    s_device_used = true;
+    s_strip.created++;
+    *ret_strip = &s_device;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    if (!strip || index >= strip->max_leds) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    strip->pixels[index][0] = red;
+    strip->pixels[index][1] = green;
+    strip->pixels[index][2] = blue;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip)
+{
+    if (!strip) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(s_strip.pixels, strip->pixels, sizeof(s_strip.pixels));
+    s_strip.refreshes++;
+    if (s_frame_count < SIM_LED_STRIP_MAX_FRAMES) {
+        s_frames[s_frame_count].time_us = sim_now_us();
+        memcpy(s_frames[s_frame_count].pixels, strip->pixels, sizeof(s_frames[s_frame_count].pixels));
+    }
+    s_frame_count++;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip)
+{
+    if (!strip) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(strip->pixels, 0, sizeof(strip->pixels));
+    return led_strip_refresh(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip)
+{
+    if (strip != &s_device || !s_device_used) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_device_used = false;
+    s_strip.deleted++;
+    return ESP_OK;
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for esp_log and esp_err_to_name, and for deferred_log which
+ * prints at once: there is no interrupt context to keep printf out of. The
+ * ESP_LOGx output can also go to a file, as a serial monitor log.
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "deferred_log.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sim.h"
+
+static FILE *s_log_file;
+
+static int sim_log_enabled(void)
+{
+    static int enabled = -1;
+    if (enabled < 0) {
+        enabled = getenv("SIM_LOG") != NULL;
+    }
+    return enabled;
+}
+
+static void sim_log_vwrite(FILE *file, esp_log_level_t level, const char *tag, const char *format, va_list args)
+{
+    fprintf(file, "%c (%" PRId64 ") %s: ", "NEWIDV"[level], sim_now_us() / 1000, tag);
+    vfprintf(file, format, args);
+    fputc('\n', file);
+}
+
+void sim_log_to(FILE *file)
+{
+    s_log_file = file;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    if (s_log_file) {
+        va_start(args, format);
+        sim_log_vwrite(s_log_file, level, tag, format, args);
+        va_end(args);
+    }
+    if (sim_log_enabled()) {
+        va_start(args, format);
+        sim_log_vwrite(stderr, level, tag, format, args);
+        va_end(args);
+    }
+}
+
+/* The arguments were cut to 32 bits, string pointers among them cannot be read back on a 64-bit host */
+void deferred_log_write(esp_log_level_t level, const char *tag, const char *format, const uint32_t *args, uint32_t argc)
+{
+    if (!sim_log_enabled()) {
+        return;
+    }
+    fprintf(stderr, "%c (%" PRId64 ") %s: [%s]", "NEWIDV"[level], sim_now_us() / 1000, tag, format);
+    for (uint32_t i = 0; i < argc; i++) {
+        fprintf(stderr, " 0x%" PRIx32, args[i]);
+    }
+    fputc('\n', stderr);
+}
+
+esp_err_t deferred_log_init(void)
+{
+    return ESP_OK;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_NOT_ENOUGH_SPACE:
+        return "ESP_ERR_NVS_NOT_ENOUGH_SPACE";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,341 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the NVS API: a fixed number of entries in memory, written
+ * through at once, so a commit only reports the injected failures. A value that
+ * failed to commit stays written, as it does on the chip until the next commit.
+ *
+ * The flash wear is modelled on the nvs partition: pages of 32-byte entries
+ * filled in turn, a value taking one entry and a blob its index, its data
+ * header and its data. A value written again leaves its old entries erased in
+ * their page. One page is kept free: when the last other one fills up, the
+ * full page with the most erased entries has its live values moved to the free
+ * page and is erased, the oldest one among equals, as the NVS library does.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "nvs.h"
+#include "sim.h"
+
+#define SIM_NVS_MAX_ENTRIES     32
+#define SIM_NVS_MAX_HANDLES     8
+#define SIM_NVS_NAMESPACE_SIZE  16
+/* the nvs partition of partitions.csv, 0x6000 bytes */
+#define SIM_NVS_PAGES           6
+#define SIM_NVS_PAGE_ENTRIES    126
+#define SIM_NVS_ENTRY_SIZE      32
+
+typedef struct {
+    bool used;
+    char namespace_name[SIM_NVS_NAMESPACE_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    size_t length;
+    uint8_t value[SIM_NVS_MAX_VALUE_SIZE];
+    uint8_t page;               /* page holding the value */
+    uint8_t span;               /* flash entries taken by the value */
+} sim_nvs_entry_t;
+
+typedef struct {
+    uint16_t used;              /* entries written since the page was erased */
+    uint16_t erased;            /* entries of values written again or erased since */
+    bool full;
+    uint32_t sequence;          /* order in which the pages were filled */
+    uint32_t erases;
+} sim_nvs_page_t;
+
+typedef struct {
+    bool open;
+    bool writable;
+    char namespace_name[SIM_NVS_NAMESPACE_SIZE];
+} sim_nvs_handle_t;
+
+static sim_nvs_entry_t s_entries[SIM_NVS_MAX_ENTRIES];
+/* handle n is s_handles[n - 1], 0 is never valid */
+static sim_nvs_handle_t s_handles[SIM_NVS_MAX_HANDLES];
+static uint32_t s_failing_writes;
+static esp_err_t s_write_error;
+static uint32_t s_failing_commits;
+static esp_err_t s_commit_error;
+static uint32_t s_writes;
+static sim_nvs_page_t s_pages[SIM_NVS_PAGES];
+static uint8_t s_active_page;
+static uint32_t s_page_sequence;
+
+void sim_nvs_fail_writes(uint32_t count, esp_err_t err)
+{
+    s_failing_writes = count;
+    s_write_error = err;
+}
+
+void sim_nvs_fail_commits(uint32_t count, esp_err_t err)
+{
+    s_failing_commits = count;
+    s_commit_error = err;
+}
+
+uint32_t sim_nvs_write_count(void)
+{
+    return s_writes;
+}
+
+uint32_t sim_nvs_erase_count(void)
+{
+    uint32_t erases = 0;
+    for (int i = 0; i < SIM_NVS_PAGES; i++) {
+        erases += s_pages[i].erases;
+    }
+    return erases;
+}
+
+uint32_t sim_nvs_page_erase_max(void)
+{
+    uint32_t erases = 0;
+    for (int i = 0; i < SIM_NVS_PAGES; i++) {
+        erases = s_pages[i].erases > erases ? s_pages[i].erases : erases;
+    }
+    return erases;
+}
+
+size_t sim_nvs_entry_count(const char *namespace_name)
+{
+    size_t count = 0;
+    for (int i = 0; i < SIM_NVS_MAX_ENTRIES; i++) {
+        count += s_entries[i].used && strcmp(s_entries[i].namespace_name, namespace_name) == 0;
+    }
+    return count;
+}
+
+static sim_nvs_handle_t *sim_nvs_handle(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > SIM_NVS_MAX_HANDLES || !s_handles[handle - 1].open) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static sim_nvs_entry_t *sim_nvs_find(const sim_nvs_handle_t *handle, const char *key)
+{
+    for (int i = 0; i < SIM_NVS_MAX_ENTRIES; i++) {
+        sim_nvs_entry_t *entry = &s_entries[i];
+        if (entry->used && strcmp(entry->namespace_name, handle->namespace_name) == 0 && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static int sim_nvs_free_page(void)
+{
+    for (int i = 0; i < SIM_NVS_PAGES; i++) {
+        if (i != s_active_page && !s_pages[i].full && s_pages[i].used == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Move on to a free page, compacting the full page with the most erased entries into it when it is the last one */
+static bool sim_nvs_next_page(void)
+{
+    s_pages[s_active_page].full = true;
+    int free_page = sim_nvs_free_page();
+    if (free_page < 0) {
+        return false;
+    }
+    s_active_page = free_page;
+    s_pages[free_page].sequence = ++s_page_sequence;
+    if (sim_nvs_free_page() >= 0) {
+        return true;
+    }
+    int victim = -1;
+    for (int i = 0; i < SIM_NVS_PAGES; i++) {
+        if (s_pages[i].full && (victim < 0 || s_pages[i].erased > s_pages[victim].erased ||
+                                (s_pages[i].erased == s_pages[victim].erased && s_pages[i].sequence < s_pages[victim].sequence))) {
+            victim = i;
+        }
+    }
+    if (victim < 0 || s_pages[victim].erased == 0) {
+        return false;
+    }
+    for (int i = 0; i < SIM_NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && s_entries[i].page == victim) {
+            s_entries[i].page = s_active_page;
+            s_pages[s_active_page].used += s_entries[i].span;
+        }
+    }
+    s_pages[victim] = (sim_nvs_page_t) { .erases = s_pages[victim].erases + 1 };
+    return true;
+}
+
+/* Erase the flash entries of a value */
+static void sim_nvs_release(sim_nvs_entry_t *entry)
+{
+    s_pages[entry->page].erased += entry->span;
+    entry->span = 0;
+}
+
+/* Write the flash entries of a value to the active page */
+static esp_err_t sim_nvs_place(sim_nvs_entry_t *entry, bool blob)
+{
+    uint8_t span = blob ? 2 + (entry->length + SIM_NVS_ENTRY_SIZE - 1) / SIM_NVS_ENTRY_SIZE : 1;
+    while (s_pages[s_active_page].used + span > SIM_NVS_PAGE_ENTRIES) {
+        if (!sim_nvs_next_page()) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+    }
+    entry->page = s_active_page;
+    entry->span = span;
+    s_pages[s_active_page].used += span;
+    return ESP_OK;
+}
+
+/* Take one of the injected failures */
+static esp_err_t sim_nvs_injected(uint32_t *count, esp_err_t err)
+{
+    if (*count) {
+        (*count)--;
+        return err;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_nvs_set(nvs_handle_t handle, const char *key, const void *value, size_t length, bool blob)
+{
+    sim_nvs_handle_t *h = sim_nvs_handle(handle);
+    if (!h) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!h->writable) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (length > SIM_NVS_MAX_VALUE_SIZE || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    esp_err_t err = sim_nvs_injected(&s_failing_writes, s_write_error);
+    if (err != ESP_OK) {
+        return err;
+    }
+    sim_nvs_entry_t *entry = sim_nvs_find(h, key);
+    for (int i = 0; !entry && i < SIM_NVS_MAX_ENTRIES; i++) {
+        if (!s_entries[i].used) {
+            entry = &s_entries[i];
+            *entry = (sim_nvs_entry_t) { .used = true };
+            strcpy(entry->namespace_name, h->namespace_name);
+            strcpy(entry->key, key);
+        }
+    }
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    sim_nvs_release(entry);
+    memcpy(entry->value, value, length);
+    entry->length = length;
+    err = sim_nvs_place(entry, blob);
+    if (err != ESP_OK) {
+        entry->used = false;
+        return err;
+    }
+    s_writes++;
+    return ESP_OK;
+}
+
+static esp_err_t sim_nvs_get(nvs_handle_t handle, const char *key, void *value, size_t *length)
+{
+    sim_nvs_handle_t *h = sim_nvs_handle(handle);
+    if (!h) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    const sim_nvs_entry_t *entry = sim_nvs_find(h, key);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < entry->length) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(value, entry->value, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (strlen(namespace_name) >= SIM_NVS_NAMESPACE_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < SIM_NVS_MAX_HANDLES; i++) {
+        if (!s_handles[i].open) {
+            s_handles[i] = (sim_nvs_handle_t) { .open = true, .writable = open_mode == NVS_READWRITE };
+            strcpy(s_handles[i].namespace_name, namespace_name);
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    sim_nvs_handle_t *h = sim_nvs_handle(handle);
+    if (h) {
+        h->open = false;
+    }
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return sim_nvs_set(handle, key, &value, sizeof(value), false);
+}
+
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char *key, uint16_t value)
+{
+    return sim_nvs_set(handle, key, &value, sizeof(value), false);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return sim_nvs_get(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char *key, uint16_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return sim_nvs_get(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return sim_nvs_set(handle, key, value, length, true);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return sim_nvs_get(handle, key, out_value, length);
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    sim_nvs_handle_t *h = sim_nvs_handle(handle);
+    if (!h) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!h->writable) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    for (int i = 0; i < SIM_NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && strcmp(s_entries[i].namespace_name, h->namespace_name) == 0) {
+            sim_nvs_release(&s_entries[i]);
+            s_entries[i].used = false;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    if (!sim_nvs_handle(handle)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    return sim_nvs_injected(&s_failing_commits, s_commit_error);
+}
@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the OTA API and esp_restart(). The update partition is a
+ * buffer in memory, written sequentially: each sector is erased when the first
+ * write reaches it, as esp_ota_begin() with OTA_WITH_SEQUENTIAL_WRITES does.
+ *
+ * The clock does not move while a task runs, so the flash time is accounted
+ * apart: each write starts once the flash is done with the previous ones and
+ * takes the erase of the sectors it reaches plus the programming of its pages.
+ * How far the flash lags behind tells whether the writer would hold up the
+ * download on the chip.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_app_format.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "sim.h"
+
+#define SIM_OTA_HANDLE  1
+
+/* the app partitions of partitions.csv */
+static const esp_partition_t s_partitions[] = {
+    { .address = 0x20000, .size = 960 * 1024, .label = "ota_0" },
+    { .address = 0x110000, .size = 960 * 1024, .label = "ota_1" },
+};
+static const esp_partition_t *const s_running = &s_partitions[0];
+static const esp_partition_t *const s_update = &s_partitions[1];
+
+static sim_ota_t s_ota = {
+    .boot = &s_partitions[0],
+    .running_state = ESP_OTA_IMG_VALID,
+};
+static uint8_t *s_data;
+static bool s_open;
+
+sim_ota_t *sim_ota(void)
+{
+    return &s_ota;
+}
+
+const uint8_t *sim_ota_partition_data(void)
+{
+    return s_data;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return s_running;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return s_update;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    if (partition != s_update || s_open) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_data) {
+        s_data = malloc(s_update->size);
+        if (!s_data) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(s_data, 0xFF, s_update->size);
+    s_ota.writes = 0;
+    s_ota.written = 0;
+    s_ota.sectors_erased = 0;
+    s_ota.flash_busy_us = 0;
+    s_ota.flash_done_us = sim_now_us();
+    s_ota.lag_max_us = 0;
+    s_ota.ended = false;
+    s_open = true;
+    *out_handle = SIM_OTA_HANDLE;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != SIM_OTA_HANDLE || !s_open) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ota.written + size > s_update->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t end = s_ota.written + size;
+    uint32_t sectors = (end + SIM_OTA_SECTOR_SIZE - 1) / SIM_OTA_SECTOR_SIZE - s_ota.sectors_erased;
+    uint32_t pages = (end + SIM_OTA_PAGE_SIZE - 1) / SIM_OTA_PAGE_SIZE - s_ota.written / SIM_OTA_PAGE_SIZE;
+    int64_t busy_us = sectors * SIM_OTA_SECTOR_ERASE_US + pages * SIM_OTA_PAGE_PROGRAM_US;
+    int64_t now_us = sim_now_us();
+    s_ota.flash_done_us = (s_ota.flash_done_us > now_us ? s_ota.flash_done_us : now_us) + busy_us;
+    s_ota.flash_busy_us += busy_us;
+    if (s_ota.flash_done_us - now_us > s_ota.lag_max_us) {
+        s_ota.lag_max_us = s_ota.flash_done_us - now_us;
+    }
+    s_ota.sectors_erased += sectors;
+
+    memcpy(&s_data[s_ota.written], data, size);
+    s_ota.written = end;
+    s_ota.writes++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != SIM_OTA_HANDLE || !s_open) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_open = false;
+    if (s_ota.written < sizeof(esp_image_header_t) || s_data[0] != ESP_IMAGE_HEADER_MAGIC) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    s_ota.ended = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    if (handle != SIM_OTA_HANDLE || !s_open) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_open = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    if (partition == s_update && !s_ota.ended) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    s_ota.boot = partition;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *ota_state)
+{
+    if (partition != s_running) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *ota_state = s_ota.running_state;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void)
+{
+    s_ota.running_state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+void esp_restart(void)
+{
+    s_ota.restarts++;
+}
@@ -0,0 +1,299 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the endpoint, cluster and attribute lists of the Zigbee
+ * stack, allocated the way the stack does: a block per list node and a copy of
+ * each attribute value, counted in sim_zb_list_heap(). The standard clusters
+ * accept the attributes the device uses, with their ZCL data type.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_zigbee_core.h"
+#include "sim.h"
+
+typedef struct {
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+    uint8_t size;       /*!< Size of a value that is not a ZCL type, 0 to take it from the type */
+} sim_zb_std_attr_t;
+
+static const sim_zb_std_attr_t s_std_attrs[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_ZCL_VERSION_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING },
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING },
+    { ESP_ZB_ZCL_CLUSTER_ID_BASIC, ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, ESP_ZB_ZCL_ATTR_IDENTIFY_IDENTIFY_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_GROUPS, ESP_ZB_ZCL_ATTR_GROUPS_NAME_SUPPORT_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_COUNT_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_NAME_SUPPORT_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_OPTIONS_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_COLOR_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_CAPABILITIES_ID, ESP_ZB_ZCL_ATTR_TYPE_16BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_DESCRIPTION_ID, ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING },
+    { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_OUT_OF_SERVICE_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_STATUS_FLAGS_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_FILE_VERSION_ID, ESP_ZB_ZCL_ATTR_TYPE_U32 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    /* the client variables, not a ZCL attribute but kept with them */
+    { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID, ESP_ZB_ZCL_ATTR_TYPE_NULL,
+      sizeof(esp_zb_zcl_ota_upgrade_client_variable_t) },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_CONTROL_SEQUENCE_OF_OPERATION_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, ESP_ZB_ZCL_ATTR_TYPE_16BITMAP },
+    { ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+};
+
+static sim_zb_list_heap_t s_heap;
+
+static void *sim_zb_list_alloc(size_t size)
+{
+    void *block = calloc(1, size);
+    if (block) {
+        s_heap.allocations++;
+        s_heap.bytes += size;
+        s_heap.live++;
+    }
+    return block;
+}
+
+static void sim_zb_list_release(void *block)
+{
+    if (block) {
+        s_heap.live--;
+        free(block);
+    }
+}
+
+const sim_zb_list_heap_t *sim_zb_list_heap(void)
+{
+    return &s_heap;
+}
+
+esp_zb_ep_list_t *esp_zb_ep_list_create(void)
+{
+    return sim_zb_list_alloc(sizeof(esp_zb_ep_list_t));
+}
+
+esp_zb_cluster_list_t *esp_zb_zcl_cluster_list_create(void)
+{
+    return sim_zb_list_alloc(sizeof(esp_zb_cluster_list_t));
+}
+
+esp_zb_attribute_list_t *esp_zb_zcl_attr_list_create(uint16_t cluster_id)
+{
+    esp_zb_attribute_list_t *attr_list = sim_zb_list_alloc(sizeof(esp_zb_attribute_list_t));
+    if (attr_list) {
+        attr_list->cluster_id = cluster_id;
+    }
+    return attr_list;
+}
+
+/* Append an attribute with a copy of its value, one of each identifier per cluster */
+static esp_err_t sim_zb_attr_append(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access,
+                                    const void *value_p, size_t size)
+{
+    esp_zb_attribute_list_t **tail = &attr_list->next;
+    for (; *tail; tail = &(*tail)->next) {
+        if ((*tail)->attribute.id == attr_id) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    esp_zb_attribute_list_t *node = sim_zb_list_alloc(sizeof(esp_zb_attribute_list_t));
+    void *value = node ? sim_zb_list_alloc(size) : NULL;
+    if (!value) {
+        sim_zb_list_release(node);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(value, value_p, size);
+    node->attribute = (esp_zb_zcl_attr_t) {
+        .id = attr_id,
+        .type = attr_type,
+        .access = attr_access,
+        .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+        .data_p = value,
+    };
+    node->cluster_id = attr_list->cluster_id;
+    *tail = node;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_custom_cluster_add_custom_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, uint8_t attr_type, uint8_t attr_access,
+                                                void *value_p)
+{
+    if (!attr_list || !value_p) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* strings are copied with their length prefix */
+    size_t size = sim_zb_attr_size(attr_type);
+    if (attr_type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING || attr_type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING) {
+        size = 1 + *(const uint8_t *)value_p;
+    }
+    return size ? sim_zb_attr_append(attr_list, attr_id, attr_type, attr_access, value_p, size) : ESP_ERR_INVALID_ARG;
+}
+
+/* Add a standard attribute of a cluster with its type, the value of a non-ZCL one is copied as is */
+static esp_err_t sim_zb_std_attr_add(uint16_t cluster_id, esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p)
+{
+    if (!attr_list || !value_p || attr_list->cluster_id != cluster_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < sizeof(s_std_attrs) / sizeof(s_std_attrs[0]); i++) {
+        const sim_zb_std_attr_t *std = &s_std_attrs[i];
+        if (std->cluster_id != cluster_id || std->attr_id != attr_id) {
+            continue;
+        }
+        if (std->size) {
+            return sim_zb_attr_append(attr_list, attr_id, std->type, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, value_p, std->size);
+        }
+        return esp_zb_custom_cluster_add_custom_attr(attr_list, attr_id, std->type, ESP_ZB_ZCL_ATTR_ACCESS_READ_ONLY, value_p);
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+#define SIM_ZB_STD_ADD_ATTR(name, cluster_id)                                                       \
+    esp_err_t esp_zb_##name##_cluster_add_attr(esp_zb_attribute_list_t *attr_list, uint16_t attr_id, void *value_p) \
+    {                                                                                               \
+        return sim_zb_std_attr_add((cluster_id), attr_list, attr_id, value_p);                      \
+    }
+
+SIM_ZB_STD_ADD_ATTR(basic, ESP_ZB_ZCL_CLUSTER_ID_BASIC)
+SIM_ZB_STD_ADD_ATTR(identify, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY)
+SIM_ZB_STD_ADD_ATTR(groups, ESP_ZB_ZCL_CLUSTER_ID_GROUPS)
+SIM_ZB_STD_ADD_ATTR(scenes, ESP_ZB_ZCL_CLUSTER_ID_SCENES)
+SIM_ZB_STD_ADD_ATTR(on_off, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF)
+SIM_ZB_STD_ADD_ATTR(level, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL)
+SIM_ZB_STD_ADD_ATTR(color_control, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL)
+SIM_ZB_STD_ADD_ATTR(binary_input, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT)
+SIM_ZB_STD_ADD_ATTR(ota, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE)
+SIM_ZB_STD_ADD_ATTR(thermostat, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT)
+SIM_ZB_STD_ADD_ATTR(temperature_meas, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT)
+
+/* Append a cluster, one of each identifier and role per endpoint */
+static esp_err_t sim_zb_cluster_add(uint16_t cluster_id, esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list,
+                                    uint8_t role_mask)
+{
+    if (!cluster_list || !attr_list || attr_list->cluster_id != cluster_id ||
+        esp_zb_cluster_list_get_cluster(cluster_list, cluster_id, role_mask)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_zb_cluster_list_t *node = sim_zb_list_alloc(sizeof(esp_zb_cluster_list_t));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    node->cluster = (esp_zb_zcl_cluster_t) {
+        .cluster_id = cluster_id,
+        .attr_list = attr_list,
+        .role_mask = role_mask,
+        .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+    };
+    for (esp_zb_attribute_list_t *attr = attr_list->next; attr; attr = attr->next) {
+        node->cluster.attr_count++;
+    }
+    esp_zb_cluster_list_t **tail = &cluster_list->next;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = node;
+    return ESP_OK;
+}
+
+#define SIM_ZB_ADD_CLUSTER(name, cluster_id)                                                        \
+    esp_err_t esp_zb_cluster_list_add_##name##_cluster(esp_zb_cluster_list_t *cluster_list, esp_zb_attribute_list_t *attr_list, \
+                                                       uint8_t role_mask)                           \
+    {                                                                                               \
+        return sim_zb_cluster_add((cluster_id), cluster_list, attr_list, role_mask);                \
+    }
+
+SIM_ZB_ADD_CLUSTER(basic, ESP_ZB_ZCL_CLUSTER_ID_BASIC)
+SIM_ZB_ADD_CLUSTER(identify, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY)
+SIM_ZB_ADD_CLUSTER(groups, ESP_ZB_ZCL_CLUSTER_ID_GROUPS)
+SIM_ZB_ADD_CLUSTER(scenes, ESP_ZB_ZCL_CLUSTER_ID_SCENES)
+SIM_ZB_ADD_CLUSTER(on_off, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF)
+SIM_ZB_ADD_CLUSTER(level, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL)
+SIM_ZB_ADD_CLUSTER(color_control, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL)
+SIM_ZB_ADD_CLUSTER(binary_input, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT)
+SIM_ZB_ADD_CLUSTER(ota, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE)
+SIM_ZB_ADD_CLUSTER(thermostat, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT)
+SIM_ZB_ADD_CLUSTER(temperature_meas, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT)
+SIM_ZB_ADD_CLUSTER(diagnostics, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS)
+
+esp_err_t esp_zb_ep_list_add_ep(esp_zb_ep_list_t *ep_list, esp_zb_cluster_list_t *cluster_list, esp_zb_endpoint_config_t endpoint_config)
+{
+    if (!ep_list || !cluster_list || esp_zb_ep_list_get_ep(ep_list, endpoint_config.endpoint)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_zb_ep_list_t *node = sim_zb_list_alloc(sizeof(esp_zb_ep_list_t));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    node->config = endpoint_config;
+    node->cluster_list = cluster_list;
+    esp_zb_ep_list_t **tail = &ep_list->next;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = node;
+    return ESP_OK;
+}
+
+esp_zb_cluster_list_t *esp_zb_ep_list_get_ep(const esp_zb_ep_list_t *ep_list, uint8_t ep_id)
+{
+    for (const esp_zb_ep_list_t *ep = ep_list ? ep_list->next : NULL; ep; ep = ep->next) {
+        if (ep->config.endpoint == ep_id) {
+            return ep->cluster_list;
+        }
+    }
+    return NULL;
+}
+
+esp_zb_attribute_list_t *esp_zb_cluster_list_get_cluster(const esp_zb_cluster_list_t *cluster_list, uint16_t cluster_id, uint8_t role_mask)
+{
+    for (const esp_zb_cluster_list_t *cluster = cluster_list ? cluster_list->next : NULL; cluster; cluster = cluster->next) {
+        if (cluster->cluster.cluster_id == cluster_id && cluster->cluster.role_mask == role_mask) {
+            return cluster->cluster.attr_list;
+        }
+    }
+    return NULL;
+}
+
+void sim_zb_ep_list_free(esp_zb_ep_list_t *ep_list)
+{
+    while (ep_list) {
+        esp_zb_ep_list_t *ep = ep_list;
+        ep_list = ep->next;
+        esp_zb_cluster_list_t *cluster_list = ep->cluster_list;
+        while (cluster_list) {
+            esp_zb_cluster_list_t *cluster = cluster_list;
+            cluster_list = cluster->next;
+            esp_zb_attribute_list_t *attr_list = cluster->cluster.attr_list;
+            while (attr_list) {
+                esp_zb_attribute_list_t *attr = attr_list;
+                attr_list = attr->next;
+                sim_zb_list_release(attr->attribute.data_p);
+                sim_zb_list_release(attr);
+            }
+            sim_zb_list_release(cluster);
+        }
+        sim_zb_list_release(ep);
+    }
+}
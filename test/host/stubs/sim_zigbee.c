@@ -0,0 +1,620 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stand-in for the Zigbee attribute store, the reporting information,
+ * the scene table, the APS data request, the ZCL sequence number, the network
+ * commissioning, the OTA Upgrade client side of the stack, with the server, and
+ * the On/Off commands sent through the binding table, with the devices bound
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_zigbee_core.h"
+#include "sim.h"
+#include "zboss_api.h"
+
+/* ZCL sizes of an On/Off command and of a Default Response */
+#define SIM_ZB_ON_OFF_SIZE          3
+#define SIM_ZB_DEFAULT_RESP_SIZE    5
+/* records in a Mgmt_Bind_rsp, as many as fit in a frame */
+#define SIM_ZB_BINDING_RECORDS      3
+#define SIM_ZB_UNKNOWN_SHORT_ADDR   0xFFFF
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    esp_zb_zcl_attr_t attr;
+    uint8_t value[4];
+    esp_zb_zcl_reporting_info_t reporting;
+    bool reporting_set;
+    bool reporting_stopped;     /* by the application, until the next Configure Reporting */
+    bool report_scheduled;
+} sim_zb_attr_t;
+
+typedef struct {
+    uint8_t src_endpoint;
+    uint16_t cluster_id;
+    uint8_t device;
+} sim_zb_binding_t;
+
+/* On/Off command on its way to a device, then its Default Response on the way back */
+typedef struct {
+    sim_zb_device_t *device;
+    bool on;
+    uint8_t tsn;
+    uint8_t src_endpoint;       /* 0 for a command of the coordinator, not answered to this device */
+    bool active;
+} sim_zb_command_t;
+
+static sim_zb_attr_t s_attrs[SIM_ZB_MAX_ATTRS];
+static uint8_t s_attr_count;
+static sim_zb_frame_t s_frames[SIM_ZB_MAX_FRAMES];
+static size_t s_frame_count;
+static sim_zb_network_t s_network;
+static sim_zb_scene_t s_scenes[SIM_ZB_MAX_SCENES];
+static size_t s_scene_count;
+static uint8_t s_zcl_seq_num;
+static uint32_t s_stack_reports;
+static esp_zb_core_action_callback_t s_action_handler;
+static sim_zb_ota_t s_ota;
+static const uint8_t *s_ota_file;
+static uint32_t s_ota_size;
+static uint32_t s_ota_offset;
+static int64_t s_ota_next_us;     /* the next exchange ends then */
+static sim_zb_device_t s_devices[SIM_ZB_MAX_DEVICES];
+static uint8_t s_device_count;
+static sim_zb_binding_t s_bindings[SIM_ZB_MAX_BINDINGS];
+static uint8_t s_binding_count;
+static sim_zb_command_t s_commands[SIM_ZB_MAX_COMMANDS];
+static esp_zb_zdo_binding_table_callback_t s_binding_table_cb;
+static void *s_binding_table_ctx;
+static uint8_t s_binding_table_index;
+
+static sim_zb_attr_t *sim_zb_attr_find(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id)
+{
+    for (uint8_t i = 0; i < s_attr_count; i++) {
+        sim_zb_attr_t *entry = &s_attrs[i];
+        if (entry->endpoint == endpoint && entry->cluster_id == cluster_id && entry->attr.id == attr_id) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+size_t sim_zb_attr_size(uint8_t type)
+{
+    switch (type) {
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT:
+    case ESP_ZB_ZCL_ATTR_TYPE_BOOL:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U8:
+    case ESP_ZB_ZCL_ATTR_TYPE_S8:
+    case ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
+        return 1;
+    case ESP_ZB_ZCL_ATTR_TYPE_16BIT:
+    case ESP_ZB_ZCL_ATTR_TYPE_16BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U16:
+    case ESP_ZB_ZCL_ATTR_TYPE_S16:
+    case ESP_ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
+        return 2;
+    case ESP_ZB_ZCL_ATTR_TYPE_32BIT:
+    case ESP_ZB_ZCL_ATTR_TYPE_32BITMAP:
+    case ESP_ZB_ZCL_ATTR_TYPE_U32:
+    case ESP_ZB_ZCL_ATTR_TYPE_S32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+esp_err_t sim_zb_attr_add(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, uint8_t type, const void *value)
+{
+    size_t size = sim_zb_attr_size(type);
+    if (size == 0 || sim_zb_attr_find(endpoint, cluster_id, attr_id)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_attr_count == SIM_ZB_MAX_ATTRS) {
+        return ESP_ERR_NO_MEM;
+    }
+    sim_zb_attr_t *entry = &s_attrs[s_attr_count++];
+    entry->endpoint = endpoint;
+    entry->cluster_id = cluster_id;
+    entry->attr = (esp_zb_zcl_attr_t) {
+        .id = attr_id,
+        .type = type,
+        .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+        .data_p = entry->value,
+    };
+    memcpy(entry->value, value, size);
+    return ESP_OK;
+}
+
+esp_err_t sim_zb_reporting_set(uint8_t endpoint, uint16_t cluster_id, uint16_t attr_id, uint16_t min_interval, uint16_t max_interval)
+{
+    sim_zb_attr_t *entry = sim_zb_attr_find(endpoint, cluster_id, attr_id);
+    if (!entry) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    entry->reporting = (esp_zb_zcl_reporting_info_t) {
+        .ep = endpoint,
+        .cluster_id = cluster_id,
+        .cluster_role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+        .attr_id = attr_id,
+        .u.send_info = { .min_interval = min_interval, .max_interval = max_interval },
+        .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+    };
+    entry->reporting_set = true;
+    entry->reporting_stopped = false;
+    return ESP_OK;
+}
+
+uint32_t sim_zb_stack_report_count(void)
+{
+    return s_stack_reports;
+}
+
+/* The stack reports the attributes set since it last ran, if their reporting still stands */
+static void sim_zb_stack_report_cb(uint8_t index)
+{
+    sim_zb_attr_t *entry = &s_attrs[index];
+    entry->report_scheduled = false;
+    if (entry->reporting_set && !entry->reporting_stopped) {
+        s_stack_reports++;
+    }
+}
+
+size_t sim_zb_frame_count(void)
+{
+    return s_frame_count;
+}
+
+const sim_zb_frame_t *sim_zb_frame(size_t index)
+{
+    return index < s_frame_count && index < SIM_ZB_MAX_FRAMES ? &s_frames[index] : NULL;
+}
+
+void sim_zb_frames_clear(void)
+{
+    s_frame_count = 0;
+}
+
+bool esp_zb_lock_acquire(uint32_t block_ticks)
+{
+    return true;
+}
+
+void esp_zb_lock_release(void)
+{
+}
+
+esp_zb_zcl_attr_t *esp_zb_zcl_get_attribute(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id)
+{
+    sim_zb_attr_t *entry = sim_zb_attr_find(endpoint, cluster_id, attr_id);
+    return entry && cluster_role == ESP_ZB_ZCL_CLUSTER_SERVER_ROLE ? &entry->attr : NULL;
+}
+
+esp_zb_zcl_status_t esp_zb_zcl_set_attribute_val(uint8_t endpoint, uint16_t cluster_id, uint8_t cluster_role, uint16_t attr_id,
+                                                 void *value_p, bool check)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(endpoint, cluster_id, cluster_role, attr_id);
+    if (!attr) {
+        return ESP_ZB_ZCL_STATUS_FAIL;
+    }
+    memcpy(attr->data_p, value_p, sim_zb_attr_size(attr->type));
+    sim_zb_attr_t *entry = sim_zb_attr_find(endpoint, cluster_id, attr_id);
+    if (entry->reporting_set && !entry->report_scheduled) {
+        entry->report_scheduled = true;
+        esp_zb_scheduler_alarm((esp_zb_callback_t)sim_zb_stack_report_cb, (uint8_t)(entry - s_attrs), 0);
+    }
+    return ESP_ZB_ZCL_STATUS_SUCCESS;
+}
+
+esp_zb_zcl_reporting_info_t *esp_zb_zcl_find_reporting_info(esp_zb_zcl_attr_location_info_t attr_info)
+{
+    sim_zb_attr_t *entry = sim_zb_attr_find(attr_info.endpoint_id, attr_info.cluster_id, attr_info.attr_id);
+    return entry && entry->reporting_set ? &entry->reporting : NULL;
+}
+
+esp_err_t esp_zb_zcl_stop_attr_reporting(esp_zb_zcl_attr_location_info_t attr_info)
+{
+    sim_zb_attr_t *entry = sim_zb_attr_find(attr_info.endpoint_id, attr_info.cluster_id, attr_info.attr_id);
+    if (!entry || !entry->reporting_set) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    entry->reporting_stopped = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_aps_data_request(esp_zb_apsde_data_req_t *req)
+{
+    if (req->asdu_length > SIM_ZB_FRAME_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (s_frame_count < SIM_ZB_MAX_FRAMES) {
+        sim_zb_frame_t *frame = &s_frames[s_frame_count];
+        frame->time_us = sim_now_us();
+        frame->src_endpoint = req->src_endpoint;
+        frame->cluster_id = req->cluster_id;
+        frame->dst_addr_mode = req->dst_addr_mode;
+        frame->length = req->asdu_length;
+        memcpy(frame->asdu, req->asdu, req->asdu_length);
+    }
+    s_frame_count++;
+    return ESP_OK;
+}
+
+uint8_t zb_zcl_get_next_seq_number(void)
+{
+    return s_zcl_seq_num++;
+}
+
+sim_zb_network_t *sim_zb_network(void)
+{
+    return &s_network;
+}
+
+esp_err_t esp_zb_bdb_start_top_level_commissioning(uint8_t mode_mask)
+{
+    if (mode_mask == ESP_ZB_BDB_MODE_NETWORK_STEERING) {
+        s_network.steerings++;
+        s_network.last_steering_us = sim_now_us();
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_zb_set_primary_network_channel_set(uint32_t channel_mask)
+{
+    s_network.channel_mask = channel_mask;
+    return ESP_OK;
+}
+
+uint8_t esp_zb_get_current_channel(void)
+{
+    return s_network.channel;
+}
+
+uint16_t esp_zb_get_pan_id(void)
+{
+    return s_network.pan_id;
+}
+
+uint16_t esp_zb_get_short_address(void)
+{
+    return s_network.short_addr;
+}
+
+size_t sim_zb_scene_count(void)
+{
+    return s_scene_count;
+}
+
+const sim_zb_scene_t *sim_zb_scene_find(uint8_t endpoint, uint16_t group_id, uint8_t scene_id)
+{
+    for (size_t i = 0; i < s_scene_count; i++) {
+        if (s_scenes[i].endpoint == endpoint && s_scenes[i].group_id == group_id && s_scenes[i].scene_id == scene_id) {
+            return &s_scenes[i];
+        }
+    }
+    return NULL;
+}
+
+void sim_zb_scenes_clear(void)
+{
+    s_scene_count = 0;
+}
+
+esp_err_t esp_zb_zcl_scenes_table_store(uint8_t endpoint, uint16_t group_id, uint8_t scene_id, uint16_t transition_time,
+                                        esp_zb_zcl_scenes_extension_field_t *field)
+{
+    sim_zb_scene_t *scene = (sim_zb_scene_t *)sim_zb_scene_find(endpoint, group_id, scene_id);
+    if (!scene) {
+        if (s_scene_count == SIM_ZB_MAX_SCENES) {
+            return ESP_ERR_NO_MEM;
+        }
+        scene = &s_scenes[s_scene_count++];
+    }
+    *scene = (sim_zb_scene_t) {
+        .endpoint = endpoint,
+        .group_id = group_id,
+        .scene_id = scene_id,
+    };
+    for (; field; field = field->next) {
+        if (scene->data_length + 3 + field->length > SIM_ZB_SCENE_DATA_SIZE) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        uint8_t *data = &scene->data[scene->data_length];
+        data[0] = field->cluster_id & 0xFF;
+        data[1] = field->cluster_id >> 8;
+        data[2] = field->length;
+        memcpy(&data[3], field->extension_field_attribute_value_list, field->length);
+        scene->data_length += 3 + field->length;
+    }
+    return ESP_OK;
+}
+
+void esp_zb_core_action_handler_register(esp_zb_core_action_callback_t cb)
+{
+    s_action_handler = cb;
+}
+
+/* One frame of payload bytes on the air, with its acknowledgement */
+static int64_t sim_zb_frame_us(uint32_t payload)
+{
+    return (payload + SIM_ZB_FRAME_OVERHEAD) * SIM_ZB_BYTE_US + SIM_ZB_FRAME_ACK_US;
+}
+
+/* Image Block Request, the server's answer, then the Image Block Response in fragments */
+static int64_t sim_zb_ota_exchange_us(uint32_t block)
+{
+    /* ZCL header, then status, manufacturer code, image type, file version, offset and data size */
+    const uint32_t request = 3 + 14, response = 3 + 14 + block;
+    int64_t time_us = sim_zb_frame_us(request) + SIM_ZB_OTA_SERVER_US;
+    for (uint32_t sent = 0; sent < response; sent += SIM_ZB_FRAME_PAYLOAD) {
+        time_us += sim_zb_frame_us(response - sent < SIM_ZB_FRAME_PAYLOAD ? response - sent : SIM_ZB_FRAME_PAYLOAD);
+    }
+    return time_us;
+}
+
+/* Fire an alarm at a time in microseconds, the scheduler counts in milliseconds */
+static void sim_zb_alarm_at(esp_zb_callback_t cb, uint8_t param, int64_t at_us)
+{
+    int64_t wait_us = at_us - sim_now_us();
+    esp_zb_scheduler_alarm(cb, param, wait_us > 0 ? (wait_us + 999) / 1000 : 0);
+}
+
+static uint32_t sim_zb_read_u32(const uint8_t *data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static void sim_zb_ota_cb(uint8_t status);
+
+static void sim_zb_ota_next(esp_zb_zcl_ota_upgrade_status_t status, int64_t delay_us)
+{
+    s_ota_next_us += delay_us;
+    sim_zb_alarm_at(sim_zb_ota_cb, status, s_ota_next_us);
+}
+
+static void sim_zb_ota_cb(uint8_t status)
+{
+    esp_zb_zcl_ota_upgrade_value_message_t message = {
+        .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = 1, .cluster = ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE },
+        .upgrade_status = status,
+        .ota_header = {
+            .manufacturer_code = s_ota_file[10] | s_ota_file[11] << 8,
+            .image_type = s_ota_file[12] | s_ota_file[13] << 8,
+            .file_version = sim_zb_read_u32(&s_ota_file[14]),
+            .image_size = s_ota_size,
+        },
+    };
+    if (status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE) {
+        message.payload_size = s_ota_size - s_ota_offset < s_ota.block_size ? s_ota_size - s_ota_offset : s_ota.block_size;
+        message.payload = (uint8_t *)&s_ota_file[s_ota_offset];
+    }
+    if (status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK) {
+        s_ota.check_us = sim_now_us();
+    }
+    s_ota.result = s_action_handler ? s_action_handler(ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID, &message) : ESP_ERR_INVALID_STATE;
+    if (s_ota.result != ESP_OK) {
+        s_ota.done = true;
+        return;
+    }
+    switch (status) {
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START:
+        /* the stack keeps the OTA header, its length is in the header */
+        s_ota_offset = s_ota_file[6] | s_ota_file[7] << 8;
+        sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, sim_zb_ota_exchange_us(s_ota.block_size));
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE:
+        s_ota_offset += message.payload_size;
+        s_ota.blocks++;
+        if (s_ota_offset < s_ota_size) {
+            sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE, sim_zb_ota_exchange_us(s_ota.block_size));
+        } else {
+            sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY, 0);
+        }
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+        sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK, 0);
+        break;
+    case ESP_ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+        /* Upgrade End Request, then the Upgrade End Response tells when to switch */
+        sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_FINISH, 2 * sim_zb_frame_us(3 + 13) + SIM_ZB_OTA_SERVER_US);
+        break;
+    default:
+        s_ota.done = true;
+        break;
+    }
+}
+
+void sim_zb_ota_serve(const uint8_t *file, uint32_t size, uint16_t block_size)
+{
+    s_ota = (sim_zb_ota_t) {
+        .block_size = block_size,
+        .start_us = sim_now_us(),
+    };
+    s_ota_file = file;
+    s_ota_size = size;
+    s_ota_next_us = sim_now_us();
+    /* Query Next Image Request and Response */
+    sim_zb_ota_next(ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START, 2 * sim_zb_frame_us(3 + 13) + SIM_ZB_OTA_SERVER_US);
+}
+
+const sim_zb_ota_t *sim_zb_ota(void)
+{
+    return &s_ota;
+}
+
+sim_zb_device_t *sim_zb_device_add(uint16_t short_addr, const uint8_t ieee_addr[8], uint8_t endpoint)
+{
+    if (s_device_count == SIM_ZB_MAX_DEVICES) {
+        return NULL;
+    }
+    sim_zb_device_t *device = &s_devices[s_device_count++];
+    *device = (sim_zb_device_t) {
+        .short_addr = short_addr,
+        .endpoint = endpoint,
+        .hops = 1,
+        .coordinator_hops = 1,
+    };
+    memcpy(device->ieee_addr, ieee_addr, sizeof(device->ieee_addr));
+    return device;
+}
+
+esp_err_t sim_zb_bind(uint8_t src_endpoint, uint16_t cluster_id, const sim_zb_device_t *device)
+{
+    if (s_binding_count == SIM_ZB_MAX_BINDINGS) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_bindings[s_binding_count++] = (sim_zb_binding_t) {
+        .src_endpoint = src_endpoint,
+        .cluster_id = cluster_id,
+        .device = device - s_devices,
+    };
+    return ESP_OK;
+}
+
+uint16_t esp_zb_address_short_by_ieee(esp_zb_ieee_addr_t address)
+{
+    for (uint8_t i = 0; i < s_device_count; i++) {
+        if (memcmp(s_devices[i].ieee_addr, address, sizeof(s_devices[i].ieee_addr)) == 0) {
+            return s_devices[i].short_addr;
+        }
+    }
+    return SIM_ZB_UNKNOWN_SHORT_ADDR;
+}
+
+/* One hop of a frame of payload bytes through the mesh */
+static int64_t sim_zb_hop_us(uint32_t payload)
+{
+    return SIM_ZB_CSMA_US + sim_zb_frame_us(payload);
+}
+
+static void sim_zb_default_resp_cb(uint8_t slot)
+{
+    sim_zb_command_t *command = &s_commands[slot];
+    esp_zb_zcl_cmd_default_resp_message_t message = {
+        .info = {
+            .status = ESP_ZB_ZCL_STATUS_SUCCESS,
+            .header.tsn = command->tsn,
+            .src_address.u.short_addr = command->device->short_addr,
+            .dst_address = s_network.short_addr,
+            .src_endpoint = command->device->endpoint,
+            .dst_endpoint = command->src_endpoint,
+            .cluster = ESP_ZB_ZCL_CLUSTER_ID_ON_OFF,
+            .profile = ESP_ZB_AF_HA_PROFILE_ID,
+        },
+        .resp_to_cmd = command->on ? ESP_ZB_ZCL_CMD_ON_OFF_ON_ID : ESP_ZB_ZCL_CMD_ON_OFF_OFF_ID,
+        .status_code = ESP_ZB_ZCL_STATUS_SUCCESS,
+    };
+    command->active = false;
+    if (s_action_handler) {
+        s_action_handler(ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID, &message);
+    }
+}
+
+/* The command reaches the device, which answers it if it came through a binding */
+static void sim_zb_command_cb(uint8_t slot)
+{
+    sim_zb_command_t *command = &s_commands[slot];
+    sim_zb_device_t *device = command->device;
+    if (device->lose > 0) {
+        device->lose--;
+        command->active = false;
+        return;
+    }
+    device->commands++;
+    if (device->on != command->on) {
+        device->on = command->on;
+        device->changed_us = sim_now_us();
+    }
+    if (command->src_endpoint == 0) {
+        command->active = false;
+        return;
+    }
+    sim_zb_alarm_at(sim_zb_default_resp_cb, slot, sim_now_us() + SIM_ZB_DEVICE_US + device->hops * sim_zb_hop_us(SIM_ZB_DEFAULT_RESP_SIZE));
+}
+
+static void sim_zb_command_send(sim_zb_device_t *device, bool on, uint8_t tsn, uint8_t src_endpoint, int64_t arrival_us)
+{
+    for (uint8_t i = 0; i < SIM_ZB_MAX_COMMANDS; i++) {
+        if (!s_commands[i].active) {
+            s_commands[i] = (sim_zb_command_t) {
+                .device = device,
+                .on = on,
+                .tsn = tsn,
+                .src_endpoint = src_endpoint,
+                .active = true,
+            };
+            sim_zb_alarm_at(sim_zb_command_cb, i, arrival_us);
+            return;
+        }
+    }
+    fprintf(stderr, "sim: more than %d On/Off commands on their way\n", SIM_ZB_MAX_COMMANDS);
+    abort();
+}
+
+uint8_t esp_zb_zcl_on_off_cmd_req(esp_zb_zcl_on_off_cmd_t *cmd_req)
+{
+    uint8_t tsn = s_zcl_seq_num++;
+    if (cmd_req->address_mode != ESP_ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT) {
+        return tsn;
+    }
+    /* one unicast per device bound, sent one after the other */
+    int64_t sent_us = sim_now_us();
+    for (uint8_t i = 0; i < s_binding_count; i++) {
+        const sim_zb_binding_t *binding = &s_bindings[i];
+        if (binding->src_endpoint != cmd_req->zcl_basic_cmd.src_endpoint || binding->cluster_id != ESP_ZB_ZCL_CLUSTER_ID_ON_OFF) {
+            continue;
+        }
+        sim_zb_device_t *device = &s_devices[binding->device];
+        sent_us += sim_zb_hop_us(SIM_ZB_ON_OFF_SIZE);
+        sim_zb_command_send(device, cmd_req->on_off_cmd_id == ESP_ZB_ZCL_CMD_ON_OFF_ON_ID, tsn, binding->src_endpoint,
+                            sent_us + (device->hops - 1) * sim_zb_hop_us(SIM_ZB_ON_OFF_SIZE));
+    }
+    return tsn;
+}
+
+void sim_zb_coordinator_on_off(const sim_zb_frame_t *report, sim_zb_device_t *device, bool on, int64_t automation_us)
+{
+    int64_t at_coordinator_us = report->time_us + s_network.coordinator_hops * sim_zb_hop_us(report->length);
+    sim_zb_command_send(device, on, 0, 0, at_coordinator_us + automation_us + device->coordinator_hops * sim_zb_hop_us(SIM_ZB_ON_OFF_SIZE));
+}
+
+/* Mgmt_Bind_rsp of the device's own stack, from the record asked for */
+static void sim_zb_binding_table_cb(uint8_t param)
+{
+    esp_zb_zdo_binding_table_record_t records[SIM_ZB_BINDING_RECORDS];
+    esp_zb_zdo_binding_table_info_t info = {
+        .status = ESP_ZB_ZDP_STATUS_SUCCESS,
+        .index = s_binding_table_index,
+        .total = s_binding_count,
+    };
+    for (uint8_t i = s_binding_table_index; i < s_binding_count && info.count < SIM_ZB_BINDING_RECORDS; i++) {
+        const sim_zb_binding_t *binding = &s_bindings[i];
+        esp_zb_zdo_binding_table_record_t *record = &records[info.count];
+        *record = (esp_zb_zdo_binding_table_record_t) {
+            .src_endp = binding->src_endpoint,
+            .cluster_id = binding->cluster_id,
+            .dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED,
+            .dst_endp = s_devices[binding->device].endpoint,
+        };
+        memcpy(record->dst_address.addr_long, s_devices[binding->device].ieee_addr, sizeof(record->dst_address.addr_long));
+        if (info.count > 0) {
+            records[info.count - 1].next = record;
+        }
+        info.count++;
+    }
+    info.record = info.count > 0 ? records : NULL;
+    s_binding_table_cb(&info, s_binding_table_ctx);
+}
+
+void esp_zb_zdo_binding_table_req(esp_zb_zdo_mgmt_bind_param_t *cmd_req, esp_zb_zdo_binding_table_callback_t user_cb, void *user_ctx)
+{
+    s_binding_table_cb = user_cb;
+    s_binding_table_ctx = user_ctx;
+    s_binding_table_index = cmd_req->start_index;
+    /* asked of the device itself, its stack answers without a frame */
+    esp_zb_scheduler_alarm(sim_zb_binding_table_cb, 0, 0);
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Minimal unit test harness of the host build: a test is a function of
+ * assertions, an assertion that fails reports its line and ends the test.
+ *
+ *     static void test_something(void)
+ *     {
+ *         TEST_ASSERT_EQUAL(4, 2 + 2);
+ *     }
+ *
+ *     int main(void)
+ *     {
+ *         TEST_RUN(test_something);
+ *         return TEST_END();
+ *     }
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static int s_test_failures;
+static int s_test_count;
+
+#define TEST_FAIL(fmt, ...) do {                                                        \
+        fprintf(stderr, "%s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__);        \
+        s_test_failures++;                                                              \
+        return;                                                                         \
+    } while (0)
+
+#define TEST_ASSERT(cond) do {                                                          \
+        if (!(cond)) {                                                                  \
+            TEST_FAIL("%s is false", #cond);                                            \
+        }                                                                               \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) do {                                        \
+        int64_t test_expected_ = (int64_t)(expected);                                   \
+        int64_t test_actual_ = (int64_t)(actual);                                       \
+        if (test_expected_ != test_actual_) {                                           \
+            TEST_FAIL("%s is %" PRId64 ", expected %" PRId64, #actual, test_actual_, test_expected_); \
+        }                                                                               \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL_MEMORY(expected, actual, length) do {                         \
+        if (memcmp((expected), (actual), (length)) != 0) {                              \
+            TEST_FAIL("%s differs from %s", #actual, #expected);                        \
+        }                                                                               \
+    } while (0)
+
+#define TEST_RUN(test) do {                                                             \
+        int test_failures_ = s_test_failures;                                           \
+        s_test_count++;                                                                 \
+        test();                                                                         \
+        printf("%s %s\n", s_test_failures == test_failures_ ? "PASS" : "FAIL", #test);  \
+    } while (0)
+
+#define TEST_END() (printf("%d test(s), %d failure(s)\n", s_test_count, s_test_failures), s_test_failures != 0)
@@ -0,0 +1,336 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host test of attr_registry on the Zigbee stand-in, and a micro-benchmark of
+ * its dispatch against a mocked attribute list: the endpoint, cluster and
+ * attribute lists of the device as linked lists, walked the way
+ * esp_zb_zcl_get_attribute() does, and the nested switch the attribute write
+ * handler had before the registry.
+ */
+
+#include <inttypes.h>
+#include <time.h>
+#include "attr_registry.h"
+#include "esp_zb_light.h"
+#include "sim.h"
+#include "test.h"
+
+#define MOCK_MAX_ATTRS      128
+#define MOCK_MAX_CLUSTERS   24
+#define MOCK_MAX_ENDPOINTS  4
+#define BENCH_ROUNDS        100000
+
+typedef struct mock_attr_s {
+    esp_zb_zcl_attr_t attr;
+    struct mock_attr_s *next;
+} mock_attr_t;
+
+typedef struct mock_cluster_s {
+    uint16_t cluster_id;
+    uint8_t role;
+    mock_attr_t *attrs;
+    struct mock_cluster_s *next;
+} mock_cluster_t;
+
+typedef struct mock_endpoint_s {
+    uint8_t endpoint;
+    mock_cluster_t *clusters;
+    struct mock_endpoint_s *next;
+} mock_endpoint_t;
+
+/* The server clusters of the device and the attributes the stack creates for them, up to 12 per cluster */
+static const struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_ids[12];
+    uint8_t attr_count;
+} s_device[] = {
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BASIC, { 0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x4000 }, 9 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, { 0x0000 }, 1 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_GROUPS, { 0x0000 }, 1 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, { 0x0000, 0x0001, 0x0002, 0x0003, 0x0004 }, 5 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, { 0x0000, 0x4000, 0x4001, 0x4002, 0x4003 }, 5 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, { 0x0000, 0x0001, 0x000F, 0x0010, 0x0011, 0x0012, 0x0013, 0x0014,
+                                                                      0x4000 }, 9 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, { 0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0007, 0x0008, 0x000F,
+                                                                      0x4001, 0x400A, 0x400B, 0x400C }, 12 },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BASIC, { 0x0000, 0x0007 }, 2 },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, { 0x0000 }, 1 },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, { 0x0051, 0x0055, 0x006F }, 3 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BASIC, { 0x0000, 0x0007 }, 2 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, { 0x0000 }, 1 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, { 0x0000, 0x0002, 0x0003, 0x0004, 0x0008, 0x0012, 0x0014, 0x0015,
+                                                                       0x0016, 0x001B, 0x001C, 0x0029 }, 12 },
+    { BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BASIC, { 0x0000, 0x0007 }, 2 },
+    { BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, { 0x0000 }, 1 },
+    { BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, { 0x0000, 0x0001, 0x0002, 0x0003 }, 4 },
+};
+
+static mock_attr_t s_mock_attrs[MOCK_MAX_ATTRS];
+static mock_cluster_t s_mock_clusters[MOCK_MAX_CLUSTERS];
+static mock_endpoint_t s_mock_endpoints[MOCK_MAX_ENDPOINTS];
+static mock_endpoint_t *s_mock_list;
+static size_t s_mock_attr_count;
+static uint8_t s_mock_values[MOCK_MAX_ATTRS][2];
+static uint32_t s_sink;
+
+static void on_write(uint32_t index, const void *value)
+{
+    s_sink += index + *(const uint8_t *)value;
+}
+
+static void light_on_off_write(const void *value) { on_write(0, value); }
+static void light_level_write(const void *value) { on_write(1, value); }
+static void light_on_off_transition_write(const void *value) { on_write(2, value); }
+static void light_color_x_write(const void *value) { on_write(3, value); }
+static void light_color_y_write(const void *value) { on_write(4, value); }
+static void thermostat_setpoint_write(const void *value) { on_write(5, value); }
+static void thermostat_system_mode_write(const void *value) { on_write(6, value); }
+
+/* The table of esp_zb_light.c */
+static attr_registry_entry_t s_attributes[] = {
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, light_on_off_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, light_level_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_on_off_transition_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_x_write },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, light_color_y_write },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, NULL },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, thermostat_setpoint_write },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, thermostat_setpoint_write },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+      ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, thermostat_system_mode_write },
+};
+
+#define ATTRIBUTE_COUNT (sizeof(s_attributes) / sizeof(s_attributes[0]))
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+/* Link the lists of s_device, in the order the clusters are added */
+static void mock_build(void)
+{
+    size_t cluster_count = 0, endpoint_count = 0;
+    mock_endpoint_t **endpoint_next = &s_mock_list;
+    mock_cluster_t **cluster_next = NULL;
+    for (size_t i = 0; i < sizeof(s_device) / sizeof(s_device[0]); i++) {
+        if (endpoint_count == 0 || s_mock_endpoints[endpoint_count - 1].endpoint != s_device[i].endpoint) {
+            mock_endpoint_t *endpoint = &s_mock_endpoints[endpoint_count++];
+            endpoint->endpoint = s_device[i].endpoint;
+            *endpoint_next = endpoint;
+            endpoint_next = &endpoint->next;
+            cluster_next = &endpoint->clusters;
+        }
+        mock_cluster_t *cluster = &s_mock_clusters[cluster_count++];
+        cluster->cluster_id = s_device[i].cluster_id;
+        cluster->role = ESP_ZB_ZCL_CLUSTER_SERVER_ROLE;
+        *cluster_next = cluster;
+        cluster_next = &cluster->next;
+        mock_attr_t **attr_next = &cluster->attrs;
+        for (uint8_t a = 0; a < s_device[i].attr_count; a++) {
+            mock_attr_t *attr = &s_mock_attrs[s_mock_attr_count];
+            attr->attr = (esp_zb_zcl_attr_t) {
+                .id = s_device[i].attr_ids[a],
+                .manuf_code = ESP_ZB_ZCL_ATTR_NON_MANUFACTURER_SPECIFIC,
+                .data_p = s_mock_values[s_mock_attr_count],
+            };
+            s_mock_attr_count++;
+            *attr_next = attr;
+            attr_next = &attr->next;
+        }
+    }
+}
+
+/* The endpoint, cluster and attribute walk of esp_zb_zcl_get_attribute() */
+static esp_zb_zcl_attr_t *mock_get_attribute(uint8_t endpoint_id, uint16_t cluster_id, uint8_t role, uint16_t attr_id)
+{
+    for (mock_endpoint_t *endpoint = s_mock_list; endpoint; endpoint = endpoint->next) {
+        if (endpoint->endpoint != endpoint_id) {
+            continue;
+        }
+        for (mock_cluster_t *cluster = endpoint->clusters; cluster; cluster = cluster->next) {
+            if (cluster->cluster_id != cluster_id || cluster->role != role) {
+                continue;
+            }
+            for (mock_attr_t *attr = cluster->attrs; attr; attr = attr->next) {
+                if (attr->attr.id == attr_id) {
+                    return &attr->attr;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/* The attribute write handler before the registry: a switch per endpoint and cluster, an if per attribute */
+static esp_err_t switch_dispatch(const esp_zb_zcl_set_attr_value_message_t *message)
+{
+    const esp_zb_zcl_attribute_t *attribute = &message->attribute;
+    if (!attribute->data.value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    switch (message->info.dst_endpoint) {
+    case BATHROOM_LIGHT_ENDPOINT:
+        switch (message->info.cluster) {
+        case ESP_ZB_ZCL_CLUSTER_ID_ON_OFF:
+            if (attribute->id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_BOOL) {
+                light_on_off_write(attribute->data.value);
+                return ESP_OK;
+            }
+            break;
+        case ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL:
+            if (attribute->id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_U8) {
+                light_level_write(attribute->data.value);
+                return ESP_OK;
+            } else if (attribute->id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID &&
+                       attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_U16) {
+                light_on_off_transition_write(attribute->data.value);
+                return ESP_OK;
+            }
+            break;
+        case ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL:
+            if (attribute->id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_U16) {
+                light_color_x_write(attribute->data.value);
+                return ESP_OK;
+            } else if (attribute->id == ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_U16) {
+                light_color_y_write(attribute->data.value);
+                return ESP_OK;
+            }
+            break;
+        default:
+            break;
+        }
+        break;
+    case BATHROOM_THERMOSTAT_ENDPOINT:
+        if (message->info.cluster != ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT) {
+            break;
+        }
+        if ((attribute->id == ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID ||
+             attribute->id == ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID) && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_S16) {
+            thermostat_setpoint_write(attribute->data.value);
+            return ESP_OK;
+        } else if (attribute->id == ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID && attribute->data.type == ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM) {
+            thermostat_system_mode_write(attribute->data.value);
+            return ESP_OK;
+        }
+        break;
+    default:
+        break;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_zb_zcl_set_attr_value_message_t write_message(const attr_registry_entry_t *entry, void *value)
+{
+    return (esp_zb_zcl_set_attr_value_message_t) {
+        .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = entry->endpoint, .cluster = entry->cluster_id },
+        .attribute = { .id = entry->attr_id, .data = { .type = entry->attr_type, .size = 2, .value = value } },
+    };
+}
+
+static void test_init(void)
+{
+    uint16_t zero = 0;
+    mock_build();
+    for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+        const attr_registry_entry_t *entry = &s_attributes[i];
+        TEST_ASSERT_EQUAL(ESP_OK, sim_zb_attr_add(entry->endpoint, entry->cluster_id, entry->attr_id, entry->attr_type, &zero));
+        TEST_ASSERT(mock_get_attribute(entry->endpoint, entry->cluster_id, entry->cluster_role, entry->attr_id));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, attr_registry_init(s_attributes, ATTRIBUTE_COUNT));
+}
+
+static void test_find_and_dispatch(void)
+{
+    uint16_t value = 1;
+    for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+        attr_registry_entry_t *entry = &s_attributes[i];
+        TEST_ASSERT(entry->attr == esp_zb_zcl_get_attribute(entry->endpoint, entry->cluster_id, entry->cluster_role, entry->attr_id));
+        TEST_ASSERT(attr_registry_find(entry->endpoint, entry->cluster_id, entry->attr_id) == entry);
+
+        esp_zb_zcl_set_attr_value_message_t message = write_message(entry, &value);
+        TEST_ASSERT_EQUAL(entry->on_write ? ESP_OK : ESP_ERR_NOT_FOUND, attr_registry_dispatch(&message));
+        TEST_ASSERT_EQUAL(entry->on_write ? ESP_OK : ESP_ERR_NOT_FOUND, switch_dispatch(&message));
+        message.attribute.data.type = ESP_ZB_ZCL_ATTR_TYPE_8BITMAP;
+        TEST_ASSERT_EQUAL(entry->on_write ? ESP_ERR_INVALID_ARG : ESP_ERR_NOT_FOUND, attr_registry_dispatch(&message));
+    }
+    /* the same attribute id on another cluster or endpoint is not mistaken for a registered one */
+    TEST_ASSERT(!attr_registry_find(BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID));
+    TEST_ASSERT(!attr_registry_find(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID));
+    TEST_ASSERT(!attr_registry_find(BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, 0x0007));
+}
+
+static void test_dispatch_cost(void)
+{
+    struct timespec start, end;
+    uint16_t value = 1;
+    esp_zb_zcl_set_attr_value_message_t messages[ATTRIBUTE_COUNT];
+    for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+        messages[i] = write_message(&s_attributes[i], &value);
+    }
+
+    /* resolving an attribute handle: the list walk, then the registry */
+    uintptr_t found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+            const attr_registry_entry_t *entry = &s_attributes[i];
+            found += (uintptr_t)mock_get_attribute(entry->endpoint, entry->cluster_id, entry->cluster_role, entry->attr_id);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t walk_ns = elapsed_ns(&start, &end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+            const attr_registry_entry_t *entry = &s_attributes[i];
+            found += (uintptr_t)attr_registry_find(entry->endpoint, entry->cluster_id, entry->attr_id);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t find_ns = elapsed_ns(&start, &end);
+
+    /* routing a write to its handler: the nested switch, then the registry */
+    uint32_t handled = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+            handled += switch_dispatch(&messages[i]) == ESP_OK;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t switch_ns = elapsed_ns(&start, &end);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < ATTRIBUTE_COUNT; i++) {
+            handled += attr_registry_dispatch(&messages[i]) == ESP_OK;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t dispatch_ns = elapsed_ns(&start, &end);
+
+    int64_t lookups = (int64_t)BENCH_ROUNDS * ATTRIBUTE_COUNT;
+    printf("%zu attributes in %zu clusters on %d endpoints: lookup %" PRId64 " ns by list walk, %" PRId64 " ns by registry\n",
+           s_mock_attr_count, sizeof(s_device) / sizeof(s_device[0]), MOCK_MAX_ENDPOINTS, walk_ns / lookups, find_ns / lookups);
+    printf("write dispatch: %" PRId64 " ns by nested switch, %" PRId64 " ns by registry, on the host\n",
+           switch_ns / lookups, dispatch_ns / lookups);
+    TEST_ASSERT(found != 0);
+    TEST_ASSERT_EQUAL(2 * BENCH_ROUNDS * (ATTRIBUTE_COUNT - 1), handled);
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_find_and_dispatch);
+    TEST_RUN(test_dispatch_cost);
+    return TEST_END();
+}
@@ -0,0 +1,209 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of color_engine, against the float conversions of light_driver.h it replaces,
+ * over the whole input range, and a benchmark of both
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+#include "color_engine.h"
+#include "light_driver.h"
+#include "test.h"
+
+/* Largest difference per channel allowed with the float reference */
+#define COLOR_TOLERANCE     1
+/* Below this y the colours are far out of the gamut and every channel clamps, the rounding of the
+ * integer division may then cross the clamp: up to 13 steps off for y below 0x02C0 */
+#define XY_TOLERANCE_MIN_Y  0x0400
+#define XY_FULL_STEP        0x0040
+#define BENCH_ROUNDS        20
+
+static volatile uint8_t s_sink;
+
+static uint8_t to_channel(float value)
+{
+    if (value <= 0) {
+        return 0;
+    }
+    return value >= 1 ? UINT8_MAX : (uint8_t)(value * UINT8_MAX);
+}
+
+static int channel_error(color_rgb_t a, uint8_t red, uint8_t green, uint8_t blue)
+{
+    int error = abs(a.red - red);
+    error = abs(a.green - green) > error ? abs(a.green - green) : error;
+    return abs(a.blue - blue) > error ? abs(a.blue - blue) : error;
+}
+
+static void test_xy_matches_float_reference(void)
+{
+    int worst = 0;
+    for (uint32_t x = 0x0400; x <= 0xF000; x += 0x0400) {
+        for (uint32_t y = 0x0400; x + y <= 0xFFFF; y += 0x0400) {
+            float X = (float)x / y;
+            float Z = (float)(UINT16_MAX - x - y) / y;
+            float r, g, b;
+            XYZ_to_RGB(X, 1.0f, Z, r, g, b);
+            int error = channel_error(color_engine_xy_to_rgb(x, y), to_channel(r), to_channel(g), to_channel(b));
+            worst = error > worst ? error : worst;
+        }
+    }
+    TEST_ASSERT(worst <= COLOR_TOLERANCE);
+}
+
+static void test_xy_full_range(void)
+{
+    int worst = 0;
+    uint32_t points = 0, low_y_off = 0;
+    for (uint32_t x = 0; x <= UINT16_MAX; x += XY_FULL_STEP) {
+        for (uint32_t y = XY_FULL_STEP; x + y <= UINT16_MAX; y += XY_FULL_STEP) {
+            float X = (float)x / y;
+            float Z = (float)(UINT16_MAX - x - y) / y;
+            float r, g, b;
+            XYZ_to_RGB(X, 1.0f, Z, r, g, b);
+            int error = channel_error(color_engine_xy_to_rgb(x, y), to_channel(r), to_channel(g), to_channel(b));
+            points++;
+            if (y < XY_TOLERANCE_MIN_Y) {
+                low_y_off += error > COLOR_TOLERANCE;
+            } else {
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    printf("xy: %" PRIu32 " points, worst error %d from y 0x%04x, %" PRIu32 " points below it off by more\n",
+           points, worst, XY_TOLERANCE_MIN_Y, low_y_off);
+    TEST_ASSERT(worst <= COLOR_TOLERANCE);
+}
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+static void test_conversion_cost(void)
+{
+    struct timespec start, end;
+    uint32_t conversions = 0;
+    int64_t engine_ns = 0, float_ns = 0;
+
+    /* xy: the Color Control range in steps of 0x0400 */
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t x = 0x0400; x <= 0xF000; x += 0x0400) {
+            for (uint32_t y = 0x0400; x + y <= 0xFFFF; y += 0x0400) {
+                color_rgb_t rgb = color_engine_xy_to_rgb(x, y);
+                s_sink = rgb.red ^ rgb.green ^ rgb.blue;
+                conversions += round == 0;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        engine_ns += elapsed_ns(&start, &end);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t x = 0x0400; x <= 0xF000; x += 0x0400) {
+            for (uint32_t y = 0x0400; x + y <= 0xFFFF; y += 0x0400) {
+                float r, g, b;
+                XYZ_to_RGB((float)x / y, 1.0f, (float)(UINT16_MAX - x - y) / y, r, g, b);
+                s_sink = to_channel(r) ^ to_channel(g) ^ to_channel(b);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        float_ns += elapsed_ns(&start, &end);
+    }
+    double xy_engine = (double)engine_ns / BENCH_ROUNDS / conversions, xy_float = (double)float_ns / BENCH_ROUNDS / conversions;
+
+    engine_ns = float_ns = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int hue = 0; hue <= UINT8_MAX; hue++) {
+            for (int sat = 0; sat <= UINT8_MAX; sat++) {
+                color_rgb_t rgb = color_engine_hue_sat_to_rgb(hue, sat);
+                s_sink = rgb.red ^ rgb.green ^ rgb.blue;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        engine_ns += elapsed_ns(&start, &end);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int hue = 0; hue <= UINT8_MAX; hue++) {
+            for (int sat = 0; sat <= UINT8_MAX; sat++) {
+                float r, g, b;
+                HSV_to_RGB(hue, sat, UINT8_MAX, r, g, b);
+                s_sink = (uint8_t)r ^ (uint8_t)g ^ (uint8_t)b;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        float_ns += elapsed_ns(&start, &end);
+    }
+    const uint32_t hue_sat_conversions = (UINT8_MAX + 1) * (UINT8_MAX + 1);
+    printf("xy: %.1f ns per conversion, float macros %.1f ns; hue/saturation: %.1f ns, float macro %.1f ns, on the host\n",
+           xy_engine, xy_float, (double)engine_ns / BENCH_ROUNDS / hue_sat_conversions,
+           (double)float_ns / BENCH_ROUNDS / hue_sat_conversions);
+    TEST_ASSERT(conversions > 0);
+}
+
+static void test_xy_white_and_zero_y(void)
+{
+    /* D65 white point, x 0.3127 y 0.3290 */
+    color_rgb_t white = color_engine_xy_to_rgb(0x5000, 0x5439);
+    TEST_ASSERT(white.red >= 250 && white.green >= 250 && white.blue >= 250);
+    /* y = 0 does not divide by zero */
+    color_engine_xy_to_rgb(0x8000, 0);
+}
+
+static void test_hue_sat_matches_float_reference(void)
+{
+    int worst = 0;
+    for (int hue = 0; hue <= UINT8_MAX; hue++) {
+        for (int sat = 0; sat <= UINT8_MAX; sat++) {
+            float r, g, b;
+            HSV_to_RGB(hue, sat, UINT8_MAX, r, g, b);
+            int error = channel_error(color_engine_hue_sat_to_rgb(hue, sat), (uint8_t)r, (uint8_t)g, (uint8_t)b);
+            worst = error > worst ? error : worst;
+        }
+    }
+    TEST_ASSERT(worst <= COLOR_TOLERANCE);
+}
+
+static void test_hue_sat_white_and_red(void)
+{
+    color_rgb_t white = color_engine_hue_sat_to_rgb(100, 0);
+    TEST_ASSERT_EQUAL(255, white.red);
+    TEST_ASSERT_EQUAL(255, white.green);
+    TEST_ASSERT_EQUAL(255, white.blue);
+    color_rgb_t red = color_engine_hue_sat_to_rgb(0, UINT8_MAX);
+    TEST_ASSERT_EQUAL(255, red.red);
+    TEST_ASSERT_EQUAL(0, red.green);
+    TEST_ASSERT_EQUAL(0, red.blue);
+}
+
+static void test_scale(void)
+{
+    color_rgb_t color = { .red = 255, .green = 128, .blue = 0 };
+    color_rgb_t full = color_engine_scale(color, UINT8_MAX, false);
+    TEST_ASSERT_EQUAL_MEMORY(&color, &full, sizeof(color));
+    color_rgb_t half = color_engine_scale(color, 128, false);
+    TEST_ASSERT_EQUAL(128, half.red);
+    TEST_ASSERT_EQUAL(64, half.green);
+    TEST_ASSERT_EQUAL(0, half.blue);
+    color_rgb_t off = color_engine_scale(color, 0, true);
+    TEST_ASSERT_EQUAL(0, off.red);
+    TEST_ASSERT_EQUAL(0, off.green);
+    /* gamma 2.2 darkens the middle and keeps the ends */
+    color_rgb_t gamma = color_engine_scale(color, UINT8_MAX, true);
+    TEST_ASSERT_EQUAL(255, gamma.red);
+    TEST_ASSERT(gamma.green < 64);
+    TEST_ASSERT_EQUAL(0, gamma.blue);
+}
+
+int main(void)
+{
+    TEST_RUN(test_xy_matches_float_reference);
+    TEST_RUN(test_xy_full_range);
+    TEST_RUN(test_xy_white_and_zero_y);
+    TEST_RUN(test_hue_sat_matches_float_reference);
+    TEST_RUN(test_hue_sat_white_and_red);
+    TEST_RUN(test_scale);
+    TEST_RUN(test_conversion_cost);
+    return TEST_END();
+}
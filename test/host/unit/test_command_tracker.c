@@ -0,0 +1,138 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of command_tracker
+ */
+
+#include "command_tracker.h"
+#include "test.h"
+
+#define PLUG        0x1234
+#define HEATER      0x5678
+#define ENDPOINT    1
+
+static void two_targets(command_tracker_t *tracker)
+{
+    command_tracker_init(tracker, 500, 3);
+    command_tracker_add_target(tracker, PLUG, ENDPOINT);
+    command_tracker_add_target(tracker, HEATER, ENDPOINT);
+}
+
+static void test_targets(void)
+{
+    command_tracker_t tracker;
+    command_tracker_init(&tracker, 500, 3);
+    TEST_ASSERT(command_tracker_add_target(&tracker, PLUG, ENDPOINT));
+    TEST_ASSERT(!command_tracker_add_target(&tracker, PLUG, ENDPOINT));
+    TEST_ASSERT(command_tracker_add_target(&tracker, PLUG, ENDPOINT + 1));
+    for (uint16_t addr = 1; tracker.target_count < COMMAND_TRACKER_MAX_TARGETS; addr++) {
+        TEST_ASSERT(command_tracker_add_target(&tracker, addr, ENDPOINT));
+    }
+    TEST_ASSERT(!command_tracker_add_target(&tracker, HEATER, ENDPOINT));
+    command_tracker_clear_targets(&tracker);
+    TEST_ASSERT(command_tracker_add_target(&tracker, HEATER, ENDPOINT));
+}
+
+static void test_done_once_every_target_acked(void)
+{
+    command_tracker_t tracker;
+    int64_t next_ms;
+    two_targets(&tracker);
+    TEST_ASSERT_EQUAL(1500, command_tracker_sent(&tracker, 10, false, 1000));
+    TEST_ASSERT(!command_tracker_ack(&tracker, 10, PLUG, ENDPOINT));
+    /* another transaction, or a target not bound, does not count */
+    TEST_ASSERT(!command_tracker_ack(&tracker, 9, HEATER, ENDPOINT));
+    TEST_ASSERT(!command_tracker_ack(&tracker, 10, 0x9999, ENDPOINT));
+    TEST_ASSERT(command_tracker_ack(&tracker, 10, HEATER, ENDPOINT));
+    TEST_ASSERT(!tracker.pending);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_IDLE, command_tracker_poll(&tracker, 2000, &next_ms));
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_NO_DEADLINE, next_ms);
+}
+
+static void test_retry_then_failure(void)
+{
+    command_tracker_t tracker;
+    int64_t next_ms;
+    two_targets(&tracker);
+    command_tracker_sent(&tracker, 10, false, 0);
+    command_tracker_ack(&tracker, 10, PLUG, ENDPOINT);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_IDLE, command_tracker_poll(&tracker, 499, &next_ms));
+    TEST_ASSERT_EQUAL(500, next_ms);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_RETRY, command_tracker_poll(&tracker, 500, &next_ms));
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_NO_DEADLINE, next_ms);
+
+    TEST_ASSERT_EQUAL(1100, command_tracker_sent(&tracker, 11, true, 600));
+    /* the late answer to the first attempt is ignored */
+    TEST_ASSERT(!command_tracker_ack(&tracker, 10, HEATER, ENDPOINT));
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_RETRY, command_tracker_poll(&tracker, 1100, &next_ms));
+    command_tracker_sent(&tracker, 12, true, 1100);
+    TEST_ASSERT_EQUAL(3, tracker.attempts);
+    TEST_ASSERT_EQUAL(0, tracker.sent_ms);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_FAILED, command_tracker_poll(&tracker, 1600, &next_ms));
+    TEST_ASSERT(!tracker.pending);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_IDLE, command_tracker_poll(&tracker, 5000, &next_ms));
+}
+
+static void test_retry_keeps_acknowledgements(void)
+{
+    command_tracker_t tracker;
+    int64_t next_ms;
+    two_targets(&tracker);
+    command_tracker_sent(&tracker, 10, false, 0);
+    command_tracker_ack(&tracker, 10, PLUG, ENDPOINT);
+    command_tracker_poll(&tracker, 500, &next_ms);
+    command_tracker_sent(&tracker, 11, true, 500);
+    /* only the heater is still awaited */
+    TEST_ASSERT(command_tracker_ack(&tracker, 11, HEATER, ENDPOINT));
+}
+
+static void test_new_command_supersedes(void)
+{
+    command_tracker_t tracker;
+    two_targets(&tracker);
+    command_tracker_sent(&tracker, 10, false, 0);
+    command_tracker_ack(&tracker, 10, PLUG, ENDPOINT);
+    command_tracker_sent(&tracker, 20, false, 300);
+    TEST_ASSERT_EQUAL(1, tracker.attempts);
+    TEST_ASSERT_EQUAL(800, tracker.deadline_ms);
+    TEST_ASSERT(!command_tracker_ack(&tracker, 10, HEATER, ENDPOINT));
+    TEST_ASSERT(!command_tracker_ack(&tracker, 20, HEATER, ENDPOINT));
+    TEST_ASSERT(command_tracker_ack(&tracker, 20, PLUG, ENDPOINT));
+}
+
+static void test_no_target_nothing_to_wait_for(void)
+{
+    command_tracker_t tracker;
+    int64_t next_ms;
+    command_tracker_init(&tracker, 500, 3);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_NO_DEADLINE, command_tracker_sent(&tracker, 1, false, 0));
+    TEST_ASSERT(!tracker.pending);
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_IDLE, command_tracker_poll(&tracker, 10000, &next_ms));
+}
+
+static void test_target_added_while_pending(void)
+{
+    command_tracker_t tracker;
+    command_tracker_init(&tracker, 500, 3);
+    command_tracker_add_target(&tracker, PLUG, ENDPOINT);
+    command_tracker_sent(&tracker, 10, false, 0);
+    /* it did not receive the command, the next attempt brings it */
+    command_tracker_add_target(&tracker, HEATER, ENDPOINT);
+    TEST_ASSERT(!command_tracker_ack(&tracker, 10, PLUG, ENDPOINT));
+    int64_t next_ms;
+    TEST_ASSERT_EQUAL(COMMAND_TRACKER_RETRY, command_tracker_poll(&tracker, 500, &next_ms));
+    command_tracker_sent(&tracker, 11, true, 500);
+    TEST_ASSERT(command_tracker_ack(&tracker, 11, HEATER, ENDPOINT));
+}
+
+int main(void)
+{
+    TEST_RUN(test_targets);
+    TEST_RUN(test_done_once_every_target_acked);
+    TEST_RUN(test_retry_then_failure);
+    TEST_RUN(test_retry_keeps_acknowledgements);
+    TEST_RUN(test_new_command_supersedes);
+    TEST_RUN(test_no_target_nothing_to_wait_for);
+    TEST_RUN(test_target_added_while_pending);
+    return TEST_END();
+}
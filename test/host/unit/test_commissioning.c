@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of commissioning on the NVS and Zigbee stand-ins, and a simulation
+ * of coordinator outages: the time to join again once the coordinator is back
+ * and the channels scanned meanwhile, against the former retry of a full scan
+ * every second
+ */
+
+#include <inttypes.h>
+#include "commissioning.h"
+#include "join_backoff.h"
+#include "sim.h"
+#include "test.h"
+
+#define ALL_CHANNELS    0x07FFF800UL
+
+/* Active scan of one channel at the default scan duration: (2^3 + 1) superframes of 15.36 ms */
+#define SCAN_CHANNEL_MS         138
+#define COORDINATOR_CHANNEL     15
+#define COORDINATOR_PAN_ID      0x1A62
+/* The former signal handler: a full scan again 1 s after a failure */
+#define FIXED_RETRY_MS          1000
+#define SIM_STEP_US             10000
+
+typedef struct {
+    const char *name;
+    uint32_t outage_s;
+    uint8_t channel;            /* channel of the coordinator once it is back */
+} outage_t;
+
+typedef struct {
+    int64_t join_ms;            /* from the coordinator back to the device joined */
+    uint32_t attempts;
+    uint32_t channels;          /* channels scanned from the network lost to the device joined */
+} outage_result_t;
+
+static int64_t s_back_us;
+static uint8_t s_coordinator_channel;
+
+static void test_first_start_steers_on_all_channels(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, commissioning_init(ALL_CHANNELS));
+    commissioning_start();
+    sim_advance(0);
+    TEST_ASSERT_EQUAL(1, sim_zb_network()->steerings);
+    TEST_ASSERT_EQUAL(ALL_CHANNELS, sim_zb_network()->channel_mask);
+}
+
+static void test_failed_steering_is_retried_later(void)
+{
+    commissioning_steering_done(ESP_FAIL);
+    sim_advance(COMMISSIONING_FIRST_DELAY_MS / 2 * 1000LL - 1);
+    TEST_ASSERT_EQUAL(1, sim_zb_network()->steerings);
+    sim_advance(COMMISSIONING_FIRST_DELAY_MS / 2 * 1000LL + 1);
+    TEST_ASSERT_EQUAL(2, sim_zb_network()->steerings);
+}
+
+static void test_network_joined_is_saved(void)
+{
+    sim_zb_network()->channel = 15;
+    sim_zb_network()->pan_id = 0x1A62;
+    commissioning_steering_done(ESP_OK);
+    TEST_ASSERT_EQUAL(2, sim_nvs_entry_count(COMMISSIONING_NAMESPACE));
+}
+
+static void test_rejoin_starts_on_the_last_channel(void)
+{
+    /* what the signal handler does when the rejoin at reboot fails */
+    uint32_t steerings = sim_zb_network()->steerings;
+    commissioning_start();
+    sim_advance(0);
+    TEST_ASSERT_EQUAL(steerings + 1, sim_zb_network()->steerings);
+    TEST_ASSERT_EQUAL(1UL << 15, sim_zb_network()->channel_mask);
+}
+
+static void test_start_replaces_the_scheduled_attempt(void)
+{
+    uint32_t steerings = sim_zb_network()->steerings;
+    commissioning_steering_done(ESP_FAIL);
+    commissioning_start();
+    sim_advance(COMMISSIONING_MAX_DELAY_MS * 1000LL);
+    TEST_ASSERT_EQUAL(steerings + 1, sim_zb_network()->steerings);
+}
+
+static void test_next_boot_starts_on_the_last_channel(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, commissioning_init(ALL_CHANNELS));
+    commissioning_start();
+    sim_advance(0);
+    TEST_ASSERT_EQUAL(1UL << 15, sim_zb_network()->channel_mask);
+}
+
+static void test_erase_forgets_the_network(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, commissioning_erase());
+    TEST_ASSERT_EQUAL(0, sim_nvs_entry_count(COMMISSIONING_NAMESPACE));
+    TEST_ASSERT_EQUAL(ESP_OK, commissioning_init(ALL_CHANNELS));
+    commissioning_start();
+    sim_advance(0);
+    TEST_ASSERT_EQUAL(ALL_CHANNELS, sim_zb_network()->channel_mask);
+}
+
+/* Run the steerings commissioning schedules until one finds the coordinator */
+static outage_result_t steer_until_joined(void)
+{
+    outage_result_t result = { 0 };
+    for (;;) {
+        uint32_t steerings = sim_zb_network()->steerings;
+        while (sim_zb_network()->steerings == steerings) {
+            sim_advance(SIM_STEP_US);
+        }
+        uint32_t mask = sim_zb_network()->channel_mask;
+        uint32_t channels = __builtin_popcount(mask);
+        sim_advance(channels * SCAN_CHANNEL_MS * 1000LL);
+        result.attempts++;
+        result.channels += channels;
+        if (sim_now_us() >= s_back_us && (mask & 1UL << s_coordinator_channel)) {
+            sim_zb_network()->channel = s_coordinator_channel;
+            sim_zb_network()->pan_id = COORDINATOR_PAN_ID;
+            commissioning_steering_done(ESP_OK);
+            result.join_ms = (sim_now_us() - s_back_us) / 1000;
+            return result;
+        }
+        commissioning_steering_done(ESP_FAIL);
+    }
+}
+
+/* The same outage with the former strategy */
+static outage_result_t fixed_retry(const outage_t *outage)
+{
+    outage_result_t result = { 0 };
+    int64_t now_ms = 0, back_ms = outage->outage_s * 1000LL;
+    for (;;) {
+        now_ms += __builtin_popcount(ALL_CHANNELS) * SCAN_CHANNEL_MS;
+        result.attempts++;
+        result.channels += __builtin_popcount(ALL_CHANNELS);
+        if (now_ms >= back_ms) {
+            result.join_ms = now_ms - back_ms;
+            return result;
+        }
+        now_ms += FIXED_RETRY_MS;
+    }
+}
+
+static void test_coordinator_outages(void)
+{
+    static const outage_t outages[] = {
+        { "restart", 10, COORDINATOR_CHANNEL },
+        { "2 min", 120, COORDINATOR_CHANNEL },
+        { "30 min", 1800, COORDINATOR_CHANNEL },
+        { "new channel", 60, 20 },
+    };
+    /* joined once, the channel is saved */
+    s_back_us = 0;
+    s_coordinator_channel = COORDINATOR_CHANNEL;
+    commissioning_start();
+    steer_until_joined();
+
+    for (size_t i = 0; i < sizeof(outages) / sizeof(outages[0]); i++) {
+        const outage_t *outage = &outages[i];
+        s_back_us = sim_now_us() + outage->outage_s * 1000000LL;
+        s_coordinator_channel = outage->channel;
+        /* the network is lost when the coordinator goes down */
+        commissioning_start();
+        outage_result_t result = steer_until_joined();
+        outage_result_t fixed = fixed_retry(outage);
+        printf("%-11s: joined %6" PRId64 " ms after the coordinator, %3" PRIu32 " attempts, %4" PRIu32 " channels scanned; "
+               "fixed retry: %4" PRId64 " ms, %4" PRIu32 " attempts, %5" PRIu32 " channels\n", outage->name, result.join_ms,
+               result.attempts, result.channels, fixed.join_ms, fixed.attempts, fixed.channels);
+        /* the jitter only shortens the delay: the next attempt is at most a max delay away, then scans */
+        TEST_ASSERT(result.join_ms <= COMMISSIONING_MAX_DELAY_MS + __builtin_popcount(ALL_CHANNELS) * SCAN_CHANNEL_MS);
+        TEST_ASSERT(result.channels < fixed.channels);
+        TEST_ASSERT_EQUAL(outage->channel, sim_zb_network()->channel);
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(test_first_start_steers_on_all_channels);
+    TEST_RUN(test_failed_steering_is_retried_later);
+    TEST_RUN(test_network_joined_is_saved);
+    TEST_RUN(test_rejoin_starts_on_the_last_channel);
+    TEST_RUN(test_start_replaces_the_scheduled_attempt);
+    TEST_RUN(test_next_boot_starts_on_the_last_channel);
+    TEST_RUN(test_erase_forgets_the_network);
+    TEST_RUN(test_coordinator_outages);
+    return TEST_END();
+}
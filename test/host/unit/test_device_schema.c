@@ -0,0 +1,221 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host test of the device schema and its builder on the list stand-in: the
+ * endpoints, clusters and attributes esp_zcl_utility_build_ep_list() makes of
+ * device_schema are checked against the layout the firmware relies on, the
+ * length-prefixed strings against their literals, and the heap blocks the
+ * build takes and its host time are measured.
+ */
+
+#include <inttypes.h>
+#include <time.h>
+#include "device_schema.h"
+#include "diagnostics.h"
+#include "esp_zb_light.h"
+#include "ota_client.h"
+#include "sim.h"
+#include "test.h"
+#include "thermostat.h"
+
+#define BENCH_BUILDS        1000
+#define MAX_CLUSTERS        8
+
+typedef struct {
+    uint16_t cluster_id;
+    uint8_t role;
+    uint8_t attr_count;
+} cluster_layout_t;
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t device_id;
+    cluster_layout_t clusters[MAX_CLUSTERS];
+    uint8_t cluster_count;
+} ep_layout_t;
+
+#define S ESP_ZB_ZCL_CLUSTER_SERVER_ROLE
+#define C ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE
+
+static const ep_layout_t s_layout[] = {
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_HA_ON_OFF_LIGHT_DEVICE_ID, {
+        { ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, 4 }, { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, S, 1 }, { ESP_ZB_ZCL_CLUSTER_ID_GROUPS, S, 1 },
+        { ESP_ZB_ZCL_CLUSTER_ID_SCENES, S, 5 }, { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, S, 1 }, { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, S, 2 },
+        { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, S, 6 }, { ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, S, 5 } }, 8 },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_HA_CUSTOM_ATTR_DEVICE_ID, {
+        { ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, 4 }, { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, S, 1 }, { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, C, 0 },
+        { ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, S, 4 }, { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, C, 0 }, { ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, C, 4 },
+        { ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, S, 6 } }, 7 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_HA_THERMOSTAT_DEVICE_ID, {
+        { ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, 4 }, { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, S, 1 }, { ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, S, 8 } }, 3 },
+    { BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID, {
+        { ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, 4 }, { ESP_ZB_ZCL_CLUSTER_ID_IDENTIFY, S, 1 }, { ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, S, 3 } }, 3 },
+};
+
+/* Attributes the firmware reads, writes or reports, with the type it expects */
+static const struct {
+    uint8_t endpoint;
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+} s_used_attrs[] = {
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_ON_OFF_TRANSITION_TIME_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8 },
+    { BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, DIAGNOSTICS_ATTR_LATENCY_ID + LATENCY_TRACE_PATH_WRITE_TO_LED,
+      ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING },
+    { BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, ESP_ZB_ZCL_ATTR_BINARY_INPUT_PRESENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_S16 },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM },
+    { BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID,
+      ESP_ZB_ZCL_ATTR_TYPE_16BITMAP },
+    { BATHROOM_TEMPERATURE_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ESP_ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16 },
+};
+
+static esp_zb_ep_list_t *s_ep_list;
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+static const esp_zb_zcl_attr_t *find_attr(uint8_t endpoint, uint16_t cluster_id, uint8_t role, uint16_t attr_id)
+{
+    esp_zb_attribute_list_t *attr_list = esp_zb_cluster_list_get_cluster(esp_zb_ep_list_get_ep(s_ep_list, endpoint), cluster_id, role);
+    for (esp_zb_attribute_list_t *attr = attr_list ? attr_list->next : NULL; attr; attr = attr->next) {
+        if (attr->attribute.id == attr_id) {
+            return &attr->attribute;
+        }
+    }
+    return NULL;
+}
+
+/* A ZCL string attribute holds its literal with the length in front */
+static bool string_equals(const esp_zb_zcl_attr_t *attr, const char *literal)
+{
+    const uint8_t *value = attr->data_p;
+    return attr->type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING && value[0] == strlen(literal) && memcmp(&value[1], literal, value[0]) == 0;
+}
+
+static void test_build(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, esp_zcl_utility_build_ep_list(device_schema, device_schema_ep_count, &s_ep_list));
+    TEST_ASSERT(s_ep_list);
+}
+
+static void test_layout(void)
+{
+    const esp_zb_ep_list_t *ep = s_ep_list->next;
+    for (size_t e = 0; e < sizeof(s_layout) / sizeof(s_layout[0]); e++, ep = ep->next) {
+        const ep_layout_t *layout = &s_layout[e];
+        TEST_ASSERT(ep);
+        TEST_ASSERT_EQUAL(layout->endpoint, ep->config.endpoint);
+        TEST_ASSERT_EQUAL(ESP_ZB_AF_HA_PROFILE_ID, ep->config.app_profile_id);
+        TEST_ASSERT_EQUAL(layout->device_id, ep->config.app_device_id);
+        const esp_zb_cluster_list_t *cluster = ep->cluster_list->next;
+        for (uint8_t c = 0; c < layout->cluster_count; c++, cluster = cluster->next) {
+            TEST_ASSERT(cluster);
+            TEST_ASSERT_EQUAL(layout->clusters[c].cluster_id, cluster->cluster.cluster_id);
+            TEST_ASSERT_EQUAL(layout->clusters[c].role, cluster->cluster.role_mask);
+            TEST_ASSERT_EQUAL(layout->clusters[c].attr_count, cluster->cluster.attr_count);
+        }
+        TEST_ASSERT(!cluster);
+    }
+    TEST_ASSERT(!ep);
+
+    for (size_t i = 0; i < sizeof(s_used_attrs) / sizeof(s_used_attrs[0]); i++) {
+        const esp_zb_zcl_attr_t *attr = find_attr(s_used_attrs[i].endpoint, s_used_attrs[i].cluster_id, S, s_used_attrs[i].attr_id);
+        TEST_ASSERT(attr);
+        TEST_ASSERT_EQUAL(s_used_attrs[i].type, attr->type);
+    }
+}
+
+static void test_strings_and_defaults(void)
+{
+    for (size_t e = 0; e < sizeof(s_layout) / sizeof(s_layout[0]); e++) {
+        TEST_ASSERT(string_equals(find_attr(s_layout[e].endpoint, ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID),
+                                  ESP_MANUFACTURER_NAME));
+        TEST_ASSERT(string_equals(find_attr(s_layout[e].endpoint, ESP_ZB_ZCL_CLUSTER_ID_BASIC, S, ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID),
+                                  ESP_MODEL_IDENTIFIER));
+    }
+    TEST_ASSERT(string_equals(find_attr(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_BINARY_INPUT, S,
+                                        ESP_ZB_ZCL_ATTR_BINARY_INPUT_DESCRIPTION_ID), "Switch state"));
+
+    const diagnostics_histogram_attr_t *histogram = find_attr(BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_DIAGNOSTICS, S,
+                                                              DIAGNOSTICS_ATTR_LATENCY_ID + LATENCY_TRACE_PATH_WRITE_TO_LED)->data_p;
+    TEST_ASSERT_EQUAL(sizeof(histogram->data), histogram->len);
+    const esp_zb_zcl_attr_t *level = find_attr(BATHROOM_LIGHT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, S,
+                                               ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID);
+    TEST_ASSERT_EQUAL(ESP_ZB_ZCL_LEVEL_CONTROL_CURRENT_LEVEL_DEFAULT_VALUE, *(const uint8_t *)level->data_p);
+    const esp_zb_zcl_attr_t *comfort = find_attr(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, S,
+                                                 ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID);
+    TEST_ASSERT_EQUAL(THERMOSTAT_COMFORT_SETPOINT, *(const int16_t *)comfort->data_p);
+    const esp_zb_zcl_ota_upgrade_client_variable_t *ota = find_attr(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, C,
+                                                                    ESP_ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID)->data_p;
+    TEST_ASSERT_EQUAL(OTA_CLIENT_BLOCK_SIZE, ota->max_data_size);
+}
+
+static void test_build_allocations(void)
+{
+    /* the lists take a head per list, a node per endpoint and cluster and a node and a value per attribute */
+    uint32_t clusters = 0, attrs = 0, value_bytes = 0, schema_bytes = device_schema_ep_count * sizeof(zcl_utility_ep_desc_t);
+    for (uint8_t e = 0; e < device_schema_ep_count; e++) {
+        clusters += device_schema[e].cluster_count;
+        schema_bytes += device_schema[e].cluster_count * sizeof(zcl_utility_cluster_desc_t);
+        for (uint8_t c = 0; c < device_schema[e].cluster_count; c++) {
+            attrs += device_schema[e].clusters[c].attr_count;
+            schema_bytes += device_schema[e].clusters[c].attr_count * sizeof(zcl_utility_attr_desc_t);
+        }
+    }
+    for (const esp_zb_ep_list_t *ep = s_ep_list->next; ep; ep = ep->next) {
+        for (const esp_zb_cluster_list_t *cluster = ep->cluster_list->next; cluster; cluster = cluster->next) {
+            for (const esp_zb_attribute_list_t *attr = cluster->cluster.attr_list->next; attr; attr = attr->next) {
+                value_bytes += attr->attribute.type == ESP_ZB_ZCL_ATTR_TYPE_CHAR_STRING ||
+                               attr->attribute.type == ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING ? 1 + *(const uint8_t *)attr->attribute.data_p :
+                               attr->attribute.type == ESP_ZB_ZCL_ATTR_TYPE_NULL ? sizeof(esp_zb_zcl_ota_upgrade_client_variable_t) :
+                               sim_zb_attr_size(attr->attribute.type);
+            }
+        }
+    }
+    const sim_zb_list_heap_t *heap = sim_zb_list_heap();
+    uint32_t allocations = 1 + 2 * device_schema_ep_count + 2 * clusters + 2 * attrs;
+    TEST_ASSERT_EQUAL(allocations, heap->allocations);
+    TEST_ASSERT_EQUAL((1 + device_schema_ep_count) * sizeof(esp_zb_ep_list_t) + device_schema_ep_count * sizeof(esp_zb_cluster_list_t) +
+                      clusters * (sizeof(esp_zb_cluster_list_t) + sizeof(esp_zb_attribute_list_t)) +
+                      attrs * sizeof(esp_zb_attribute_list_t) + value_bytes, heap->bytes);
+    sim_zb_ep_list_free(s_ep_list);
+    TEST_ASSERT_EQUAL(0, heap->live);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_BUILDS; i++) {
+        esp_zb_ep_list_t *ep_list;
+        esp_zcl_utility_build_ep_list(device_schema, device_schema_ep_count, &ep_list);
+        sim_zb_ep_list_free(ep_list);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_EQUAL(0, heap->live);
+    TEST_ASSERT_EQUAL((BENCH_BUILDS + 1) * allocations, heap->allocations);
+
+    printf("%" PRIu8 " endpoints, %" PRIu32 " clusters, %" PRIu32 " attributes: %" PRIu32 " heap blocks, %" PRIu32 " bytes "
+           "(%" PRIu32 " of values); schema %" PRIu32 " bytes of const data; build %" PRId64 " ns on the host\n",
+           device_schema_ep_count, clusters, attrs, allocations, heap->bytes / (BENCH_BUILDS + 1), value_bytes, schema_bytes,
+           elapsed_ns(&start, &end) / BENCH_BUILDS);
+}
+
+int main(void)
+{
+    TEST_RUN(test_build);
+    TEST_RUN(test_layout);
+    TEST_RUN(test_strings_and_defaults);
+    TEST_RUN(test_build_allocations);
+    return TEST_END();
+}
@@ -0,0 +1,243 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of framebuffer, and a benchmark of the render and commit path of
+ * light_driver.c: fill the back buffer, copy its dirty regions to the front
+ * buffer, read the dirty pixels of the front buffer out to the strip
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include "framebuffer.h"
+#include "test.h"
+
+/* Three regions, the last one short */
+#define PIXELS  20
+
+#define BENCH_PIXELS_MAX    300
+#define BENCH_FRAMES        20000
+/* a status bar, the first region */
+#define BENCH_BAR_PIXELS    FRAMEBUFFER_REGION_PIXELS
+
+static const color_rgb_t s_red = { .red = 255 };
+static const color_rgb_t s_black = { 0 };
+
+typedef struct {
+    uint8_t pixels[FRAMEBUFFER_BYTES(PIXELS)];
+    uint32_t dirty[FRAMEBUFFER_DIRTY_WORDS(PIXELS)];
+    framebuffer_t fb;
+} test_framebuffer_t;
+
+static void test_framebuffer_init(test_framebuffer_t *t)
+{
+    framebuffer_init(&t->fb, t->pixels, t->dirty, PIXELS);
+}
+
+static void clean(framebuffer_t *fb)
+{
+    uint16_t first, count;
+    while (framebuffer_take_dirty(fb, &first, &count)) {
+    }
+}
+
+static void test_init_black_and_dirty(void)
+{
+    test_framebuffer_t t;
+    memset(t.pixels, 0xAA, sizeof(t.pixels));
+    test_framebuffer_init(&t);
+    TEST_ASSERT(framebuffer_is_black(&t.fb));
+    TEST_ASSERT(framebuffer_is_dirty(&t.fb));
+    uint16_t first, count;
+    TEST_ASSERT(framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT_EQUAL(FRAMEBUFFER_REGION_PIXELS, count);
+    TEST_ASSERT(framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT(framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT_EQUAL(2 * FRAMEBUFFER_REGION_PIXELS, first);
+    TEST_ASSERT_EQUAL(PIXELS - 2 * FRAMEBUFFER_REGION_PIXELS, count);
+    TEST_ASSERT(!framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT(!framebuffer_is_dirty(&t.fb));
+}
+
+static void test_unchanged_write_stays_clean(void)
+{
+    test_framebuffer_t t;
+    test_framebuffer_init(&t);
+    clean(&t.fb);
+    TEST_ASSERT(!framebuffer_fill(&t.fb, 0, PIXELS, s_black));
+    TEST_ASSERT(!framebuffer_is_dirty(&t.fb));
+}
+
+static void test_fill_marks_its_regions(void)
+{
+    test_framebuffer_t t;
+    test_framebuffer_init(&t);
+    clean(&t.fb);
+    /* pixels 6 to 9, across the first two regions */
+    TEST_ASSERT(framebuffer_fill(&t.fb, 6, 4, s_red));
+    TEST_ASSERT_EQUAL(255, framebuffer_get(&t.fb, 9).red);
+    TEST_ASSERT_EQUAL(0, framebuffer_get(&t.fb, 10).red);
+    TEST_ASSERT(!framebuffer_is_black(&t.fb));
+    uint16_t first, count;
+    TEST_ASSERT(framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT_EQUAL(0, first);
+    TEST_ASSERT(framebuffer_take_dirty(&t.fb, &first, &count));
+    TEST_ASSERT_EQUAL(FRAMEBUFFER_REGION_PIXELS, first);
+    TEST_ASSERT(!framebuffer_take_dirty(&t.fb, &first, &count));
+}
+
+static void test_fill_out_of_range_ignored(void)
+{
+    test_framebuffer_t t;
+    test_framebuffer_init(&t);
+    clean(&t.fb);
+    TEST_ASSERT(!framebuffer_fill(&t.fb, PIXELS, 5, s_red));
+    TEST_ASSERT(framebuffer_fill(&t.fb, PIXELS - 1, UINT16_MAX, s_red));
+    TEST_ASSERT_EQUAL(255, framebuffer_get(&t.fb, PIXELS - 1).red);
+}
+
+static void test_copy_dirty(void)
+{
+    test_framebuffer_t back, front;
+    test_framebuffer_init(&back);
+    test_framebuffer_init(&front);
+    clean(&back.fb);
+    clean(&front.fb);
+    framebuffer_fill(&back.fb, 17, 1, s_red);
+    TEST_ASSERT_EQUAL(1, framebuffer_copy_dirty(&front.fb, &back.fb));
+    TEST_ASSERT(!framebuffer_is_dirty(&back.fb));
+    TEST_ASSERT_EQUAL_MEMORY(back.pixels, front.pixels, sizeof(front.pixels));
+    uint16_t first, count;
+    TEST_ASSERT(framebuffer_take_dirty(&front.fb, &first, &count));
+    TEST_ASSERT_EQUAL(2 * FRAMEBUFFER_REGION_PIXELS, first);
+    TEST_ASSERT(!framebuffer_take_dirty(&front.fb, &first, &count));
+    TEST_ASSERT_EQUAL(0, framebuffer_copy_dirty(&front.fb, &back.fb));
+}
+
+static void test_mark_all_dirty(void)
+{
+    test_framebuffer_t t;
+    test_framebuffer_init(&t);
+    clean(&t.fb);
+    framebuffer_mark_all_dirty(&t.fb);
+    unsigned regions = 0;
+    uint16_t first, count;
+    while (framebuffer_take_dirty(&t.fb, &first, &count)) {
+        regions++;
+    }
+    TEST_ASSERT_EQUAL(3, regions);
+}
+
+static void test_more_than_one_dirty_word(void)
+{
+    enum { COUNT = FRAMEBUFFER_REGION_PIXELS * 40 };
+    static uint8_t pixels[FRAMEBUFFER_BYTES(COUNT)];
+    static uint32_t dirty[FRAMEBUFFER_DIRTY_WORDS(COUNT)];
+    framebuffer_t fb;
+    TEST_ASSERT_EQUAL(2, FRAMEBUFFER_DIRTY_WORDS(COUNT));
+    framebuffer_init(&fb, pixels, dirty, COUNT);
+    clean(&fb);
+    framebuffer_fill(&fb, COUNT - 1, 1, s_red);
+    uint16_t first, count;
+    TEST_ASSERT(framebuffer_take_dirty(&fb, &first, &count));
+    TEST_ASSERT_EQUAL(39 * FRAMEBUFFER_REGION_PIXELS, first);
+    TEST_ASSERT_EQUAL(FRAMEBUFFER_REGION_PIXELS, count);
+}
+
+typedef struct {
+    uint8_t back_pixels[FRAMEBUFFER_BYTES(BENCH_PIXELS_MAX)];
+    uint32_t back_dirty[FRAMEBUFFER_DIRTY_WORDS(BENCH_PIXELS_MAX)];
+    uint8_t front_pixels[FRAMEBUFFER_BYTES(BENCH_PIXELS_MAX)];
+    uint32_t front_dirty[FRAMEBUFFER_DIRTY_WORDS(BENCH_PIXELS_MAX)];
+    uint8_t strip[FRAMEBUFFER_BYTES(BENCH_PIXELS_MAX)];
+    framebuffer_t back;
+    framebuffer_t front;
+} bench_t;
+
+/* The transmit task: the dirty pixels of the front buffer, one at a time as led_strip_set_pixel() takes them */
+static uint32_t bench_send(bench_t *b)
+{
+    uint16_t first, count;
+    uint32_t sent = 0;
+    while (framebuffer_take_dirty(&b->front, &first, &count)) {
+        for (uint16_t index = first; index < first + count; index++) {
+            color_rgb_t pixel = framebuffer_get(&b->front, index);
+            b->strip[index * 3] = pixel.green;
+            b->strip[index * 3 + 1] = pixel.red;
+            b->strip[index * 3 + 2] = pixel.blue;
+            sent++;
+        }
+    }
+    return sent;
+}
+
+/**
+ * @brief Render and commit BENCH_FRAMES frames of pixels
+ *
+ * @param fill_count  Pixels redrawn per frame, from the first one
+ * @param change      The frames differ from one another, otherwise the same frame is drawn again
+ * @return Host time per frame, in ns
+ */
+static int64_t bench_run(bench_t *b, uint16_t pixels, uint16_t fill_count, bool change, uint32_t *regions, uint32_t *sent)
+{
+    framebuffer_init(&b->back, b->back_pixels, b->back_dirty, pixels);
+    framebuffer_init(&b->front, b->front_pixels, b->front_dirty, pixels);
+    framebuffer_copy_dirty(&b->front, &b->back);
+    bench_send(b);
+    *regions = 0;
+    *sent = 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t frame = 0; frame < BENCH_FRAMES; frame++) {
+        uint8_t level = change ? (uint8_t)(frame + 1) : 0x80;
+        framebuffer_fill(&b->back, 0, fill_count, (color_rgb_t) { .red = level, .green = level, .blue = level });
+        *regions += framebuffer_copy_dirty(&b->front, &b->back);
+        *sent += bench_send(b);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec) / BENCH_FRAMES;
+}
+
+static void test_render_and_commit_throughput(void)
+{
+    static bench_t b;
+    static const uint16_t sizes[] = { 1, 60, BENCH_PIXELS_MAX };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint16_t pixels = sizes[i];
+        uint32_t all_regions = (pixels + FRAMEBUFFER_REGION_PIXELS - 1) / FRAMEBUFFER_REGION_PIXELS;
+        uint32_t regions, sent;
+
+        int64_t full_ns = bench_run(&b, pixels, pixels, true, &regions, &sent);
+        TEST_ASSERT_EQUAL(all_regions * BENCH_FRAMES, regions);
+        TEST_ASSERT_EQUAL((uint32_t)pixels * BENCH_FRAMES, sent);
+        TEST_ASSERT_EQUAL(BENCH_FRAMES & 0xFF, b.strip[FRAMEBUFFER_BYTES(pixels) - 1]);
+
+        uint16_t bar = pixels < BENCH_BAR_PIXELS ? pixels : BENCH_BAR_PIXELS;
+        int64_t bar_ns = bench_run(&b, pixels, bar, true, &regions, &sent);
+        TEST_ASSERT_EQUAL(BENCH_FRAMES, regions);
+        TEST_ASSERT_EQUAL((uint32_t)bar * BENCH_FRAMES, sent);
+
+        /* the frame is drawn once, then unchanged */
+        int64_t same_ns = bench_run(&b, pixels, pixels, false, &regions, &sent);
+        TEST_ASSERT_EQUAL(all_regions, regions);
+        TEST_ASSERT_EQUAL(pixels, sent);
+
+        printf("%3" PRIu16 " pixels: %6" PRId64 " ns per full frame, %4" PRId64 " ns per status bar frame, "
+               "%4" PRId64 " ns per unchanged frame on the host\n", pixels, full_ns, bar_ns, same_ns);
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(test_init_black_and_dirty);
+    TEST_RUN(test_unchanged_write_stays_clean);
+    TEST_RUN(test_fill_marks_its_regions);
+    TEST_RUN(test_fill_out_of_range_ignored);
+    TEST_RUN(test_copy_dirty);
+    TEST_RUN(test_mark_all_dirty);
+    TEST_RUN(test_more_than_one_dirty_word);
+    TEST_RUN(test_render_and_commit_throughput);
+    return TEST_END();
+}
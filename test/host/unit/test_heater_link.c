@@ -0,0 +1,228 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the heater latency on the Zigbee stand-in: the Eco/Comfort
+ * button switches the thermostat, one heater follows through the binding table
+ * of heater_link, another one through the coordinator, as a home automation
+ * server acting on the ThermostatRunningState report does. The time from the
+ * button to each heater switching is compared, then with the server down and
+ * with a command lost on the way.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include "esp_zb_light.h"
+#include "heater_link.h"
+#include "latency_trace.h"
+#include "sim.h"
+#include "test.h"
+#include "thermostat.h"
+
+#define PRESSES             100
+#define PRESS_PERIOD_US     (60 * 1000000LL)
+#define FOLLOW_TIMEOUT_US   (10 * 1000000LL)
+#define STEP_US             1000
+#define DOWN_PRESSES        10
+/* between the two setpoints, the heating follows Comfort */
+#define ROOM_TEMPERATURE    2000
+/* The coordinator hands the report to the server over its serial link, the Zigbee integration decodes it
+ * and the automation engine sends the command back, modelled as 50 to 300 ms */
+#define AUTOMATION_MIN_US   50000
+#define AUTOMATION_MAX_US   300000
+#define COORDINATOR_HOPS    2
+/* Report Attributes: frame control, sequence number and command, then per record the attribute id and type */
+#define REPORT_HEADER_SIZE  3
+#define RECORD_HEADER_SIZE  3
+#define RUNNING_STATE_HEAT  0x0001
+
+typedef struct {
+    uint32_t count;
+    int64_t sum_us;
+    int64_t min_us;
+    int64_t max_us;
+} latency_t;
+
+static const uint8_t s_bound_ieee[8] = { 0x01, 0x00, 0x00, 0xFF, 0xFE, 0x4B, 0x12, 0x00 };
+static const uint8_t s_automated_ieee[8] = { 0x02, 0x00, 0x00, 0xFF, 0xFE, 0x4B, 0x12, 0x00 };
+/* the heater bound to the binary input endpoint, and the one switched by the server */
+static sim_zb_device_t *s_bound;
+static sim_zb_device_t *s_automated;
+static bool s_server_up = true;
+static size_t s_frames_forwarded;
+static int64_t s_press_us;
+/* button to the ThermostatRunningState report leaving the device */
+static latency_t s_report;
+static uint32_t s_rand = 0x9E3779B9;
+
+static void latency_add(latency_t *latency, int64_t latency_us)
+{
+    latency->min_us = latency->count == 0 || latency_us < latency->min_us ? latency_us : latency->min_us;
+    latency->max_us = latency_us > latency->max_us ? latency_us : latency->max_us;
+    latency->sum_us += latency_us;
+    latency->count++;
+}
+
+static uint32_t automation_rand(void)
+{
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return AUTOMATION_MIN_US + s_rand % (AUTOMATION_MAX_US - AUTOMATION_MIN_US + 1);
+}
+
+/* What esp_zb_light.c does with the Default Responses */
+static esp_err_t action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
+{
+    return callback_id == ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID ? heater_link_handle_default_response(message) : ESP_OK;
+}
+
+/* Have the server switch its heater on each ThermostatRunningState report sent since the last call */
+static void forward_reports(void)
+{
+    for (; s_frames_forwarded < sim_zb_frame_count(); s_frames_forwarded++) {
+        const sim_zb_frame_t *frame = sim_zb_frame(s_frames_forwarded);
+        if (frame->src_endpoint != BATHROOM_THERMOSTAT_ENDPOINT || frame->cluster_id != ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT) {
+            continue;
+        }
+        for (uint32_t offset = REPORT_HEADER_SIZE; offset + RECORD_HEADER_SIZE <= frame->length;
+             offset += RECORD_HEADER_SIZE + sim_zb_attr_size(frame->asdu[offset + 2])) {
+            uint16_t attr_id = frame->asdu[offset] | frame->asdu[offset + 1] << 8;
+            if (attr_id != ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID) {
+                continue;
+            }
+            latency_add(&s_report, frame->time_us - s_press_us);
+            if (s_server_up) {
+                sim_zb_coordinator_on_off(frame, s_automated, frame->asdu[offset + RECORD_HEADER_SIZE] & RUNNING_STATE_HEAT,
+                                          automation_rand());
+            }
+        }
+    }
+}
+
+/* Switch Comfort on or off, as the button does once settled, and time the heaters that follow */
+static void press(bool occupied, latency_t *bound, latency_t *automated)
+{
+    int64_t start_us = sim_now_us();
+    s_press_us = start_us;
+    latency_trace_point(LATENCY_TRACE_BUTTON_EDGE);
+    thermostat_set_occupied(occupied);
+    while (sim_now_us() - start_us < FOLLOW_TIMEOUT_US && (s_bound->on != occupied || (s_server_up && s_automated->on != occupied))) {
+        sim_advance(STEP_US);
+        forward_reports();
+    }
+    if (s_bound->on == occupied && s_bound->changed_us >= start_us) {
+        latency_add(bound, s_bound->changed_us - start_us);
+    }
+    if (s_automated->on == occupied && s_automated->changed_us >= start_us) {
+        latency_add(automated, s_automated->changed_us - start_us);
+    }
+    sim_advance(PRESS_PERIOD_US - (sim_now_us() - start_us));
+    forward_reports();
+    sim_zb_frames_clear();
+    s_frames_forwarded = 0;
+}
+
+static void test_init(void)
+{
+    int16_t temperature = ROOM_TEMPERATURE, comfort = THERMOSTAT_COMFORT_SETPOINT, eco = THERMOSTAT_ECO_SETPOINT;
+    uint8_t zero = 0, heat = ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT;
+    uint16_t running_state = 0;
+    const struct {
+        uint16_t attr_id;
+        uint8_t type;
+        const void *value;
+    } attrs[] = {
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &temperature },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP, &zero },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, &zero },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &comfort },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &eco },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, &heat },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, ESP_ZB_ZCL_ATTR_TYPE_16BITMAP, &running_state },
+    };
+    for (size_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, sim_zb_attr_add(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, attrs[i].attr_id,
+                                                  attrs[i].type, attrs[i].value));
+    }
+
+    /* both heaters in the same room, one hop away, the coordinator further */
+    sim_zb_network()->short_addr = 0x4A21;
+    sim_zb_network()->coordinator_hops = COORDINATOR_HOPS;
+    s_bound = sim_zb_device_add(0x7C10, s_bound_ieee, 1);
+    s_automated = sim_zb_device_add(0x7C11, s_automated_ieee, 1);
+    TEST_ASSERT(s_bound && s_automated);
+    s_bound->coordinator_hops = COORDINATOR_HOPS;
+    s_automated->coordinator_hops = COORDINATOR_HOPS;
+    TEST_ASSERT_EQUAL(ESP_OK, sim_zb_bind(BATHROOM_BINARY_INPUT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, s_bound));
+
+    esp_zb_core_action_handler_register(action_handler);
+    latency_trace_init();
+    heater_link_init();
+    TEST_ASSERT_EQUAL(ESP_OK, thermostat_init(false));
+
+    /* the binding table is read and the heater told the state right after joining */
+    heater_link_network_ready();
+    sim_advance(PRESS_PERIOD_US);
+    TEST_ASSERT_EQUAL(1, s_bound->commands);
+    TEST_ASSERT(!s_bound->on);
+    TEST_ASSERT_EQUAL(0, s_automated->commands);
+    sim_zb_frames_clear();
+}
+
+static void test_direct_against_coordinator(void)
+{
+    latency_t bound = { 0 }, automated = { 0 };
+    s_report = (latency_t) { 0 };
+    for (uint32_t i = 0; i < PRESSES; i++) {
+        press(i % 2 == 0, &bound, &automated);
+    }
+
+    latency_trace_histogram_t ack;
+    latency_trace_get_histogram(LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK, &ack);
+    printf("binding: heater switched in %.1f ms on average, %.1f to %.1f ms, acknowledged within %.1f ms\n",
+           bound.sum_us / 1000.0 / bound.count, bound.min_us / 1000.0, bound.max_us / 1000.0, ack.max_us / 1000.0);
+    printf("coordinator: heater switched in %.1f ms on average, %.1f to %.1f ms, of which %.1f ms until the report was sent\n",
+           automated.sum_us / 1000.0 / automated.count, automated.min_us / 1000.0, automated.max_us / 1000.0,
+           s_report.sum_us / 1000.0 / s_report.count);
+    TEST_ASSERT_EQUAL(PRESSES, bound.count);
+    TEST_ASSERT_EQUAL(PRESSES, automated.count);
+    TEST_ASSERT_EQUAL(PRESSES, ack.count);
+    TEST_ASSERT(bound.max_us < automated.min_us);
+}
+
+static void test_server_down(void)
+{
+    latency_t bound = { 0 }, automated = { 0 };
+    s_server_up = false;
+    for (uint32_t i = 0; i < DOWN_PRESSES; i++) {
+        press(i % 2 == 0, &bound, &automated);
+    }
+    s_server_up = true;
+    printf("server down: %" PRIu32 " of %d presses followed through the binding, %" PRIu32 " through the coordinator\n",
+           bound.count, DOWN_PRESSES, automated.count);
+    TEST_ASSERT_EQUAL(DOWN_PRESSES, bound.count);
+    TEST_ASSERT_EQUAL(0, automated.count);
+}
+
+static void test_lost_command_is_repeated(void)
+{
+    latency_t bound = { 0 }, automated = { 0 };
+    uint32_t commands = s_bound->commands;
+    s_bound->lose = 1;
+    press(true, &bound, &automated);
+    printf("command lost: heater switched after %.1f ms through the binding, %.1f ms through the coordinator\n",
+           bound.max_us / 1000.0, automated.max_us / 1000.0);
+    TEST_ASSERT_EQUAL(1, bound.count);
+    TEST_ASSERT(bound.max_us >= HEATER_LINK_ACK_TIMEOUT_MS * 1000LL);
+    TEST_ASSERT(bound.max_us < HEATER_LINK_ACK_TIMEOUT_MS * 1000LL + automated.min_us);
+    TEST_ASSERT_EQUAL(commands + 1, s_bound->commands);
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_direct_against_coordinator);
+    TEST_RUN(test_server_down);
+    TEST_RUN(test_lost_command_is_repeated);
+    return TEST_END();
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of join_backoff
+ */
+
+#include "join_backoff.h"
+#include "test.h"
+
+#define ALL_CHANNELS    0x07FFF800UL
+
+static const join_backoff_config_t s_config = {
+    .all_channels_mask = ALL_CHANNELS,
+    .last_channel_tries = 2,
+    .first_delay_ms = 1000,
+    .max_delay_ms = 300000,
+};
+
+static void test_first_join_scans_all_channels(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, JOIN_BACKOFF_NO_CHANNEL);
+    join_backoff_attempt_t attempt = join_backoff_start(&jb);
+    TEST_ASSERT_EQUAL(ALL_CHANNELS, attempt.channel_mask);
+    TEST_ASSERT_EQUAL(0, attempt.delay_ms);
+    TEST_ASSERT_EQUAL(16, jb.channels_scanned);
+}
+
+static void test_last_channel_is_tried_alone_first(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, 15);
+    TEST_ASSERT_EQUAL(1UL << 15, join_backoff_start(&jb).channel_mask);
+    TEST_ASSERT_EQUAL(1UL << 15, join_backoff_failed(&jb, 0).channel_mask);
+    TEST_ASSERT_EQUAL(ALL_CHANNELS, join_backoff_failed(&jb, 0).channel_mask);
+    TEST_ASSERT_EQUAL(3, jb.attempts);
+    TEST_ASSERT_EQUAL(1 + 1 + 16, jb.channels_scanned);
+}
+
+static void test_last_channel_outside_the_mask_is_ignored(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, 5);
+    TEST_ASSERT_EQUAL(ALL_CHANNELS, join_backoff_start(&jb).channel_mask);
+}
+
+static void test_delay_doubles_up_to_max(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, JOIN_BACKOFF_NO_CHANNEL);
+    join_backoff_start(&jb);
+    /* random 0 gives the fixed half of the delay */
+    uint32_t expected_ms = 1000;
+    for (int failure = 1; failure <= 20; failure++) {
+        TEST_ASSERT_EQUAL(expected_ms / 2, join_backoff_failed(&jb, 0).delay_ms);
+        expected_ms = expected_ms * 2 < s_config.max_delay_ms ? expected_ms * 2 : s_config.max_delay_ms;
+    }
+}
+
+static void test_jitter_stays_within_the_delay(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, JOIN_BACKOFF_NO_CHANNEL);
+    join_backoff_start(&jb);
+    join_backoff_failed(&jb, 0);
+    join_backoff_failed(&jb, 0);
+    /* third failure, 4 s delay */
+    join_backoff_t saved = jb;
+    TEST_ASSERT_EQUAL(4000, join_backoff_failed(&jb, 2000).delay_ms);
+    jb = saved;
+    TEST_ASSERT_EQUAL(2000, join_backoff_failed(&jb, 2001).delay_ms);
+    jb = saved;
+    TEST_ASSERT_EQUAL(3234, join_backoff_failed(&jb, 1234).delay_ms);
+    for (uint32_t random = 0; random < 100000; random += 7) {
+        jb = saved;
+        uint32_t delay_ms = join_backoff_failed(&jb, random * 2654435761u).delay_ms;
+        TEST_ASSERT(delay_ms >= 2000 && delay_ms <= 4000);
+    }
+}
+
+static void test_join_resets_the_backoff(void)
+{
+    join_backoff_t jb;
+    join_backoff_init(&jb, &s_config, JOIN_BACKOFF_NO_CHANNEL);
+    join_backoff_start(&jb);
+    for (int failure = 0; failure < 10; failure++) {
+        join_backoff_failed(&jb, 0);
+    }
+    join_backoff_joined(&jb, 20);
+    TEST_ASSERT_EQUAL(0, jb.failures);
+    /* the network is lost again */
+    join_backoff_attempt_t attempt = join_backoff_start(&jb);
+    TEST_ASSERT_EQUAL(1UL << 20, attempt.channel_mask);
+    TEST_ASSERT_EQUAL(0, attempt.delay_ms);
+    TEST_ASSERT_EQUAL(1, jb.attempts);
+    TEST_ASSERT_EQUAL(500, join_backoff_failed(&jb, 0).delay_ms);
+}
+
+int main(void)
+{
+    TEST_RUN(test_first_join_scans_all_channels);
+    TEST_RUN(test_last_channel_is_tried_alone_first);
+    TEST_RUN(test_last_channel_outside_the_mask_is_ignored);
+    TEST_RUN(test_delay_doubles_up_to_max);
+    TEST_RUN(test_jitter_stays_within_the_delay);
+    TEST_RUN(test_join_resets_the_backoff);
+    return TEST_END();
+}
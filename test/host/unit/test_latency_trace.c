@@ -0,0 +1,208 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of latency_trace on the simulated clock: the paths closed into the
+ * histograms, the raw events of latency_trace_dump() read back by
+ * tools/trace_dump.py against the histograms of the device, across the wrap of
+ * the 32-bit timestamps, the decoding of a histogram attribute by the same tool,
+ * and the host time of a trace point.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "latency_trace.h"
+#include "sim.h"
+#include "test.h"
+
+#define ROUNDS              10
+#define BENCH_POINTS        1000000
+
+/* as printed by tools/trace_dump.py */
+static const char *const s_path_names[LATENCY_TRACE_PATH_COUNT] = {
+    [LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET] = "edge_to_attr_set",
+    [LATENCY_TRACE_PATH_EDGE_TO_REPORT] = "edge_to_report",
+    [LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE] = "edge_to_debounce",
+    [LATENCY_TRACE_PATH_WRITE_TO_LED] = "write_to_led",
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND] = "edge_to_command",
+    [LATENCY_TRACE_PATH_EDGE_TO_COMMAND_ACK] = "edge_to_command_ack",
+};
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t bins[LATENCY_TRACE_BINS];
+} tool_histogram_t;
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+static void point_at(int64_t at_us, latency_trace_point_t point)
+{
+    sim_advance(at_us - sim_now_us());
+    latency_trace_point(point);
+}
+
+static int bin_of_bound(uint32_t bound_us)
+{
+    int bin = 0;
+    while (((uint32_t)LATENCY_TRACE_BIN0_US << bin) < bound_us) {
+        bin++;
+    }
+    return bin;
+}
+
+/* Parse the output of tools/trace_dump.py into one histogram per name, found counts the histograms read */
+static void run_tool(const char *arguments, const char *const *names, int name_count, tool_histogram_t *out, int *found)
+{
+    char command[512];
+    snprintf(command, sizeof(command), "%s %s", TRACE_DUMP_COMMAND, arguments);
+    FILE *tool = popen(command, "r");
+    TEST_ASSERT(tool);
+    char line[160];
+    int current = -1;
+    *found = 0;
+    while (fgets(line, sizeof(line), tool)) {
+        char name[32];
+        unsigned count, bound, n, max_us = 0;
+        int fields = sscanf(line, "%31[a-z_]: %u samples, max %u us", name, &count, &max_us);
+        if (fields >= 2) {
+            current = -1;
+            for (int i = 0; i < name_count; i++) {
+                if (strcmp(name, names[i]) == 0) {
+                    current = i;
+                    out[i].count = count;
+                    out[i].max_us = max_us;
+                    (*found)++;
+                }
+            }
+        } else if (current >= 0 && sscanf(line, " < %u us %u", &bound, &n) == 2) {
+            out[current].bins[bin_of_bound(bound)] = n;
+        } else if (current >= 0 && sscanf(line, " >= %u us %u", &bound, &n) == 2) {
+            out[current].bins[LATENCY_TRACE_BINS - 1] = n;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, pclose(tool));
+}
+
+static void test_paths_into_histograms(void)
+{
+    latency_trace_init();
+    /* the 32-bit timestamps of the dump wrap in the middle of the rounds */
+    sim_advance(((int64_t)1 << 32) - 2000000 - sim_now_us());
+
+    FILE *log = fopen(LATENCY_TRACE_LOG_FILE, "w");
+    TEST_ASSERT(log);
+    int64_t at_us = sim_now_us();
+    for (int round = 0; round < ROUNDS; round++) {
+        /* 6 events a round, the 60 of them fit in the ring */
+        int64_t debounce_us = 5000 + 3000 * round;
+        point_at(at_us, LATENCY_TRACE_BUTTON_EDGE);
+        point_at(at_us + debounce_us, LATENCY_TRACE_DEBOUNCE_DONE);
+        point_at(at_us + debounce_us + 200, LATENCY_TRACE_ATTR_SET);
+        point_at(at_us + debounce_us + (1000 << round), LATENCY_TRACE_REPORT_REQUEST);
+        at_us = sim_now_us() + 100000;
+        point_at(at_us, LATENCY_TRACE_ATTR_CALLBACK);
+        point_at(at_us + (100 << round), LATENCY_TRACE_LED_REFRESH);
+        at_us = sim_now_us() + 300000;
+    }
+    sim_log_to(log);
+    latency_trace_dump();
+    sim_log_to(NULL);
+    fclose(log);
+
+    latency_trace_histogram_t histograms[LATENCY_TRACE_PATH_COUNT];
+    for (int path = 0; path < LATENCY_TRACE_PATH_COUNT; path++) {
+        latency_trace_get_histogram(path, &histograms[path]);
+    }
+    TEST_ASSERT_EQUAL(ROUNDS, histograms[LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE].count);
+    TEST_ASSERT_EQUAL(5000 + 3000 * (ROUNDS - 1), histograms[LATENCY_TRACE_PATH_EDGE_TO_DEBOUNCE].max_us);
+    TEST_ASSERT_EQUAL(ROUNDS, histograms[LATENCY_TRACE_PATH_EDGE_TO_ATTR_SET].count);
+    TEST_ASSERT_EQUAL(ROUNDS, histograms[LATENCY_TRACE_PATH_EDGE_TO_REPORT].count);
+    TEST_ASSERT_EQUAL(5000 + 3000 * (ROUNDS - 1) + (1000 << (ROUNDS - 1)), histograms[LATENCY_TRACE_PATH_EDGE_TO_REPORT].max_us);
+    TEST_ASSERT_EQUAL(0, histograms[LATENCY_TRACE_PATH_EDGE_TO_COMMAND].count);
+    /* one write per bin from 100 us (< 128 us) to 51.2 ms (< 65.5 ms) */
+    const latency_trace_histogram_t *write = &histograms[LATENCY_TRACE_PATH_WRITE_TO_LED];
+    TEST_ASSERT_EQUAL(ROUNDS, write->count);
+    for (int bin = 0; bin < LATENCY_TRACE_BINS; bin++) {
+        TEST_ASSERT_EQUAL(bin < ROUNDS ? 1 : 0, write->bins[bin]);
+    }
+
+    /* the same histograms rebuilt on the host from the raw events */
+    tool_histogram_t tool[LATENCY_TRACE_PATH_COUNT] = { 0 };
+    int found = 0;
+    run_tool(LATENCY_TRACE_LOG_FILE, s_path_names, LATENCY_TRACE_PATH_COUNT, tool, &found);
+    TEST_ASSERT_EQUAL(LATENCY_TRACE_PATH_COUNT, found);
+    for (int path = 0; path < LATENCY_TRACE_PATH_COUNT; path++) {
+        TEST_ASSERT_EQUAL(histograms[path].count, tool[path].count);
+        for (int bin = 0; bin < LATENCY_TRACE_BINS; bin++) {
+            TEST_ASSERT_EQUAL(histograms[path].bins[bin], tool[path].bins[bin]);
+        }
+    }
+    printf("trace_dump.py: %d paths, %" PRIu32 " latencies rebuilt from %d events, timestamps wrapped at %" PRId64 " us\n",
+           LATENCY_TRACE_PATH_COUNT, latency_trace_sample_count(), 6 * ROUNDS, (int64_t)1 << 32);
+}
+
+static void test_histogram_attribute_decoded(void)
+{
+    latency_trace_histogram_t histogram;
+    latency_trace_get_histogram(LATENCY_TRACE_PATH_EDGE_TO_REPORT, &histogram);
+
+    /* the octet string of diagnostics.c, without its length byte */
+    char arguments[16 + 2 * (2 * LATENCY_TRACE_BINS + 4) + 1] = "--attr ";
+    char *hex = arguments + strlen(arguments);
+    for (int i = 0; i < LATENCY_TRACE_BINS; i++) {
+        hex += sprintf(hex, "%02x%02x", histogram.bins[i] & 0xFF, histogram.bins[i] >> 8);
+    }
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+        hex += sprintf(hex, "%02x", (unsigned)(histogram.max_us >> (8 * i)) & 0xFF);
+    }
+
+    static const char *const names[] = { "attribute" };
+    tool_histogram_t tool = { 0 };
+    int found = 0;
+    run_tool(arguments, names, 1, &tool, &found);
+    TEST_ASSERT_EQUAL(1, found);
+    TEST_ASSERT_EQUAL(histogram.count, tool.count);
+    TEST_ASSERT_EQUAL(histogram.max_us, tool.max_us);
+    for (int bin = 0; bin < LATENCY_TRACE_BINS; bin++) {
+        TEST_ASSERT_EQUAL(histogram.bins[bin], tool.bins[bin]);
+    }
+}
+
+static void test_cost_per_trace_point(void)
+{
+    struct timespec start, end;
+    /* no path, as latency_trace_init() times it on the device: the ring write and the path scan */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_POINTS; i++) {
+        latency_trace_point(LATENCY_TRACE_POINT_COUNT);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t idle_ns = elapsed_ns(&start, &end);
+
+    /* every point opens or closes a path into a histogram */
+    uint32_t samples = latency_trace_sample_count();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_POINTS / 2; i++) {
+        latency_trace_point(LATENCY_TRACE_ATTR_CALLBACK);
+        latency_trace_point(LATENCY_TRACE_LED_REFRESH);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t path_ns = elapsed_ns(&start, &end);
+    TEST_ASSERT_EQUAL(BENCH_POINTS / 2, latency_trace_sample_count() - samples);
+
+    printf("trace point: %" PRId64 " ns outside any path, %" PRId64 " ns opening or closing one, on the host\n",
+           idle_ns / BENCH_POINTS, path_ns / BENCH_POINTS);
+}
+
+int main(void)
+{
+    TEST_RUN(test_paths_into_histograms);
+    TEST_RUN(test_histogram_attribute_decoded);
+    TEST_RUN(test_cost_per_trace_point);
+    return TEST_END();
+}
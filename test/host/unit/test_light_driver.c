@@ -0,0 +1,148 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of the render loop of light_driver on the esp_timer, FreeRTOS
+ * and led_strip stand-ins: the frames a fade sends to the strip are recorded
+ * with their time, and the host time of a frame sent, of a frame rendered
+ * unchanged and of an idle frame period is measured. The frames sent include the
+ * switch to the transmit task, a thread hand-off in the simulation.
+ */
+
+#include <inttypes.h>
+#include <time.h>
+#include "latency_trace.h"
+#include "light_driver.h"
+#include "sim.h"
+#include "test.h"
+
+#define FADE_MS             1000
+#define FADE_FRAMES         (FADE_MS * 1000 / LIGHT_DRIVER_FRAME_PERIOD_US)
+/* a fade of a few steps over many frames */
+#define SLOW_FADE_MS        2000
+#define SLOW_FADE_FROM      100
+#define SLOW_FADE_TO        104
+#define BENCH_FADES         20
+#define BENCH_IDLE_PERIODS  1000
+
+static const light_driver_state_t s_off = { .power = false, .level = UINT8_MAX, .color_x = 0x5000, .color_y = 0x5439 };
+static const light_driver_state_t s_white = { .power = true, .level = UINT8_MAX, .color_x = 0x5000, .color_y = 0x5439 };
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+static void test_init(void)
+{
+    latency_trace_init();
+    light_driver_init(false);
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    TEST_ASSERT_EQUAL(0, sim_led_strip_get()->pixels[0][1]);
+}
+
+static void test_fade_is_rendered_at_the_frame_rate(void)
+{
+    sim_led_strip_frames_clear();
+    int64_t start_us = sim_now_us();
+    light_driver_fade_to_state(&s_white, FADE_MS);
+    sim_advance(FADE_MS * 1000LL + 10 * LIGHT_DRIVER_FRAME_PERIOD_US);
+
+    size_t frames = sim_led_strip_frame_count();
+    printf("fade over %d ms: %zu frames, the first after %" PRId64 " us, the last after %" PRId64 " us\n", FADE_MS, frames,
+           sim_led_strip_frame(0)->time_us - start_us, sim_led_strip_frame(frames - 1)->time_us - start_us);
+    /* the frame at the start of the fade is still black, then one frame per period up to the target */
+    TEST_ASSERT_EQUAL(FADE_FRAMES, frames);
+    for (size_t i = 1; i < frames; i++) {
+        const sim_led_strip_frame_t *frame = sim_led_strip_frame(i);
+        TEST_ASSERT_EQUAL(LIGHT_DRIVER_FRAME_PERIOD_US, frame->time_us - sim_led_strip_frame(i - 1)->time_us);
+        TEST_ASSERT(frame->pixels[0][1] > sim_led_strip_frame(i - 1)->pixels[0][1]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(sim_led_strip_get()->pixels[0], sim_led_strip_frame(frames - 1)->pixels[0], 3);
+    TEST_ASSERT(sim_led_strip_get()->pixels[0][1] >= 250);
+
+    /* idle: the frame timer is stopped, nothing runs */
+    uint64_t events = sim_event_count();
+    sim_advance(10 * 1000000LL);
+    TEST_ASSERT_EQUAL(events, sim_event_count());
+    TEST_ASSERT_EQUAL(frames, sim_led_strip_frame_count());
+}
+
+static void test_slow_fade_skips_unchanged_frames(void)
+{
+    light_driver_state_t state = s_white;
+    state.level = SLOW_FADE_FROM;
+    light_driver_set_state(&state);
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    sim_led_strip_frames_clear();
+    uint64_t events = sim_event_count();
+
+    state.level = SLOW_FADE_TO;
+    light_driver_fade_to_state(&state, SLOW_FADE_MS);
+    sim_advance(SLOW_FADE_MS * 1000LL + 10 * LIGHT_DRIVER_FRAME_PERIOD_US);
+    uint64_t rendered = sim_event_count() - events;
+    printf("fade of %d levels over %d ms: %" PRIu64 " frames rendered, %zu sent\n", SLOW_FADE_TO - SLOW_FADE_FROM, SLOW_FADE_MS,
+           rendered, sim_led_strip_frame_count());
+    TEST_ASSERT(rendered >= SLOW_FADE_MS * 1000 / LIGHT_DRIVER_FRAME_PERIOD_US);
+    /* one frame per distinct colour, at most one per level step and channel */
+    TEST_ASSERT(sim_led_strip_frame_count() <= 3 * (SLOW_FADE_TO - SLOW_FADE_FROM));
+}
+
+static void test_cpu_time_per_frame(void)
+{
+    struct timespec start, end;
+    uint32_t refreshes = sim_led_strip_get()->refreshes;
+    uint64_t events = sim_event_count();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_FADES; i++) {
+        light_driver_fade_to_state(i % 2 == 0 ? &s_off : &s_white, FADE_MS);
+        for (int frame = 0; frame < FADE_FRAMES + 1; frame++) {
+            sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t rendered = sim_event_count() - events;
+    int64_t fade_ns = elapsed_ns(&start, &end);
+    refreshes = sim_led_strip_get()->refreshes - refreshes;
+
+    /* the same number of frames, a few levels apart: rendered, but unchanged frames are not committed */
+    light_driver_state_t state = s_white;
+    state.level = SLOW_FADE_FROM;
+    light_driver_set_state(&state);
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    state.level = SLOW_FADE_TO;
+    uint32_t slow_refreshes = sim_led_strip_get()->refreshes;
+    events = sim_event_count();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    light_driver_fade_to_state(&state, BENCH_FADES * FADE_MS);
+    for (int frame = 0; frame < BENCH_FADES * FADE_FRAMES + 1; frame++) {
+        sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t slow_rendered = sim_event_count() - events;
+    int64_t slow_ns = elapsed_ns(&start, &end);
+    slow_refreshes = sim_led_strip_get()->refreshes - slow_refreshes;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_IDLE_PERIODS; i++) {
+        sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t idle_ns = elapsed_ns(&start, &end);
+
+    printf("%" PRIu64 " frames rendered, %" PRIu32 " sent: %" PRId64 " ns per frame with the transmit task\n",
+           rendered, refreshes, fade_ns / (int64_t)rendered);
+    printf("%" PRIu64 " frames rendered, %" PRIu32 " sent: %" PRId64 " ns per frame; %" PRId64 " ns per idle frame period, "
+           "on the host\n", slow_rendered, slow_refreshes, slow_ns / (int64_t)slow_rendered, idle_ns / BENCH_IDLE_PERIODS);
+    TEST_ASSERT_EQUAL(BENCH_FADES * FADE_FRAMES, rendered);
+    TEST_ASSERT_EQUAL(BENCH_FADES * FADE_FRAMES, slow_rendered);
+    TEST_ASSERT(slow_refreshes <= 3 * (SLOW_FADE_TO - SLOW_FADE_FROM));
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_fade_is_rendered_at_the_frame_rate);
+    TEST_RUN(test_slow_fade_skips_unchanged_frames);
+    TEST_RUN(test_cpu_time_per_frame);
+    return TEST_END();
+}
@@ -0,0 +1,151 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of light_scenes on the NVS and Zigbee stand-ins: the saved scenes
+ * are handed back to the stack at boot, without those removed in between
+ */
+
+#include "esp_zb_light.h"
+#include "light_scenes.h"
+#include "light_state.h"
+#include "scene_table.h"
+#include "sim.h"
+#include "test.h"
+
+typedef struct {
+    uint16_t cluster_id;
+    uint16_t attr_id;
+    uint8_t type;
+    uint16_t initial;
+} attr_t;
+
+static const attr_t s_attrs[] = {
+    { ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0 },
+    { ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, 255 },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_X_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, 0x616B },
+    { ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_Y_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, 0x607D },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_SCENE_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, 0 },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_CURRENT_GROUP_ID, ESP_ZB_ZCL_ATTR_TYPE_U16, 0 },
+    { ESP_ZB_ZCL_CLUSTER_ID_SCENES, ESP_ZB_ZCL_ATTR_SCENES_SCENE_VALID_ID, ESP_ZB_ZCL_ATTR_TYPE_BOOL, 0 },
+};
+
+/* What a reboot does to the scenes: the stack comes back with an empty table and the saved ones are restored */
+static void reboot(void)
+{
+    sim_zb_scenes_clear();
+    TEST_ASSERT_EQUAL(ESP_OK, light_scenes_init());
+}
+
+static void store(uint16_t group_id, uint8_t scene_id, uint8_t level)
+{
+    light_state_stage_power(true);
+    light_state_stage_level(level);
+    esp_zb_zcl_store_scene_message_t message = {
+        .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = BATHROOM_LIGHT_ENDPOINT },
+        .group_id = group_id,
+        .scene_id = scene_id,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, light_scenes_store(&message));
+}
+
+static esp_err_t recall(uint16_t group_id, uint8_t scene_id)
+{
+    esp_zb_zcl_recall_scene_message_t message = {
+        .info = { .status = ESP_ZB_ZCL_STATUS_SUCCESS, .dst_endpoint = BATHROOM_LIGHT_ENDPOINT },
+        .group_id = group_id,
+        .scene_id = scene_id,
+    };
+    return light_scenes_recall(&message);
+}
+
+static void test_setup(void)
+{
+    for (size_t i = 0; i < sizeof(s_attrs) / sizeof(s_attrs[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, sim_zb_attr_add(BATHROOM_LIGHT_ENDPOINT, s_attrs[i].cluster_id, s_attrs[i].attr_id, s_attrs[i].type,
+                                                  &s_attrs[i].initial));
+    }
+    light_driver_state_t initial = { .power = false, .level = 255, .color_x = 0x616B, .color_y = 0x607D };
+    light_driver_init(false);
+    light_state_init(&initial);
+    TEST_ASSERT_EQUAL(ESP_OK, light_scenes_init());
+    TEST_ASSERT_EQUAL(0, sim_zb_scene_count());
+}
+
+static void test_stored_scenes_survive_a_reboot(void)
+{
+    store(0, 1, 40);
+    store(5, 1, 80);
+    store(5, 2, 120);
+    store(6, 1, 160);
+    reboot();
+    TEST_ASSERT_EQUAL(4, sim_zb_scene_count());
+    const sim_zb_scene_t *scene = sim_zb_scene_find(BATHROOM_LIGHT_ENDPOINT, 5, 2);
+    TEST_ASSERT(scene);
+    /* On/Off, then Level Control with the level */
+    TEST_ASSERT_EQUAL(120, scene->data[7]);
+}
+
+static void test_removed_scene_stays_removed(void)
+{
+    static const uint8_t payload[] = { 0x05, 0x00, 0x01 };
+    light_scenes_command(SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_SCENE, payload, sizeof(payload));
+    reboot();
+    TEST_ASSERT_EQUAL(3, sim_zb_scene_count());
+    TEST_ASSERT(!sim_zb_scene_find(BATHROOM_LIGHT_ENDPOINT, 5, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, recall(5, 1));
+    TEST_ASSERT_EQUAL(ESP_OK, recall(5, 2));
+    TEST_ASSERT_EQUAL(120, light_state_get()->level);
+}
+
+static void test_removed_group_stays_removed(void)
+{
+    static const uint8_t payload[] = { 0x05, 0x00 };
+    light_scenes_command(SCENE_TABLE_GROUPS_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_GROUP, payload, sizeof(payload));
+    reboot();
+    TEST_ASSERT_EQUAL(2, sim_zb_scene_count());
+    TEST_ASSERT(sim_zb_scene_find(BATHROOM_LIGHT_ENDPOINT, 0, 1));
+    TEST_ASSERT(sim_zb_scene_find(BATHROOM_LIGHT_ENDPOINT, 6, 1));
+}
+
+static void test_remove_all_scenes_and_groups(void)
+{
+    static const uint8_t group_0[] = { 0x00, 0x00 };
+    light_scenes_command(SCENE_TABLE_GROUPS_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_ALL_GROUPS, NULL, 0);
+    reboot();
+    TEST_ASSERT_EQUAL(1, sim_zb_scene_count());
+    light_scenes_command(SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_ALL_SCENES, group_0, sizeof(group_0));
+    reboot();
+    TEST_ASSERT_EQUAL(0, sim_zb_scene_count());
+}
+
+static void test_other_commands_do_not_write(void)
+{
+    static const uint8_t payload[] = { 0x00, 0x00, 0x01 };
+    store(0, 1, 40);
+    uint32_t writes = sim_nvs_write_count();
+    /* View Scene, and Remove Scene of a scene that is not there */
+    light_scenes_command(SCENE_TABLE_SCENES_CLUSTER_ID, 0x01, payload, sizeof(payload));
+    static const uint8_t other[] = { 0x00, 0x00, 0x09 };
+    light_scenes_command(SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_SCENE, other, sizeof(other));
+    TEST_ASSERT_EQUAL(writes, sim_nvs_write_count());
+}
+
+static void test_erase_forgets_the_scenes(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, light_scenes_erase());
+    TEST_ASSERT_EQUAL(0, sim_nvs_entry_count(LIGHT_SCENES_NAMESPACE));
+    reboot();
+    TEST_ASSERT_EQUAL(0, sim_zb_scene_count());
+}
+
+int main(void)
+{
+    TEST_RUN(test_setup);
+    TEST_RUN(test_stored_scenes_survive_a_reboot);
+    TEST_RUN(test_removed_scene_stays_removed);
+    TEST_RUN(test_removed_group_stays_removed);
+    TEST_RUN(test_remove_all_scenes_and_groups);
+    TEST_RUN(test_other_commands_do_not_write);
+    TEST_RUN(test_erase_forgets_the_scenes);
+    return TEST_END();
+}
@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host test of ota_client against the OTA server of the Zigbee stand-in: a
+ * firmware sized image with its SHA-256 appended is served in blocks of several
+ * sizes, streamed through the two sector buffers and the writer task to the
+ * update partition. The transfer time, the flash lag and the RAM held by the
+ * download are printed for each block size.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_app_format.h"
+#include "mbedtls/sha256.h"
+#include "memory_report.h"
+#include "ota_client.h"
+#include "ota_image.h"
+#include "sim.h"
+#include "test.h"
+
+#define FILE_IDENTIFIER     0x0BEEF11E
+#define IMAGE_SIZE          (600 * 1024)
+#define DIGEST_SIZE         32
+#define FILE_SIZE           (OTA_IMAGE_FILE_HEADER_MIN_SIZE + OTA_IMAGE_ELEMENT_HEADER_SIZE + IMAGE_SIZE)
+
+static uint8_t s_file[FILE_SIZE];
+static uint32_t s_received;
+/* image bytes handed to the client and not in flash yet, the most at once */
+static uint32_t s_buffered_max;
+
+esp_err_t memory_report_add_task(TaskHandle_t task, uint32_t stack_size)
+{
+    return task ? ESP_OK : ESP_FAIL;
+}
+
+static void put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *data, uint32_t value)
+{
+    put_u16(data, value);
+    put_u16(data + 2, value >> 16);
+}
+
+/* What esp_zb_light.c does with the OTA messages, and the bytes the client still holds after each block */
+static esp_err_t action_handler(esp_zb_core_action_callback_id_t callback_id, const void *message)
+{
+    const esp_zb_zcl_ota_upgrade_value_message_t *ota = message;
+    if (callback_id != ESP_ZB_CORE_OTA_UPGRADE_VALUE_CB_ID) {
+        return ESP_OK;
+    }
+    esp_err_t ret = ota_client_handle(ota);
+    if (ota->upgrade_status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_START) {
+        s_received = 0;
+        s_buffered_max = 0;
+    } else if (ota->upgrade_status == ESP_ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE) {
+        s_received += ota->payload_size;
+        /* the sub-element header is not image data; until the writer opens the image, written is the previous one's */
+        uint32_t image = s_received > OTA_IMAGE_ELEMENT_HEADER_SIZE ? s_received - OTA_IMAGE_ELEMENT_HEADER_SIZE : 0;
+        if (image > sim_ota()->written && image - sim_ota()->written > s_buffered_max) {
+            s_buffered_max = image - sim_ota()->written;
+        }
+    }
+    return ret;
+}
+
+/* An OTA file of one upgrade image sub-element, the image a pseudo-random app with its SHA-256 appended */
+static void make_file(void)
+{
+    uint8_t *header = s_file;
+    put_u32(&header[0], FILE_IDENTIFIER);
+    put_u16(&header[4], 0x0100);
+    put_u16(&header[6], OTA_IMAGE_FILE_HEADER_MIN_SIZE);
+    put_u16(&header[8], 0);
+    put_u16(&header[10], OTA_CLIENT_MANUFACTURER_CODE);
+    put_u16(&header[12], OTA_CLIENT_IMAGE_TYPE);
+    put_u32(&header[14], OTA_CLIENT_FILE_VERSION + 1);
+    put_u16(&header[18], 0x0002);
+    memcpy(&header[20], "bathroom_thermostat_controller", 30);
+    put_u32(&header[52], FILE_SIZE);
+
+    uint8_t *element = &s_file[OTA_IMAGE_FILE_HEADER_MIN_SIZE];
+    put_u16(&element[0], OTA_IMAGE_TAG_UPGRADE_IMAGE);
+    put_u32(&element[2], IMAGE_SIZE);
+
+    uint8_t *image = &element[OTA_IMAGE_ELEMENT_HEADER_SIZE];
+    uint32_t seed = 0x2545F491;
+    for (uint32_t i = 0; i < IMAGE_SIZE - DIGEST_SIZE; i++) {
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+    esp_image_header_t app = {
+        .magic = ESP_IMAGE_HEADER_MAGIC,
+        .segment_count = 4,
+        .chip_id = 0x000D,
+        .hash_appended = 1,
+    };
+    memcpy(image, &app, sizeof(app));
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, image, IMAGE_SIZE - DIGEST_SIZE);
+    mbedtls_sha256_finish(&sha, &image[IMAGE_SIZE - DIGEST_SIZE]);
+    mbedtls_sha256_free(&sha);
+}
+
+static void serve(uint16_t block_size)
+{
+    sim_zb_ota_serve(s_file, FILE_SIZE, block_size);
+    while (!sim_zb_ota()->done) {
+        sim_advance(100000);
+    }
+}
+
+static void test_sha256(void)
+{
+    static const uint8_t expected[DIGEST_SIZE] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+    };
+    uint8_t digest[DIGEST_SIZE];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, (const uint8_t *)"abc", 3);
+    mbedtls_sha256_finish(&sha, digest);
+    TEST_ASSERT(memcmp(digest, expected, sizeof(digest)) == 0);
+}
+
+static void test_init(void)
+{
+    make_file();
+    esp_zb_core_action_handler_register(action_handler);
+    TEST_ASSERT_EQUAL(ESP_OK, ota_client_init());
+}
+
+static void test_corrupted_image_is_rejected(void)
+{
+    uint8_t *byte = &s_file[FILE_SIZE / 2];
+    *byte ^= 0x01;
+    serve(OTA_CLIENT_BLOCK_SIZE);
+    *byte ^= 0x01;
+    TEST_ASSERT_EQUAL(ESP_ERR_OTA_VALIDATE_FAILED, sim_zb_ota()->result);
+    TEST_ASSERT(!sim_ota()->ended);
+    TEST_ASSERT_EQUAL(0, sim_ota()->restarts);
+}
+
+static void test_download_per_block_size(void)
+{
+    static const uint16_t block_sizes[] = { 32, 48, 64, 128, OTA_CLIENT_BLOCK_SIZE };
+    /* the two sector buffers, the writer stack and its job queue */
+    const uint32_t client_ram = OTA_CLIENT_BUFFER_COUNT * OTA_CLIENT_BUFFER_SIZE + OTA_CLIENT_WRITER_STACK_SIZE +
+                                (OTA_CLIENT_BUFFER_COUNT + 2) * 12;
+    for (size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+        uint16_t block_size = block_sizes[i];
+        uint32_t restarts = sim_ota()->restarts;
+        serve(block_size);
+        const sim_zb_ota_t *ota = sim_zb_ota();
+        TEST_ASSERT_EQUAL(ESP_OK, ota->result);
+        TEST_ASSERT_EQUAL((FILE_SIZE - OTA_IMAGE_FILE_HEADER_MIN_SIZE + block_size - 1) / block_size, ota->blocks);
+
+        /* every byte of the image streamed to flash, a sector erased once, a write per full buffer */
+        TEST_ASSERT(sim_ota()->ended);
+        TEST_ASSERT_EQUAL(IMAGE_SIZE, sim_ota()->written);
+        TEST_ASSERT(memcmp(sim_ota_partition_data(), &s_file[FILE_SIZE - IMAGE_SIZE], IMAGE_SIZE) == 0);
+        TEST_ASSERT_EQUAL((IMAGE_SIZE + SIM_OTA_SECTOR_SIZE - 1) / SIM_OTA_SECTOR_SIZE, sim_ota()->sectors_erased);
+        TEST_ASSERT_EQUAL((IMAGE_SIZE + OTA_CLIENT_BUFFER_SIZE - 1) / OTA_CLIENT_BUFFER_SIZE, sim_ota()->writes);
+        TEST_ASSERT_EQUAL(restarts + 1, sim_ota()->restarts);
+        TEST_ASSERT(strcmp(sim_ota()->boot->label, "ota_1") == 0);
+
+        /* a buffer is written before the other one is full, the flash never holds up the download */
+        int64_t fill_us = (int64_t)(OTA_CLIENT_BUFFER_SIZE / block_size) * (ota->check_us - ota->start_us) / ota->blocks;
+        TEST_ASSERT(sim_ota()->lag_max_us < fill_us);
+        TEST_ASSERT(s_buffered_max <= OTA_CLIENT_BUFFER_COUNT * OTA_CLIENT_BUFFER_SIZE);
+
+        int64_t end_us = sim_ota()->flash_done_us > ota->check_us ? sim_ota()->flash_done_us : ota->check_us;
+        int64_t transfer_ms = (end_us - ota->start_us) / 1000;
+        printf("%3" PRIu16 "-byte blocks: %5" PRIu32 " blocks in %6.1f s (%4" PRId64 " bytes/s), flash busy %.1f s, "
+               "worst flash lag %3" PRId64 " ms; RAM %" PRIu32 " bytes of client + %" PRIu16 " of block, "
+               "%" PRIu32 " image bytes held at most\n",
+               block_size, ota->blocks, transfer_ms / 1000.0, (int64_t)FILE_SIZE * 1000 / transfer_ms,
+               sim_ota()->flash_busy_us / 1e6, sim_ota()->lag_max_us / 1000, client_ram, block_size, s_buffered_max);
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(test_sha256);
+    TEST_RUN(test_init);
+    TEST_RUN(test_corrupted_image_is_rejected);
+    TEST_RUN(test_download_per_block_size);
+    return TEST_END();
+}
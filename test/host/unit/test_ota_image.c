@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of ota_image, on data/bathroom_thermostat_controller.ota: a Zigbee
+ * OTA file with the 56-byte header and a 3000-byte upgrade image sub-element
+ */
+
+#include <stdlib.h>
+#include "ota_image.h"
+#include "test.h"
+
+/* Largest block requested by ota_client */
+#define BLOCK_SIZE          223
+#define FILE_IDENTIFIER     0x0BEEF11E
+#define FILE_MAX_SIZE       8192
+
+static uint8_t s_file[FILE_MAX_SIZE];
+static size_t s_file_size;
+static uint8_t s_image[FILE_MAX_SIZE];
+static size_t s_image_length;
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static void put_u32(uint8_t *data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        data[i] = value >> (8 * i);
+    }
+}
+
+/* What the stack does with the header: check it, keep ImageSize and skip the header length */
+static void read_header(const uint8_t *file, uint32_t *file_size, uint16_t *header_length)
+{
+    *file_size = read_u32(&file[52]);
+    *header_length = file[6] | file[7] << 8;
+}
+
+/**
+ * Feed the body of a file in blocks of the given size, as the stack hands them over
+ *
+ * @return The status of the first block that fails, OTA_IMAGE_OK if none
+ */
+static ota_image_status_t feed(ota_image_t *image, const uint8_t *file, size_t length, size_t block_size)
+{
+    uint32_t file_size;
+    uint16_t header_length;
+    read_header(file, &file_size, &header_length);
+    ota_image_init(image, file_size);
+    s_image_length = 0;
+    for (size_t offset = header_length; offset < length; offset += block_size) {
+        const uint8_t *block = &file[offset];
+        size_t left = length - offset < block_size ? length - offset : block_size;
+        while (left) {
+            size_t consumed;
+            const uint8_t *element_data;
+            size_t element_length;
+            ota_image_status_t status = ota_image_parse(image, block, left, &consumed, &element_data, &element_length);
+            if (status != OTA_IMAGE_OK) {
+                return status;
+            }
+            memcpy(&s_image[s_image_length], element_data, element_length);
+            s_image_length += element_length;
+            block += consumed;
+            left -= consumed;
+        }
+    }
+    return OTA_IMAGE_OK;
+}
+
+static void load_file(void)
+{
+    FILE *file = fopen(OTA_IMAGE_TEST_FILE, "rb");
+    TEST_ASSERT(file);
+    s_file_size = fread(s_file, 1, sizeof(s_file), file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(FILE_IDENTIFIER, read_u32(s_file));
+    TEST_ASSERT_EQUAL(s_file_size, read_u32(&s_file[52]));
+}
+
+static void test_file_in_blocks(void)
+{
+    ota_image_t image;
+    TEST_ASSERT_EQUAL(OTA_IMAGE_OK, feed(&image, s_file, s_file_size, BLOCK_SIZE));
+    TEST_ASSERT(ota_image_complete(&image));
+    TEST_ASSERT_EQUAL(3000, image.image_length);
+    TEST_ASSERT_EQUAL(3000, s_image_length);
+    TEST_ASSERT_EQUAL_MEMORY(&s_file[OTA_IMAGE_FILE_HEADER_MIN_SIZE + OTA_IMAGE_ELEMENT_HEADER_SIZE], s_image, s_image_length);
+    TEST_ASSERT_EQUAL(0xE9, s_image[0]);
+}
+
+static void test_file_byte_by_byte(void)
+{
+    /* every sub-element header is split across blocks */
+    ota_image_t image;
+    TEST_ASSERT_EQUAL(OTA_IMAGE_OK, feed(&image, s_file, s_file_size, 1));
+    TEST_ASSERT(ota_image_complete(&image));
+    TEST_ASSERT_EQUAL(3000, s_image_length);
+}
+
+static void test_missing_block_is_incomplete(void)
+{
+    ota_image_t image;
+    for (size_t missing = 1; missing <= BLOCK_SIZE; missing += 37) {
+        TEST_ASSERT_EQUAL(OTA_IMAGE_OK, feed(&image, s_file, s_file_size - missing, BLOCK_SIZE));
+        TEST_ASSERT(!ota_image_complete(&image));
+    }
+}
+
+static void test_body_past_file_size_is_rejected(void)
+{
+    ota_image_t image;
+    uint8_t file[FILE_MAX_SIZE];
+    memcpy(file, s_file, s_file_size);
+    /* ImageSize without the header, the body then runs into what must be left for it */
+    put_u32(&file[52], s_file_size - OTA_IMAGE_FILE_HEADER_MIN_SIZE);
+    TEST_ASSERT_EQUAL(OTA_IMAGE_TOO_LONG, feed(&image, file, s_file_size, BLOCK_SIZE));
+}
+
+static void test_header_with_optional_fields(void)
+{
+    /* the hardware versions add 4 bytes to the header */
+    ota_image_t image;
+    uint8_t file[FILE_MAX_SIZE];
+    const uint16_t header_length = OTA_IMAGE_FILE_HEADER_MIN_SIZE + 4;
+    size_t body_length = s_file_size - OTA_IMAGE_FILE_HEADER_MIN_SIZE;
+    memcpy(file, s_file, OTA_IMAGE_FILE_HEADER_MIN_SIZE);
+    file[6] = header_length;
+    file[8] |= 0x04;
+    put_u32(&file[52], header_length + body_length);
+    memset(&file[OTA_IMAGE_FILE_HEADER_MIN_SIZE], 1, 4);
+    memcpy(&file[header_length], &s_file[OTA_IMAGE_FILE_HEADER_MIN_SIZE], body_length);
+    TEST_ASSERT_EQUAL(OTA_IMAGE_OK, feed(&image, file, header_length + body_length, BLOCK_SIZE));
+    TEST_ASSERT(ota_image_complete(&image));
+    TEST_ASSERT_EQUAL(3000, s_image_length);
+}
+
+static void test_other_sub_elements_are_skipped(void)
+{
+    ota_image_t image;
+    uint8_t file[FILE_MAX_SIZE];
+    /* a signature sub-element before the image, a manufacturer one after */
+    static const uint8_t before[] = { 0x01, 0x00, 0x04, 0x00, 0x00, 0x00, 0xAA, 0xBB, 0xCC, 0xDD };
+    static const uint8_t after[] = { 0x00, 0xF0, 0x02, 0x00, 0x00, 0x00, 0x12, 0x34 };
+    size_t length = OTA_IMAGE_FILE_HEADER_MIN_SIZE;
+    memcpy(file, s_file, length);
+    memcpy(&file[length], before, sizeof(before));
+    length += sizeof(before);
+    memcpy(&file[length], &s_file[OTA_IMAGE_FILE_HEADER_MIN_SIZE], s_file_size - OTA_IMAGE_FILE_HEADER_MIN_SIZE);
+    length += s_file_size - OTA_IMAGE_FILE_HEADER_MIN_SIZE;
+    memcpy(&file[length], after, sizeof(after));
+    length += sizeof(after);
+    put_u32(&file[52], length);
+    TEST_ASSERT_EQUAL(OTA_IMAGE_OK, feed(&image, file, length, BLOCK_SIZE));
+    TEST_ASSERT(ota_image_complete(&image));
+    TEST_ASSERT_EQUAL(3000, s_image_length);
+    TEST_ASSERT_EQUAL_MEMORY(&s_file[OTA_IMAGE_FILE_HEADER_MIN_SIZE + OTA_IMAGE_ELEMENT_HEADER_SIZE], s_image, s_image_length);
+}
+
+static void test_duplicate_image_is_rejected(void)
+{
+    ota_image_t image;
+    uint8_t file[FILE_MAX_SIZE];
+    static const uint8_t element[] = { 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x12, 0x34 };
+    memcpy(file, s_file, s_file_size);
+    memcpy(&file[s_file_size], element, sizeof(element));
+    put_u32(&file[52], s_file_size + sizeof(element));
+    TEST_ASSERT_EQUAL(OTA_IMAGE_DUPLICATE, feed(&image, file, s_file_size + sizeof(element), BLOCK_SIZE));
+}
+
+static void test_element_past_the_end_is_rejected(void)
+{
+    ota_image_t image;
+    uint8_t file[FILE_MAX_SIZE];
+    memcpy(file, s_file, s_file_size);
+    put_u32(&file[OTA_IMAGE_FILE_HEADER_MIN_SIZE + 2], 0xFFFFFFF0);
+    TEST_ASSERT_EQUAL(OTA_IMAGE_TOO_LONG, feed(&image, file, s_file_size, BLOCK_SIZE));
+}
+
+int main(void)
+{
+    TEST_RUN(load_file);
+    if (s_test_failures) {
+        return TEST_END();
+    }
+    TEST_RUN(test_file_in_blocks);
+    TEST_RUN(test_file_byte_by_byte);
+    TEST_RUN(test_missing_block_is_incomplete);
+    TEST_RUN(test_body_past_file_size_is_rejected);
+    TEST_RUN(test_header_with_optional_fields);
+    TEST_RUN(test_other_sub_elements_are_skipped);
+    TEST_RUN(test_duplicate_image_is_rejected);
+    TEST_RUN(test_element_past_the_end_is_rejected);
+    return TEST_END();
+}
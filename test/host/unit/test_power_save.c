@@ -0,0 +1,296 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Energy model of the low-power mode: a bathroom day from unit/data (reports,
+ * button presses and light commands of the coordinator) is replayed for each
+ * configuration, the light commands through the real light driver on the
+ * stand-ins, which tells how long the LED strip holds its RMT channel and so
+ * keeps the chip out of light sleep. The average current and the battery life
+ * come from the modelled currents and awake times below: typical ESP32-C6 and
+ * WS2812B figures, rounded, not measurements of the board.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "latency_trace.h"
+#include "light_driver.h"
+#include "sim.h"
+#include "temperature_sensor.h"
+#include "test.h"
+
+#define DAY_US                  (24 * 3600 * INT64_C(1000000))
+#define TRACE_MAX_EVENTS        1024
+
+/* currents at 3.3 V */
+#define MODEL_SLEEP_UA          180     /* light sleep, radio off */
+#define MODEL_IDLE_UA           18000   /* awake in the idle task, radio off: a PM lock is held */
+#define MODEL_ACTIVE_UA         25000   /* CPU running at 160 MHz, radio off */
+#define MODEL_RX_UA             78000   /* IEEE 802.15.4 receiving, CPU awake */
+#define MODEL_TX_UA             100000  /* IEEE 802.15.4 transmitting, CPU awake */
+#define MODEL_PIXEL_DARK_UA     600     /* a dark pixel, the strip supply is not switched */
+#define MODEL_CHANNEL_FULL_UA   12000   /* a colour channel of a pixel at 255 */
+
+/* awake time of one occurrence */
+#define MODEL_WAKE_US           400     /* leaving light sleep and entering it again */
+#define MODEL_POLL_TX_US        600     /* MAC data request */
+#define MODEL_POLL_RX_US        5000    /* waiting for the ack and the pending data */
+#define MODEL_FRAME_TX_US       2000    /* a report or a command response */
+#define MODEL_FRAME_RX_US       8000    /* its MAC ack, then the APS ack on a fast poll */
+#define MODEL_HANDLER_US        2000    /* handling a command or building a report */
+#define MODEL_EDGE_US           200     /* a button interrupt or a debounce timer expiry */
+#define MODEL_SAMPLE_US         (TEMPERATURE_SENSOR_OVERSAMPLING * 1000000LL / TEMPERATURE_SENSOR_SAMPLE_FREQ_HZ)
+
+#define MODEL_BATTERY_MAH       2500
+
+typedef enum {
+    TRACE_REPORT,
+    TRACE_PRESS,
+    TRACE_LIGHT,
+} trace_kind_t;
+
+typedef struct {
+    int64_t time_ms;
+    trace_kind_t kind;
+    uint8_t level;
+    uint32_t transition_ms;
+} trace_event_t;
+
+typedef struct {
+    const char *name;
+    bool light_sleep;
+    uint32_t poll_ms;           /* 0: receiver on when idle */
+    bool strip_release;         /* LIGHT_DRIVER_AUTO_POWER_DOWN */
+} energy_config_t;
+
+/* before the low-power mode, then with the 3 s and the 30 s ED_KEEP_ALIVE as poll interval */
+static const energy_config_t s_configs[] = {
+    { "no PM, receiver on, strip kept", false, 0, false },
+    { "light sleep, 3 s poll, strip kept", true, 3000, false },
+    { "light sleep, 3 s poll, strip released", true, 3000, true },
+    { "light sleep, 30 s poll, strip kept", true, 30000, false },
+    { "light sleep, 30 s poll, strip released", true, 30000, true },
+};
+
+#define CONFIG_COUNT            (sizeof(s_configs) / sizeof(s_configs[0]))
+
+typedef struct {
+    int64_t strip_held_us;
+    int64_t led_charge;         /* uA x us of the pixels */
+    int64_t delay_sum_us;       /* light commands waiting for the next poll */
+    int64_t delay_worst_us;
+    int64_t average_ua;
+} energy_result_t;
+
+static trace_event_t s_events[TRACE_MAX_EVENTS];
+static size_t s_event_count;
+static energy_result_t s_results[CONFIG_COUNT];
+
+static void test_load_trace(void)
+{
+    FILE *file = fopen(POWER_SAVE_TRACE_FILE, "r");
+    TEST_ASSERT(file);
+    char line[64];
+    uint32_t reports = 0, presses = 0, lights = 0;
+    while (fgets(line, sizeof(line), file) && s_event_count < TRACE_MAX_EVENTS) {
+        trace_event_t *event = &s_events[s_event_count];
+        char kind[16];
+        unsigned level = 0;
+        if (line[0] == '#' || sscanf(line, "%" SCNd64 ",%15[a-z],%u,%" SCNu32, &event->time_ms, kind, &level,
+                                     &event->transition_ms) < 2) {
+            continue;
+        }
+        if (strcmp(kind, "report") == 0) {
+            event->kind = TRACE_REPORT;
+            reports++;
+        } else if (strcmp(kind, "press") == 0) {
+            event->kind = TRACE_PRESS;
+            presses++;
+        } else {
+            TEST_ASSERT(strcmp(kind, "light") == 0);
+            event->kind = TRACE_LIGHT;
+            event->level = level;
+            lights++;
+        }
+        TEST_ASSERT(s_event_count == 0 || event->time_ms >= s_events[s_event_count - 1].time_ms);
+        s_event_count++;
+    }
+    fclose(file);
+    printf("day: %" PRIu32 " reports, %" PRIu32 " presses, %" PRIu32 " light commands\n", reports, presses, lights);
+    TEST_ASSERT_EQUAL(620, reports);
+    TEST_ASSERT_EQUAL(4, presses);
+    TEST_ASSERT_EQUAL(11, lights);
+}
+
+/* a command of the coordinator is held by the parent until the next data poll */
+static int64_t command_delay_us(const energy_config_t *config, int64_t time_ms)
+{
+    if (config->poll_ms == 0) {
+        return 0;
+    }
+    return (config->poll_ms - time_ms % config->poll_ms) % config->poll_ms * 1000;
+}
+
+static bool strip_held(void)
+{
+    return sim_led_strip_get()->created > sim_led_strip_get()->deleted;
+}
+
+static int64_t pixels_ua(void)
+{
+    int64_t current = 0;
+    for (int i = 0; i < CONFIG_EXAMPLE_STRIP_LED_NUMBER; i++) {
+        current += MODEL_PIXEL_DARK_UA;
+        for (int channel = 0; channel < 3; channel++) {
+            current += sim_led_strip_get()->pixels[i][channel] * MODEL_CHANNEL_FULL_UA / UINT8_MAX;
+        }
+    }
+    return current;
+}
+
+/* frame by frame while a transition can run, in one step otherwise */
+static void advance_to(int64_t target_us, int64_t busy_until_us, energy_result_t *result)
+{
+    while (sim_now_us() < target_us) {
+        int64_t step_us = target_us - sim_now_us();
+        if (sim_now_us() < busy_until_us && step_us > LIGHT_DRIVER_FRAME_PERIOD_US) {
+            step_us = LIGHT_DRIVER_FRAME_PERIOD_US;
+        }
+        result->strip_held_us += strip_held() ? step_us : 0;
+        result->led_charge += pixels_ua() * step_us;
+        sim_advance(step_us);
+    }
+}
+
+static void replay_light(const energy_config_t *config, energy_result_t *result)
+{
+    light_driver_state_t state = { .power = false, .level = UINT8_MAX, .color_x = 0x5000, .color_y = 0x5439 };
+    light_driver_set_state(&state);
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    TEST_ASSERT(!strip_held());
+
+    int64_t start_us = sim_now_us(), busy_until_us = 0;
+    uint32_t commands = 0;
+    for (size_t i = 0; i < s_event_count; i++) {
+        const trace_event_t *event = &s_events[i];
+        if (event->kind != TRACE_LIGHT) {
+            continue;
+        }
+        int64_t delay_us = command_delay_us(config, event->time_ms);
+        advance_to(start_us + event->time_ms * 1000 + delay_us, busy_until_us, result);
+        state.power = event->level > 0;
+        state.level = event->level > 0 ? event->level : state.level;
+        light_driver_fade_to_state(&state, event->transition_ms);
+        busy_until_us = sim_now_us() + event->transition_ms * 1000LL + 5 * LIGHT_DRIVER_FRAME_PERIOD_US;
+        result->delay_sum_us += delay_us;
+        result->delay_worst_us = delay_us > result->delay_worst_us ? delay_us : result->delay_worst_us;
+        commands++;
+    }
+    advance_to(start_us + DAY_US, busy_until_us, result);
+    result->delay_sum_us /= commands;
+    TEST_ASSERT(!strip_held());
+    if (!config->strip_release) {
+        /* created at light_driver_init() and never deleted */
+        result->strip_held_us = DAY_US;
+    }
+}
+
+typedef struct {
+    int64_t charge;             /* uA x us */
+    int64_t awake_us;
+} energy_awake_t;
+
+static void awake(energy_awake_t *awake, int64_t current_ua, int64_t duration_us)
+{
+    awake->charge += current_ua * duration_us;
+    awake->awake_us += duration_us;
+}
+
+static void frame_exchange(energy_awake_t *activity)
+{
+    awake(activity, MODEL_ACTIVE_UA, MODEL_HANDLER_US);
+    awake(activity, MODEL_TX_UA, MODEL_FRAME_TX_US);
+    awake(activity, MODEL_RX_UA, MODEL_FRAME_RX_US);
+}
+
+static int64_t average_ua(const energy_config_t *config, const energy_result_t *result)
+{
+    int64_t charge = result->led_charge;
+    if (!config->light_sleep) {
+        /* the receiver never stops and the CPU stays up with it, only the transmissions add */
+        int64_t frames = s_event_count;
+        return (charge + MODEL_RX_UA * DAY_US + frames * (MODEL_TX_UA - MODEL_RX_UA) * MODEL_FRAME_TX_US) / DAY_US;
+    }
+
+    energy_awake_t activity = { 0 };
+    for (int64_t poll = 0; poll < DAY_US / (config->poll_ms * 1000LL); poll++) {
+        awake(&activity, MODEL_ACTIVE_UA, MODEL_WAKE_US);
+        awake(&activity, MODEL_TX_UA, MODEL_POLL_TX_US);
+        awake(&activity, MODEL_RX_UA, MODEL_POLL_RX_US);
+    }
+    for (int64_t sample = 0; sample < DAY_US / (TEMPERATURE_SENSOR_PERIOD_MS * 1000LL); sample++) {
+        awake(&activity, MODEL_ACTIVE_UA, MODEL_WAKE_US + MODEL_SAMPLE_US);
+    }
+    for (size_t i = 0; i < s_event_count; i++) {
+        const trace_event_t *event = &s_events[i];
+        if (event->kind == TRACE_PRESS) {
+            /* press and release edges, each with its debounce timer */
+            for (int edge = 0; edge < 4; edge++) {
+                awake(&activity, MODEL_ACTIVE_UA, MODEL_WAKE_US + MODEL_EDGE_US);
+            }
+        }
+        if (event->kind != TRACE_LIGHT) {
+            awake(&activity, MODEL_ACTIVE_UA, MODEL_WAKE_US);
+        }
+        /* a command comes with a poll, the stack answers it */
+        frame_exchange(&activity);
+    }
+    int64_t held_us = result->strip_held_us;
+    if (held_us > DAY_US - activity.awake_us) {
+        held_us = DAY_US - activity.awake_us;
+    }
+    charge += activity.charge + MODEL_IDLE_UA * held_us + MODEL_SLEEP_UA * (DAY_US - activity.awake_us - held_us);
+    return charge / DAY_US;
+}
+
+static void test_day_per_configuration(void)
+{
+    latency_trace_init();
+    light_driver_init(false);
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+
+    for (size_t i = 0; i < CONFIG_COUNT; i++) {
+        const energy_config_t *config = &s_configs[i];
+        energy_result_t *result = &s_results[i];
+        replay_light(config, result);
+        result->average_ua = average_ua(config, result);
+        printf("%-40s %3" PRId64 ".%02" PRId64 " mA, %4" PRId64 " days on %d mAh; strip held %5" PRId64 " s, LED %" PRId64
+               ".%02" PRId64 " mA; light commands delayed %" PRId64 " ms on average, %" PRId64 " ms at worst\n",
+               config->name, result->average_ua / 1000, result->average_ua % 1000 / 10,
+               MODEL_BATTERY_MAH * INT64_C(1000) / result->average_ua / 24, MODEL_BATTERY_MAH, result->strip_held_us / 1000000,
+               result->led_charge / DAY_US / 1000, result->led_charge / DAY_US % 1000 / 10,
+               result->delay_sum_us / 1000, result->delay_worst_us / 1000);
+        TEST_ASSERT(result->delay_worst_us < config->poll_ms * 1000LL || config->poll_ms == 0);
+    }
+
+    /* the LED is lit for a little over 2 h of the day, the strip is released in the dark */
+    TEST_ASSERT(s_results[2].strip_held_us > 2 * 3600 * 1000000LL);
+    TEST_ASSERT(s_results[2].strip_held_us < 3 * 3600 * 1000000LL);
+    /* the light is the same in every configuration */
+    for (size_t i = 1; i < CONFIG_COUNT; i++) {
+        TEST_ASSERT(s_results[i].led_charge / DAY_US - s_results[0].led_charge / DAY_US < 50);
+        TEST_ASSERT(s_results[0].led_charge / DAY_US - s_results[i].led_charge / DAY_US < 50);
+    }
+    /* a held strip keeps the chip awake, the receiver costs more than that */
+    TEST_ASSERT(s_results[4].average_ua < s_results[2].average_ua);
+    TEST_ASSERT(s_results[2].average_ua < s_results[1].average_ua);
+    TEST_ASSERT(s_results[4].average_ua < s_results[3].average_ua);
+    TEST_ASSERT(s_results[1].average_ua < s_results[0].average_ua);
+}
+
+int main(void)
+{
+    TEST_RUN(test_load_trace);
+    TEST_RUN(test_day_per_configuration);
+    return TEST_END();
+}
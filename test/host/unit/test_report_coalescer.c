@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of report_coalescer
+ */
+
+#include "report_coalescer.h"
+#include "test.h"
+
+static void test_changes_merged_in_the_window(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 100, 1);
+    TEST_ASSERT_EQUAL(1100, report_coalescer_update(&rc, 1, 1000));
+    /* later changes within the window do not move the deadline */
+    TEST_ASSERT_EQUAL(1100, report_coalescer_update(&rc, 2, 1050));
+    TEST_ASSERT(!report_coalescer_poll(&rc, 1099, &next_ms));
+    TEST_ASSERT_EQUAL(1100, next_ms);
+    TEST_ASSERT(report_coalescer_poll(&rc, 1100, &next_ms));
+    TEST_ASSERT_EQUAL(2, rc.reported_value);
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, next_ms);
+}
+
+static void test_return_to_reported_value_cancels(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 100, 1);
+    report_coalescer_update(&rc, 1, 0);
+    TEST_ASSERT(report_coalescer_poll(&rc, 100, &next_ms));
+    report_coalescer_update(&rc, 0, 200);
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, report_coalescer_update(&rc, 1, 250));
+    TEST_ASSERT(!report_coalescer_poll(&rc, 300, &next_ms));
+}
+
+static void test_reportable_change(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 0, 50);
+    /* the first value is always reported */
+    report_coalescer_update(&rc, 2000, 0);
+    TEST_ASSERT(report_coalescer_poll(&rc, 0, &next_ms));
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, report_coalescer_update(&rc, 2049, 10));
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, report_coalescer_update(&rc, 1951, 20));
+    TEST_ASSERT_EQUAL(30, report_coalescer_update(&rc, 1950, 30));
+    TEST_ASSERT(report_coalescer_poll(&rc, 30, &next_ms));
+    TEST_ASSERT_EQUAL(1950, rc.reported_value);
+}
+
+static void test_min_interval(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 100, 1);
+    report_coalescer_set_intervals(&rc, 5, 0);
+    report_coalescer_update(&rc, 1, 0);
+    TEST_ASSERT(report_coalescer_poll(&rc, 100, &next_ms));
+    TEST_ASSERT_EQUAL(5100, report_coalescer_update(&rc, 2, 1000));
+    TEST_ASSERT(!report_coalescer_poll(&rc, 1100, &next_ms));
+    TEST_ASSERT_EQUAL(5100, next_ms);
+    TEST_ASSERT(report_coalescer_poll(&rc, 5100, &next_ms));
+}
+
+static void test_max_interval(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 0, 1);
+    report_coalescer_set_intervals(&rc, 0, 60);
+    /* nothing is repeated before a first report */
+    TEST_ASSERT(!report_coalescer_poll(&rc, 120000, &next_ms));
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, next_ms);
+    report_coalescer_update(&rc, 7, 0);
+    TEST_ASSERT(report_coalescer_poll(&rc, 0, &next_ms));
+    TEST_ASSERT_EQUAL(60000, next_ms);
+    TEST_ASSERT(!report_coalescer_poll(&rc, 59999, &next_ms));
+    TEST_ASSERT(report_coalescer_poll(&rc, 60000, &next_ms));
+    TEST_ASSERT_EQUAL(120000, next_ms);
+}
+
+static void test_periodic_reports_disabled(void)
+{
+    report_coalescer_t rc;
+    int64_t next_ms;
+    report_coalescer_init(&rc, 0, 1);
+    report_coalescer_set_intervals(&rc, 0, REPORT_COALESCER_MAX_INTERVAL_DISABLED);
+    report_coalescer_update(&rc, 7, 0);
+    TEST_ASSERT(report_coalescer_poll(&rc, 0, &next_ms));
+    TEST_ASSERT_EQUAL(REPORT_COALESCER_NO_DEADLINE, next_ms);
+    TEST_ASSERT(!report_coalescer_poll(&rc, 0x7FFFFFFF, &next_ms));
+}
+
+int main(void)
+{
+    TEST_RUN(test_changes_merged_in_the_window);
+    TEST_RUN(test_return_to_reported_value_cancels);
+    TEST_RUN(test_reportable_change);
+    TEST_RUN(test_min_interval);
+    TEST_RUN(test_max_interval);
+    TEST_RUN(test_periodic_reports_disabled);
+    return TEST_END();
+}
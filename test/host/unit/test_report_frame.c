@@ -0,0 +1,90 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of report_frame
+ */
+
+#include "report_frame.h"
+#include "test.h"
+
+static void test_header(void)
+{
+    uint8_t data[16];
+    report_frame_t frame;
+    report_frame_init(&frame, data, sizeof(data), 0x42);
+    static const uint8_t expected[] = { 0x18, 0x42, 0x0A };
+    TEST_ASSERT_EQUAL(REPORT_FRAME_HEADER_SIZE, frame.length);
+    TEST_ASSERT_EQUAL(0, frame.records);
+    TEST_ASSERT_EQUAL_MEMORY(expected, data, sizeof(expected));
+}
+
+static void test_records(void)
+{
+    uint8_t data[32];
+    report_frame_t frame;
+    report_frame_init(&frame, data, sizeof(data), 7);
+    /* Occupancy (bitmap8) and ThermostatRunningState (bitmap16) */
+    uint8_t occupancy = 0x01;
+    uint8_t running_state[] = { 0x01, 0x00 };
+    TEST_ASSERT(report_frame_add(&frame, 0x0002, 0x18, &occupancy));
+    TEST_ASSERT(report_frame_add(&frame, 0x0029, 0x19, running_state));
+    static const uint8_t expected[] = {
+        0x18, 0x07, 0x0A,
+        0x02, 0x00, 0x18, 0x01,
+        0x29, 0x00, 0x19, 0x01, 0x00,
+    };
+    TEST_ASSERT_EQUAL(2, frame.records);
+    TEST_ASSERT_EQUAL(sizeof(expected), frame.length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, data, sizeof(expected));
+}
+
+static void test_value_sizes(void)
+{
+    TEST_ASSERT_EQUAL(1, report_frame_value_size(0x10, NULL));
+    TEST_ASSERT_EQUAL(2, report_frame_value_size(0x29, NULL));
+    TEST_ASSERT_EQUAL(4, report_frame_value_size(0x23, NULL));
+    static const uint8_t name[] = { 3, 'b', 'a', 't' };
+    TEST_ASSERT_EQUAL(4, report_frame_value_size(0x42, name));
+    /* single precision is not supported */
+    TEST_ASSERT_EQUAL(0, report_frame_value_size(0x39, NULL));
+}
+
+static void test_record_that_does_not_fit(void)
+{
+    uint8_t data[REPORT_FRAME_HEADER_SIZE + 2 * (REPORT_FRAME_RECORD_HEADER_SIZE + 2) + REPORT_FRAME_RECORD_HEADER_SIZE + 1];
+    report_frame_t frame;
+    report_frame_init(&frame, data, sizeof(data), 0);
+    uint16_t value = 0x1234;
+    TEST_ASSERT(report_frame_add(&frame, 0x0003, 0x21, &value));
+    TEST_ASSERT(report_frame_add(&frame, 0x0004, 0x21, &value));
+    size_t length = frame.length;
+    /* one byte short of a third record, the frame is left as it was */
+    TEST_ASSERT(!report_frame_add(&frame, 0x0005, 0x21, &value));
+    TEST_ASSERT_EQUAL(length, frame.length);
+    TEST_ASSERT_EQUAL(2, frame.records);
+    /* a smaller value still fits */
+    uint8_t small = 1;
+    TEST_ASSERT(report_frame_add(&frame, 0x0006, 0x20, &small));
+    TEST_ASSERT_EQUAL(sizeof(data), frame.length);
+}
+
+static void test_unsupported_type(void)
+{
+    uint8_t data[16];
+    report_frame_t frame;
+    report_frame_init(&frame, data, sizeof(data), 0);
+    float value = 21.5f;
+    TEST_ASSERT(!report_frame_add(&frame, 0x0000, 0x39, &value));
+    TEST_ASSERT_EQUAL(REPORT_FRAME_HEADER_SIZE, frame.length);
+    TEST_ASSERT_EQUAL(0, frame.records);
+}
+
+int main(void)
+{
+    TEST_RUN(test_header);
+    TEST_RUN(test_records);
+    TEST_RUN(test_value_sizes);
+    TEST_RUN(test_record_that_does_not_fit);
+    TEST_RUN(test_unsupported_type);
+    return TEST_END();
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of scene_table
+ */
+
+#include "scene_table.h"
+#include "test.h"
+
+static const scene_table_state_t s_warm = { .power = 1, .level = 120, .color_x = 0x7A00, .color_y = 0x6400 };
+static const scene_table_state_t s_dim = { .power = 1, .level = 10, .color_x = 0x5000, .color_y = 0x5500 };
+
+static void test_store_and_find(void)
+{
+    scene_table_t table;
+    scene_table_init(&table);
+    TEST_ASSERT(!scene_table_find(&table, 0, 1));
+    TEST_ASSERT(scene_table_store(&table, 0, 1, &s_warm));
+    TEST_ASSERT(scene_table_store(&table, 5, 1, &s_dim));
+    TEST_ASSERT_EQUAL(2, scene_table_count(&table));
+    const scene_table_entry_t *entry = scene_table_find(&table, 5, 1);
+    TEST_ASSERT(entry);
+    TEST_ASSERT_EQUAL(10, entry->state.level);
+    TEST_ASSERT_EQUAL(120, scene_table_find(&table, 0, 1)->state.level);
+}
+
+static void test_store_overwrites(void)
+{
+    scene_table_t table;
+    scene_table_init(&table);
+    scene_table_store(&table, 0, 1, &s_warm);
+    scene_table_store(&table, 0, 1, &s_dim);
+    TEST_ASSERT_EQUAL(1, scene_table_count(&table));
+    TEST_ASSERT_EQUAL(10, scene_table_find(&table, 0, 1)->state.level);
+}
+
+static void test_full_table(void)
+{
+    scene_table_t table;
+    scene_table_init(&table);
+    for (int i = 0; i < SCENE_TABLE_MAX_SCENES; i++) {
+        TEST_ASSERT(scene_table_store(&table, 0, i, &s_warm));
+    }
+    TEST_ASSERT(!scene_table_store(&table, 0, SCENE_TABLE_MAX_SCENES, &s_warm));
+    /* an existing scene can still be stored again, and a removed one frees its entry */
+    TEST_ASSERT(scene_table_store(&table, 0, 0, &s_dim));
+    TEST_ASSERT(scene_table_remove(&table, 0, 3));
+    TEST_ASSERT(scene_table_store(&table, 0, SCENE_TABLE_MAX_SCENES, &s_warm));
+}
+
+static void test_remove(void)
+{
+    scene_table_t table;
+    scene_table_init(&table);
+    scene_table_store(&table, 0, 1, &s_warm);
+    TEST_ASSERT(!scene_table_remove(&table, 0, 2));
+    TEST_ASSERT(!scene_table_remove(&table, 1, 1));
+    TEST_ASSERT(scene_table_remove(&table, 0, 1));
+    TEST_ASSERT(!scene_table_find(&table, 0, 1));
+    TEST_ASSERT_EQUAL(0, scene_table_count(&table));
+}
+
+static void fill(scene_table_t *table)
+{
+    scene_table_init(table);
+    scene_table_store(table, 0, 1, &s_warm);
+    scene_table_store(table, 0, 2, &s_dim);
+    scene_table_store(table, 5, 1, &s_warm);
+    scene_table_store(table, 5, 2, &s_dim);
+    scene_table_store(table, 6, 1, &s_warm);
+}
+
+static void test_remove_scene_command(void)
+{
+    scene_table_t table;
+    fill(&table);
+    static const uint8_t payload[] = { 0x05, 0x00, 0x02 };
+    TEST_ASSERT_EQUAL(1, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_SCENE, payload, 3));
+    TEST_ASSERT(!scene_table_find(&table, 5, 2));
+    TEST_ASSERT_EQUAL(4, scene_table_count(&table));
+    /* too short for its scene ID */
+    static const uint8_t other[] = { 0x05, 0x00, 0x01 };
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_SCENE, other, 2));
+    TEST_ASSERT_EQUAL(4, scene_table_count(&table));
+}
+
+static void test_remove_all_scenes_command(void)
+{
+    scene_table_t table;
+    fill(&table);
+    static const uint8_t group_5[] = { 0x05, 0x00 };
+    TEST_ASSERT_EQUAL(2, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_ALL_SCENES, group_5, 2));
+    static const uint8_t group_0[] = { 0x00, 0x00 };
+    TEST_ASSERT_EQUAL(2, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_ALL_SCENES, group_0, 2));
+    TEST_ASSERT_EQUAL(1, scene_table_count(&table));
+    TEST_ASSERT(scene_table_find(&table, 6, 1));
+}
+
+static void test_remove_group_command(void)
+{
+    scene_table_t table;
+    fill(&table);
+    static const uint8_t group_5[] = { 0x05, 0x00 };
+    TEST_ASSERT_EQUAL(2, scene_table_apply_command(&table, SCENE_TABLE_GROUPS_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_GROUP, group_5, 2));
+    TEST_ASSERT(!scene_table_find(&table, 5, 1));
+    TEST_ASSERT(scene_table_find(&table, 6, 1));
+    /* 0 is not a group */
+    static const uint8_t group_0[] = { 0x00, 0x00 };
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_GROUPS_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_GROUP, group_0, 2));
+    TEST_ASSERT_EQUAL(3, scene_table_count(&table));
+}
+
+static void test_remove_all_groups_command(void)
+{
+    scene_table_t table;
+    fill(&table);
+    TEST_ASSERT_EQUAL(3, scene_table_apply_command(&table, SCENE_TABLE_GROUPS_CLUSTER_ID, SCENE_TABLE_CMD_REMOVE_ALL_GROUPS, NULL, 0));
+    TEST_ASSERT_EQUAL(2, scene_table_count(&table));
+    TEST_ASSERT(scene_table_find(&table, 0, 1));
+    TEST_ASSERT(scene_table_find(&table, 0, 2));
+}
+
+static void test_other_commands_leave_the_table(void)
+{
+    scene_table_t table;
+    fill(&table);
+    static const uint8_t payload[] = { 0x05, 0x00, 0x01 };
+    /* View Scene, Store Scene, Recall Scene, then Add Group */
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, 0x01, payload, 3));
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, 0x04, payload, 3));
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_SCENES_CLUSTER_ID, 0x05, payload, 3));
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, SCENE_TABLE_GROUPS_CLUSTER_ID, 0x00, payload, 3));
+    /* Remove Scene sent to another cluster */
+    TEST_ASSERT_EQUAL(0, scene_table_apply_command(&table, 0x0006, SCENE_TABLE_CMD_REMOVE_SCENE, payload, 3));
+    TEST_ASSERT_EQUAL(5, scene_table_count(&table));
+}
+
+static void test_field_sets_round_trip(void)
+{
+    uint8_t data[SCENE_TABLE_FIELD_SET_MAX_LENGTH];
+    scene_table_state_t state = { 0 };
+    static const uint16_t clusters[] = {
+        SCENE_TABLE_ON_OFF_CLUSTER_ID, SCENE_TABLE_LEVEL_CLUSTER_ID, SCENE_TABLE_COLOR_CLUSTER_ID,
+    };
+    for (size_t i = 0; i < sizeof(clusters) / sizeof(clusters[0]); i++) {
+        size_t length = scene_table_encode_field_set(&s_warm, clusters[i], data);
+        TEST_ASSERT(length > 0 && length <= SCENE_TABLE_FIELD_SET_MAX_LENGTH);
+        scene_table_decode_field_set(&state, clusters[i], data, length);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(&s_warm, &state, sizeof(state));
+
+    TEST_ASSERT_EQUAL(4, scene_table_encode_field_set(&s_warm, SCENE_TABLE_COLOR_CLUSTER_ID, data));
+    TEST_ASSERT_EQUAL(0x00, data[0]);
+    TEST_ASSERT_EQUAL(0x7A, data[1]);
+    TEST_ASSERT_EQUAL(0, scene_table_encode_field_set(&s_warm, 0x0201, data));
+}
+
+static void test_short_field_set_keeps_the_rest(void)
+{
+    scene_table_state_t state = s_dim;
+    static const uint8_t x_only[] = { 0x34, 0x12 };
+    scene_table_decode_field_set(&state, SCENE_TABLE_COLOR_CLUSTER_ID, x_only, sizeof(x_only));
+    TEST_ASSERT_EQUAL(0x1234, state.color_x);
+    TEST_ASSERT_EQUAL(s_dim.color_y, state.color_y);
+    scene_table_decode_field_set(&state, SCENE_TABLE_LEVEL_CLUSTER_ID, x_only, 0);
+    TEST_ASSERT_EQUAL(s_dim.level, state.level);
+    static const uint8_t on[] = { 0x00 };
+    scene_table_decode_field_set(&state, SCENE_TABLE_ON_OFF_CLUSTER_ID, on, 1);
+    TEST_ASSERT_EQUAL(0, state.power);
+}
+
+int main(void)
+{
+    TEST_RUN(test_store_and_find);
+    TEST_RUN(test_store_overwrites);
+    TEST_RUN(test_full_table);
+    TEST_RUN(test_remove);
+    TEST_RUN(test_remove_scene_command);
+    TEST_RUN(test_remove_all_scenes_command);
+    TEST_RUN(test_remove_group_command);
+    TEST_RUN(test_remove_all_groups_command);
+    TEST_RUN(test_other_commands_leave_the_table);
+    TEST_RUN(test_field_sets_round_trip);
+    TEST_RUN(test_short_field_set_keeps_the_rest);
+    return TEST_END();
+}
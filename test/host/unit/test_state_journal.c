@@ -0,0 +1,138 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of state_journal
+ */
+
+#include "state_journal.h"
+#include "test.h"
+
+static void test_clean_journal_has_no_deadline(void)
+{
+    state_journal_t journal;
+    int64_t next_ms;
+    state_journal_init(&journal, 2000, 30000, 0);
+    TEST_ASSERT(!state_journal_poll(&journal, 1000000, &next_ms));
+    TEST_ASSERT_EQUAL(STATE_JOURNAL_NO_DEADLINE, next_ms);
+}
+
+static void test_change_is_due_after_debounce(void)
+{
+    state_journal_t journal;
+    int64_t next_ms;
+    state_journal_init(&journal, 2000, 30000, 0);
+    TEST_ASSERT_EQUAL(2100, state_journal_touch(&journal, 100));
+    TEST_ASSERT(!state_journal_poll(&journal, 2099, &next_ms));
+    TEST_ASSERT_EQUAL(2100, next_ms);
+    TEST_ASSERT(state_journal_poll(&journal, 2100, &next_ms));
+    TEST_ASSERT_EQUAL(STATE_JOURNAL_NO_DEADLINE, next_ms);
+    /* written once */
+    TEST_ASSERT(!state_journal_poll(&journal, 2200, &next_ms));
+}
+
+static void test_burst_is_written_at_max_delay(void)
+{
+    state_journal_t journal;
+    int64_t next_ms;
+    state_journal_init(&journal, 2000, 30000, 0);
+    for (int64_t now_ms = 0; now_ms < 30000; now_ms += 1000) {
+        state_journal_touch(&journal, now_ms);
+        TEST_ASSERT(!state_journal_poll(&journal, now_ms, &next_ms));
+    }
+    TEST_ASSERT_EQUAL(30000, state_journal_touch(&journal, 29500));
+    TEST_ASSERT(state_journal_poll(&journal, 30000, &next_ms));
+}
+
+static void test_max_delay_is_at_least_debounce(void)
+{
+    state_journal_t journal;
+    state_journal_init(&journal, 2000, 500, 0);
+    TEST_ASSERT_EQUAL(2000, journal.max_delay_ms);
+    TEST_ASSERT_EQUAL(2000, state_journal_touch(&journal, 0));
+}
+
+static void test_touch_after_failed_write_is_due_again(void)
+{
+    state_journal_t journal;
+    int64_t next_ms;
+    state_journal_init(&journal, 2000, 30000, 0);
+    state_journal_touch(&journal, 0);
+    TEST_ASSERT(state_journal_poll(&journal, 2000, &next_ms));
+    /* what state_store does when the write fails */
+    TEST_ASSERT_EQUAL(4000, state_journal_touch(&journal, 2000));
+    TEST_ASSERT(!state_journal_poll(&journal, 3999, &next_ms));
+    TEST_ASSERT_EQUAL(4000, next_ms);
+    TEST_ASSERT(state_journal_poll(&journal, 4000, &next_ms));
+}
+
+static void test_record_round_trip(void)
+{
+    state_journal_t journal;
+    state_journal_header_t header;
+    const uint8_t payload[] = { 1, 2, 3, 4, 5 };
+    state_journal_init(&journal, 0, 0, 41);
+    state_journal_encode(&journal, &header, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(STATE_JOURNAL_FORMAT, header.format);
+    TEST_ASSERT_EQUAL(sizeof(payload), header.length);
+    TEST_ASSERT_EQUAL(42, header.sequence);
+    TEST_ASSERT(state_journal_check(&header, payload, sizeof(payload)));
+    state_journal_encode(&journal, &header, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(43, header.sequence);
+}
+
+static void test_record_crc_is_crc32(void)
+{
+    /* CRC-32 of the header fields before the CRC, then of "123456789" */
+    state_journal_t journal;
+    state_journal_header_t header;
+    state_journal_init(&journal, 0, 0, 0);
+    state_journal_encode(&journal, &header, "123456789", 9);
+    uint8_t bytes[offsetof(state_journal_header_t, crc) + 9];
+    memcpy(bytes, &header, offsetof(state_journal_header_t, crc));
+    memcpy(&bytes[offsetof(state_journal_header_t, crc)], "123456789", 9);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    TEST_ASSERT_EQUAL((uint32_t)~crc, header.crc);
+}
+
+static void test_damaged_record_is_rejected(void)
+{
+    state_journal_t journal;
+    state_journal_header_t header;
+    uint8_t payload[] = { 1, 2, 3, 4, 5 };
+    state_journal_init(&journal, 0, 0, 0);
+    state_journal_encode(&journal, &header, payload, sizeof(payload));
+
+    payload[2] ^= 0x10;
+    TEST_ASSERT(!state_journal_check(&header, payload, sizeof(payload)));
+    payload[2] ^= 0x10;
+
+    header.sequence++;
+    TEST_ASSERT(!state_journal_check(&header, payload, sizeof(payload)));
+    header.sequence--;
+
+    /* a record of an older layout, the CRC does not help there */
+    TEST_ASSERT(!state_journal_check(&header, payload, sizeof(payload) - 1));
+    header.format ^= 1;
+    TEST_ASSERT(!state_journal_check(&header, payload, sizeof(payload)));
+    header.format ^= 1;
+    TEST_ASSERT(state_journal_check(&header, payload, sizeof(payload)));
+}
+
+int main(void)
+{
+    TEST_RUN(test_clean_journal_has_no_deadline);
+    TEST_RUN(test_change_is_due_after_debounce);
+    TEST_RUN(test_burst_is_written_at_max_delay);
+    TEST_RUN(test_max_delay_is_at_least_debounce);
+    TEST_RUN(test_touch_after_failed_write_is_due_again);
+    TEST_RUN(test_record_round_trip);
+    TEST_RUN(test_record_crc_is_crc32);
+    TEST_RUN(test_damaged_record_is_rejected);
+    return TEST_END();
+}
@@ -0,0 +1,126 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of state_store on the NVS stand-in
+ */
+
+#include <time.h>
+#include "esp_random.h"
+#include "sim.h"
+#include "state_store.h"
+#include "test.h"
+
+/* changes of the wear run, made in dimming bursts with pauses of up to ten minutes after the debounce time between them */
+#define WEAR_CHANGES        1000000
+#define WEAR_BURST          8
+#define WEAR_BURST_STEP_MS  100
+#define WEAR_PAUSE_MAX_S    600
+/* a tenth of the 100000 erase cycles NVS flash pages are rated for */
+#define WEAR_PAGE_ERASE_MAX 10000
+
+static state_store_state_t s_state;
+
+static void snapshot(state_store_state_t *state)
+{
+    *state = s_state;
+}
+
+static void change(uint8_t level)
+{
+    s_state.light_level = level;
+    state_store_touch();
+}
+
+static void test_first_boot_has_nothing_saved(void)
+{
+    state_store_state_t state;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, state_store_restore(&state));
+    state_store_init(snapshot);
+}
+
+static void test_change_is_saved_after_debounce(void)
+{
+    uint32_t writes = sim_nvs_write_count();
+    change(10);
+    sim_advance((STATE_STORE_DEBOUNCE_MS - 1) * 1000LL);
+    TEST_ASSERT_EQUAL(writes, sim_nvs_write_count());
+    sim_advance(1000);
+    TEST_ASSERT_EQUAL(writes + 1, sim_nvs_write_count());
+}
+
+static void test_failed_write_is_retried(void)
+{
+    uint32_t writes = sim_nvs_write_count();
+    change(20);
+    sim_nvs_fail_writes(1, ESP_ERR_NVS_NOT_ENOUGH_SPACE);
+    sim_advance(STATE_STORE_DEBOUNCE_MS * 1000LL);
+    TEST_ASSERT_EQUAL(writes, sim_nvs_write_count());
+    /* no further change, the pending one is written after another debounce time */
+    sim_advance(STATE_STORE_DEBOUNCE_MS * 1000LL);
+    TEST_ASSERT_EQUAL(writes + 1, sim_nvs_write_count());
+}
+
+static void test_failed_commit_is_retried(void)
+{
+    uint32_t writes = sim_nvs_write_count();
+    change(30);
+    sim_nvs_fail_commits(1, ESP_FAIL);
+    sim_advance(STATE_STORE_DEBOUNCE_MS * 1000LL);
+    TEST_ASSERT_EQUAL(writes + 1, sim_nvs_write_count());
+    sim_advance(STATE_STORE_DEBOUNCE_MS * 1000LL);
+    TEST_ASSERT_EQUAL(writes + 2, sim_nvs_write_count());
+    /* then nothing is pending */
+    sim_advance(STATE_STORE_MAX_DELAY_MS * 1000LL);
+    TEST_ASSERT_EQUAL(writes + 2, sim_nvs_write_count());
+}
+
+static void test_restore_reads_newest_record(void)
+{
+    state_store_state_t state;
+    TEST_ASSERT_EQUAL(ESP_OK, state_store_restore(&state));
+    TEST_ASSERT_EQUAL(30, state.light_level);
+}
+
+static void test_wear_of_a_million_changes(void)
+{
+    uint32_t writes = sim_nvs_write_count();
+    uint32_t erases = sim_nvs_erase_count();
+    for (uint32_t i = 0; i < WEAR_CHANGES; i++) {
+        change((uint8_t)i);
+        if (i % WEAR_BURST != WEAR_BURST - 1) {
+            sim_advance(WEAR_BURST_STEP_MS * 1000LL);
+        } else {
+            sim_advance(STATE_STORE_DEBOUNCE_MS * 1000LL + esp_random() % WEAR_PAUSE_MAX_S * 1000000LL);
+        }
+    }
+    sim_advance(STATE_STORE_MAX_DELAY_MS * 1000LL);
+    writes = sim_nvs_write_count() - writes;
+    erases = sim_nvs_erase_count() - erases;
+
+    struct timespec start, end;
+    state_store_state_t state;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    esp_err_t err = state_store_restore(&state);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int64_t restore_ns = (end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec;
+
+    printf("%d changes: %" PRIu32 " records written, %" PRIu32 " page erases, at most %" PRIu32 " on one page\n",
+           WEAR_CHANGES, writes, erases, sim_nvs_page_erase_max());
+    printf("restore after the run: %" PRId64 " ns on the host\n", restore_ns);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+    TEST_ASSERT_EQUAL((uint8_t)(WEAR_CHANGES - 1), state.light_level);
+    /* a burst is one record */
+    TEST_ASSERT_EQUAL(WEAR_CHANGES / WEAR_BURST, writes);
+    TEST_ASSERT(sim_nvs_page_erase_max() < WEAR_PAGE_ERASE_MAX);
+}
+
+int main(void)
+{
+    TEST_RUN(test_first_boot_has_nothing_saved);
+    TEST_RUN(test_change_is_saved_after_debounce);
+    TEST_RUN(test_failed_write_is_retried);
+    TEST_RUN(test_failed_commit_is_retried);
+    TEST_RUN(test_restore_reads_newest_record);
+    TEST_RUN(test_wear_of_a_million_changes);
+    return TEST_END();
+}
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host simulation of status_indicator on the timer wheel, light_state and the
+ * light driver, with the Zigbee scheduler alarm and the LED strip stand-ins: the
+ * LED on-time of an indication as the module accounts it, against the time the
+ * frames sent show it and the time the strip (RMT channel) is held, for a single
+ * press, a press repeated during the indication, a mode toggled during it and
+ * an indication over a lit light.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "latency_trace.h"
+#include "light_driver.h"
+#include "light_state.h"
+#include "sim.h"
+#include "status_indicator.h"
+#include "test.h"
+
+#define STEP_US             (STATUS_INDICATOR_TICK_MS * 1000)
+#define INDICATION_MS       (STATUS_INDICATOR_ON_MS + STATUS_INDICATOR_FADE_MS)
+
+static const light_driver_state_t s_off = { .power = false, .level = UINT8_MAX, .color_x = 0x5000, .color_y = 0x5439 };
+static const light_driver_state_t s_white = { .power = true, .level = UINT8_MAX, .color_x = 0x5000, .color_y = 0x5439 };
+
+typedef struct {
+    int64_t strip_held_ms;
+    int64_t first_frame_ms;     /* from the press */
+    int64_t last_frame_ms;
+    size_t frames;
+} led_usage_t;
+
+static bool strip_held(void)
+{
+    return sim_led_strip_get()->created > sim_led_strip_get()->deleted;
+}
+
+static void run(int64_t duration_ms, led_usage_t *usage)
+{
+    for (int64_t step = 0; step < duration_ms * 1000 / STEP_US; step++) {
+        usage->strip_held_ms += strip_held() ? STATUS_INDICATOR_TICK_MS : 0;
+        sim_advance(STEP_US);
+    }
+}
+
+/* press, then the steps given by the test case, then until the indication is over */
+static void finish(int64_t start_us, led_usage_t *usage)
+{
+    run(INDICATION_MS + 1000, usage);
+    usage->frames = sim_led_strip_frame_count();
+    TEST_ASSERT(usage->frames > 0);
+    usage->first_frame_ms = (sim_led_strip_frame(0)->time_us - start_us) / 1000;
+    usage->last_frame_ms = (sim_led_strip_frame(usage->frames - 1)->time_us - start_us) / 1000;
+}
+
+static void print_usage(const char *name, const led_usage_t *usage)
+{
+    const status_indicator_stats_t *stats = status_indicator_get_stats();
+    printf("%-22s LED on %5" PRIu32 " ms as accounted, frames from %3" PRId64 " to %5" PRId64 " ms (%2zu), strip held %5" PRId64
+           " ms\n", name, stats->last_on_ms, usage->first_frame_ms, usage->last_frame_ms, usage->frames, usage->strip_held_ms);
+}
+
+static int64_t start(const light_driver_state_t *light)
+{
+    light_state_apply(light, 0);
+    sim_advance(100 * 1000);
+    sim_led_strip_frames_clear();
+    return sim_now_us();
+}
+
+static void test_init(void)
+{
+    latency_trace_init();
+    light_driver_init(false);
+    light_state_init(&s_off);
+    status_indicator_init();
+    sim_advance(LIGHT_DRIVER_FRAME_PERIOD_US);
+    TEST_ASSERT(!strip_held());
+    TEST_ASSERT_EQUAL(0, status_indicator_get_stats()->count);
+}
+
+static void test_single_press(void)
+{
+    led_usage_t usage = { 0 };
+    int64_t start_us = start(&s_off);
+    status_indicator_show(true);
+    /* red while shown */
+    run(STATUS_INDICATOR_ON_MS / 2, &usage);
+    TEST_ASSERT(sim_led_strip_get()->pixels[0][0] > 4 * sim_led_strip_get()->pixels[0][1]);
+    finish(start_us, &usage);
+    print_usage("single press", &usage);
+
+    const status_indicator_stats_t *stats = status_indicator_get_stats();
+    TEST_ASSERT_EQUAL(1, stats->count);
+    TEST_ASSERT(stats->last_on_ms >= INDICATION_MS && stats->last_on_ms <= INDICATION_MS + 2 * STATUS_INDICATOR_TICK_MS);
+    /* the frames end with the fade, then the strip is released */
+    TEST_ASSERT(usage.last_frame_ms <= stats->last_on_ms);
+    TEST_ASSERT(usage.strip_held_ms >= usage.last_frame_ms - usage.first_frame_ms - STATUS_INDICATOR_TICK_MS);
+    TEST_ASSERT(usage.strip_held_ms <= stats->last_on_ms + 2 * STATUS_INDICATOR_TICK_MS);
+    TEST_ASSERT(!strip_held());
+    TEST_ASSERT_EQUAL(0, sim_led_strip_get()->pixels[0][0]);
+}
+
+static void test_press_again_restarts_the_on_time(void)
+{
+    led_usage_t usage = { 0 };
+    int64_t start_us = start(&s_off);
+    status_indicator_show(true);
+    run(STATUS_INDICATOR_ON_MS / 2, &usage);
+    status_indicator_show(true);
+    finish(start_us, &usage);
+    print_usage("pressed again at 5 s", &usage);
+
+    const status_indicator_stats_t *stats = status_indicator_get_stats();
+    TEST_ASSERT_EQUAL(2, stats->count);
+    TEST_ASSERT(stats->last_on_ms >= STATUS_INDICATOR_ON_MS / 2 + INDICATION_MS);
+    TEST_ASSERT(stats->last_on_ms <= STATUS_INDICATOR_ON_MS / 2 + INDICATION_MS + 2 * STATUS_INDICATOR_TICK_MS);
+    TEST_ASSERT(!strip_held());
+}
+
+static void test_toggle_during_the_indication(void)
+{
+    led_usage_t usage = { 0 };
+    int64_t start_us = start(&s_off);
+    status_indicator_show(true);
+    run(STATUS_INDICATOR_ON_MS / 2, &usage);
+    status_indicator_update(false);
+    run(100, &usage);
+    /* green now, the on-time goes on */
+    TEST_ASSERT(sim_led_strip_get()->pixels[0][1] > 4 * sim_led_strip_get()->pixels[0][0]);
+    finish(start_us, &usage);
+    print_usage("toggled at 5 s", &usage);
+
+    const status_indicator_stats_t *stats = status_indicator_get_stats();
+    TEST_ASSERT_EQUAL(3, stats->count);
+    TEST_ASSERT(stats->last_on_ms >= INDICATION_MS && stats->last_on_ms <= INDICATION_MS + 2 * STATUS_INDICATOR_TICK_MS);
+}
+
+static void test_indication_over_a_lit_light(void)
+{
+    led_usage_t usage = { 0 };
+    int64_t start_us = start(&s_white);
+    uint8_t lit[3];
+    memcpy(lit, sim_led_strip_get()->pixels[0], sizeof(lit));
+    TEST_ASSERT(lit[0] > 0);
+    status_indicator_show(false);
+    finish(start_us, &usage);
+    print_usage("over a lit light", &usage);
+
+    const status_indicator_stats_t *stats = status_indicator_get_stats();
+    TEST_ASSERT_EQUAL(4, stats->count);
+    TEST_ASSERT(stats->last_on_ms >= INDICATION_MS && stats->last_on_ms <= INDICATION_MS + 2 * STATUS_INDICATOR_TICK_MS);
+    /* back to the light, which keeps the strip */
+    TEST_ASSERT(strip_held());
+    TEST_ASSERT_EQUAL(usage.strip_held_ms, INDICATION_MS + 1000);
+    TEST_ASSERT_EQUAL_MEMORY(light_state_get(), &s_white, sizeof(s_white));
+    TEST_ASSERT_EQUAL_MEMORY(lit, sim_led_strip_get()->pixels[0], sizeof(lit));
+    printf("%" PRIu32 " indications, %" PRIu64 " ms of LED on-time in total\n", stats->count, stats->total_on_ms);
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_single_press);
+    TEST_RUN(test_press_again_restarts_the_on_time);
+    TEST_RUN(test_toggle_during_the_indication);
+    TEST_RUN(test_indication_over_a_lit_light);
+    return TEST_END();
+}
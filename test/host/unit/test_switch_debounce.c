@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of switch_debounce
+ */
+
+#include "switch_debounce.h"
+#include "test.h"
+
+static void test_clean_press_and_release(void)
+{
+    switch_debounce_t db;
+    switch_debounce_init(&db, false, 3);
+    switch_debounce_edge(&db, 1000);
+    TEST_ASSERT_EQUAL(1000, db.first_edge_us);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_PRESSED, switch_debounce_sample(&db, true));
+    TEST_ASSERT(db.pressed);
+    TEST_ASSERT_EQUAL(-1, db.first_edge_us);
+
+    switch_debounce_edge(&db, 50000);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, false));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, false));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_RELEASED, switch_debounce_sample(&db, false));
+    TEST_ASSERT(!db.pressed);
+}
+
+static void test_bounce_restarts_the_window(void)
+{
+    switch_debounce_t db;
+    switch_debounce_init(&db, false, 3);
+    switch_debounce_edge(&db, 0);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, false));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT(!db.pressed);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_PRESSED, switch_debounce_sample(&db, true));
+}
+
+static void test_glitch_settles_unchanged(void)
+{
+    switch_debounce_t db;
+    switch_debounce_init(&db, false, 2);
+    switch_debounce_edge(&db, 0);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, true));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SAMPLE_AGAIN, switch_debounce_sample(&db, false));
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_SETTLED, switch_debounce_sample(&db, false));
+    TEST_ASSERT(!db.pressed);
+    TEST_ASSERT_EQUAL(-1, db.first_edge_us);
+}
+
+static void test_edges_within_a_window_keep_the_first(void)
+{
+    switch_debounce_t db;
+    switch_debounce_init(&db, false, 2);
+    switch_debounce_edge(&db, 100);
+    switch_debounce_sample(&db, true);
+    switch_debounce_edge(&db, 300);
+    TEST_ASSERT_EQUAL(100, db.first_edge_us);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_PRESSED, switch_debounce_sample(&db, true));
+    switch_debounce_edge(&db, 900);
+    TEST_ASSERT_EQUAL(900, db.first_edge_us);
+}
+
+static void test_one_sample_required_at_least(void)
+{
+    switch_debounce_t db;
+    switch_debounce_init(&db, true, 0);
+    TEST_ASSERT_EQUAL(1, db.required_samples);
+    switch_debounce_edge(&db, 0);
+    TEST_ASSERT_EQUAL(SWITCH_DEBOUNCE_RELEASED, switch_debounce_sample(&db, false));
+}
+
+int main(void)
+{
+    TEST_RUN(test_clean_press_and_release);
+    TEST_RUN(test_bounce_restarts_the_window);
+    TEST_RUN(test_glitch_settles_unchanged);
+    TEST_RUN(test_edges_within_a_window_keep_the_first);
+    TEST_RUN(test_one_sample_required_at_least);
+    return TEST_END();
+}
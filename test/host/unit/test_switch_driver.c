@@ -0,0 +1,218 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host stress test of switch_driver on the GPIO and esp_timer stand-ins: millions
+ * of bouncing edges on all the buttons at once go through the interrupt handler
+ * and the shared debounce timer, every press and release must reach the callback
+ * once and in time. Then the press to callback latency of one button for each
+ * bounce profile.
+ */
+
+#include <inttypes.h>
+#include "sim.h"
+#include "switch_driver.h"
+#include "test.h"
+
+#define STRESS_EDGES        2000000
+/* bursts shorter than two sample periods, so that no three samples fall inside one */
+#define BOUNCE_MAX_US       (2 * SWITCH_DEBOUNCE_SAMPLE_PERIOD_US - 500)
+/* stable levels held longer than a debounce takes, as a finger does */
+#define STABLE_MIN_US       30000
+#define STABLE_MAX_US       250000
+/* first edge to callback: the burst, then the stable samples after the first sample period */
+#define LATENCY_MAX_US      (BOUNCE_MAX_US + (SWITCH_DEBOUNCE_STABLE_SAMPLES + 1) * SWITCH_DEBOUNCE_SAMPLE_PERIOD_US)
+#define PROFILE_TRANSITIONS 10000
+#define PROFILE_COUNT       (sizeof(s_profiles) / sizeof(s_profiles[0]))
+
+/** Bounce profile of a press or release: the toggles after the first edge, spread over the span */
+typedef struct {
+    const char *name;
+    uint32_t bounces;
+    uint32_t span_us;
+} bounce_profile_t;
+
+/** Edges driven on one button and the press or release they must produce */
+typedef struct {
+    switch_func_pair_t *pair;
+    bool level;                 /* level driven, the buttons are active low */
+    uint32_t toggles_left;      /* toggles left in the current burst */
+    int64_t next_us;            /* time of the next toggle */
+    int64_t burst_end_us;       /* the current burst does not toggle after this */
+    bool outstanding;           /* a press or release is expected */
+    bool expected_pressed;
+    int64_t first_edge_us;
+    int64_t settle_us;
+} stress_pin_t;
+
+typedef struct {
+    uint64_t edges;
+    uint64_t transitions;
+    uint64_t callbacks;
+    uint64_t dropped;
+    uint64_t spurious;
+    int64_t worst_first_edge_us;
+    int64_t worst_settle_us;
+    int64_t first_edge_sum_us;
+    int64_t settle_sum_us;
+} stress_result_t;
+
+static const bounce_profile_t s_profiles[] = {
+    { "clean edge", 0, 0 },
+    { "short bounce", 3, 1000 },
+    { "long bounce", 20, BOUNCE_MAX_US },
+};
+
+static switch_func_pair_t s_buttons[SWITCH_DRIVER_MAX_BUTTONS] = {
+    { .pin = GPIO_NUM_4, .func = SWITCH_ONOFF_TOGGLE_CONTROL },
+    { .pin = GPIO_NUM_5, .func = SWITCH_LEVEL_UP_CONTROL },
+    { .pin = GPIO_NUM_6, .func = SWITCH_LEVEL_DOWN_CONTROL },
+    { .pin = GPIO_NUM_7, .func = SWITCH_COLOR_CONTROL },
+};
+static stress_pin_t s_pins[SWITCH_DRIVER_MAX_BUTTONS];
+static stress_result_t s_result;
+static uint32_t s_rand = 0x9E3779B9;
+/* profile of every burst, or -1 to draw one for each */
+static int s_forced_profile = -1;
+
+static uint32_t stress_rand(uint32_t min, uint32_t max)
+{
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return min + s_rand % (max - min + 1);
+}
+
+static void stress_callback(switch_func_pair_t *pair, switch_gesture_t gesture)
+{
+    if (gesture != SWITCH_GESTURE_PRESS && gesture != SWITCH_GESTURE_RELEASE) {
+        return;
+    }
+    stress_pin_t *pin = &s_pins[pair - s_buttons];
+    s_result.callbacks++;
+    if (!pin->outstanding || pin->expected_pressed != (gesture == SWITCH_GESTURE_PRESS)) {
+        s_result.spurious++;
+        return;
+    }
+    pin->outstanding = false;
+    int64_t first_edge_us = sim_now_us() - pin->first_edge_us;
+    int64_t settle_us = sim_now_us() - pin->settle_us;
+    s_result.worst_first_edge_us = first_edge_us > s_result.worst_first_edge_us ? first_edge_us : s_result.worst_first_edge_us;
+    s_result.worst_settle_us = settle_us > s_result.worst_settle_us ? settle_us : s_result.worst_settle_us;
+    s_result.first_edge_sum_us += first_edge_us;
+    s_result.settle_sum_us += settle_us;
+}
+
+/* Start a press or release: one clean edge, a few fast bounces, or a long bouncing burst */
+static void stress_start_burst(stress_pin_t *pin, int64_t now_us)
+{
+    if (pin->outstanding) {
+        s_result.dropped++;
+    }
+    const bounce_profile_t *profile = &s_profiles[s_forced_profile >= 0 ? s_forced_profile : stress_rand(0, PROFILE_COUNT - 1)];
+    pin->toggles_left = 2 * stress_rand(0, profile->bounces) + 1;
+    pin->burst_end_us = now_us + profile->span_us;
+    pin->outstanding = true;
+    pin->expected_pressed = pin->level;     /* active low, the burst ends on the other level */
+    pin->first_edge_us = now_us;
+    s_result.transitions++;
+}
+
+static void stress_toggle(stress_pin_t *pin, int64_t now_us)
+{
+    if (pin->toggles_left == 0) {
+        stress_start_burst(pin, now_us);
+    }
+    pin->level = !pin->level;
+    sim_gpio_set(pin->pair->pin, pin->level);
+    s_result.edges++;
+    if (--pin->toggles_left > 0) {
+        /* spread the toggles left over what remains of the burst */
+        int64_t budget_us = (pin->burst_end_us - now_us) / pin->toggles_left;
+        pin->next_us = now_us + stress_rand(1, budget_us > 1 ? (uint32_t)budget_us : 1);
+    } else {
+        pin->settle_us = now_us;
+        pin->next_us = now_us + stress_rand(STABLE_MIN_US, STABLE_MAX_US);
+    }
+}
+
+static void test_init(void)
+{
+    TEST_ASSERT(switch_driver_init(s_buttons, SWITCH_DRIVER_MAX_BUTTONS, stress_callback));
+    for (int i = 0; i < SWITCH_DRIVER_MAX_BUTTONS; i++) {
+        s_pins[i] = (stress_pin_t) {
+            .pair = &s_buttons[i],
+            .level = !GPIO_INPUT_LEVEL_ON,
+            .next_us = stress_rand(0, STABLE_MAX_US),
+        };
+    }
+}
+
+static void test_every_press_and_release_reaches_the_callback(void)
+{
+    for (;;) {
+        /* once enough edges were driven, only the bursts under way go on */
+        bool draining = s_result.edges >= STRESS_EDGES;
+        stress_pin_t *next = NULL;
+        for (int i = 0; i < SWITCH_DRIVER_MAX_BUTTONS; i++) {
+            stress_pin_t *pin = &s_pins[i];
+            if ((!draining || pin->toggles_left > 0) && (!next || pin->next_us < next->next_us)) {
+                next = pin;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        sim_advance(next->next_us - sim_now_us());
+        stress_toggle(next, next->next_us);
+    }
+    sim_advance(STABLE_MAX_US);
+    for (int i = 0; i < SWITCH_DRIVER_MAX_BUTTONS; i++) {
+        s_result.dropped += s_pins[i].outstanding;
+    }
+
+    printf("%" PRIu64 " edges, %" PRIu64 " presses and releases, %" PRIu64 " callbacks, "
+           "%" PRIu64 " dropped, %" PRIu64 " spurious\n",
+           s_result.edges, s_result.transitions, s_result.callbacks, s_result.dropped, s_result.spurious);
+    printf("worst latency %" PRId64 " us from the first edge, %" PRId64 " us from the last one\n",
+           s_result.worst_first_edge_us, s_result.worst_settle_us);
+    TEST_ASSERT(s_result.edges >= STRESS_EDGES);
+    TEST_ASSERT_EQUAL(0, s_result.dropped);
+    TEST_ASSERT_EQUAL(0, s_result.spurious);
+    TEST_ASSERT(s_result.worst_first_edge_us <= LATENCY_MAX_US);
+    TEST_ASSERT(s_result.worst_settle_us <= (SWITCH_DEBOUNCE_STABLE_SAMPLES + 1) * SWITCH_DEBOUNCE_SAMPLE_PERIOD_US);
+}
+
+static void test_latency_per_bounce_profile(void)
+{
+    stress_pin_t *pin = &s_pins[0];
+    for (size_t p = 0; p < PROFILE_COUNT; p++) {
+        s_forced_profile = p;
+        s_result = (stress_result_t) { 0 };
+        pin->next_us = sim_now_us() + STABLE_MIN_US;
+        while (s_result.transitions < PROFILE_TRANSITIONS || pin->toggles_left > 0) {
+            sim_advance(pin->next_us - sim_now_us());
+            stress_toggle(pin, pin->next_us);
+        }
+        sim_advance(STABLE_MAX_US);
+        s_result.dropped += pin->outstanding;
+
+        printf("%-12s: %" PRIu64 " presses and releases, latency from the first edge %.1f ms on average, %.1f ms at worst, "
+               "from the last edge %.1f ms on average, %.1f ms at worst\n",
+               s_profiles[p].name, s_result.transitions, s_result.first_edge_sum_us / 1000.0 / s_result.callbacks,
+               s_result.worst_first_edge_us / 1000.0, s_result.settle_sum_us / 1000.0 / s_result.callbacks,
+               s_result.worst_settle_us / 1000.0);
+        TEST_ASSERT_EQUAL(s_result.transitions, s_result.callbacks);
+        TEST_ASSERT_EQUAL(0, s_result.dropped);
+        TEST_ASSERT_EQUAL(0, s_result.spurious);
+        TEST_ASSERT(s_result.worst_first_edge_us <= s_profiles[p].span_us + (SWITCH_DEBOUNCE_STABLE_SAMPLES + 1) * SWITCH_DEBOUNCE_SAMPLE_PERIOD_US);
+    }
+    s_forced_profile = -1;
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_every_press_and_release_reaches_the_callback);
+    TEST_RUN(test_latency_per_bounce_profile);
+    return TEST_END();
+}
@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of switch_gesture
+ */
+
+#include "switch_gesture.h"
+#include "test.h"
+
+#define MS(ms)  ((int64_t)(ms) * 1000)
+
+#define PRESS           SWITCH_GESTURE_BIT(SWITCH_GESTURE_PRESS)
+#define RELEASE         SWITCH_GESTURE_BIT(SWITCH_GESTURE_RELEASE)
+#define CLICK           SWITCH_GESTURE_BIT(SWITCH_GESTURE_CLICK)
+#define DOUBLE_CLICK    SWITCH_GESTURE_BIT(SWITCH_GESTURE_DOUBLE_CLICK)
+#define LONG_PRESS      SWITCH_GESTURE_BIT(SWITCH_GESTURE_LONG_PRESS)
+#define HOLD            SWITCH_GESTURE_BIT(SWITCH_GESTURE_HOLD)
+
+static const switch_gesture_config_t s_config = {
+    .double_click_ms = 300,
+    .long_press_ms = 1000,
+    .hold_ms = 5000,
+};
+
+static void test_click_without_double_click(void)
+{
+    switch_gesture_config_t config = { 0 };
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &config);
+    TEST_ASSERT_EQUAL(PRESS, switch_gesture_input(&state, true, MS(0)));
+    TEST_ASSERT_EQUAL(SWITCH_GESTURE_NO_DEADLINE, switch_gesture_next_deadline(&state));
+    TEST_ASSERT_EQUAL(RELEASE | CLICK, switch_gesture_input(&state, false, MS(100)));
+    /* an unchanged input is not a gesture */
+    TEST_ASSERT_EQUAL(0, switch_gesture_input(&state, false, MS(150)));
+}
+
+static void test_click_waits_out_the_double_click_window(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    TEST_ASSERT_EQUAL(RELEASE, switch_gesture_input(&state, false, MS(100)));
+    TEST_ASSERT_EQUAL(MS(400), switch_gesture_next_deadline(&state));
+    TEST_ASSERT_EQUAL(0, switch_gesture_poll(&state, MS(399)));
+    TEST_ASSERT_EQUAL(CLICK, switch_gesture_poll(&state, MS(400)));
+    TEST_ASSERT_EQUAL(SWITCH_GESTURE_NO_DEADLINE, switch_gesture_next_deadline(&state));
+}
+
+static void test_double_click(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    switch_gesture_input(&state, false, MS(100));
+    TEST_ASSERT_EQUAL(PRESS, switch_gesture_input(&state, true, MS(300)));
+    TEST_ASSERT_EQUAL(RELEASE | DOUBLE_CLICK, switch_gesture_input(&state, false, MS(400)));
+    TEST_ASSERT_EQUAL(0, switch_gesture_poll(&state, MS(2000)));
+}
+
+static void test_late_second_press_is_two_clicks(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    switch_gesture_input(&state, false, MS(100));
+    /* the overdue click comes with the press even if nobody polled */
+    TEST_ASSERT_EQUAL(CLICK | PRESS, switch_gesture_input(&state, true, MS(500)));
+    TEST_ASSERT_EQUAL(RELEASE, switch_gesture_input(&state, false, MS(600)));
+    TEST_ASSERT_EQUAL(CLICK, switch_gesture_poll(&state, MS(900)));
+}
+
+static void test_long_press_then_hold(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    TEST_ASSERT_EQUAL(MS(1000), switch_gesture_next_deadline(&state));
+    TEST_ASSERT_EQUAL(LONG_PRESS, switch_gesture_poll(&state, MS(1000)));
+    TEST_ASSERT_EQUAL(0, switch_gesture_poll(&state, MS(1500)));
+    TEST_ASSERT_EQUAL(MS(5000), switch_gesture_next_deadline(&state));
+    TEST_ASSERT_EQUAL(HOLD, switch_gesture_poll(&state, MS(5000)));
+    TEST_ASSERT_EQUAL(SWITCH_GESTURE_NO_DEADLINE, switch_gesture_next_deadline(&state));
+    /* a timed out press is not a click */
+    TEST_ASSERT_EQUAL(RELEASE, switch_gesture_input(&state, false, MS(6000)));
+    TEST_ASSERT_EQUAL(SWITCH_GESTURE_NO_DEADLINE, switch_gesture_next_deadline(&state));
+}
+
+static void test_late_poll_fires_both(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    TEST_ASSERT_EQUAL(LONG_PRESS | HOLD, switch_gesture_poll(&state, MS(7000)));
+}
+
+static void test_timeout_seen_on_release(void)
+{
+    switch_gesture_state_t state;
+    switch_gesture_init(&state, &s_config);
+    switch_gesture_input(&state, true, MS(0));
+    /* released after the long press time without a poll in between */
+    TEST_ASSERT_EQUAL(LONG_PRESS | RELEASE, switch_gesture_input(&state, false, MS(1200)));
+    TEST_ASSERT_EQUAL(0, switch_gesture_poll(&state, MS(2000)));
+}
+
+int main(void)
+{
+    TEST_RUN(test_click_without_double_click);
+    TEST_RUN(test_click_waits_out_the_double_click_window);
+    TEST_RUN(test_double_click);
+    TEST_RUN(test_late_second_press_is_two_clicks);
+    TEST_RUN(test_long_press_then_hold);
+    TEST_RUN(test_late_poll_fires_both);
+    TEST_RUN(test_timeout_seen_on_release);
+    return TEST_END();
+}
@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of temperature_filter, and a bath trace replayed through the signal
+ * chain and the reporting of temperature_sensor.c
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include "report_coalescer.h"
+#include "temperature_filter.h"
+#include "temperature_sensor.h"
+#include "test.h"
+
+#define TRACE_PERIOD_MS     TEMPERATURE_SENSOR_PERIOD_MS
+
+static const temperature_filter_ntc_point_t s_table[] = {
+    { 2500, 0 },
+    { 2000, 1000 },
+    { 1500, 2500 },
+};
+
+static void test_ntc_interpolation(void)
+{
+    TEST_ASSERT_EQUAL(0, temperature_filter_ntc(s_table, 3, 2500));
+    TEST_ASSERT_EQUAL(1000, temperature_filter_ntc(s_table, 3, 2000));
+    TEST_ASSERT_EQUAL(2500, temperature_filter_ntc(s_table, 3, 1500));
+    TEST_ASSERT_EQUAL(500, temperature_filter_ntc(s_table, 3, 2250));
+    TEST_ASSERT_EQUAL(1750, temperature_filter_ntc(s_table, 3, 1750));
+}
+
+static void test_ntc_out_of_table(void)
+{
+    /* open and shorted sensor */
+    TEST_ASSERT_EQUAL(TEMPERATURE_FILTER_UNKNOWN, temperature_filter_ntc(s_table, 3, 2501));
+    TEST_ASSERT_EQUAL(TEMPERATURE_FILTER_UNKNOWN, temperature_filter_ntc(s_table, 3, 1499));
+    TEST_ASSERT_EQUAL(TEMPERATURE_FILTER_UNKNOWN, temperature_filter_ntc(s_table, 1, 2500));
+}
+
+static void test_first_sample_passes_through(void)
+{
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, 3);
+    TEST_ASSERT_EQUAL(2150, temperature_filter_push(&filter, 2150));
+    TEST_ASSERT_EQUAL(2150, temperature_filter_push(&filter, 2150));
+}
+
+static void test_single_outlier_removed(void)
+{
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, 0);
+    for (int i = 0; i < TEMPERATURE_FILTER_MEDIAN_SIZE; i++) {
+        temperature_filter_push(&filter, 2000);
+    }
+    TEST_ASSERT_EQUAL(2000, temperature_filter_push(&filter, 8000));
+    TEST_ASSERT_EQUAL(2000, temperature_filter_push(&filter, -4000));
+    TEST_ASSERT_EQUAL(2000, temperature_filter_push(&filter, 2000));
+}
+
+static void test_step_response(void)
+{
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, 2);
+    temperature_filter_push(&filter, 2000);
+    int16_t previous = 2000;
+    int16_t value = 0;
+    for (int i = 0; i < 40; i++) {
+        value = temperature_filter_push(&filter, 2400);
+        /* rises without overshoot */
+        TEST_ASSERT(value >= previous && value <= 2400);
+        previous = value;
+    }
+    TEST_ASSERT(value >= 2399);
+}
+
+static void test_unknown_empties_the_filter(void)
+{
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, 3);
+    temperature_filter_push(&filter, 2000);
+    temperature_filter_push(&filter, 2000);
+    TEST_ASSERT_EQUAL(TEMPERATURE_FILTER_UNKNOWN, temperature_filter_push(&filter, TEMPERATURE_FILTER_UNKNOWN));
+    TEST_ASSERT_EQUAL(0, filter.count);
+    TEST_ASSERT_EQUAL(3, filter.shift);
+    TEST_ASSERT_EQUAL(1500, temperature_filter_push(&filter, 1500));
+}
+
+static void test_negative_temperatures(void)
+{
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, 1);
+    TEST_ASSERT_EQUAL(-500, temperature_filter_push(&filter, -500));
+    TEST_ASSERT_EQUAL(-500, temperature_filter_push(&filter, -503));
+    /* the median is now -503, halfway to it is -501.5, rounded away from zero */
+    TEST_ASSERT_EQUAL(-502, temperature_filter_push(&filter, -503));
+}
+
+/* The calibration table of temperature_sensor.c */
+static const temperature_filter_ntc_point_t s_sensor_table[] = {
+    { 2816, -1000 }, { 2689, -500 }, { 2543, 0 }, { 2381, 500 }, { 2206, 1000 },
+    { 2023, 1500 }, { 1836, 2000 }, { 1650, 2500 }, { 1470, 3000 }, { 1301, 3500 },
+    { 1143, 4000 }, { 1000, 4500 }, { 871, 5000 }, { 757, 5500 }, { 657, 6000 },
+};
+
+static int64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000LL + end->tv_nsec - start->tv_nsec;
+}
+
+static void test_bath_trace_reports(void)
+{
+    FILE *file = fopen(TEMPERATURE_TRACE_FILE, "r");
+    TEST_ASSERT(file);
+    temperature_filter_t filter;
+    temperature_filter_init(&filter, TEMPERATURE_SENSOR_FILTER_SHIFT);
+    report_coalescer_t coalescer;
+    report_coalescer_init(&coalescer, 0, TEMPERATURE_SENSOR_REPORT_DELTA);
+    report_coalescer_set_intervals(&coalescer, TEMPERATURE_SENSOR_REPORT_MIN_S, TEMPERATURE_SENSOR_REPORT_MAX_S);
+
+    char line[64];
+    uint32_t samples = 0, unknown = 0, changes = 0, reports = 0;
+    int64_t filter_ns = 0, time_ms = 0, next_ms = REPORT_COALESCER_NO_DEADLINE;
+    int16_t published = TEMPERATURE_FILTER_UNKNOWN, low = INT16_MAX, high = INT16_MIN;
+    while (fgets(line, sizeof(line), file)) {
+        int32_t millivolts;
+        if (line[0] == '#' || sscanf(line, "%" SCNd64 ",%" SCNd32, &time_ms, &millivolts) != 2) {
+            continue;
+        }
+        /* the reports due before this sample, as attr_reporter's alarm sends them */
+        while (next_ms <= time_ms) {
+            int64_t poll_ms = next_ms;
+            reports += report_coalescer_poll(&coalescer, poll_ms, &next_ms);
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int16_t temperature = temperature_filter_ntc(s_sensor_table, sizeof(s_sensor_table) / sizeof(s_sensor_table[0]), millivolts);
+        temperature = temperature_filter_push(&filter, temperature);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        filter_ns += elapsed_ns(&start, &end);
+        samples++;
+
+        unknown += temperature == TEMPERATURE_FILTER_UNKNOWN;
+        if (temperature != TEMPERATURE_FILTER_UNKNOWN) {
+            low = temperature < low ? temperature : low;
+            high = temperature > high ? temperature : high;
+        }
+        /* temperature_sensor.c publishes the changes only */
+        if (temperature != published) {
+            published = temperature;
+            changes++;
+            next_ms = report_coalescer_update(&coalescer, temperature, time_ms);
+            if (next_ms <= time_ms) {
+                reports += report_coalescer_poll(&coalescer, time_ms, &next_ms);
+            }
+        }
+    }
+    fclose(file);
+
+    printf("%" PRIu32 " samples over %" PRId64 " min: %" PRIu32 " unknown, %" PRIu32 " changes published, %" PRIu32 " reports\n",
+           samples, (time_ms + TRACE_PERIOD_MS) / 60000, unknown, changes, reports);
+    printf("filtered between %d and %d, %" PRId64 " ns per sample on the host\n", low, high, filter_ns / samples);
+    TEST_ASSERT_EQUAL(1440, samples);
+    /* the open sensor empties the filter for its 3 periods, the disturbed conversions never show */
+    TEST_ASSERT_EQUAL(3, unknown);
+    TEST_ASSERT(low >= 1880 && high <= 2660);
+    /* a report per 0.2 °C move, against a frame per period or per published change without the delta */
+    TEST_ASSERT_EQUAL(66, reports);
+}
+
+int main(void)
+{
+    TEST_RUN(test_ntc_interpolation);
+    TEST_RUN(test_ntc_out_of_table);
+    TEST_RUN(test_first_sample_passes_through);
+    TEST_RUN(test_single_outlier_removed);
+    TEST_RUN(test_step_response);
+    TEST_RUN(test_unknown_empties_the_filter);
+    TEST_RUN(test_negative_temperatures);
+    TEST_RUN(test_bath_trace_reports);
+    return TEST_END();
+}
@@ -0,0 +1,219 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host test of the thermostat reports on the Zigbee stand-in: a bath replayed
+ * through thermostat.c, Comfort switched on, the room heated up to the setpoint,
+ * Eco switched back on and the room cooling down. The Report Attributes frames
+ * attr_reporter sends are counted against one frame per attribute report.
+ * Then a day in a simulated room: a heater warming a radiator that warms the
+ * room, which loses heat to the outside, with two Comfort periods. The distance
+ * to the setpoint and the reports sent per hour are measured.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include "esp_zb_light.h"
+#include "heater_link.h"
+#include "sim.h"
+#include "test.h"
+#include "thermostat.h"
+
+/* the temperature sensor reports every ten seconds, the room takes 0.05 °C per sample */
+#define SAMPLE_PERIOD_US    10000000LL
+#define SAMPLE_STEP         5
+#define ROOM_TEMPERATURE    1900
+/* Report Attributes: frame control, sequence number and command, then per record the attribute id and type */
+#define REPORT_HEADER_SIZE  3
+#define RECORD_HEADER_SIZE  3
+
+/* Room model: time constants of the losses to the outside, of the radiator to the room and of the radiator warming up */
+#define ROOM_OUTSIDE        10.0
+#define ROOM_LOSS_S         7200.0
+#define ROOM_RADIATOR_S     14400.0
+#define RADIATOR_ROOM_S     600.0
+#define RADIATOR_HEAT_RATE  (40.0 / RADIATOR_ROOM_S)    /* the radiator settles 40 °C above the room */
+#define ROOM_STEP_S         1
+#define DAY_SAMPLES         (24 * 3600 / 10)
+#define HOUR_SAMPLES        (3600 / 10)
+/* a mode is tracked once the room first reaches its setpoint, until the mode changes; the radiator
+ * keeps warming the room after the heating stops, the room overshoots the band by up to half of it */
+#define TRACK_MAX_ERROR     THERMOSTAT_HYSTERESIS
+#define TRACK_MEAN_ERROR    30
+#define FRAMES_PER_HOUR_MAX 30
+
+typedef struct {
+    double room;
+    double radiator;
+} room_t;
+
+typedef struct {
+    uint32_t samples;
+    double error_sum;
+    int32_t error_max;
+    uint32_t warm_up_samples;
+} accuracy_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t records;
+    uint32_t bytes;
+} report_count_t;
+
+static report_count_t s_count;
+static int16_t s_temperature = ROOM_TEMPERATURE;
+static bool s_heater;
+
+void heater_link_set(bool heating)
+{
+    s_heater = heating;
+}
+
+/* Add the frames sent since the last call to s_count */
+static void count_frames(void)
+{
+    for (size_t i = 0; i < sim_zb_frame_count(); i++) {
+        const sim_zb_frame_t *frame = sim_zb_frame(i);
+        s_count.frames++;
+        s_count.bytes += frame->length;
+        for (uint32_t offset = REPORT_HEADER_SIZE; offset + RECORD_HEADER_SIZE <= frame->length; s_count.records++) {
+            offset += RECORD_HEADER_SIZE + sim_zb_attr_size(frame->asdu[offset + 2]);
+        }
+    }
+    sim_zb_frames_clear();
+}
+
+static void sample(int16_t step)
+{
+    s_temperature += step;
+    thermostat_set_local_temperature(s_temperature);
+    sim_advance(SAMPLE_PERIOD_US);
+    count_frames();
+}
+
+static void test_init(void)
+{
+    int16_t comfort = THERMOSTAT_COMFORT_SETPOINT, eco = THERMOSTAT_ECO_SETPOINT;
+    uint8_t zero = 0, heat = ESP_ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT;
+    uint16_t running_state = 0;
+    const struct {
+        uint16_t attr_id;
+        uint8_t type;
+        const void *value;
+    } attrs[] = {
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &s_temperature },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPANCY_ID, ESP_ZB_ZCL_ATTR_TYPE_8BITMAP, &zero },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, ESP_ZB_ZCL_ATTR_TYPE_U8, &zero },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &comfort },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_UNOCCUPIED_HEATING_SETPOINT_ID, ESP_ZB_ZCL_ATTR_TYPE_S16, &eco },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ESP_ZB_ZCL_ATTR_TYPE_8BIT_ENUM, &heat },
+        { ESP_ZB_ZCL_ATTR_THERMOSTAT_THERMOSTAT_RUNNING_STATE_ID, ESP_ZB_ZCL_ATTR_TYPE_16BITMAP, &running_state },
+    };
+    for (size_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, sim_zb_attr_add(BATHROOM_THERMOSTAT_ENDPOINT, ESP_ZB_ZCL_CLUSTER_ID_THERMOSTAT, attrs[i].attr_id,
+                                                  attrs[i].type, attrs[i].value));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, thermostat_init(false));
+    sim_advance(SAMPLE_PERIOD_US);
+    TEST_ASSERT_EQUAL(0, sim_zb_frame_count());
+}
+
+static void test_bath_is_reported_in_batched_frames(void)
+{
+    /* Comfort: Occupancy and ThermostatRunningState change together */
+    thermostat_set_occupied(true);
+    sim_advance(SAMPLE_PERIOD_US);
+    count_frames();
+    TEST_ASSERT(s_heater);
+    TEST_ASSERT_EQUAL(1, s_count.frames);
+    TEST_ASSERT_EQUAL(2, s_count.records);
+
+    while (s_heater) {
+        sample(SAMPLE_STEP);
+    }
+    thermostat_set_occupied(false);
+    while (s_temperature > ROOM_TEMPERATURE) {
+        sample(-SAMPLE_STEP);
+    }
+
+    uint32_t unbatched_bytes = s_count.bytes + (s_count.records - s_count.frames) * REPORT_HEADER_SIZE;
+    printf("batched: %" PRIu32 " frames, %" PRIu32 " bytes; one frame per report: %" PRIu32 " frames, %" PRIu32 " bytes\n",
+           s_count.frames, s_count.bytes, s_count.records, unbatched_bytes);
+    /* Comfort and the heater turning off at the setpoint each save a frame, the temperature reports go alone */
+    TEST_ASSERT_EQUAL(67, s_count.frames);
+    TEST_ASSERT_EQUAL(69, s_count.records);
+    TEST_ASSERT_EQUAL(544, s_count.bytes);
+    TEST_ASSERT_EQUAL(550, unbatched_bytes);
+}
+
+/* Move the room model on by one sample period */
+static void room_step(room_t *room, bool heating)
+{
+    for (int i = 0; i < SAMPLE_PERIOD_US / 1000000 / ROOM_STEP_S; i++) {
+        double to_room = (room->radiator - room->room) / ROOM_RADIATOR_S;
+        double to_outside = (room->room - ROOM_OUTSIDE) / ROOM_LOSS_S;
+        room->radiator += ROOM_STEP_S * ((heating ? RADIATOR_HEAT_RATE : 0) - (room->radiator - room->room) / RADIATOR_ROOM_S);
+        room->room += ROOM_STEP_S * (to_room - to_outside);
+    }
+}
+
+static void test_room_day_is_held_at_the_setpoint(void)
+{
+    /* Comfort in the morning and the evening */
+    static const struct {
+        uint32_t from_hour;
+        uint32_t to_hour;
+    } comfort[] = { { 6, 8 }, { 19, 22 } };
+    room_t room = { .room = THERMOSTAT_ECO_SETPOINT / 100.0, .radiator = THERMOSTAT_ECO_SETPOINT / 100.0 };
+    accuracy_t accuracy = { 0 };
+    bool occupied = false, tracking = false;
+    uint32_t cycles = 0;
+
+    s_count = (report_count_t) { 0 };
+    for (uint32_t i = 0; i < DAY_SAMPLES; i++) {
+        bool comfort_now = false;
+        for (size_t p = 0; p < sizeof(comfort) / sizeof(comfort[0]); p++) {
+            comfort_now |= i >= comfort[p].from_hour * HOUR_SAMPLES && i < comfort[p].to_hour * HOUR_SAMPLES;
+        }
+        if (comfort_now != occupied) {
+            occupied = comfort_now;
+            tracking = false;
+            thermostat_set_occupied(occupied);
+        }
+        bool heating = s_heater;
+        room_step(&room, heating);
+        s_temperature = lround(room.room * 100);
+        thermostat_set_local_temperature(s_temperature);
+        cycles += !heating && s_heater;
+
+        int16_t setpoint = occupied ? THERMOSTAT_COMFORT_SETPOINT : THERMOSTAT_ECO_SETPOINT;
+        int32_t error = abs(s_temperature - setpoint);
+        tracking |= error <= THERMOSTAT_HYSTERESIS / 2;
+        if (tracking) {
+            accuracy.samples++;
+            accuracy.error_sum += error;
+            accuracy.error_max = error > accuracy.error_max ? error : accuracy.error_max;
+        } else {
+            accuracy.warm_up_samples++;
+        }
+        sim_advance(SAMPLE_PERIOD_US);
+        count_frames();
+    }
+
+    double mean_error = accuracy.error_sum / accuracy.samples;
+    printf("room day: mean error %.1f, worst %" PRId32 " (0.01 °C) over %" PRIu32 " samples, %" PRIu32 " samples to reach a setpoint\n",
+           mean_error, accuracy.error_max, accuracy.samples, accuracy.warm_up_samples);
+    printf("room day: %" PRIu32 " heating cycles, %.1f report frames and %.1f reports per hour\n", cycles,
+           s_count.frames / 24.0, s_count.records / 24.0);
+    TEST_ASSERT(accuracy.error_max <= TRACK_MAX_ERROR);
+    TEST_ASSERT(mean_error <= TRACK_MEAN_ERROR);
+    TEST_ASSERT(s_count.frames <= FRAMES_PER_HOUR_MAX * 24);
+}
+
+int main(void)
+{
+    TEST_RUN(test_init);
+    TEST_RUN(test_bath_is_reported_in_batched_frames);
+    TEST_RUN(test_room_day_is_held_at_the_setpoint);
+    return TEST_END();
+}
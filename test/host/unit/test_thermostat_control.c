@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of thermostat_control
+ */
+
+#include "test.h"
+#include "thermostat_control.h"
+
+/* 21 °C with a 0.5 °C band, heating below 20.75 °C and up to 21.25 °C */
+#define SETPOINT    2100
+#define HYSTERESIS  50
+
+static void test_hysteresis_band(void)
+{
+    thermostat_control_t tc;
+    thermostat_control_init(&tc, HYSTERESIS);
+    TEST_ASSERT(!thermostat_control_update(&tc, 2076, SETPOINT, true));
+    TEST_ASSERT(!tc.heating);
+    TEST_ASSERT(thermostat_control_update(&tc, 2075, SETPOINT, true));
+    TEST_ASSERT(tc.heating);
+    /* inside the band the output holds */
+    TEST_ASSERT(!thermostat_control_update(&tc, 2100, SETPOINT, true));
+    TEST_ASSERT(!thermostat_control_update(&tc, 2124, SETPOINT, true));
+    TEST_ASSERT(tc.heating);
+    TEST_ASSERT(thermostat_control_update(&tc, 2125, SETPOINT, true));
+    TEST_ASSERT(!tc.heating);
+    TEST_ASSERT(!thermostat_control_update(&tc, 2080, SETPOINT, true));
+    TEST_ASSERT_EQUAL(1, tc.cycles);
+}
+
+static void test_setpoint_change(void)
+{
+    thermostat_control_t tc;
+    thermostat_control_init(&tc, HYSTERESIS);
+    /* Eco to Comfort at the same temperature */
+    TEST_ASSERT(!thermostat_control_update(&tc, 1900, 1700, true));
+    TEST_ASSERT(thermostat_control_update(&tc, 1900, SETPOINT, true));
+    TEST_ASSERT(tc.heating);
+    TEST_ASSERT(thermostat_control_update(&tc, 1900, 1700, true));
+    TEST_ASSERT(!tc.heating);
+}
+
+static void test_disabled_and_unknown_stop_the_heating(void)
+{
+    thermostat_control_t tc;
+    thermostat_control_init(&tc, HYSTERESIS);
+    thermostat_control_update(&tc, 1500, SETPOINT, true);
+    TEST_ASSERT(thermostat_control_update(&tc, 1500, SETPOINT, false));
+    TEST_ASSERT(!tc.heating);
+    TEST_ASSERT(!thermostat_control_update(&tc, 1500, SETPOINT, false));
+    TEST_ASSERT(thermostat_control_update(&tc, 1500, SETPOINT, true));
+    TEST_ASSERT(thermostat_control_update(&tc, THERMOSTAT_CONTROL_TEMPERATURE_UNKNOWN, SETPOINT, true));
+    TEST_ASSERT(!tc.heating);
+    TEST_ASSERT_EQUAL(2, tc.cycles);
+}
+
+static void test_extreme_values(void)
+{
+    thermostat_control_t tc;
+    thermostat_control_init(&tc, HYSTERESIS);
+    /* the comparisons do not overflow at the ends of the int16 range */
+    TEST_ASSERT(thermostat_control_update(&tc, INT16_MIN + 1, INT16_MAX, true));
+    TEST_ASSERT(thermostat_control_update(&tc, INT16_MAX, INT16_MIN + 1, true));
+    TEST_ASSERT(!tc.heating);
+}
+
+int main(void)
+{
+    TEST_RUN(test_hysteresis_band);
+    TEST_RUN(test_setpoint_change);
+    TEST_RUN(test_disabled_and_unknown_stop_the_heating);
+    TEST_RUN(test_extreme_values);
+    return TEST_END();
+}
@@ -0,0 +1,142 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Host tests of timer_wheel
+ */
+
+#include "test.h"
+#include "timer_wheel.h"
+
+#define MAX_EXPIRED 8
+
+static int s_expired[MAX_EXPIRED];
+static unsigned s_expired_count;
+
+static void record_cb(void *arg, int64_t now_ms)
+{
+    if (s_expired_count < MAX_EXPIRED) {
+        s_expired[s_expired_count] = (int)(intptr_t)arg;
+    }
+    s_expired_count++;
+}
+
+static void reset(void)
+{
+    s_expired_count = 0;
+}
+
+static void test_deadline_order(void)
+{
+    timer_wheel_t wheel;
+    timer_wheel_entry_t entries[3];
+    timer_wheel_init(&wheel, 10);
+    reset();
+    for (int i = 0; i < 3; i++) {
+        timer_wheel_entry_init(&entries[i], record_cb, (void *)(intptr_t)i);
+    }
+    timer_wheel_schedule(&wheel, &entries[0], 300);
+    timer_wheel_schedule(&wheel, &entries[1], 100);
+    timer_wheel_schedule(&wheel, &entries[2], 200);
+    TEST_ASSERT_EQUAL(100, timer_wheel_next_deadline(&wheel));
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, 99));
+    TEST_ASSERT_EQUAL(3, timer_wheel_advance(&wheel, 300));
+    TEST_ASSERT_EQUAL(1, s_expired[0]);
+    TEST_ASSERT_EQUAL(2, s_expired[1]);
+    TEST_ASSERT_EQUAL(0, s_expired[2]);
+    TEST_ASSERT_EQUAL(TIMER_WHEEL_NO_DEADLINE, timer_wheel_next_deadline(&wheel));
+}
+
+static void test_deadline_rounded_up(void)
+{
+    timer_wheel_t wheel;
+    timer_wheel_entry_t entry;
+    timer_wheel_init(&wheel, 10);
+    timer_wheel_entry_init(&entry, record_cb, NULL);
+    reset();
+    timer_wheel_schedule(&wheel, &entry, 101);
+    TEST_ASSERT_EQUAL(110, timer_wheel_next_deadline(&wheel));
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, 109));
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, 110));
+}
+
+/* deadlines a multiple of TIMER_WHEEL_SLOTS ticks apart share a slot */
+static void test_same_slot_later_round(void)
+{
+    timer_wheel_t wheel;
+    timer_wheel_entry_t near, far;
+    timer_wheel_init(&wheel, 1);
+    timer_wheel_entry_init(&near, record_cb, (void *)1);
+    timer_wheel_entry_init(&far, record_cb, (void *)2);
+    reset();
+    timer_wheel_schedule(&wheel, &far, 5 + TIMER_WHEEL_SLOTS);
+    timer_wheel_schedule(&wheel, &near, 5);
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, 5));
+    TEST_ASSERT_EQUAL(1, s_expired[0]);
+    TEST_ASSERT(far.scheduled);
+    TEST_ASSERT_EQUAL(5 + TIMER_WHEEL_SLOTS, timer_wheel_next_deadline(&wheel));
+}
+
+static void test_cancel_and_move(void)
+{
+    timer_wheel_t wheel;
+    timer_wheel_entry_t a, b;
+    timer_wheel_init(&wheel, 1);
+    timer_wheel_entry_init(&a, record_cb, (void *)1);
+    timer_wheel_entry_init(&b, record_cb, (void *)2);
+    reset();
+    timer_wheel_schedule(&wheel, &a, 10);
+    timer_wheel_schedule(&wheel, &b, 20);
+    timer_wheel_cancel(&wheel, &a);
+    timer_wheel_cancel(&wheel, &a);
+    TEST_ASSERT(!a.scheduled);
+    TEST_ASSERT_EQUAL(20, timer_wheel_next_deadline(&wheel));
+    /* scheduling a scheduled entry moves it */
+    timer_wheel_schedule(&wheel, &b, 40);
+    TEST_ASSERT_EQUAL(0, timer_wheel_advance(&wheel, 30));
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, 40));
+    TEST_ASSERT_EQUAL(1, s_expired_count);
+}
+
+static void test_past_deadline(void)
+{
+    timer_wheel_t wheel;
+    timer_wheel_entry_t entry;
+    timer_wheel_init(&wheel, 10);
+    timer_wheel_entry_init(&entry, record_cb, NULL);
+    reset();
+    timer_wheel_schedule(&wheel, &entry, 50);
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, 1000));
+}
+
+static timer_wheel_t s_wheel;
+static timer_wheel_entry_t s_periodic;
+
+static void periodic_cb(void *arg, int64_t now_ms)
+{
+    s_expired_count++;
+    timer_wheel_schedule(&s_wheel, &s_periodic, now_ms + 100);
+}
+
+static void test_schedule_from_callback(void)
+{
+    timer_wheel_init(&s_wheel, 10);
+    timer_wheel_entry_init(&s_periodic, periodic_cb, NULL);
+    reset();
+    timer_wheel_schedule(&s_wheel, &s_periodic, 100);
+    for (int64_t now_ms = 0; now_ms <= 1000; now_ms += 10) {
+        timer_wheel_advance(&s_wheel, now_ms);
+    }
+    TEST_ASSERT_EQUAL(10, s_expired_count);
+    TEST_ASSERT_EQUAL(1100, timer_wheel_next_deadline(&s_wheel));
+}
+
+int main(void)
+{
+    TEST_RUN(test_deadline_order);
+    TEST_RUN(test_deadline_rounded_up);
+    TEST_RUN(test_same_slot_later_round);
+    TEST_RUN(test_cancel_and_move);
+    TEST_RUN(test_past_deadline);
+    TEST_RUN(test_schedule_from_callback);
+    return TEST_END();
+}